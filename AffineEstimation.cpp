@@ -0,0 +1,482 @@
+
+#include "AffineEstimation.hpp"
+#include "ElementWise.hpp"
+#include "Instrumentation.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of AffineEstimation
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Least-squares sums are taken over chunks of this many points; the chunking is the same for
+	// any number of threads, which keeps the rounding, and so the result, reproducible.
+	//
+	const size_t PointsPerChunk = 32768;
+
+	//
+	// RANSAC draws this many hypotheses per round, in groups that are scored together tile by
+	// tile, so each tile of points is loaded once per group rather than once per hypothesis.
+	//
+	const unsigned int HypothesesPerRound = 64;
+	const unsigned int HypothesesPerGroup = 4;
+	const size_t       PointsPerTile = 4096;
+
+	//
+	// A triangle of sample points whose area is below this fraction of the product of its
+	// two edge lengths is treated as collinear.
+	//
+	const double CollinearTolerance = 1e-6;
+
+	//
+	// First and second moments of a set of correspondences, (x, y) -> (u, v), relative to an
+	// origin so that the sums of squares do not cancel.
+	//
+	struct Moments
+	{
+		Moments()
+			: n(0), sx(0), sy(0), su(0), sv(0),
+			  sxx(0), sxy(0), syy(0), sxu(0), syu(0), sxv(0), syv(0)
+		{
+		}
+
+		void operator+=(const Moments& rh)
+		{
+			n += rh.n;
+			sx += rh.sx;
+			sy += rh.sy;
+			su += rh.su;
+			sv += rh.sv;
+			sxx += rh.sxx;
+			sxy += rh.sxy;
+			syy += rh.syy;
+			sxu += rh.sxu;
+			syu += rh.syu;
+			sxv += rh.sxv;
+			syv += rh.syv;
+		}
+
+		double n, sx, sy, su, sv, sxx, sxy, syy, sxu, syu, sxv, syv;
+	};
+
+	/// \brief     Moments of points [begin, end), skipping those whose mask entry is zero.
+	/// \param[in] origin. (x, y, u, v) subtracted from every point.
+	/// \param[in] mask. May be null.
+	template <typename T>
+	Moments Accumulate(const size_t begin, const size_t end,
+	                   const T* x, const T* y, const T* tx, const T* ty,
+	                   const double* origin, const unsigned char* mask)
+	{
+		Moments m;
+		for (size_t i = begin; i < end; i++)
+		{
+			if (mask != 0 && mask[i] == 0)
+			{
+				continue;
+			}
+			const double px = x[i] - origin[0];
+			const double py = y[i] - origin[1];
+			const double pu = tx[i] - origin[2];
+			const double pv = ty[i] - origin[3];
+			m.n += 1;
+			m.sx += px;
+			m.sy += py;
+			m.su += pu;
+			m.sv += pv;
+			m.sxx += px * px;
+			m.sxy += px * py;
+			m.syy += py * py;
+			m.sxu += px * pu;
+			m.syu += py * pu;
+			m.sxv += px * pv;
+			m.syv += py * pv;
+		}
+		return m;
+	}
+
+	/// \brief      Least-squares fit over the selected points.
+	/// \param[in]  mask. Points with a zero entry are left out; may be null.
+	/// \param[out] coefficients. m00, m01, m10, m11, dx, dy.
+	/// \return     false when fewer than three points are selected or they are collinear.
+	template <typename T>
+	bool FitLeastSquares(const size_t n, const T* x, const T* y, const T* tx, const T* ty,
+	                     const unsigned char* mask, double* coefficients)
+	{
+		size_t first = 0;
+		while (first < n && mask != 0 && mask[first] == 0)
+		{
+			first++;
+		}
+		if (first == n)
+		{
+			return false;
+		}
+
+		const double origin[4] = { double(x[first]), double(y[first]), double(tx[first]), double(ty[first]) };
+		const size_t numChunks = (n + PointsPerChunk - 1) / PointsPerChunk;
+		std::vector<Moments> partial(numChunks);
+		const auto accumulateChunk = [&](size_t chunk)
+		{
+			const size_t begin = chunk * PointsPerChunk;
+			partial[chunk] = Accumulate(begin, std::min(n, begin + PointsPerChunk),
+			                            x, y, tx, ty, origin, mask);
+		};
+		if (numChunks > 1 && ThreadPool::NumThreads() > 1)
+		{
+			ThreadPool::Instance().ParallelFor(numChunks, accumulateChunk);
+		}
+		else
+		{
+			for (size_t chunk = 0; chunk < numChunks; chunk++)
+			{
+				accumulateChunk(chunk);
+			}
+		}
+
+		Moments m;
+		for (size_t chunk = 0; chunk < numChunks; chunk++)
+		{
+			m += partial[chunk];
+		}
+		if (m.n < 3)
+		{
+			return false;
+		}
+
+		//
+		// Centred covariances, then the two 2x2 normal equations that share the matrix
+		// [cxx cxy; cxy cyy], one for each row of the linear map.
+		//
+		const double mx = m.sx / m.n;
+		const double my = m.sy / m.n;
+		const double mu = m.su / m.n;
+		const double mv = m.sv / m.n;
+		const double cxx = m.sxx - m.sx * mx;
+		const double cxy = m.sxy - m.sx * my;
+		const double cyy = m.syy - m.sy * my;
+		const double cxu = m.sxu - m.sx * mu;
+		const double cyu = m.syu - m.sy * mu;
+		const double cxv = m.sxv - m.sx * mv;
+		const double cyv = m.syv - m.sy * mv;
+
+		const double det = cxx * cyy - cxy * cxy;
+		if (!(det > CollinearTolerance * CollinearTolerance * cxx * cyy) || !(cxx * cyy > 0))
+		{
+			return false;
+		}
+
+		const double m00 = (cxu * cyy - cyu * cxy) / det;
+		const double m01 = (cyu * cxx - cxu * cxy) / det;
+		const double m10 = (cxv * cyy - cyv * cxy) / det;
+		const double m11 = (cyv * cxx - cxv * cxy) / det;
+		const double cx = origin[0] + mx;
+		const double cy = origin[1] + my;
+		coefficients[0] = m00;
+		coefficients[1] = m01;
+		coefficients[2] = m10;
+		coefficients[3] = m11;
+		coefficients[4] = origin[2] + mu - m00 * cx - m01 * cy;
+		coefficients[5] = origin[3] + mv - m10 * cx - m11 * cy;
+		return true;
+	}
+
+	//
+	// SplitMix64, small and statistically sound; one per hypothesis.
+	//
+	class SplitMix64
+	{
+	public:
+		explicit SplitMix64(const unsigned long long seed)
+			: m_state(seed)
+		{
+		}
+
+		unsigned long long Next()
+		{
+			unsigned long long z = (m_state += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		}
+
+	private:
+		unsigned long long m_state;
+	};
+
+	/// \brief      The exact transform of three random correspondences.
+	/// \param[in]  index. Hypothesis number, which with seed fixes the sample.
+	/// \param[out] linearMap, translation. The hypothesis.
+	/// \return     false when the sample is collinear.
+	template <typename T>
+	bool DrawHypothesis(const size_t n, const T* x, const T* y, const T* tx, const T* ty,
+	                    const unsigned long long seed, const unsigned long long index,
+	                    T* linearMap, T* translation)
+	{
+		SplitMix64 rng(seed ^ (index * 0xD1B54A32D192ED03ULL));
+		size_t sample[3];
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			bool repeated = true;
+			while (repeated)
+			{
+				sample[k] = static_cast<size_t>(rng.Next() % n);
+				repeated = false;
+				for (unsigned int j = 0; j < k; j++)
+				{
+					repeated = repeated || sample[j] == sample[k];
+				}
+			}
+		}
+
+		const size_t i0 = sample[0];
+		const size_t i1 = sample[1];
+		const size_t i2 = sample[2];
+		const double d1x = double(x[i1]) - x[i0];
+		const double d1y = double(y[i1]) - y[i0];
+		const double d2x = double(x[i2]) - x[i0];
+		const double d2y = double(y[i2]) - y[i0];
+		const double det = d1x * d2y - d2x * d1y;
+		const double scale = std::sqrt((d1x * d1x + d1y * d1y) * (d2x * d2x + d2y * d2y));
+		if (!(std::abs(det) > CollinearTolerance * scale))
+		{
+			return false;
+		}
+
+		//
+		// L = E * D^-1, with D and E the edge vectors of the source and target triangles.
+		//
+		const double e1x = double(tx[i1]) - tx[i0];
+		const double e1y = double(ty[i1]) - ty[i0];
+		const double e2x = double(tx[i2]) - tx[i0];
+		const double e2y = double(ty[i2]) - ty[i0];
+		const double m00 = (e1x * d2y - e2x * d1y) / det;
+		const double m01 = (e2x * d1x - e1x * d2x) / det;
+		const double m10 = (e1y * d2y - e2y * d1y) / det;
+		const double m11 = (e2y * d1x - e1y * d2x) / det;
+		linearMap[0] = static_cast<T>(m00);
+		linearMap[1] = static_cast<T>(m01);
+		linearMap[2] = static_cast<T>(m10);
+		linearMap[3] = static_cast<T>(m11);
+		translation[0] = static_cast<T>(tx[i0] - m00 * x[i0] - m01 * y[i0]);
+		translation[1] = static_cast<T>(ty[i0] - m10 * x[i0] - m11 * y[i0]);
+		return true;
+	}
+
+	/// \brief      Mark the inliers of a transform.
+	/// \return     Their number.
+	template <typename T>
+	size_t MarkInliers(const size_t n, const T* x, const T* y, const T* tx, const T* ty,
+	                   const T* linearMap, const T* translation, const T maxSquaredError,
+	                   unsigned char* inliers)
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < n; i++)
+		{
+			const T ex = linearMap[0] * x[i] + linearMap[1] * y[i] + translation[0] - tx[i];
+			const T ey = linearMap[2] * x[i] + linearMap[3] * y[i] + translation[1] - ty[i];
+			inliers[i] = ex * ex + ey * ey <= maxSquaredError ? 1 : 0;
+			count += inliers[i];
+		}
+		return count;
+	}
+
+	/// \brief  Iterations needed to draw one outlier-free sample with the given confidence.
+	unsigned int RequiredIterations(const double inlierRatio, const double confidence,
+	                                const unsigned int maxIterations)
+	{
+		const double good = inlierRatio * inlierRatio * inlierRatio;
+		if (good >= 1.0)
+		{
+			return 1;
+		}
+		if (good <= 0.0 || confidence >= 1.0)
+		{
+			return maxIterations;
+		}
+		const double needed = std::ceil(std::log(1.0 - confidence) / std::log(1.0 - good));
+		return needed < maxIterations ? static_cast<unsigned int>(std::max(needed, 1.0)) : maxIterations;
+	}
+}
+
+
+/// \brief      Least-squares affine transform from n correspondences.
+/// \param[in]  n. Number of correspondences, at least 3.
+/// \param[in]  x, y. Source coordinates.
+/// \param[in]  tx, ty. Target coordinates.
+/// \param[out] atp. The transform.
+template <typename T>
+void numeric::EstimateAffineTransform(const size_t n,
+                                      const T* x,
+                                      const T* y,
+                                      const T* tx,
+                                      const T* ty,
+                                      BasicAffineTransformParams<T>& atp)
+{
+	if (n < 3)
+	{
+		throw std::invalid_argument(
+			"At least three correspondences are needed"
+			);
+	}
+
+	//
+	// The moments take 20 flops per correspondence.
+	//
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpEstimateAffineTransform, n, 20 * static_cast<std::uint64_t>(n));
+	double c[6];
+	if (!FitLeastSquares(n, x, y, tx, ty, static_cast<const unsigned char*>(0), c))
+	{
+		throw std::runtime_error("Degenerate point configuration");
+	}
+	atp = BasicAffineTransformParams<T>(static_cast<T>(c[0]), static_cast<T>(c[1]),
+	                                    static_cast<T>(c[2]), static_cast<T>(c[3]),
+	                                    static_cast<T>(c[4]), static_cast<T>(c[5]));
+}
+
+
+/// \brief      RANSAC affine transform from n correspondences with outliers.
+/// \param[in]  n. Number of correspondences, at least 3.
+/// \param[in]  x, y. Source coordinates.
+/// \param[in]  tx, ty. Target coordinates.
+/// \param[in]  options. Iterations, inlier threshold, confidence and seed.
+/// \param[out] atp. The transform refined over the inliers.
+/// \param[out] inliers. n flags, or null.
+/// \return     Number of inliers.
+template <typename T>
+size_t numeric::EstimateAffineTransformRansac(const size_t n,
+                                              const T* x,
+                                              const T* y,
+                                              const T* tx,
+                                              const T* ty,
+                                              const RansacOptions& options,
+                                              BasicAffineTransformParams<T>& atp,
+                                              unsigned char* inliers)
+{
+	if (n < 3)
+	{
+		throw std::invalid_argument(
+			"At least three correspondences are needed"
+			);
+	}
+
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpEstimateAffineTransformRansac, n, 0);
+	const T maxSquaredError = static_cast<T>(options.threshold * options.threshold);
+	const unsigned int numGroups = HypothesesPerRound / HypothesesPerGroup;
+	T maps[HypothesesPerRound][6];
+	bool valid[HypothesesPerRound];
+	size_t counts[HypothesesPerRound];
+
+	T best[6] = { T(0), T(0), T(0), T(0), T(0), T(0) };
+	size_t bestCount = 0;
+	unsigned int required = options.maxIterations;
+	for (unsigned int done = 0; done < required; done += HypothesesPerRound)
+	{
+		const unsigned int roundSize = std::min(HypothesesPerRound, required - done);
+
+		//
+		// Each group draws its hypotheses, then walks the points tile by tile and scores all
+		// of them against a tile while it is in cache.
+		//
+		ThreadPool::Instance().ParallelFor(numGroups, [&](size_t group)
+		{
+			const unsigned int h0 = static_cast<unsigned int>(group) * HypothesesPerGroup;
+			const unsigned int h1 = std::min(h0 + HypothesesPerGroup, roundSize);
+			for (unsigned int h = h0; h < h1; h++)
+			{
+				valid[h] = DrawHypothesis(n, x, y, tx, ty, options.seed, done + h, maps[h], maps[h] + 4);
+				counts[h] = 0;
+			}
+			for (size_t begin = 0; begin < n; begin += PointsPerTile)
+			{
+				const size_t count = std::min(PointsPerTile, n - begin);
+				for (unsigned int h = h0; h < h1; h++)
+				{
+					if (valid[h])
+					{
+						counts[h] += kernel::CountAffineInliers<T>(count, maps[h], maps[h] + 4,
+							x + begin, y + begin, tx + begin, ty + begin, maxSquaredError);
+					}
+				}
+			}
+		});
+
+		//
+		// Scoring a hypothesis takes 12 flops per correspondence.
+		//
+		NUMERIC_INSTRUMENT_FLOPS(instrumentation::OpEstimateAffineTransformRansac,
+			12 * static_cast<std::uint64_t>(roundSize) * n);
+		for (unsigned int h = 0; h < roundSize; h++)
+		{
+			if (valid[h] && counts[h] > bestCount)
+			{
+				bestCount = counts[h];
+				std::copy(maps[h], maps[h] + 6, best);
+			}
+		}
+		if (bestCount > 0)
+		{
+			required = std::min(required, RequiredIterations(double(bestCount) / n,
+				options.confidence, options.maxIterations));
+		}
+	}
+
+	if (bestCount < 3)
+	{
+		throw std::runtime_error("No affine transform found");
+	}
+
+	//
+	// Refine over the inliers of the best hypothesis, and keep the refinement if it fits at
+	// least as many points.
+	//
+	std::vector<unsigned char> mask(n);
+	bestCount = MarkInliers(n, x, y, tx, ty, best, best + 4, maxSquaredError, &mask[0]);
+
+	double c[6];
+	if (FitLeastSquares(n, x, y, tx, ty, &mask[0], c))
+	{
+		T refined[6];
+		for (unsigned int k = 0; k < 6; k++)
+		{
+			refined[k] = static_cast<T>(c[k]);
+		}
+		std::vector<unsigned char> refinedMask(n);
+		const size_t refinedCount = MarkInliers(n, x, y, tx, ty, refined, refined + 4,
+			maxSquaredError, &refinedMask[0]);
+		if (refinedCount >= bestCount)
+		{
+			bestCount = refinedCount;
+			std::copy(refined, refined + 6, best);
+			mask.swap(refinedMask);
+		}
+	}
+
+	atp = BasicAffineTransformParams<T>(best[0], best[1], best[2], best[3], best[4], best[5]);
+	if (inliers != 0)
+	{
+		std::copy(mask.begin(), mask.end(), inliers);
+	}
+	return bestCount;
+}
+
+
+#define NUMERIC_INSTANTIATE_ESTIMATION(T)                                                      \
+	template void numeric::EstimateAffineTransform<T>(const size_t, const T*, const T*,        \
+	                                                  const T*, const T*,                      \
+	                                                  BasicAffineTransformParams<T>&);         \
+	template size_t numeric::EstimateAffineTransformRansac<T>(const size_t, const T*,          \
+	                                                          const T*, const T*, const T*,    \
+	                                                          const RansacOptions&,            \
+	                                                          BasicAffineTransformParams<T>&,  \
+	                                                          unsigned char*);
+
+NUMERIC_INSTANTIATE_ESTIMATION(float)
+NUMERIC_INSTANTIATE_ESTIMATION(double)
+
+#undef NUMERIC_INSTANTIATE_ESTIMATION
@@ -0,0 +1,68 @@
+#ifndef Numeric_AffineEstimation_HPP
+#define Numeric_AffineEstimation_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include "AffineTransformParams.hpp"
+
+namespace numeric
+{
+	//
+	// Class : Settings of EstimateAffineTransformRansac.
+	//
+	// Hypotheses are drawn in rounds; after each round the number of iterations still needed
+	// is recomputed from the best inlier ratio so far and the requested confidence, and never
+	// exceeds maxIterations. Every hypothesis is drawn from its own generator, seeded from seed
+	// and the hypothesis index, so the result depends on seed only and not on the number of
+	// threads.
+	//
+	struct RansacOptions
+	{
+		RansacOptions()
+			: maxIterations(1000), threshold(1.0), confidence(0.99), seed(0)
+		{
+		}
+
+		unsigned int       maxIterations;
+		double             threshold;       // largest distance of an inlier from its target
+		double             confidence;      // probability of drawing one outlier-free sample
+		unsigned long long seed;
+	};
+
+	//
+	// Function : Least-squares affine transform mapping (x[i], y[i]) onto (tx[i], ty[i]).
+	//      Instantiated for float and double. Sums are accumulated in double over fixed-size
+	//      chunks, in parallel for large n, and combined in chunk order, so the result does not
+	//      depend on the number of threads. Throws std::invalid_argument for fewer than three
+	//      points and std::runtime_error when the source points are collinear.
+	//
+	template <typename T>
+	void EstimateAffineTransform(const size_t n,
+	                             const T* x,
+	                             const T* y,
+	                             const T* tx,
+	                             const T* ty,
+	                             BasicAffineTransformParams<T>& atp);
+
+	//
+	// Function : Robust affine transform from correspondences containing outliers.
+	//      Instantiated for float and double. Each hypothesis is the exact transform of three
+	//      random correspondences, scored by its inlier count over all points with the SIMD
+	//      kernel::CountAffineInliers; hypotheses of a round run in parallel on the ThreadPool.
+	//      The best hypothesis, the largest count and then the lowest index, is refined by least
+	//      squares over its inliers. Returns the number of inliers and, when inliers is not
+	//      null, sets inliers[i] to 1 for every inlier and 0 otherwise. Throws
+	//      std::runtime_error when no hypothesis has three inliers.
+	//
+	template <typename T>
+	size_t EstimateAffineTransformRansac(const size_t n,
+	                                     const T* x,
+	                                     const T* y,
+	                                     const T* tx,
+	                                     const T* ty,
+	                                     const RansacOptions& options,
+	                                     BasicAffineTransformParams<T>& atp,
+	                                     unsigned char* inliers = 0);
+}
+
+#endif
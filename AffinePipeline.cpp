@@ -0,0 +1,128 @@
+
+#include "AffinePipeline.hpp"
+#include "AffineTransform.hpp"
+#include <stdexcept>
+#include <cstdint>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of AffinePipeline
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+BasicAffinePipeline<T>::BasicAffinePipeline()
+	: m_numComposed(0),
+	  m_identity(T(1), T(0), T(0), T(1), T(0), T(0))
+{
+}
+
+
+template <typename T>
+size_t BasicAffinePipeline<T>::NumStages() const
+{
+	return m_stages.size();
+}
+
+
+/// \brief      Record a stage after the existing ones.
+/// \param[in]  atp. The stage.
+/// \return     the index of the stage.
+template <typename T>
+size_t BasicAffinePipeline<T>::Append(const StageType& atp)
+{
+	m_stages.push_back(atp);
+	return m_stages.size() - 1;
+}
+
+
+/// \brief      Replace a stage. The cached compositions from this stage on are dropped.
+/// \param[in]  index. Stage index.
+/// \param[in]  atp. The new stage.
+template <typename T>
+void BasicAffinePipeline<T>::SetStage(const size_t index, const StageType& atp)
+{
+	if (index >= m_stages.size())
+	{
+		throw std::out_of_range("Out of Range");
+	}
+	m_stages[index] = atp;
+	if (m_numComposed > index)
+	{
+		m_numComposed = index;
+	}
+}
+
+
+template <typename T>
+const BasicAffineTransformParams<T>& BasicAffinePipeline<T>::Stage(const size_t index) const
+{
+	if (index >= m_stages.size())
+	{
+		throw std::out_of_range("Out of Range");
+	}
+	return m_stages[index];
+}
+
+
+template <typename T>
+void BasicAffinePipeline<T>::Clear()
+{
+	m_stages.clear();
+	m_prefixes.clear();
+	m_numComposed = 0;
+}
+
+
+/// \brief      Compose the stages that are not cached yet onto the cached prefix.
+/// \return     the composition of all the stages.
+template <typename T>
+const BasicAffineTransformParams<T>& BasicAffinePipeline<T>::Composed() const
+{
+	const size_t numStages = m_stages.size();
+	if (numStages == 0)
+	{
+		return m_identity;
+	}
+
+	m_prefixes.resize(numStages);
+	if (m_numComposed == 0)
+	{
+		m_prefixes[0] = m_stages[0];
+		m_numComposed = 1;
+	}
+	for (size_t i = m_numComposed; i < numStages; i++)
+	{
+		CombineAffineTransform(m_prefixes[i - 1], m_stages[i], m_prefixes[i]);
+	}
+	m_numComposed = numStages;
+	return m_prefixes[numStages - 1];
+}
+
+
+/// \brief      Apply all the stages to a batch of points in one pass.
+/// \param[in]  p. 2*n points.
+/// \param[out] trans_p. 2*n transformed points; may be p.
+template <typename T>
+void BasicAffinePipeline<T>::Apply(const BasicMatrix<T>& p, BasicMatrix<T>& trans_p) const
+{
+	AffineTransform(Composed(), p, trans_p);
+}
+
+
+template <typename T>
+void BasicAffinePipeline<T>::Apply(const size_t n, const T* x, const T* y, T* trans_x, T* trans_y) const
+{
+	AffineTransformPoints(Composed(), n, x, y, trans_x, trans_y);
+}
+
+
+template <typename T>
+void BasicAffinePipeline<T>::Apply(const size_t n, const T* xy, T* trans_xy) const
+{
+	AffineTransformPoints(Composed(), n, xy, trans_xy);
+}
+
+
+template class numeric::BasicAffinePipeline<float>;
+template class numeric::BasicAffinePipeline<double>;
+template class numeric::BasicAffinePipeline<std::int32_t>;
@@ -0,0 +1,74 @@
+#ifndef Numeric_AffinePipeline_HPP
+#define Numeric_AffinePipeline_HPP
+
+#include <cstddef>
+#include <vector>
+#include "Matrix.hpp"
+#include "AffineTransformParams.hpp"
+
+namespace numeric
+{
+	//
+	// Class : A sequence of affine stages applied to points in one pass.
+	//
+	// Append and SetStage only record the stages; no point is touched until Apply. Apply
+	// composes the stages into a single transform and runs AffineTransformPoints once, so the
+	// points are read and written once however many stages there are.
+	//
+	// The composition of every prefix of the stages is cached. Appending a stage composes it
+	// onto the cached prefix; changing stage i recomposes stages i and later on the next
+	// Composed or Apply. Those const calls update the cache, so a pipeline must not be used
+	// from several threads while it is being changed.
+	//
+	// Instantiated for float, double and std::int32_t.
+	//
+	template <typename T>
+	class BasicAffinePipeline
+	{
+	public:
+		typedef T                             ElemType;
+		typedef BasicAffineTransformParams<T> StageType;
+
+	public:
+		BasicAffinePipeline();
+
+		size_t NumStages() const;
+
+		//
+		// Add a stage applied after the existing ones, and return its index.
+		//
+		size_t Append(const StageType& atp);
+
+		//
+		// Replace stage index. Throws std::out_of_range when there is no such stage.
+		//
+		void             SetStage(const size_t index, const StageType& atp);
+		const StageType& Stage(const size_t index) const;
+
+		void Clear();
+
+		//
+		// The composition of all the stages, the identity when there are none.
+		//
+		const StageType& Composed() const;
+
+		//
+		// Apply the composed transform, with the conventions of AffineTransform and
+		// AffineTransformPoints: p is 2*n with one point per column, x and y are coordinate
+		// arrays, xy holds interleaved points. The outputs may be the inputs.
+		//
+		void Apply(const BasicMatrix<T>& p, BasicMatrix<T>& trans_p) const;
+		void Apply(const size_t n, const T* x, const T* y, T* trans_x, T* trans_y) const;
+		void Apply(const size_t n, const T* xy, T* trans_xy) const;
+
+	private:
+		std::vector<StageType>         m_stages;
+		mutable std::vector<StageType> m_prefixes;
+		mutable size_t                 m_numComposed;
+		StageType                      m_identity;
+	};
+
+	typedef BasicAffinePipeline<double> AffinePipeline;
+}
+
+#endif
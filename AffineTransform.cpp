@@ -1,5 +1,12 @@
 #include "AffineTransform.hpp"
+#include "ElementWise.hpp"
+#include "ThreadPool.hpp"
+#include "Instrumentation.hpp"
 #include <stdexcept>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <vector>
 
 
 using namespace std;
@@ -8,60 +15,437 @@ using namespace numeric;
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //Implementation of Functions
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-void numeric::AffineTransform(AffineTransformParams& atp, Matrix& p, Matrix& trans_p)
+namespace
+{
+	//
+	// Batches are split into chunks of this many points, large enough that handing one to a
+	// worker costs far less than streaming its coordinates through memory.
+	//
+	const size_t PointsPerChunk = 32768;
+
+	size_t NumChunks(const size_t n)
+	{
+		if (ThreadPool::NumThreads() <= 1)
+		{
+			return 1;
+		}
+		return (n + PointsPerChunk - 1) / PointsPerChunk;
+	}
+
+	//
+	// Chains of transforms are scanned in blocks of this many transforms. A block of double
+	// transforms is read twice, once for its composite and once for its prefixes, and at
+	// this length it is still in L2 the second time.
+	//
+	const size_t TransformsPerBlock = 2048;
+
+	//
+	// A transform as the two rows of the 2x3 matrix [L | t]. Composing onto it is
+	//      row_i' = l_i0 * row_0 + l_i1 * row_1 + (0, 0, t_i)
+	// with (l, t) the later transform, so the running composite of a chain stays in registers
+	// and each row is updated with whole-row multiply-adds.
+	//
+	// The rows are left to the compiler rather than packed into simd::Vec: three coefficients
+	// fill no Vec width, and each step waits for the one before it, which vectors over the
+	// coefficients do not shorten. Independent chains are what speed it up, see ComposeRange.
+	//
+	template <typename T>
+	struct AffineRows
+	{
+		T r[2][3];
+	};
+
+	template <typename T>
+	inline AffineRows<T> LoadRows(const BasicAffineTransformParams<T>& atp)
+	{
+		const T* l = atp.LinearMap().Data();
+		const T* t = atp.Translation().Data();
+		AffineRows<T> rows = {{{l[0], l[1], t[0]}, {l[2], l[3], t[1]}}};
+		return rows;
+	}
+
+	template <typename T>
+	inline void StoreRows(const AffineRows<T>& rows, BasicAffineTransformParams<T>& atp)
+	{
+		T* l = atp.LinearMap().Data();
+		T* t = atp.Translation().Data();
+		l[0] = rows.r[0][0];
+		l[1] = rows.r[0][1];
+		l[2] = rows.r[1][0];
+		l[3] = rows.r[1][1];
+		t[0] = rows.r[0][2];
+		t[1] = rows.r[1][2];
+	}
+
+	/// \brief      next( first( point ) ), rounded as CombineAffineTransform rounds it.
+	template <typename T>
+	inline AffineRows<T> Then(const AffineRows<T>& first, const AffineRows<T>& next)
+	{
+		AffineRows<T> rows;
+		for (int i = 0; i < 2; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				rows.r[i][j] = next.r[i][0] * first.r[0][j] + next.r[i][1] * first.r[1][j];
+			}
+			rows.r[i][2] += next.r[i][2];
+		}
+		return rows;
+	}
+
+	/// \brief      Composite of the transforms [begin, end). Each step of a fold waits for the
+	///             one before it, so four quarters of the range are folded side by side and
+	///             then composed pairwise.
+	template <typename T>
+	AffineRows<T> ComposeRange(const BasicAffineTransformParams<T>* atps,
+	                           const size_t begin, const size_t end)
+	{
+		const size_t quarter = (end - begin) / 4;
+		if (quarter < 2)
+		{
+			AffineRows<T> composite = LoadRows(atps[begin]);
+			for (size_t i = begin + 1; i < end; i++)
+			{
+				composite = Then(composite, LoadRows(atps[i]));
+			}
+			return composite;
+		}
+
+		const BasicAffineTransformParams<T>* q0 = atps + begin;
+		const BasicAffineTransformParams<T>* q1 = q0 + quarter;
+		const BasicAffineTransformParams<T>* q2 = q1 + quarter;
+		const BasicAffineTransformParams<T>* q3 = q2 + quarter;
+		AffineRows<T> c0 = LoadRows(q0[0]);
+		AffineRows<T> c1 = LoadRows(q1[0]);
+		AffineRows<T> c2 = LoadRows(q2[0]);
+		AffineRows<T> c3 = LoadRows(q3[0]);
+		for (size_t i = 1; i < quarter; i++)
+		{
+			c0 = Then(c0, LoadRows(q0[i]));
+			c1 = Then(c1, LoadRows(q1[i]));
+			c2 = Then(c2, LoadRows(q2[i]));
+			c3 = Then(c3, LoadRows(q3[i]));
+		}
+		for (size_t i = begin + 4 * quarter; i < end; i++)
+		{
+			c3 = Then(c3, LoadRows(atps[i]));
+		}
+		return Then(Then(c0, c1), Then(c2, c3));
+	}
+
+	/// \brief      Prefixes of block b, starting from offset, the composite of the blocks
+	///             before it. Block b may be written in place once its composite is taken.
+	template <typename T>
+	void ScanBlock(const size_t n, const BasicAffineTransformParams<T>* atps,
+	               BasicAffineTransformParams<T>* prefixes, const size_t b,
+	               const AffineRows<T>& offset)
+	{
+		const size_t begin = b * TransformsPerBlock;
+		const size_t end = std::min(n, begin + TransformsPerBlock);
+		AffineRows<T> running = LoadRows(atps[begin]);
+		if (b > 0)
+		{
+			running = Then(offset, running);
+		}
+		StoreRows(running, prefixes[begin]);
+		for (size_t i = begin + 1; i < end; i++)
+		{
+			running = Then(running, LoadRows(atps[i]));
+			StoreRows(running, prefixes[i]);
+		}
+	}
+
+	/// \brief      offsets[b] is the composite of blocks [0, b), for b in [1, numOffsets).
+	///             offsets[0] is unused.
+	template <typename T>
+	void BlockOffsets(const size_t n, const BasicAffineTransformParams<T>* atps,
+	                  const size_t numOffsets, std::vector<AffineRows<T> >& offsets)
+	{
+		offsets.resize(numOffsets);
+		if (numOffsets <= 1)
+		{
+			return;
+		}
+
+		//
+		// offsets[b + 1] first holds the composite of block b alone, then the chain is folded.
+		//
+		const auto blockComposite = [&](size_t b)
+		{
+			const size_t begin = b * TransformsPerBlock;
+			offsets[b + 1] = ComposeRange(atps, begin, std::min(n, begin + TransformsPerBlock));
+		};
+		if (ThreadPool::NumThreads() > 1)
+		{
+			ThreadPool::Instance().ParallelFor(numOffsets - 1, blockComposite);
+		}
+		else
+		{
+			for (size_t b = 0; b + 1 < numOffsets; b++)
+			{
+				blockComposite(b);
+			}
+		}
+		for (size_t b = 2; b < numOffsets; b++)
+		{
+			offsets[b] = Then(offsets[b - 1], offsets[b]);
+		}
+	}
+}
+
+
+template <typename T>
+void numeric::AffineTransform(const BasicAffineTransformParams<T>& atp,
+                             const BasicMatrix<T>& p,
+                             BasicMatrix<T>& trans_p)
 {
 	//
 	// Sanity check. Assume that the atp is OK
 	//
-	if (!(p.Rows() == 2 && p.Cols() == 1 && trans_p.Rows() == 2 && trans_p.Cols() == 1))
+	if (!(p.Rows() == 2 && trans_p.Rows() == 2 && p.Cols() == trans_p.Cols()))
+	{
+		throw std::invalid_argument("Points must be 2*n matrices of the same size.");
+	}
+
+	//
+	// L * p + t would be a Gemm with an inner dimension of 2, where packing costs more than
+	// the arithmetic, after a pass that fills trans_p with t. The point kernel does it all in
+	// one streaming pass and lets trans_p be p; on 2^20 points it is about five times faster.
+	//
+	const size_t n = p.Cols();
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpAffineTransform, 2 * n, 8 * static_cast<std::uint64_t>(n));
+	AffineTransformPoints(atp, n, p.Data(), p.Data() + n, trans_p.Data(), trans_p.Data() + n);
+}
+
+
+template <typename T>
+void numeric::AffineTransform(const BasicAffineTransformParams<T>& atp,
+                             const FixedMatrix<T, 2, 1>& p,
+                             FixedMatrix<T, 2, 1>& trans_p)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpAffineTransformPoint, 2, 8);
+	//
+	// trans_p may be p, so the point is built in a local first.
+	//
+	FixedMatrix<T, 2, 1> result = atp.Translation();
+	FixedMatrix<T, 2, 1>::Gemm(T(1), atp.LinearMap(), p, T(1), result);
+	trans_p = result;
+}
+
+
+template <typename T>
+void numeric::AffineTransformPoints(const BasicAffineTransformParams<T>& atp,
+                                   const size_t n,
+                                   const T* x,
+                                   const T* y,
+                                   T* trans_x,
+                                   T* trans_y)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpAffineTransformPoints, 2 * n, 8 * static_cast<std::uint64_t>(n));
+	const T* linearMap = atp.LinearMap().Data();
+	const T* translation = atp.Translation().Data();
+	const size_t numChunks = NumChunks(n);
+	if (numChunks <= 1)
+	{
+		kernel::AffinePoints<T>(n, linearMap, translation, x, y, trans_x, trans_y);
+		return;
+	}
+
+	ThreadPool::Instance().ParallelFor(numChunks, [=](size_t chunk)
+	{
+		const size_t begin = chunk * PointsPerChunk;
+		const size_t count = std::min(PointsPerChunk, n - begin);
+		kernel::AffinePoints<T>(count, linearMap, translation, x + begin, y + begin,
+		                        trans_x + begin, trans_y + begin);
+	});
+}
+
+
+template <typename T>
+void numeric::AffineTransformPoints(const BasicAffineTransformParams<T>& atp,
+                                   const size_t n,
+                                   const T* xy,
+                                   T* trans_xy)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpAffineTransformPoints, 2 * n, 8 * static_cast<std::uint64_t>(n));
+	const T* linearMap = atp.LinearMap().Data();
+	const T* translation = atp.Translation().Data();
+	const size_t numChunks = NumChunks(n);
+	if (numChunks <= 1)
 	{
-		throw std::invalid_argument("Points must be 2*1 matrices.");
+		kernel::AffinePointsInterleaved<T>(n, linearMap, translation, xy, trans_xy);
+		return;
 	}
 
-	trans_p = atp.LinearMap()*p + atp.Translation();
+	ThreadPool::Instance().ParallelFor(numChunks, [=](size_t chunk)
+	{
+		const size_t begin = chunk * PointsPerChunk;
+		const size_t count = std::min(PointsPerChunk, n - begin);
+		kernel::AffinePointsInterleaved<T>(count, linearMap, translation, xy + 2 * begin,
+		                                   trans_xy + 2 * begin);
+	});
 }
 
 
 //
-// Note: If the class Matrix contains a matrix inverse method, the implementation of the following
-// function would be straightforward. 
+// Note: General inverses are provided by BasicLUDecomposition (LUDecomposition.hpp). For the 2x2
+// linear map the closed form below is cheaper and needs no allocation.
 //
-bool numeric::InverseAffineTransform(AffineTransformParams& atp, AffineTransformParams& inv_atp)
+template <typename T>
+bool numeric::InverseAffineTransform(const BasicAffineTransformParams<T>& atp,
+                                     BasicAffineTransformParams<T>& inv_atp)
 {
 	//
 	// Sanity check. Assume that both atps are OK.
 	//
-
-	double val = atp.LinearMap()(0, 0)*atp.LinearMap()(1, 1) -
-		atp.LinearMap()(0, 1)*atp.LinearMap()(1, 0);
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpInverseAffineTransform, 6, 14);
+	const typename BasicAffineTransformParams<T>::LinearMapType& a = atp.LinearMap();
+	const T val = a(0, 0)*a(1, 1) - a(0, 1)*a(1, 0);
 
 	if (std::abs(val) < 1e-20)
 	{
 		return false;
 	}
 
-	inv_atp.LinearMap()(0, 0) = atp.LinearMap()(1, 1) / val;
-	inv_atp.LinearMap()(0, 1) = -atp.LinearMap()(0, 1) / val;
-	inv_atp.LinearMap()(1, 0) = -atp.LinearMap()(1, 0) / val;
-	inv_atp.LinearMap()(1, 1) = atp.LinearMap()(0, 0) / val;
-
-	inv_atp.Translation()(0, 0) = -atp.Translation()(0, 0)*inv_atp.LinearMap()(0, 0)
-		- atp.Translation()(1, 0)*inv_atp.LinearMap()(0, 1);
-	inv_atp.Translation()(1, 0) = -atp.Translation()(0, 0)*inv_atp.LinearMap()(1, 0)
-		- atp.Translation()(1, 0)*inv_atp.LinearMap()(1, 1);
+	//
+	// Build the result on the stack first, so that atp and inv_atp may be the same object.
+	//
+	BasicAffineTransformParams<T> inv(a(1, 1) / val, -a(0, 1) / val, -a(1, 0) / val, a(0, 0) / val, 0, 0);
+	FixedMatrix<T, 2, 1>::Gemm(T(-1), inv.LinearMap(), atp.Translation(), T(0), inv.Translation());
+	inv_atp = inv;
 	return true;
 }
 
-void numeric::CombineAffineTransform(AffineTransformParams& atp0,
-	                             AffineTransformParams& atp1,
-	                             AffineTransformParams& atp01)
+template <typename T>
+void numeric::CombineAffineTransform(const BasicAffineTransformParams<T>& atp0,
+	                                 const BasicAffineTransformParams<T>& atp1,
+	                                 BasicAffineTransformParams<T>& atp01)
+{
+	//
+	// Both parts are computed before atp01 is written, so it may alias atp0 or atp1.
+	//
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpCombineAffineTransform, 6, 20);
+	typename BasicAffineTransformParams<T>::LinearMapType linearMap;
+	FixedMatrix<T, 2, 2>::Gemm(T(1), atp1.LinearMap(), atp0.LinearMap(), T(0), linearMap);
+	typename BasicAffineTransformParams<T>::TranslationType translation = atp1.Translation();
+	FixedMatrix<T, 2, 1>::Gemm(T(1), atp1.LinearMap(), atp0.Translation(), T(1), translation);
+	atp01.LinearMap() = linearMap;
+	atp01.Translation() = translation;
+}
+
+
+template <typename T>
+void numeric::CombineAffineTransformPrefixes(const size_t n,
+                                             const BasicAffineTransformParams<T>* atps,
+                                             BasicAffineTransformParams<T>* prefixes)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpCombineAffineTransformPrefixes, 6 * n,
+	                             20 * static_cast<std::uint64_t>(n));
+	if (n == 0)
+	{
+		return;
+	}
+
+	const size_t numBlocks = (n + TransformsPerBlock - 1) / TransformsPerBlock;
+	if (numBlocks == 1 || ThreadPool::NumThreads() <= 1)
+	{
+		//
+		// On one thread each block is composed and then scanned while it is still in cache.
+		// The offsets are chained exactly as BlockOffsets chains them.
+		//
+		AffineRows<T> offset = AffineRows<T>();
+		for (size_t b = 0; b < numBlocks; b++)
+		{
+			const size_t begin = b * TransformsPerBlock;
+			AffineRows<T> composite = offset;
+			if (b + 1 < numBlocks)
+			{
+				composite = ComposeRange(atps, begin, begin + TransformsPerBlock);
+			}
+			ScanBlock(n, atps, prefixes, b, offset);
+			offset = b == 0 ? composite : Then(offset, composite);
+		}
+		return;
+	}
+
+	//
+	// Every block composite is taken before any block is written, so prefixes may be atps.
+	//
+	std::vector<AffineRows<T> > offsets;
+	BlockOffsets(n, atps, numBlocks, offsets);
+	ThreadPool::Instance().ParallelFor(numBlocks, [&](size_t b)
+	{
+		ScanBlock(n, atps, prefixes, b, offsets[b]);
+	});
+}
+
+
+template <typename T>
+void numeric::CombineAffineTransforms(const size_t n,
+                                      const BasicAffineTransformParams<T>* atps,
+                                      BasicAffineTransformParams<T>& result)
 {
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpCombineAffineTransforms, 6 * n,
+	                             20 * static_cast<std::uint64_t>(n));
+	if (n == 0)
+	{
+		result = BasicAffineTransformParams<T>(T(1), T(0), T(0), T(1), T(0), T(0));
+		return;
+	}
+
 	//
-	// Sanity check.
+	// The composites of all blocks but the last are chained as in the prefix scan, and the
+	// last block is folded onto them, so the result is bitwise the last prefix.
 	//
-	atp01.LinearMap() = atp1.LinearMap() * atp0.LinearMap();
-	atp01.Translation() = atp1.Translation() + atp1.LinearMap()*atp0.Translation();
+	const size_t numBlocks = (n + TransformsPerBlock - 1) / TransformsPerBlock;
+	std::vector<AffineRows<T> > offsets;
+	BlockOffsets(n, atps, numBlocks, offsets);
+
+	const size_t begin = (numBlocks - 1) * TransformsPerBlock;
+	AffineRows<T> composite = LoadRows(atps[begin]);
+	if (numBlocks > 1)
+	{
+		composite = Then(offsets[numBlocks - 1], composite);
+	}
+	for (size_t i = begin + 1; i < n; i++)
+	{
+		composite = Then(composite, LoadRows(atps[i]));
+	}
+	StoreRows(composite, result);
 }
 
 
+#define NUMERIC_INSTANTIATE_AFFINE(T)                                                          \
+	template void numeric::AffineTransform<T>(const BasicAffineTransformParams<T>&,            \
+	                                          const BasicMatrix<T>&, BasicMatrix<T>&);         \
+	template void numeric::AffineTransform<T>(const BasicAffineTransformParams<T>&,            \
+	                                          const FixedMatrix<T, 2, 1>&,                     \
+	                                          FixedMatrix<T, 2, 1>&);                          \
+	template void numeric::AffineTransformPoints<T>(const BasicAffineTransformParams<T>&,      \
+	                                                const size_t, const T*, const T*,          \
+	                                                T*, T*);                                   \
+	template void numeric::AffineTransformPoints<T>(const BasicAffineTransformParams<T>&,      \
+	                                                const size_t, const T*, T*);               \
+	template void numeric::CombineAffineTransform<T>(const BasicAffineTransformParams<T>&,     \
+	                                                 const BasicAffineTransformParams<T>&,     \
+	                                                 BasicAffineTransformParams<T>&);          \
+	template void numeric::CombineAffineTransformPrefixes<T>(const size_t,                     \
+	                                                         const BasicAffineTransformParams<T>*, \
+	                                                         BasicAffineTransformParams<T>*);  \
+	template void numeric::CombineAffineTransforms<T>(const size_t,                            \
+	                                                  const BasicAffineTransformParams<T>*,    \
+	                                                  BasicAffineTransformParams<T>&);
+
+NUMERIC_INSTANTIATE_AFFINE(float)
+NUMERIC_INSTANTIATE_AFFINE(double)
+NUMERIC_INSTANTIATE_AFFINE(std::int32_t)
 
+#undef NUMERIC_INSTANTIATE_AFFINE
+
+//
+// The inverse divides by the determinant, so it is only provided for floating-point types.
+//
+template bool numeric::InverseAffineTransform<float>(const BasicAffineTransformParams<float>&,
+                                                     BasicAffineTransformParams<float>&);
+template bool numeric::InverseAffineTransform<double>(const BasicAffineTransformParams<double>&,
+                                                      BasicAffineTransformParams<double>&);
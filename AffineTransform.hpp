@@ -1,29 +1,95 @@
 #ifndef AffineTransform_Hpp
 #define AffineTransform_Hpp
 
+#include <cstddef>
 #include "Matrix.hpp"
+#include "FixedMatrix.hpp"
 #include "AffineTransformParams.hpp"
 
 namespace numeric
 {
 	//
-	// Function : Apply affine transform
+	// Function : Apply affine transform. Instantiated for float, double and std::int32_t.
+	//      p holds one point per column, row 0 the x and row 1 the y coordinates, so a 2*n
+	//      matrix is transformed in one batch (see AffineTransformPoints). trans_p must have
+	//      the same shape and may be p.
 	//
-	void AffineTransform(AffineTransformParams& atp, Matrix& p, Matrix& trans_p);
+	template <typename T>
+	void AffineTransform(const BasicAffineTransformParams<T>& atp,
+	                     const BasicMatrix<T>& p,
+	                     BasicMatrix<T>& trans_p);
 
 	//
-	// Function : Inverse an affine transform
+	// Function : Apply affine transform to a fixed-size point, without any allocation.
 	//
-	bool InverseAffineTransform(AffineTransformParams& atp, AffineTransformParams& inv_atp);
+	template <typename T>
+	void AffineTransform(const BasicAffineTransformParams<T>& atp,
+	                     const FixedMatrix<T, 2, 1>& p,
+	                     FixedMatrix<T, 2, 1>& trans_p);
 
 	//
-	// Function : Compose two affine transforms
+	// Function : Apply affine transform to n points stored as separate coordinate arrays.
+	//      The outputs may be the inputs (in place) but must not otherwise overlap them. The
+	//      work is vectorised and, for large n, split across the ThreadPool.
+	//
+	template <typename T>
+	void AffineTransformPoints(const BasicAffineTransformParams<T>& atp,
+	                           const size_t n,
+	                           const T* x,
+	                           const T* y,
+	                           T* trans_x,
+	                           T* trans_y);
+
+	//
+	// Function : Apply affine transform to n interleaved points, xy = (x0, y0, x1, y1, ...).
+	//      trans_xy may be xy.
+	//
+	template <typename T>
+	void AffineTransformPoints(const BasicAffineTransformParams<T>& atp,
+	                           const size_t n,
+	                           const T* xy,
+	                           T* trans_xy);
+
+	//
+	// Function : Inverse an affine transform. Instantiated for float and double.
+	//
+	template <typename T>
+	bool InverseAffineTransform(const BasicAffineTransformParams<T>& atp,
+	                            BasicAffineTransformParams<T>& inv_atp);
+
+	//
+	// Function : Compose two affine transforms. Instantiated for float, double and std::int32_t.
 	//      trans_point = atp1( atp0( point ) )
 	//      trans_point = atp01( point )
 	//
-	void CombineAffineTransform(AffineTransformParams& atp0,
-		                    AffineTransformParams& atp1,
-		                    AffineTransformParams& atp01);
+	template <typename T>
+	void CombineAffineTransform(const BasicAffineTransformParams<T>& atp0,
+		                        const BasicAffineTransformParams<T>& atp1,
+		                        BasicAffineTransformParams<T>& atp01);
+
+	//
+	// Function : All the prefix compositions of a chain of n transforms,
+	//      prefixes[i] = atps[i]( ... atps[1]( atps[0]( point ) ) ... )
+	//      The chain is cut into blocks of a fixed length. The composite of each block is taken
+	//      in parallel, the composites are chained serially, and each block is then scanned
+	//      in parallel from the composite of the blocks before it. The blocks do not depend on
+	//      the number of threads, so neither do the results. prefixes may be atps.
+	//      Instantiated for float, double and std::int32_t.
+	//
+	template <typename T>
+	void CombineAffineTransformPrefixes(const size_t n,
+	                                    const BasicAffineTransformParams<T>* atps,
+	                                    BasicAffineTransformParams<T>* prefixes);
+
+	//
+	// Function : Composition of a whole chain, equal to the last prefix of
+	//      CombineAffineTransformPrefixes without storing the others. An empty chain gives the
+	//      identity.
+	//
+	template <typename T>
+	void CombineAffineTransforms(const size_t n,
+	                             const BasicAffineTransformParams<T>* atps,
+	                             BasicAffineTransformParams<T>& result);
 }
 
 #endif 
@@ -1,4 +1,5 @@
 #include "AffineTransformParams.hpp"
+#include <cstdint>
 
 using namespace numeric;
 
@@ -6,42 +7,42 @@ using namespace numeric;
 //Implementation of AffineTransformParams
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 //
-// Friend function. Note that this implementation is practical only when AffineTransformParams is 
-// small so that the copy constructor won't cost too much time. 
+// Free function. The parameters are stored inline, so the result is returned without any
+// allocation.
 //
-AffineTransformParams numeric::operator + (const AffineTransformParams& lh,
-	                                       const AffineTransformParams& rh)
+template <typename T>
+BasicAffineTransformParams<T> numeric::operator + (const BasicAffineTransformParams<T>& lh,
+	                                               const BasicAffineTransformParams<T>& rh)
 {
-	//
-	// Sanity check
-	//	
-	Matrix linearmap = lh.LinearMap() + rh.LinearMap();
-	Matrix translation = lh.Translation() + rh.Translation();
-	AffineTransformParams sumAtp(linearmap, translation);
-	return sumAtp;
+	return BasicAffineTransformParams<T>(lh.LinearMap() + rh.LinearMap(),
+	                                     lh.Translation() + rh.Translation());
 }
 
 
 //
 // Member functions 
 //
-void AffineTransformParams::Add(AffineTransformParams& lh,
-	                            AffineTransformParams& rh,
-                                AffineTransformParams& result)
+template <typename T>
+void BasicAffineTransformParams<T>::Add(const BasicAffineTransformParams& lh,
+	                                    const BasicAffineTransformParams& rh,
+                                        BasicAffineTransformParams& result)
 {
-	result.SetLinearMap(lh.LinearMap() + rh.LinearMap());
-	result.SetTranslation(lh.Translation() + rh.Translation());
+	result.LinearMap() = lh.LinearMap() + rh.LinearMap();
+	result.Translation() = lh.Translation() + rh.Translation();
 }
 
 
-AffineTransformParams::AffineTransformParams()
+template <typename T>
+BasicAffineTransformParams<T>::BasicAffineTransformParams()
 {
-	m_pLinearMap = 0;
-	m_pTranslation = 0;
-	this->AllocMemory();
+	LinearMapType::Zero(m_linearMap);
+	TranslationType::Zero(m_translation);
 }
 
-AffineTransformParams::AffineTransformParams(Matrix& linearMap, Matrix& translation)
+
+template <typename T>
+BasicAffineTransformParams<T>::BasicAffineTransformParams(const Matrix& linearMap,
+                                                          const Matrix& translation)
 {
 	//
 	// Sanity check
@@ -54,65 +55,45 @@ AffineTransformParams::AffineTransformParams(Matrix& linearMap, Matrix& translat
 	//
 	// Copy values instead of passing inferences.
 	//
-	this->AllocMemory();
-	(*m_pLinearMap) = linearMap;
-	(*m_pTranslation) = translation;
+	m_linearMap = LinearMapType(linearMap);
+	m_translation = TranslationType(translation);
 }
 
-AffineTransformParams::AffineTransformParams(AtpType m00,
-											 AtpType m01,
-											 AtpType m10,
-											 AtpType m11,
-											 AtpType dx,
-											 AtpType dy)
-{
-	this->AllocMemory();
-	(*m_pLinearMap)(0, 0) = m00;
-	(*m_pLinearMap)(0, 1) = m01;
-	(*m_pLinearMap)(1, 0) = m10;
-	(*m_pLinearMap)(1, 1) = m11;
-	(*m_pTranslation)(0, 0) = dx;
-	(*m_pTranslation)(1, 0) = dy;
-}
 
-
-AffineTransformParams::AffineTransformParams(const AffineTransformParams& atp)
+template <typename T>
+BasicAffineTransformParams<T>::BasicAffineTransformParams(const LinearMapType& linearMap,
+                                                          const TranslationType& translation)
+	: m_linearMap(linearMap),
+	  m_translation(translation)
 {
-	this->AllocMemory();
-	(*m_pLinearMap) = atp.LinearMap();
-	(*m_pTranslation) = atp.Translation();
 }
 
 
-AffineTransformParams::~AffineTransformParams()
+template <typename T>
+BasicAffineTransformParams<T>::BasicAffineTransformParams(AtpType m00,
+													      AtpType m01,
+													      AtpType m10,
+													      AtpType m11,
+													      AtpType dx,
+													      AtpType dy)
 {
-	this->ReleaseMemory();
+	m_linearMap(0, 0) = m00;
+	m_linearMap(0, 1) = m01;
+	m_linearMap(1, 0) = m10;
+	m_linearMap(1, 1) = m11;
+	m_translation(0, 0) = dx;
+	m_translation(1, 0) = dy;
 }
 
 
-void AffineTransformParams::AllocMemory()
+template <typename T>
+BasicAffineTransformParams<T>::~BasicAffineTransformParams()
 {
-	try
-	{
-		m_pLinearMap = new Matrix(2, 2);
-		m_pTranslation = new Matrix(2, 1);
-	}
-	catch (std::bad_alloc& exc)
-	{
-		this->ReleaseMemory();
-		//throw std::bad_alloc("AffineTransformParams::AllocMemory Failed");
-		throw exc;
-	}
-}
-
-void AffineTransformParams::ReleaseMemory()
-{
-	delete m_pLinearMap;
-	delete m_pTranslation;
 }
 
 
-bool AffineTransformParams::IsThisLinearMap(Matrix& mat)
+template <typename T>
+bool BasicAffineTransformParams<T>::IsThisLinearMap(const Matrix& mat)
 {
 	if (mat.Rows() == 2 && mat.Cols() == 2)
 	{
@@ -121,7 +102,8 @@ bool AffineTransformParams::IsThisLinearMap(Matrix& mat)
 	return false;
 }
 
-bool AffineTransformParams::IsThisTranslation(Matrix& mat)
+template <typename T>
+bool BasicAffineTransformParams<T>::IsThisTranslation(const Matrix& mat)
 {
 	if (mat.Rows() == 2 && mat.Cols() == 1)
 	{
@@ -131,9 +113,13 @@ bool AffineTransformParams::IsThisTranslation(Matrix& mat)
 }
 
 
-AffineTransformParams& AffineTransformParams::operator = (const AffineTransformParams& atp)
-{
-	(*m_pLinearMap) = atp.LinearMap();
-	(*m_pTranslation) = atp.Translation();
-	return (*this);
-}
+#define NUMERIC_INSTANTIATE_ATP(T)                                                             \
+	template class numeric::BasicAffineTransformParams<T>;                                     \
+	template BasicAffineTransformParams<T> numeric::operator+ <T>(                             \
+		const BasicAffineTransformParams<T>&, const BasicAffineTransformParams<T>&);
+
+NUMERIC_INSTANTIATE_ATP(float)
+NUMERIC_INSTANTIATE_ATP(double)
+NUMERIC_INSTANTIATE_ATP(std::int32_t)
+
+#undef NUMERIC_INSTANTIATE_ATP
@@ -4,62 +4,83 @@
 #include <iostream>
 #include <stdexcept>
 #include "Matrix.hpp"
-#include "AffineTransformParams.hpp"
+#include "FixedMatrix.hpp"
 
 namespace numeric
 {
 
-	#define AtpType double
+	template <typename T> class BasicAffineTransformParams;
 
 	//
-	// Class : Affine transform parameters
+	// Note: This is NOT the composition of two transforms
 	//
-	class AffineTransformParams
+	template <typename T>
+	BasicAffineTransformParams<T> operator+(const BasicAffineTransformParams<T>& lh,
+	                                        const BasicAffineTransformParams<T>& rh);
+
+	//
+	// Class : Affine transform parameters over the element type T. Instantiated for float,
+	//      double and std::int32_t.
+	//
+	// The linear map and the translation are fixed-size matrices stored inline, so creating,
+	// copying and composing transforms never allocates.
+	//
+	template <typename T>
+	class BasicAffineTransformParams
 	{        
-		//
-		// Note: This is NOT the composition of two transforms
-		//
-		friend AffineTransformParams operator+(const AffineTransformParams& lh,
-											   const AffineTransformParams& rh);
 	public:
-		static void Add(AffineTransformParams& lh,
-			            AffineTransformParams& rh,
-			            AffineTransformParams& result);
+		typedef T                     AtpType;
+		typedef BasicMatrix<T>        Matrix;
+		typedef FixedMatrix<T, 2, 2>  LinearMapType;
+		typedef FixedMatrix<T, 2, 1>  TranslationType;
+
+		static void Add(const BasicAffineTransformParams& lh,
+			            const BasicAffineTransformParams& rh,
+			            BasicAffineTransformParams& result);
 
 	public:
-		AffineTransformParams();
-		AffineTransformParams(const AffineTransformParams&);
-		AffineTransformParams(Matrix& linearMap, Matrix& translation);
-		AffineTransformParams(AtpType m00,
-							  AtpType m01,
-							  AtpType m10,
-							  AtpType m11,
-							  AtpType dx,
-							  AtpType dy);
-		virtual ~AffineTransformParams();
-		AffineTransformParams& operator=(const AffineTransformParams& atp);
+		BasicAffineTransformParams();
+		BasicAffineTransformParams(const Matrix& linearMap, const Matrix& translation);
+		BasicAffineTransformParams(const LinearMapType& linearMap, const TranslationType& translation);
+		BasicAffineTransformParams(AtpType m00,
+							       AtpType m01,
+							       AtpType m10,
+							       AtpType m11,
+							       AtpType dx,
+							       AtpType dy);
+		virtual ~BasicAffineTransformParams();
 
 		//
 		// accessors. More convenient but probably less safer
 		//
-		inline Matrix& LinearMap() const
+		inline LinearMapType& LinearMap()
 		{
-			return (*m_pLinearMap);
+			return m_linearMap;
 		}
 
-		inline Matrix& Translation() const
+		inline const LinearMapType& LinearMap() const
 		{
-			return (*m_pTranslation);
+			return m_linearMap;
+		}
+
+		inline TranslationType& Translation()
+		{
+			return m_translation;
+		}
+
+		inline const TranslationType& Translation() const
+		{
+			return m_translation;
 		}
 
 		//
 		// accessors. 
 		//
-		inline void SetLinearMap(Matrix& alinearmap)
+		inline void SetLinearMap(const Matrix& alinearmap)
 		{
 			if (IsThisLinearMap(alinearmap))
 			{
-				(*m_pLinearMap) = alinearmap;
+				m_linearMap = LinearMapType(alinearmap);
 			}
 			else
 			{
@@ -67,16 +88,21 @@ namespace numeric
 			}
 		}
 
-		inline const Matrix& GetLinearMap() const
+		inline void SetLinearMap(const LinearMapType& alinearmap)
+		{
+			m_linearMap = alinearmap;
+		}
+
+		inline const LinearMapType& GetLinearMap() const
 		{
-			return (*m_pLinearMap);
+			return m_linearMap;
 		}
 
-		inline void SetTranslation(Matrix& atranslation)
+		inline void SetTranslation(const Matrix& atranslation)
 		{
 			if (IsThisTranslation(atranslation))
 			{
-				(*m_pTranslation) = atranslation;
+				m_translation = TranslationType(atranslation);
 			}
 			else
 			{
@@ -84,22 +110,26 @@ namespace numeric
 			}
 		}
 
-		inline const Matrix& GetTranslation() const
+		inline void SetTranslation(const TranslationType& atranslation)
 		{
-			return (*m_pTranslation);
+			m_translation = atranslation;
 		}
 
-	protected:
-		virtual void AllocMemory();
-		virtual void ReleaseMemory();
+		inline const TranslationType& GetTranslation() const
+		{
+			return m_translation;
+		}
 
-		static bool IsThisLinearMap(Matrix& mat);
-		static bool IsThisTranslation(Matrix& mat);
+	protected:
+		static bool IsThisLinearMap(const Matrix& mat);
+		static bool IsThisTranslation(const Matrix& mat);
 
 	private:
-		Matrix* m_pLinearMap;
-		Matrix* m_pTranslation;
+		LinearMapType   m_linearMap;
+		TranslationType m_translation;
 	};	
+
+	typedef BasicAffineTransformParams<double> AffineTransformParams;
 }
 
 #endif
@@ -0,0 +1,377 @@
+
+#include "Allocator.hpp"
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of Allocator
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	std::atomic<Allocator*> g_default(NULL);
+	thread_local Allocator* t_current = NULL;
+
+	size_t RoundUp(const size_t bytes, const size_t multiple)
+	{
+		return (bytes + multiple - 1) / multiple * multiple;
+	}
+
+	//
+	// Index of the highest set bit, for bytes > 0.
+	//
+	size_t Log2Floor(size_t bytes)
+	{
+		size_t log = 0;
+		while (bytes >>= 1)
+		{
+			log++;
+		}
+		return log;
+	}
+}
+
+
+Allocator::~Allocator()
+{
+}
+
+
+/// \brief  Return the process-wide allocator. The built-in pool is never destroyed, so
+///         matrices with static storage duration can still release into it at exit.
+Allocator* Allocator::Default()
+{
+	Allocator* allocator = g_default.load();
+	if (allocator == NULL)
+	{
+		static PoolAllocator* pool = new PoolAllocator();
+		allocator = pool;
+	}
+	return allocator;
+}
+
+
+/// \brief     Replace the process-wide allocator. NULL restores the built-in pool.
+/// \param[in] allocator. Must outlive every matrix allocated from it.
+void Allocator::SetDefault(Allocator* allocator)
+{
+	g_default.store(allocator);
+}
+
+
+/// \brief  Return the allocator used for matrices created on the calling thread.
+Allocator* Allocator::Current()
+{
+	return t_current != NULL ? t_current : Default();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of AlignedAllocator
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \brief     Allocate bytes aligned to Allocator::Alignment.
+/// \param[in] bytes. Size of the block, rounded up to a multiple of the alignment.
+/// \return    The block. Throws std::bad_alloc on failure.
+void* AlignedAllocator::AllocateAligned(const size_t bytes)
+{
+	const size_t size = RoundUp(bytes > 0 ? bytes : 1, Alignment);
+#if defined(_WIN32)
+	void* p = _aligned_malloc(size, Alignment);
+#else
+	void* p = NULL;
+	if (posix_memalign(&p, Alignment, size) != 0)
+	{
+		p = NULL;
+	}
+#endif
+	if (p == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+
+void AlignedAllocator::DeallocateAligned(void* p)
+{
+#if defined(_WIN32)
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+
+void* AlignedAllocator::Allocate(const size_t bytes, size_t& reserved)
+{
+	reserved = RoundUp(bytes, Alignment);
+	return AllocateAligned(reserved);
+}
+
+
+void AlignedAllocator::Deallocate(void* p, const size_t)
+{
+	DeallocateAligned(p);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of PoolAllocator
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \brief     Constructor.
+/// \param[in] maxCachedBytes. Upper bound on the bytes kept on the free lists.
+PoolAllocator::PoolAllocator(const size_t maxCachedBytes)
+	: m_freeLists(SizeClass(MaxPooledBytes) + 1),
+	  m_cachedBytes(0),
+	  m_maxCachedBytes(maxCachedBytes)
+{
+}
+
+
+PoolAllocator::~PoolAllocator()
+{
+	Trim();
+}
+
+
+/// \brief      Hand out a block from the free list of its size class, or a new one.
+/// \param[in]  bytes. Requested size.
+/// \param[out] reserved. Size of the class, which is the usable size of the block.
+void* PoolAllocator::Allocate(const size_t bytes, size_t& reserved)
+{
+	if (bytes > MaxPooledBytes)
+	{
+		reserved = RoundUp(bytes, Alignment);
+		return AlignedAllocator::AllocateAligned(reserved);
+	}
+
+	const size_t sizeClass = SizeClass(bytes);
+	reserved = ClassBytes(sizeClass);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::vector<void*>& freeList = m_freeLists[sizeClass];
+		if (!freeList.empty())
+		{
+			void* p = freeList.back();
+			freeList.pop_back();
+			m_cachedBytes -= reserved;
+			return p;
+		}
+	}
+	return AlignedAllocator::AllocateAligned(reserved);
+}
+
+
+void PoolAllocator::Deallocate(void* p, const size_t reserved)
+{
+	if (p == NULL)
+	{
+		return;
+	}
+
+	if (reserved <= MaxPooledBytes)
+	{
+		const size_t sizeClass = SizeClass(reserved);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_cachedBytes + reserved <= m_maxCachedBytes)
+		{
+			m_freeLists[sizeClass].push_back(p);
+			m_cachedBytes += reserved;
+			return;
+		}
+	}
+	AlignedAllocator::DeallocateAligned(p);
+}
+
+
+void PoolAllocator::Trim()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (size_t i = 0; i < m_freeLists.size(); i++)
+	{
+		for (size_t j = 0; j < m_freeLists[i].size(); j++)
+		{
+			AlignedAllocator::DeallocateAligned(m_freeLists[i][j]);
+		}
+		m_freeLists[i].clear();
+	}
+	m_cachedBytes = 0;
+}
+
+
+size_t PoolAllocator::CachedBytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_cachedBytes;
+}
+
+
+size_t PoolAllocator::MaxCachedBytes() const
+{
+	return m_maxCachedBytes;
+}
+
+
+/// \brief     Map a size to its class. Up to 256 bytes the classes are multiples of 64; above,
+///            each range (2^p, 2^(p+1)] is split into four classes of 2^(p-2) bytes.
+/// \param[in] bytes. Size, at most MaxPooledBytes.
+size_t PoolAllocator::SizeClass(const size_t bytes)
+{
+	if (bytes <= 256)
+	{
+		return bytes > 0 ? (bytes - 1) / 64 : 0;
+	}
+	const size_t p = Log2Floor(bytes - 1);
+	const size_t step = ((bytes - 1) - (size_t(1) << p)) >> (p - 2);
+	return 4 + (p - 8) * 4 + step;
+}
+
+
+size_t PoolAllocator::ClassBytes(const size_t sizeClass)
+{
+	if (sizeClass < 4)
+	{
+		return (sizeClass + 1) * 64;
+	}
+	const size_t p = (sizeClass - 4) / 4 + 8;
+	const size_t step = (sizeClass - 4) % 4;
+	return (size_t(1) << p) + (step + 1) * (size_t(1) << (p - 2));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of ArenaAllocator
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// \brief     Constructor. No memory is reserved until the first allocation.
+/// \param[in] chunkBytes. Minimum size of each chunk taken from the system.
+ArenaAllocator::ArenaAllocator(const size_t chunkBytes)
+	: m_chunkBytes(RoundUp(chunkBytes > 0 ? chunkBytes : 1, Alignment)),
+	  m_top(0),
+	  m_usedInFullChunks(0)
+{
+}
+
+
+ArenaAllocator::~ArenaAllocator()
+{
+	ReleaseChunks();
+}
+
+
+void* ArenaAllocator::Allocate(const size_t bytes, size_t& reserved)
+{
+	reserved = RoundUp(bytes > 0 ? bytes : 1, Alignment);
+	if (m_chunks.empty() || m_top + reserved > m_chunks.back().size)
+	{
+		AddChunk(reserved);
+	}
+
+	void* p = m_chunks.back().begin + m_top;
+	m_top += reserved;
+	return p;
+}
+
+
+/// \brief  Reclaim the block only when it is the most recent one, which covers the usual
+///         last-in first-out lifetime of temporaries.
+void ArenaAllocator::Deallocate(void* p, const size_t reserved)
+{
+	if (!m_chunks.empty() && static_cast<char*>(p) + reserved == m_chunks.back().begin + m_top)
+	{
+		m_top -= reserved;
+	}
+}
+
+
+void ArenaAllocator::Reset()
+{
+	if (m_chunks.size() > 1)
+	{
+		size_t total = 0;
+		for (size_t i = 0; i < m_chunks.size(); i++)
+		{
+			total += m_chunks[i].size;
+		}
+		ReleaseChunks();
+		AddChunk(total);
+	}
+	m_top = 0;
+	m_usedInFullChunks = 0;
+}
+
+
+size_t ArenaAllocator::BytesUsed() const
+{
+	return m_usedInFullChunks + m_top;
+}
+
+
+size_t ArenaAllocator::BytesReserved() const
+{
+	size_t total = 0;
+	for (size_t i = 0; i < m_chunks.size(); i++)
+	{
+		total += m_chunks[i].size;
+	}
+	return total;
+}
+
+
+void ArenaAllocator::AddChunk(const size_t bytes)
+{
+	Chunk chunk;
+	chunk.size = bytes > m_chunkBytes ? bytes : m_chunkBytes;
+	chunk.begin = static_cast<char*>(AlignedAllocator::AllocateAligned(chunk.size));
+	try
+	{
+		m_chunks.push_back(chunk);
+	}
+	catch (...)
+	{
+		AlignedAllocator::DeallocateAligned(chunk.begin);
+		throw;
+	}
+
+	if (m_chunks.size() > 1)
+	{
+		m_usedInFullChunks += m_top;
+	}
+	m_top = 0;
+}
+
+
+void ArenaAllocator::ReleaseChunks()
+{
+	for (size_t i = 0; i < m_chunks.size(); i++)
+	{
+		AlignedAllocator::DeallocateAligned(m_chunks[i].begin);
+	}
+	m_chunks.clear();
+	m_top = 0;
+	m_usedInFullChunks = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of ScopedAllocator
+///////////////////////////////////////////////////////////////////////////////////////////////////
+ScopedAllocator::ScopedAllocator(Allocator& allocator)
+	: m_previous(t_current)
+{
+	t_current = &allocator;
+}
+
+
+ScopedAllocator::~ScopedAllocator()
+{
+	t_current = m_previous;
+}
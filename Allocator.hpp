@@ -0,0 +1,160 @@
+#ifndef Numeric_Allocator_HPP
+#define Numeric_Allocator_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace numeric
+{
+	//
+	// Class : Interface for the storage behind Matrix buffers.
+	//
+	// Every block handed out is aligned to Alignment bytes so the SIMD kernels never straddle
+	// a cache line at the start of a row-major buffer. Allocate reports the number of bytes it
+	// actually reserved, which may be more than requested; the caller gives the same number
+	// back to Deallocate.
+	//
+	// New matrices draw from Allocator::Current(): the allocator installed on the calling
+	// thread by a ScopedAllocator, otherwise the process-wide default, which is a PoolAllocator
+	// unless replaced with SetDefault.
+	//
+	class Allocator
+	{
+	public:
+		static const size_t Alignment = 64;
+
+		static Allocator* Default();
+		static void       SetDefault(Allocator* allocator);
+		static Allocator* Current();
+
+	public:
+		virtual ~Allocator();
+
+		virtual void* Allocate(const size_t bytes, size_t& reserved) = 0;
+		virtual void  Deallocate(void* p, const size_t reserved) = 0;
+	};
+
+
+	//
+	// Class : Plain aligned heap allocation, one system call per block.
+	//
+	class AlignedAllocator : public Allocator
+	{
+	public:
+		static void* AllocateAligned(const size_t bytes);
+		static void  DeallocateAligned(void* p);
+
+	public:
+		virtual void* Allocate(const size_t bytes, size_t& reserved);
+		virtual void  Deallocate(void* p, const size_t reserved);
+	};
+
+
+	//
+	// Class : Thread-safe allocator that keeps freed blocks on per-size-class free lists, so
+	//      temporaries of the same shape reuse memory instead of going back to the system.
+	//
+	// Size classes are spaced four per power of two, which bounds the slack in a block to 25%.
+	// Blocks larger than MaxPooledBytes bypass the lists. At most MaxCachedBytes() are kept on
+	// the lists; beyond that freed blocks are returned to the system.
+	//
+	class PoolAllocator : public Allocator
+	{
+	public:
+		static const size_t MaxPooledBytes = size_t(1) << 28;
+
+	public:
+		PoolAllocator(const size_t maxCachedBytes = size_t(1) << 28);
+		virtual ~PoolAllocator();
+
+		virtual void* Allocate(const size_t bytes, size_t& reserved);
+		virtual void  Deallocate(void* p, const size_t reserved);
+
+		//
+		// Return every cached block to the system.
+		//
+		void   Trim();
+		size_t CachedBytes() const;
+		size_t MaxCachedBytes() const;
+
+	private:
+		PoolAllocator(const PoolAllocator&);
+		PoolAllocator& operator=(const PoolAllocator&);
+
+		static size_t SizeClass(const size_t bytes);
+		static size_t ClassBytes(const size_t sizeClass);
+
+	private:
+		mutable std::mutex              m_mutex;
+		std::vector<std::vector<void*>> m_freeLists;
+		size_t                          m_cachedBytes;
+		size_t                          m_maxCachedBytes;
+	};
+
+
+	//
+	// Class : Bump-pointer scratch allocator. Allocation is a pointer increment and Deallocate
+	//      only reclaims the most recent block; everything else is released in bulk by Reset.
+	//
+	// Warning : Matrices that draw from an arena must be destroyed before Reset() or before the
+	//           arena itself. An arena is not thread-safe; use one per thread.
+	//
+	class ArenaAllocator : public Allocator
+	{
+	public:
+		ArenaAllocator(const size_t chunkBytes = size_t(1) << 20);
+		virtual ~ArenaAllocator();
+
+		virtual void* Allocate(const size_t bytes, size_t& reserved);
+		virtual void  Deallocate(void* p, const size_t reserved);
+
+		//
+		// Release every block at once. When the arena grew past its first chunk, the chunks
+		// are merged into one so the next round of the same work needs no further chunks.
+		//
+		void   Reset();
+		size_t BytesUsed() const;
+		size_t BytesReserved() const;
+
+	private:
+		ArenaAllocator(const ArenaAllocator&);
+		ArenaAllocator& operator=(const ArenaAllocator&);
+
+		struct Chunk
+		{
+			char*  begin;
+			size_t size;
+		};
+
+		void AddChunk(const size_t bytes);
+		void ReleaseChunks();
+
+	private:
+		std::vector<Chunk> m_chunks;
+		size_t             m_chunkBytes;
+		size_t             m_top;
+		size_t             m_usedInFullChunks;
+	};
+
+
+	//
+	// Class : Install an allocator for matrices created on the calling thread for the lifetime
+	//      of this object. Guards nest; the previous allocator is restored on destruction.
+	//
+	class ScopedAllocator
+	{
+	public:
+		explicit ScopedAllocator(Allocator& allocator);
+		~ScopedAllocator();
+
+	private:
+		ScopedAllocator(const ScopedAllocator&);
+		ScopedAllocator& operator=(const ScopedAllocator&);
+
+	private:
+		Allocator* m_previous;
+	};
+}
+
+#endif
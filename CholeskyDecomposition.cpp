@@ -0,0 +1,226 @@
+
+#include "CholeskyDecomposition.hpp"
+#include "Gemm.hpp"
+#include "Triangular.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of CholeskyDecomposition
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Columns per panel, which is also the row height of the trailing GEMM updates.
+	//
+	const unsigned int PanelWidth = 128;
+}
+
+
+template <typename T>
+BasicCholeskyDecomposition<T>::BasicCholeskyDecomposition()
+	: m_positiveDefinite(false)
+{
+}
+
+
+template <typename T>
+BasicCholeskyDecomposition<T>::BasicCholeskyDecomposition(const BasicMatrix<T>& mat)
+	: m_positiveDefinite(false)
+{
+	Factorize(mat);
+}
+
+
+/// \brief     Compute A = L * L^T from the lower triangle of mat.
+/// \param[in] mat. Square symmetric matrix.
+template <typename T>
+void BasicCholeskyDecomposition<T>::Factorize(const BasicMatrix<T>& mat)
+{
+	if (mat.Rows() != mat.Cols())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	const unsigned int n = mat.Rows();
+	m_l.Resize(n, n);
+	T* l = m_l.Data();
+	const T* a = mat.Data();
+	for (unsigned int i = 0; i < n; i++)
+	{
+		std::copy(a + i * n, a + i * n + i + 1, l + i * n);
+		std::fill(l + i * n + i + 1, l + (i + 1) * n, T(0));
+	}
+
+	m_positiveDefinite = true;
+	for (unsigned int k = 0; k < n; k += PanelWidth)
+	{
+		const unsigned int nb = std::min(PanelWidth, n - k);
+		if (!FactorDiagonalBlock(k, nb))
+		{
+			m_positiveDefinite = false;
+			return;
+		}
+
+		const unsigned int next = k + nb;
+		if (next == n)
+		{
+			break;
+		}
+
+		//
+		// L21 = A21 * L11^-T, one row at a time by forward substitution.
+		//
+		for (unsigned int i = next; i < n; i++)
+		{
+			T* row = l + i * n + k;
+			for (unsigned int j = 0; j < nb; j++)
+			{
+				const T* lj = l + (k + j) * n + k;
+				T sum = row[j];
+				for (unsigned int p = 0; p < j; p++)
+				{
+					sum -= row[p] * lj[p];
+				}
+				row[j] = sum / lj[j];
+			}
+		}
+
+		//
+		// A22 -= L21 * L21^T, lower half only: each block of rows is updated up to and including
+		// its diagonal block.
+		//
+		for (unsigned int ib = next; ib < n; ib += PanelWidth)
+		{
+			const unsigned int rows = std::min(PanelWidth, n - ib);
+			kernel::Gemm<T>(rows, ib + rows - next, nb,
+				T(-1), l + ib * n + k, n, 1,
+				l + next * n + k, 1, n,
+				T(1), l + ib * n + next, n, 1);
+		}
+	}
+
+	//
+	// The GEMM updates also touch the strict upper part of each diagonal block.
+	//
+	for (unsigned int i = 0; i < n; i++)
+	{
+		std::fill(l + i * n + i + 1, l + (i + 1) * n, T(0));
+	}
+}
+
+
+/// \brief     Unblocked Cholesky of the diagonal block at (k, k).
+/// \return    false when a pivot is not positive.
+template <typename T>
+bool BasicCholeskyDecomposition<T>::FactorDiagonalBlock(const unsigned int k, const unsigned int nb)
+{
+	const unsigned int n = m_l.Rows();
+	T* l = m_l.Data();
+
+	for (unsigned int j = k; j < k + nb; j++)
+	{
+		T* lj = l + j * n;
+		T diag = lj[j];
+		for (unsigned int p = k; p < j; p++)
+		{
+			diag -= lj[p] * lj[p];
+		}
+		if (!(diag > T(0)))
+		{
+			return false;
+		}
+		diag = std::sqrt(diag);
+		lj[j] = diag;
+
+		for (unsigned int i = j + 1; i < k + nb; i++)
+		{
+			T* li = l + i * n;
+			T sum = li[j];
+			for (unsigned int p = k; p < j; p++)
+			{
+				sum -= li[p] * lj[p];
+			}
+			li[j] = sum / diag;
+		}
+	}
+	return true;
+}
+
+
+template <typename T>
+unsigned int BasicCholeskyDecomposition<T>::Size() const
+{
+	return m_l.Rows();
+}
+
+
+template <typename T>
+bool BasicCholeskyDecomposition<T>::IsPositiveDefinite() const
+{
+	return m_positiveDefinite;
+}
+
+
+/// \brief      Solve A * X = B by L * Y = B and L^T * X = Y.
+/// \param[in]  b. n*nrhs right-hand sides.
+/// \param[out] x. n*nrhs solutions; may be b.
+template <typename T>
+void BasicCholeskyDecomposition<T>::Solve(const BasicMatrix<T>& b, BasicMatrix<T>& x) const
+{
+	const unsigned int n = Size();
+	if (b.Rows() != n || x.Rows() != n || x.Cols() != b.Cols())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+	if (!m_positiveDefinite)
+	{
+		throw std::runtime_error("Matrix is not positive definite");
+	}
+
+	if (&x != &b)
+	{
+		std::copy(b.Data(), b.Data() + b.NumElements(), x.Data());
+	}
+
+	const T* l = m_l.Data();
+	kernel::SolveTriangular<T>(true, false, n, x.Cols(), l, n, 1, x.Data(), x.Cols());
+	kernel::SolveTriangular<T>(false, false, n, x.Cols(), l, 1, n, x.Data(), x.Cols());
+}
+
+
+/// \brief  The determinant, the squared product of the diagonal of L, or zero when A is not
+///         positive definite.
+template <typename T>
+T BasicCholeskyDecomposition<T>::Determinant() const
+{
+	if (!m_positiveDefinite)
+	{
+		return T(0);
+	}
+
+	const unsigned int n = Size();
+	T det = T(1);
+	for (unsigned int i = 0; i < n; i++)
+	{
+		det *= m_l.Data()[i * n + i];
+	}
+	return det * det;
+}
+
+
+template <typename T>
+const BasicMatrix<T>& BasicCholeskyDecomposition<T>::Factor() const
+{
+	return m_l;
+}
+
+
+template class numeric::BasicCholeskyDecomposition<float>;
+template class numeric::BasicCholeskyDecomposition<double>;
@@ -0,0 +1,59 @@
+#ifndef Numeric_CholeskyDecomposition_HPP
+#define Numeric_CholeskyDecomposition_HPP
+
+#include <stdexcept>
+#include "Matrix.hpp"
+
+namespace numeric
+{
+	//
+	// Class : Cholesky factorization A = L * L^T of a symmetric positive definite matrix.
+	//
+	// Only the lower triangle of A is read. The factorization is right-looking and blocked:
+	// each diagonal block is factored directly, the panel below it is solved against it, and
+	// the lower half of the trailing matrix is updated with GEMM calls.
+	//
+	// A matrix that is not positive definite is reported by IsPositiveDefinite(); Solve then
+	// throws std::runtime_error.
+	//
+	// Instantiated for float and double.
+	//
+	template <typename T>
+	class BasicCholeskyDecomposition
+	{
+	public:
+		typedef T ElemType;
+
+	public:
+		BasicCholeskyDecomposition();
+		explicit BasicCholeskyDecomposition(const BasicMatrix<T>& mat);
+
+		void Factorize(const BasicMatrix<T>& mat);
+
+		unsigned int Size() const;
+		bool         IsPositiveDefinite() const;
+
+		//
+		// Solve A * X = B for every column of B. B and X are n*nrhs and may be the same matrix.
+		//
+		void Solve(const BasicMatrix<T>& b, BasicMatrix<T>& x) const;
+		T    Determinant() const;
+
+		//
+		// The lower-triangular factor L; its upper triangle is zero.
+		//
+		const BasicMatrix<T>& Factor() const;
+
+	private:
+		bool FactorDiagonalBlock(const unsigned int k, const unsigned int nb);
+
+	private:
+		BasicMatrix<T> m_l;
+		bool           m_positiveDefinite;
+	};
+
+	typedef BasicCholeskyDecomposition<float>  CholeskyDecompositionF;
+	typedef BasicCholeskyDecomposition<double> CholeskyDecomposition;
+}
+
+#endif
@@ -0,0 +1,142 @@
+
+#include "CpuFeatures.hpp"
+#include <stdexcept>
+#include <cstring>
+
+#if NUMERIC_X86_SIMD
+#include <cpuid.h>
+#endif
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of CPU feature detection
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+#if NUMERIC_X86_SIMD
+	/// \brief  Read an extended control register, which tells which register states the OS saves.
+	unsigned long long XGetBv(const unsigned int index)
+	{
+		unsigned int eax = 0;
+		unsigned int edx = 0;
+		__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
+	}
+#endif
+
+	kernel::Isa SelectIsa()
+	{
+		const kernel::Isa detected = kernel::DetectIsa();
+#ifdef NUMERIC_FORCE_ISA
+		const kernel::Isa forced = static_cast<kernel::Isa>(NUMERIC_FORCE_ISA);
+		if (forced > detected)
+		{
+			throw std::runtime_error("The forced instruction set is not supported by this CPU");
+		}
+		return forced;
+#else
+		return detected;
+#endif
+	}
+}
+
+
+/// \brief  Query CPUID and XCR0 for the widest usable instruction set.
+/// \return The detected instruction set.
+kernel::Isa kernel::DetectIsa()
+{
+#if NUMERIC_X86_SIMD
+	unsigned int eax = 0;
+	unsigned int ebx = 0;
+	unsigned int ecx = 0;
+	unsigned int edx = 0;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(edx & bit_SSE2))
+	{
+		return IsaScalar;
+	}
+
+	const bool osxsave = (ecx & bit_OSXSAVE) != 0;
+	const bool avx = (ecx & bit_AVX) != 0;
+	const bool fma = (ecx & bit_FMA) != 0;
+	if (!osxsave || !avx || !fma)
+	{
+		return IsaSse2;
+	}
+
+	//
+	// XCR0 bits 1-2 are the XMM/YMM state, bits 5-7 the AVX-512 opmask and ZMM state.
+	//
+	const unsigned long long xcr0 = XGetBv(0);
+	if ((xcr0 & 0x6) != 0x6 || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+	{
+		return IsaSse2;
+	}
+
+	if (!(ebx & bit_AVX2))
+	{
+		return IsaSse2;
+	}
+
+	if ((ebx & bit_AVX512F) && (xcr0 & 0xe6) == 0xe6)
+	{
+		return IsaAvx512;
+	}
+	return IsaAvx2;
+#else
+	return IsaScalar;
+#endif
+}
+
+
+/// \brief  Return the instruction set used by the kernels, detected once per process.
+kernel::Isa kernel::ActiveIsa()
+{
+	static const Isa isa = SelectIsa();
+	return isa;
+}
+
+
+const char* kernel::IsaName(const Isa isa)
+{
+	switch (isa)
+	{
+	case IsaSse2:
+		return "sse2";
+	case IsaAvx2:
+		return "avx2";
+	case IsaAvx512:
+		return "avx512";
+	default:
+		return "scalar";
+	}
+}
+
+
+/// \brief  Read the brand string from CPUID leaves 0x80000002 to 0x80000004.
+std::string kernel::CpuModel()
+{
+#if NUMERIC_X86_SIMD
+	if (__get_cpuid_max(0x80000000, NULL) >= 0x80000004)
+	{
+		unsigned int brand[12];
+		for (unsigned int leaf = 0; leaf < 3; leaf++)
+		{
+			unsigned int* regs = brand + 4 * leaf;
+			__get_cpuid(0x80000002 + leaf, &regs[0], &regs[1], &regs[2], &regs[3]);
+		}
+
+		char text[sizeof(brand) + 1];
+		std::memcpy(text, brand, sizeof(brand));
+		text[sizeof(brand)] = '\0';
+
+		const std::string model(text);
+		const size_t begin = model.find_first_not_of(' ');
+		if (begin != std::string::npos)
+		{
+			return model.substr(begin, model.find_last_not_of(' ') - begin + 1);
+		}
+	}
+#endif
+	return "unknown";
+}
@@ -0,0 +1,78 @@
+#ifndef Numeric_CpuFeatures_HPP
+#define Numeric_CpuFeatures_HPP
+
+//
+// Instruction sets the kernels are compiled for. A build can pin the dispatcher to one of
+// them with -DNUMERIC_FORCE_ISA=<value>, e.g. -DNUMERIC_FORCE_ISA=NUMERIC_ISA_AVX2, which is
+// how every path is verified on a single machine.
+//
+#define NUMERIC_ISA_SCALAR 0
+#define NUMERIC_ISA_SSE2   1
+#define NUMERIC_ISA_AVX2   2
+#define NUMERIC_ISA_AVX512 3
+
+//
+// SIMD kernels are built for x86 with GCC or Clang. Each ISA-specific block of code is wrapped
+// in NUMERIC_TARGET_BEGIN_<ISA> / NUMERIC_TARGET_END, so only those functions are compiled for
+// the wider instruction set and the rest of the library keeps the baseline flags.
+//
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define NUMERIC_X86_SIMD 1
+#else
+	#define NUMERIC_X86_SIMD 0
+#endif
+
+#if NUMERIC_X86_SIMD
+	#if defined(__clang__)
+		#define NUMERIC_TARGET_BEGIN_SSE2 \
+			_Pragma("clang attribute push (__attribute__((target(\"sse2\"))), apply_to = function)")
+		#define NUMERIC_TARGET_BEGIN_AVX2 \
+			_Pragma("clang attribute push (__attribute__((target(\"avx2,fma\"))), apply_to = function)")
+		#define NUMERIC_TARGET_BEGIN_AVX512 \
+			_Pragma("clang attribute push (__attribute__((target(\"avx512f,avx2,fma\"))), apply_to = function)")
+		#define NUMERIC_TARGET_END _Pragma("clang attribute pop")
+	#else
+		#define NUMERIC_TARGET_BEGIN_SSE2   _Pragma("GCC push_options") _Pragma("GCC target(\"sse2\")")
+		#define NUMERIC_TARGET_BEGIN_AVX2   _Pragma("GCC push_options") _Pragma("GCC target(\"avx2,fma\")")
+		#define NUMERIC_TARGET_BEGIN_AVX512 _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f,avx2,fma\")")
+		#define NUMERIC_TARGET_END          _Pragma("GCC pop_options")
+	#endif
+#endif
+
+#include <string>
+
+namespace numeric
+{
+	namespace kernel
+	{
+		enum Isa
+		{
+			IsaScalar = NUMERIC_ISA_SCALAR,
+			IsaSse2   = NUMERIC_ISA_SSE2,
+			IsaAvx2   = NUMERIC_ISA_AVX2,
+			IsaAvx512 = NUMERIC_ISA_AVX512
+		};
+
+		//
+		// Function : The widest instruction set supported by both the CPU and the OS.
+		//
+		Isa DetectIsa();
+
+		//
+		// Function : The instruction set the kernels dispatch to. This is DetectIsa() unless the
+		//      build forces an ISA, in which case it throws std::runtime_error when the CPU cannot
+		//      run the forced one.
+		//
+		Isa ActiveIsa();
+
+		const char* IsaName(const Isa isa);
+
+		//
+		// Function : The processor brand string, e.g. "Intel(R) Xeon(R) Gold 6338 CPU @ 2.00GHz",
+		//      with surrounding blanks removed. "unknown" where it cannot be read.
+		//
+		std::string CpuModel();
+	}
+}
+
+#endif
@@ -0,0 +1,287 @@
+
+#include "ElementWise.hpp"
+#include "SimdVector.hpp"
+#include "Tuning.hpp"
+#include <cstdint>
+#include <limits>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of the element-wise kernels
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace numeric
+{
+	namespace simd
+	{
+		namespace scalar
+		{
+			#include "ElementWiseLoops.inl"
+		}
+
+#if NUMERIC_X86_SIMD
+		namespace sse2
+		{
+NUMERIC_TARGET_BEGIN_SSE2
+			#include "ElementWiseLoops.inl"
+NUMERIC_TARGET_END
+		}
+
+		namespace avx2
+		{
+NUMERIC_TARGET_BEGIN_AVX2
+			#include "ElementWiseLoops.inl"
+NUMERIC_TARGET_END
+		}
+
+		namespace avx512
+		{
+NUMERIC_TARGET_BEGIN_AVX512
+			#include "ElementWiseLoops.inl"
+NUMERIC_TARGET_END
+		}
+#endif
+	}
+}
+
+namespace
+{
+	template <typename T>
+	struct ElementWiseTable
+	{
+		void (*add)(const size_t, const T*, const T*, T*);
+		void (*sub)(const size_t, const T*, const T*, T*);
+		void (*mul)(const size_t, const T*, const T*, T*);
+		void (*scale)(const size_t, const T, const T*, T*);
+		void (*fill)(const size_t, const T, T*);
+		void (*axpby)(const size_t, const T, const T*, const T, T*);
+		T    (*max)(const size_t, const T*, const T);
+		T    (*min)(const size_t, const T*, const T);
+		T    (*reduce[kernel::NumReduceKernels])(const size_t, const T*, const T);
+		void (*accumulate[kernel::NumReduceKernels])(const size_t, const T*, T*);
+		T    (*dot)(const size_t, const T*, const T*);
+		void (*affine)(const size_t, const T*, const T*, const T*, const T*, T*, T*);
+		void (*affineInterleaved)(const size_t, const T*, const T*, const T*, T*);
+		size_t (*affineInliers)(const size_t, const T*, const T*, const T*, const T*,
+		                        const T*, const T*, const T);
+	};
+
+#define NUMERIC_ELEMENTWISE_TABLE(isa, T)                               \
+	{                                                                   \
+		&simd::isa::BinaryLoop<T, simd::isa::AddOp>,                    \
+		&simd::isa::BinaryLoop<T, simd::isa::SubOp>,                    \
+		&simd::isa::BinaryLoop<T, simd::isa::MulOp>,                    \
+		&simd::isa::ScaleLoop<T>,                                       \
+		&simd::isa::FillLoop<T>,                                        \
+		&simd::isa::AxpbyLoop<T>,                                       \
+		&simd::isa::MaxLoop<T>,                                         \
+		&simd::isa::MinLoop<T>,                                         \
+		{                                                               \
+			&simd::isa::ReduceLoop<T, simd::isa::IdentityMap, simd::isa::AddOp>, \
+			&simd::isa::ReduceLoop<T, simd::isa::AbsMap, simd::isa::AddOp>,      \
+			&simd::isa::ReduceLoop<T, simd::isa::SquareMap, simd::isa::AddOp>,   \
+			&simd::isa::ReduceLoop<T, simd::isa::IdentityMap, simd::isa::MaxOp>, \
+			&simd::isa::ReduceLoop<T, simd::isa::IdentityMap, simd::isa::MinOp>, \
+			&simd::isa::ReduceLoop<T, simd::isa::AbsMap, simd::isa::MaxOp>       \
+		},                                                              \
+		{                                                               \
+			&simd::isa::AccumulateLoop<T, simd::isa::IdentityMap, simd::isa::AddOp>, \
+			&simd::isa::AccumulateLoop<T, simd::isa::AbsMap, simd::isa::AddOp>,      \
+			&simd::isa::AccumulateLoop<T, simd::isa::SquareMap, simd::isa::AddOp>,   \
+			&simd::isa::AccumulateLoop<T, simd::isa::IdentityMap, simd::isa::MaxOp>, \
+			&simd::isa::AccumulateLoop<T, simd::isa::IdentityMap, simd::isa::MinOp>, \
+			&simd::isa::AccumulateLoop<T, simd::isa::AbsMap, simd::isa::MaxOp>       \
+		},                                                              \
+		&simd::isa::DotLoop<T>,                                         \
+		&simd::isa::AffineLoop<T>,                                      \
+		&simd::isa::AffineInterleavedLoop<T>,                           \
+		&simd::isa::AffineInlierLoop<T>                                 \
+	}
+
+	/// \brief  Pick the kernels for the tuned instruction set, TuningParameters::elementWiseIsa.
+	template <typename T>
+	const ElementWiseTable<T>& Table()
+	{
+		static const ElementWiseTable<T> scalarTable = NUMERIC_ELEMENTWISE_TABLE(scalar, T);
+#if NUMERIC_X86_SIMD
+		static const ElementWiseTable<T> sse2Table = NUMERIC_ELEMENTWISE_TABLE(sse2, T);
+		static const ElementWiseTable<T> avx2Table = NUMERIC_ELEMENTWISE_TABLE(avx2, T);
+		static const ElementWiseTable<T> avx512Table = NUMERIC_ELEMENTWISE_TABLE(avx512, T);
+
+		switch (kernel::ElementWiseIsa())
+		{
+		case kernel::IsaAvx512:
+			return avx512Table;
+		case kernel::IsaAvx2:
+			return avx2Table;
+		case kernel::IsaSse2:
+			return sse2Table;
+		default:
+			break;
+		}
+#endif
+		return scalarTable;
+	}
+
+#undef NUMERIC_ELEMENTWISE_TABLE
+}
+
+
+/// \brief       z = x + y, element-wise.
+template <typename T>
+void kernel::Add(const size_t n, const T* x, const T* y, T* z)
+{
+	Table<T>().add(n, x, y, z);
+}
+
+
+/// \brief       z = x - y, element-wise.
+template <typename T>
+void kernel::Sub(const size_t n, const T* x, const T* y, T* z)
+{
+	Table<T>().sub(n, x, y, z);
+}
+
+
+/// \brief       z = x .* y, element-wise.
+template <typename T>
+void kernel::Mul(const size_t n, const T* x, const T* y, T* z)
+{
+	Table<T>().mul(n, x, y, z);
+}
+
+
+/// \brief       z = s * x.
+template <typename T>
+void kernel::Scale(const size_t n, const T s, const T* x, T* z)
+{
+	Table<T>().scale(n, s, x, z);
+}
+
+
+/// \brief       Set every element of z to value.
+template <typename T>
+void kernel::Fill(const size_t n, const T value, T* z)
+{
+	Table<T>().fill(n, value, z);
+}
+
+
+/// \brief       y = a * x + b * y.
+template <typename T>
+void kernel::Axpby(const size_t n, const T a, const T* x, const T b, T* y)
+{
+	if (b == T(0))
+	{
+		Table<T>().scale(n, a, x, y);
+		return;
+	}
+	Table<T>().axpby(n, a, x, b, y);
+}
+
+
+/// \brief       Largest element of x, or init for an empty buffer.
+template <typename T>
+T kernel::Max(const size_t n, const T* x, const T init)
+{
+	return Table<T>().max(n, x, init);
+}
+
+
+/// \brief       Smallest element of x, or init for an empty buffer.
+template <typename T>
+T kernel::Min(const size_t n, const T* x, const T init)
+{
+	return Table<T>().min(n, x, init);
+}
+
+
+/// \brief       op over x, starting from init.
+template <typename T>
+T kernel::Reduce(const ReduceKernel op, const size_t n, const T* x, const T init)
+{
+	return Table<T>().reduce[op](n, x, init);
+}
+
+
+/// \brief       acc[i] = op(acc[i], x[i]).
+template <typename T>
+void kernel::Accumulate(const ReduceKernel op, const size_t n, const T* x, T* acc)
+{
+	Table<T>().accumulate[op](n, x, acc);
+}
+
+
+/// \brief       Sum of x[i] * y[i].
+template <typename T>
+T kernel::Dot(const size_t n, const T* x, const T* y)
+{
+	return Table<T>().dot(n, x, y);
+}
+
+
+/// \brief       Affine map of points given as separate coordinate arrays.
+/// \param[in]   n. Number of points.
+/// \param[in]   linearMap. Row-major 2x2 matrix.
+/// \param[in]   translation. 2 elements.
+/// \param[in]   x, y. Coordinates.
+/// \param[out]  tx, ty. Transformed coordinates; may be x and y.
+template <typename T>
+void kernel::AffinePoints(const size_t n, const T* linearMap, const T* translation,
+                          const T* x, const T* y, T* tx, T* ty)
+{
+	Table<T>().affine(n, linearMap, translation, x, y, tx, ty);
+}
+
+
+/// \brief       Affine map of n interleaved points (x0, y0, x1, y1, ...).
+template <typename T>
+void kernel::AffinePointsInterleaved(const size_t n, const T* linearMap, const T* translation,
+                                     const T* xy, T* txy)
+{
+	Table<T>().affineInterleaved(n, linearMap, translation, xy, txy);
+}
+
+
+/// \brief       Count the correspondences that an affine map fits to within a tolerance.
+/// \param[in]   n. Number of points.
+/// \param[in]   linearMap, translation. The map, as for AffinePoints.
+/// \param[in]   x, y. Source coordinates.
+/// \param[in]   tx, ty. Target coordinates.
+/// \param[in]   maxSquaredError. Largest squared distance counted as a fit.
+template <typename T>
+size_t kernel::CountAffineInliers(const size_t n, const T* linearMap, const T* translation,
+                                  const T* x, const T* y, const T* tx, const T* ty,
+                                  const T maxSquaredError)
+{
+	return Table<T>().affineInliers(n, linearMap, translation, x, y, tx, ty, maxSquaredError);
+}
+
+
+#define NUMERIC_INSTANTIATE_ELEMENTWISE(T)                                         \
+	template void kernel::Add<T>(const size_t, const T*, const T*, T*);            \
+	template void kernel::Sub<T>(const size_t, const T*, const T*, T*);            \
+	template void kernel::Mul<T>(const size_t, const T*, const T*, T*);            \
+	template void kernel::Scale<T>(const size_t, const T, const T*, T*);           \
+	template void kernel::Fill<T>(const size_t, const T, T*);                      \
+	template void kernel::Axpby<T>(const size_t, const T, const T*, const T, T*);  \
+	template T kernel::Max<T>(const size_t, const T*, const T);                    \
+	template T kernel::Min<T>(const size_t, const T*, const T);                    \
+	template T kernel::Reduce<T>(const ReduceKernel, const size_t, const T*,       \
+	                             const T);                                         \
+	template void kernel::Accumulate<T>(const ReduceKernel, const size_t,          \
+	                                    const T*, T*);                             \
+	template T kernel::Dot<T>(const size_t, const T*, const T*);                   \
+	template void kernel::AffinePoints<T>(const size_t, const T*, const T*,        \
+	                                      const T*, const T*, T*, T*);             \
+	template void kernel::AffinePointsInterleaved<T>(const size_t, const T*,       \
+	                                                 const T*, const T*, T*);      \
+	template size_t kernel::CountAffineInliers<T>(const size_t, const T*,          \
+	                                              const T*, const T*, const T*,    \
+	                                              const T*, const T*, const T);
+
+NUMERIC_INSTANTIATE_ELEMENTWISE(float)
+NUMERIC_INSTANTIATE_ELEMENTWISE(double)
+NUMERIC_INSTANTIATE_ELEMENTWISE(std::int32_t)
+
+#undef NUMERIC_INSTANTIATE_ELEMENTWISE
@@ -0,0 +1,78 @@
+#ifndef Numeric_ElementWise_HPP
+#define Numeric_ElementWise_HPP
+
+#include <cstddef>
+
+namespace numeric
+{
+	namespace kernel
+	{
+		//
+		// Element-wise kernels over contiguous buffers of n elements. Each call dispatches to the
+		// SSE2, AVX2 or AVX-512 implementation selected by ActiveIsa(), or to a scalar loop.
+		// The output may be the same buffer as an input. Instantiated for float, double and
+		// std::int32_t.
+		//
+		template <typename T> void Add(const size_t n, const T* x, const T* y, T* z);
+		template <typename T> void Sub(const size_t n, const T* x, const T* y, T* z);
+		template <typename T> void Mul(const size_t n, const T* x, const T* y, T* z);
+		template <typename T> void Scale(const size_t n, const T s, const T* x, T* z);
+		template <typename T> void Fill(const size_t n, const T value, T* z);
+
+		//
+		// y = a * x + b * y in one pass. When b is zero, y is only written.
+		//
+		template <typename T> void Axpby(const size_t n, const T a, const T* x, const T b, T* y);
+
+		//
+		// Reductions. NaNs are skipped; an empty buffer yields init.
+		//
+		template <typename T> T Max(const size_t n, const T* x, const T init);
+		template <typename T> T Min(const size_t n, const T* x, const T init);
+
+		//
+		// Reductions of a buffer under op. Sum, SumAbs and SumSquares add x[i], |x[i]| and
+		// x[i]^2 and propagate NaNs; Max, Min and MaxAbs skip them. Reduce starts from init and
+		// keeps several vector accumulators whose lanes are combined pairwise, so its result
+		// depends only on n, the data and the instruction set. Accumulate folds x into acc
+		// element by element, acc[i] = op(acc[i], x[i]).
+		//
+		enum ReduceKernel
+		{
+			ReduceKernelSum,
+			ReduceKernelSumAbs,
+			ReduceKernelSumSquares,
+			ReduceKernelMax,
+			ReduceKernelMin,
+			ReduceKernelMaxAbs,
+			NumReduceKernels
+		};
+
+		template <typename T> T    Reduce(const ReduceKernel op, const size_t n, const T* x, const T init);
+		template <typename T> void Accumulate(const ReduceKernel op, const size_t n, const T* x, T* acc);
+		template <typename T> T    Dot(const size_t n, const T* x, const T* y);
+
+		//
+		// Affine map of n 2-D points, (x', y') = L * (x, y) + t, with L the row-major 2x2 linear
+		// map and t the translation. AffinePoints takes separate x and y arrays,
+		// AffinePointsInterleaved takes x0, y0, x1, y1, ... The output may be the input.
+		//
+		template <typename T>
+		void AffinePoints(const size_t n, const T* linearMap, const T* translation,
+		                  const T* x, const T* y, T* tx, T* ty);
+		template <typename T>
+		void AffinePointsInterleaved(const size_t n, const T* linearMap, const T* translation,
+		                             const T* xy, T* txy);
+
+		//
+		// Number of points i with |L * (x[i], y[i]) + t - (tx[i], ty[i])|^2 <= maxSquaredError,
+		// the inlier count used to score RANSAC hypotheses.
+		//
+		template <typename T>
+		size_t CountAffineInliers(const size_t n, const T* linearMap, const T* translation,
+		                          const T* x, const T* y, const T* tx, const T* ty,
+		                          const T maxSquaredError);
+	}
+}
+
+#endif
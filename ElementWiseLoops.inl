@@ -0,0 +1,444 @@
+//
+// Element-wise loops over contiguous buffers, written against Vec<T> of the enclosing ISA
+// namespace. This file is included once per instruction set by ElementWise.cpp, inside the
+// matching NUMERIC_TARGET_BEGIN_<ISA> block, and must not include anything itself.
+//
+
+struct AddOp
+{
+	template <typename V>
+	static inline typename V::Type Apply(const typename V::Type a, const typename V::Type b)
+	{
+		return V::Add(a, b);
+	}
+
+	template <typename T>
+	static inline T Identity()
+	{
+		return T(0);
+	}
+};
+
+struct SubOp
+{
+	template <typename V>
+	static inline typename V::Type Apply(const typename V::Type a, const typename V::Type b)
+	{
+		return V::Sub(a, b);
+	}
+};
+
+struct MulOp
+{
+	template <typename V>
+	static inline typename V::Type Apply(const typename V::Type a, const typename V::Type b)
+	{
+		return V::Mul(a, b);
+	}
+};
+
+struct MaxOp
+{
+	template <typename V>
+	static inline typename V::Type Apply(const typename V::Type a, const typename V::Type b)
+	{
+		return V::Max(a, b);
+	}
+
+	template <typename T>
+	static inline T Identity()
+	{
+		return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity()
+		                                            : std::numeric_limits<T>::lowest();
+	}
+};
+
+struct MinOp
+{
+	template <typename V>
+	static inline typename V::Type Apply(const typename V::Type a, const typename V::Type b)
+	{
+		return V::Min(a, b);
+	}
+
+	template <typename T>
+	static inline T Identity()
+	{
+		return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+		                                            : std::numeric_limits<T>::max();
+	}
+};
+
+//
+// Maps applied to each element before it is reduced. Max(a, -a) keeps a NaN, which the Max
+// and Min reductions then skip because they take the accumulator when the element is NaN.
+//
+struct IdentityMap
+{
+	template <typename V>
+	static inline typename V::Type Apply(const typename V::Type a)
+	{
+		return a;
+	}
+};
+
+struct AbsMap
+{
+	template <typename V>
+	static inline typename V::Type Apply(const typename V::Type a)
+	{
+		return V::Max(a, V::Sub(V::Set1(0), a));
+	}
+};
+
+struct SquareMap
+{
+	template <typename V>
+	static inline typename V::Type Apply(const typename V::Type a)
+	{
+		return V::Mul(a, a);
+	}
+};
+
+/// \brief       z[i] = op(x[i], y[i])
+template <typename T, typename Op>
+void BinaryLoop(const size_t n, const T* x, const T* y, T* z)
+{
+	typedef Vec<T> V;
+	typedef ::numeric::simd::scalar::Vec<T> S;
+
+	size_t i = 0;
+	for (; i + 2 * V::Width <= n; i += 2 * V::Width)
+	{
+		const typename V::Type z0 = Op::template Apply<V>(V::Load(x + i), V::Load(y + i));
+		const typename V::Type z1 = Op::template Apply<V>(V::Load(x + i + V::Width),
+		                                                   V::Load(y + i + V::Width));
+		V::Store(z + i, z0);
+		V::Store(z + i + V::Width, z1);
+	}
+	for (; i + V::Width <= n; i += V::Width)
+	{
+		V::Store(z + i, Op::template Apply<V>(V::Load(x + i), V::Load(y + i)));
+	}
+	for (; i < n; i++)
+	{
+		z[i] = Op::template Apply<S>(x[i], y[i]);
+	}
+}
+
+/// \brief       z[i] = s * x[i]
+template <typename T>
+void ScaleLoop(const size_t n, const T s, const T* x, T* z)
+{
+	typedef Vec<T> V;
+
+	const typename V::Type vs = V::Set1(s);
+	size_t i = 0;
+	for (; i + V::Width <= n; i += V::Width)
+	{
+		V::Store(z + i, V::Mul(vs, V::Load(x + i)));
+	}
+	for (; i < n; i++)
+	{
+		z[i] = s * x[i];
+	}
+}
+
+/// \brief       y[i] = a * x[i] + b * y[i]
+template <typename T>
+void AxpbyLoop(const size_t n, const T a, const T* x, const T b, T* y)
+{
+	typedef Vec<T> V;
+
+	const typename V::Type va = V::Set1(a);
+	const typename V::Type vb = V::Set1(b);
+	size_t i = 0;
+	for (; i + V::Width <= n; i += V::Width)
+	{
+		V::Store(y + i, V::Add(V::Mul(va, V::Load(x + i)), V::Mul(vb, V::Load(y + i))));
+	}
+	for (; i < n; i++)
+	{
+		y[i] = a * x[i] + b * y[i];
+	}
+}
+
+/// \brief       z[i] = value
+template <typename T>
+void FillLoop(const size_t n, const T value, T* z)
+{
+	typedef Vec<T> V;
+
+	const typename V::Type v = V::Set1(value);
+	size_t i = 0;
+	for (; i + V::Width <= n; i += V::Width)
+	{
+		V::Store(z + i, v);
+	}
+	for (; i < n; i++)
+	{
+		z[i] = value;
+	}
+}
+
+/// \brief       Largest x[i], or init when n is zero. NaNs are skipped.
+template <typename T>
+T MaxLoop(const size_t n, const T* x, const T init)
+{
+	typedef Vec<T> V;
+
+	size_t i = 0;
+	T result = init;
+	if (n >= 2 * V::Width)
+	{
+		typename V::Type acc0 = V::Set1(init);
+		typename V::Type acc1 = acc0;
+		for (; i + 2 * V::Width <= n; i += 2 * V::Width)
+		{
+			acc0 = V::Max(V::Load(x + i), acc0);
+			acc1 = V::Max(V::Load(x + i + V::Width), acc1);
+		}
+		result = V::ReduceMax(V::Max(acc0, acc1));
+	}
+	for (; i < n; i++)
+	{
+		result = x[i] > result ? x[i] : result;
+	}
+	return result;
+}
+
+/// \brief       The lanes of v combined pairwise with Op.
+template <typename T, typename Op>
+T CombineLanes(const typename Vec<T>::Type v)
+{
+	typedef Vec<T> V;
+	typedef ::numeric::simd::scalar::Vec<T> S;
+
+	T lanes[V::Width];
+	V::Store(lanes, v);
+	for (size_t width = V::Width; width > 1; width /= 2)
+	{
+		for (size_t i = 0; i < width / 2; i++)
+		{
+			lanes[i] = Op::template Apply<S>(lanes[2 * i], lanes[2 * i + 1]);
+		}
+	}
+	return lanes[0];
+}
+
+/// \brief       op over map(x[i]), starting from init. Four vector accumulators start from the
+///              identity of op and are combined pairwise, then the lanes, then init, so that
+///              init counts once however wide the vectors are; the tail is folded in last.
+template <typename T, typename Map, typename Op>
+T ReduceLoop(const size_t n, const T* x, const T init)
+{
+	typedef Vec<T> V;
+	typedef ::numeric::simd::scalar::Vec<T> S;
+
+	size_t i = 0;
+	T result = init;
+	if (n >= 4 * V::Width)
+	{
+		typename V::Type acc0 = V::Set1(Op::template Identity<T>());
+		typename V::Type acc1 = acc0;
+		typename V::Type acc2 = acc0;
+		typename V::Type acc3 = acc0;
+		for (; i + 4 * V::Width <= n; i += 4 * V::Width)
+		{
+			acc0 = Op::template Apply<V>(Map::template Apply<V>(V::Load(x + i)), acc0);
+			acc1 = Op::template Apply<V>(Map::template Apply<V>(V::Load(x + i + V::Width)), acc1);
+			acc2 = Op::template Apply<V>(Map::template Apply<V>(V::Load(x + i + 2 * V::Width)), acc2);
+			acc3 = Op::template Apply<V>(Map::template Apply<V>(V::Load(x + i + 3 * V::Width)), acc3);
+		}
+		result = Op::template Apply<S>(CombineLanes<T, Op>(Op::template Apply<V>(Op::template Apply<V>(acc0, acc1),
+		                                                                         Op::template Apply<V>(acc2, acc3))),
+		                               init);
+	}
+	for (; i < n; i++)
+	{
+		result = Op::template Apply<S>(Map::template Apply<S>(x[i]), result);
+	}
+	return result;
+}
+
+/// \brief       acc[i] = op(map(x[i]), acc[i])
+template <typename T, typename Map, typename Op>
+void AccumulateLoop(const size_t n, const T* x, T* acc)
+{
+	typedef Vec<T> V;
+	typedef ::numeric::simd::scalar::Vec<T> S;
+
+	size_t i = 0;
+	for (; i + V::Width <= n; i += V::Width)
+	{
+		V::Store(acc + i, Op::template Apply<V>(Map::template Apply<V>(V::Load(x + i)), V::Load(acc + i)));
+	}
+	for (; i < n; i++)
+	{
+		acc[i] = Op::template Apply<S>(Map::template Apply<S>(x[i]), acc[i]);
+	}
+}
+
+/// \brief       Sum of x[i] * y[i], with the accumulators combined as in ReduceLoop.
+template <typename T>
+T DotLoop(const size_t n, const T* x, const T* y)
+{
+	typedef Vec<T> V;
+
+	size_t i = 0;
+	T result = T(0);
+	if (n >= 4 * V::Width)
+	{
+		typename V::Type acc0 = V::Set1(T(0));
+		typename V::Type acc1 = acc0;
+		typename V::Type acc2 = acc0;
+		typename V::Type acc3 = acc0;
+		for (; i + 4 * V::Width <= n; i += 4 * V::Width)
+		{
+			acc0 = V::Add(V::Mul(V::Load(x + i), V::Load(y + i)), acc0);
+			acc1 = V::Add(V::Mul(V::Load(x + i + V::Width), V::Load(y + i + V::Width)), acc1);
+			acc2 = V::Add(V::Mul(V::Load(x + i + 2 * V::Width), V::Load(y + i + 2 * V::Width)), acc2);
+			acc3 = V::Add(V::Mul(V::Load(x + i + 3 * V::Width), V::Load(y + i + 3 * V::Width)), acc3);
+		}
+		result = CombineLanes<T, AddOp>(V::Add(V::Add(acc0, acc1), V::Add(acc2, acc3)));
+	}
+	for (; i < n; i++)
+	{
+		result = x[i] * y[i] + result;
+	}
+	return result;
+}
+
+/// \brief       Smallest x[i], or init when n is zero. NaNs are skipped.
+template <typename T>
+T MinLoop(const size_t n, const T* x, const T init)
+{
+	typedef Vec<T> V;
+
+	size_t i = 0;
+	T result = init;
+	if (n >= 2 * V::Width)
+	{
+		typename V::Type acc0 = V::Set1(init);
+		typename V::Type acc1 = acc0;
+		for (; i + 2 * V::Width <= n; i += 2 * V::Width)
+		{
+			acc0 = V::Min(V::Load(x + i), acc0);
+			acc1 = V::Min(V::Load(x + i + V::Width), acc1);
+		}
+		result = V::ReduceMin(V::Min(acc0, acc1));
+	}
+	for (; i < n; i++)
+	{
+		result = x[i] < result ? x[i] : result;
+	}
+	return result;
+}
+
+/// \brief       (tx[i], ty[i]) = L * (x[i], y[i]) + t, with L a row-major 2x2 matrix.
+template <typename T>
+void AffineLoop(const size_t n, const T* linearMap, const T* translation,
+                const T* x, const T* y, T* tx, T* ty)
+{
+	typedef Vec<T> V;
+
+	const typename V::Type m00 = V::Set1(linearMap[0]);
+	const typename V::Type m01 = V::Set1(linearMap[1]);
+	const typename V::Type m10 = V::Set1(linearMap[2]);
+	const typename V::Type m11 = V::Set1(linearMap[3]);
+	const typename V::Type dx = V::Set1(translation[0]);
+	const typename V::Type dy = V::Set1(translation[1]);
+
+	size_t i = 0;
+	for (; i + V::Width <= n; i += V::Width)
+	{
+		const typename V::Type vx = V::Load(x + i);
+		const typename V::Type vy = V::Load(y + i);
+		V::Store(tx + i, V::Add(V::Add(V::Mul(m00, vx), V::Mul(m01, vy)), dx));
+		V::Store(ty + i, V::Add(V::Add(V::Mul(m10, vx), V::Mul(m11, vy)), dy));
+	}
+	for (; i < n; i++)
+	{
+		const T px = x[i];
+		const T py = y[i];
+		tx[i] = linearMap[0] * px + linearMap[1] * py + translation[0];
+		ty[i] = linearMap[2] * px + linearMap[3] * py + translation[1];
+	}
+}
+
+/// \brief       The same map over interleaved points xy = (x0, y0, x1, y1, ...). A register of
+///              pairs is combined with its pair-swapped copy:
+///              (x', y') = (m00, m11) * (x, y) + (m01, m10) * (y, x) + (dx, dy)
+template <typename T>
+void AffineInterleavedLoop(const size_t n, const T* linearMap, const T* translation,
+                           const T* xy, T* txy)
+{
+	typedef Vec<T> V;
+
+	size_t i = 0;
+	if (V::Width >= 2)
+	{
+		T diag[V::Width < 2 ? 2 : V::Width];
+		T anti[V::Width < 2 ? 2 : V::Width];
+		T shift[V::Width < 2 ? 2 : V::Width];
+		for (size_t k = 0; k < V::Width; k += 2)
+		{
+			diag[k] = linearMap[0];
+			diag[k + 1] = linearMap[3];
+			anti[k] = linearMap[1];
+			anti[k + 1] = linearMap[2];
+			shift[k] = translation[0];
+			shift[k + 1] = translation[1];
+		}
+
+		const typename V::Type vd = V::Load(diag);
+		const typename V::Type va = V::Load(anti);
+		const typename V::Type vs = V::Load(shift);
+		for (; i + V::Width <= 2 * n; i += V::Width)
+		{
+			const typename V::Type v = V::Load(xy + i);
+			V::Store(txy + i, V::Add(V::Add(V::Mul(vd, v), V::Mul(va, V::SwapPairs(v))), vs));
+		}
+	}
+	for (; i < 2 * n; i += 2)
+	{
+		const T px = xy[i];
+		const T py = xy[i + 1];
+		txy[i] = linearMap[0] * px + linearMap[1] * py + translation[0];
+		txy[i + 1] = linearMap[2] * px + linearMap[3] * py + translation[1];
+	}
+}
+
+/// \brief       Number of points with |L * (x[i], y[i]) + t - (tx[i], ty[i])|^2 <= maxSquaredError.
+template <typename T>
+size_t AffineInlierLoop(const size_t n, const T* linearMap, const T* translation,
+                        const T* x, const T* y, const T* tx, const T* ty, const T maxSquaredError)
+{
+	typedef Vec<T> V;
+
+	const typename V::Type m00 = V::Set1(linearMap[0]);
+	const typename V::Type m01 = V::Set1(linearMap[1]);
+	const typename V::Type m10 = V::Set1(linearMap[2]);
+	const typename V::Type m11 = V::Set1(linearMap[3]);
+	const typename V::Type dx = V::Set1(translation[0]);
+	const typename V::Type dy = V::Set1(translation[1]);
+	const typename V::Type limit = V::Set1(maxSquaredError);
+
+	size_t count = 0;
+	size_t i = 0;
+	for (; i + V::Width <= n; i += V::Width)
+	{
+		const typename V::Type vx = V::Load(x + i);
+		const typename V::Type vy = V::Load(y + i);
+		const typename V::Type ex = V::Sub(V::Add(V::Add(V::Mul(m00, vx), V::Mul(m01, vy)), dx), V::Load(tx + i));
+		const typename V::Type ey = V::Sub(V::Add(V::Add(V::Mul(m10, vx), V::Mul(m11, vy)), dy), V::Load(ty + i));
+		count += V::CountLessEqual(V::Add(V::Mul(ex, ex), V::Mul(ey, ey)), limit);
+	}
+	for (; i < n; i++)
+	{
+		const T ex = linearMap[0] * x[i] + linearMap[1] * y[i] + translation[0] - tx[i];
+		const T ey = linearMap[2] * x[i] + linearMap[3] * y[i] + translation[1] - ty[i];
+		count += ex * ex + ey * ey <= maxSquaredError ? 1 : 0;
+	}
+	return count;
+}
@@ -0,0 +1,289 @@
+#ifndef Numeric_FixedMatrix_HPP
+#define Numeric_FixedMatrix_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include "Matrix.hpp"
+
+namespace numeric
+{
+	namespace detail
+	{
+		template <typename T, unsigned int R, unsigned int K, unsigned int C>
+		struct FixedProduct;
+	}
+
+	//
+	// Class : A matrix whose shape is fixed at compile time and whose elements are stored inline,
+	//         so it never allocates and can live on the stack or inside another object.
+	//
+	// Shapes are template arguments, so the arithmetic below needs no dimension checks: a
+	// mismatch does not compile. Element access through operator() is unchecked; GetElemAt and
+	// SetElemAt keep the std::out_of_range checks of Matrix. The 2x2, 2x1 and 3x3 products used
+	// by affine transforms are written out element by element.
+	//
+	template <typename T, unsigned int R, unsigned int C>
+	class FixedMatrix
+	{
+		static_assert(R > 0 && C > 0, "Rows and cols cann't be smaller than one.");
+
+	public:
+		typedef T ElemType;
+
+		static constexpr unsigned int Rows()        { return R; }
+		static constexpr unsigned int Cols()        { return C; }
+		static constexpr size_t       NumElements() { return static_cast<size_t>(R) * C; }
+
+		static void Zero(FixedMatrix& mat)
+		{
+			for (size_t i = 0; i < NumElements(); i++)
+			{
+				mat.m_elements[i] = T(0);
+			}
+		}
+
+		static void Ones(FixedMatrix& mat)
+		{
+			for (size_t i = 0; i < NumElements(); i++)
+			{
+				mat.m_elements[i] = T(1);
+			}
+		}
+
+		//
+		// c = alpha * a * b + beta * c, with the product kept in registers. c may be a or b;
+		// when beta is zero, c is only written.
+		//
+		template <unsigned int K>
+		static void Gemm(const T alpha, const FixedMatrix<T, R, K>& a, const FixedMatrix<T, K, C>& b,
+		                 const T beta, FixedMatrix& c)
+		{
+			T product[R * C];
+			detail::FixedProduct<T, R, K, C>::Run(a.Data(), b.Data(), product);
+			Axpby(alpha, product, beta, c.m_elements);
+		}
+
+		//
+		// y = alpha * x + beta * y; when beta is zero, y is only written.
+		//
+		static void Axpby(const T alpha, const FixedMatrix& x, const T beta, FixedMatrix& y)
+		{
+			Axpby(alpha, x.m_elements, beta, y.m_elements);
+		}
+
+	public:
+		//
+		// The elements are left uninitialised, as with Matrix(rows, cols).
+		//
+		FixedMatrix()
+		{
+		}
+
+		//
+		// Copy a Matrix of the same shape. Throws std::invalid_argument otherwise.
+		//
+		explicit FixedMatrix(const BasicMatrix<T>& mat)
+		{
+			if (mat.Rows() != R || mat.Cols() != C)
+			{
+				throw std::invalid_argument(
+					"Dimension mismatch"
+					);
+			}
+			const T* data = mat.Data();
+			for (size_t i = 0; i < NumElements(); i++)
+			{
+				m_elements[i] = data[i];
+			}
+		}
+
+		BasicMatrix<T> ToMatrix() const
+		{
+			BasicMatrix<T> mat(R, C);
+			T* data = mat.Data();
+			for (size_t i = 0; i < NumElements(); i++)
+			{
+				data[i] = m_elements[i];
+			}
+			return mat;
+		}
+
+		T& operator()(const unsigned int row, const unsigned int col)
+		{
+			return m_elements[row * C + col];
+		}
+
+		const T& operator()(const unsigned int row, const unsigned int col) const
+		{
+			return m_elements[row * C + col];
+		}
+
+		T GetElemAt(const unsigned int row, const unsigned int col) const
+		{
+			if (row >= R || col >= C)
+			{
+				throw std::out_of_range("Out of Range");
+			}
+			return m_elements[row * C + col];
+		}
+
+		void SetElemAt(const unsigned int row, const unsigned int col, const T value)
+		{
+			if (row >= R || col >= C)
+			{
+				throw std::out_of_range("Out of Range");
+			}
+			m_elements[row * C + col] = value;
+		}
+
+		T*       Data()       { return m_elements; }
+		const T* Data() const { return m_elements; }
+
+	private:
+		static void Axpby(const T alpha, const T* x, const T beta, T* y)
+		{
+			for (size_t i = 0; i < NumElements(); i++)
+			{
+				y[i] = beta == T(0) ? alpha * x[i] : alpha * x[i] + beta * y[i];
+			}
+		}
+
+	private:
+		T m_elements[R * C];
+	};
+
+
+	namespace detail
+	{
+		//
+		// Product of an R*K and a K*C fixed matrix. The loops have constant trip counts and are
+		// unrolled by the compiler; the shapes that affine transforms use are spelled out.
+		//
+		template <typename T, unsigned int R, unsigned int K, unsigned int C>
+		struct FixedProduct
+		{
+			static void Run(const T* a, const T* b, T* c)
+			{
+				for (unsigned int i = 0; i < R; i++)
+				{
+					for (unsigned int j = 0; j < C; j++)
+					{
+						T sum = T(0);
+						for (unsigned int p = 0; p < K; p++)
+						{
+							sum += a[i * K + p] * b[p * C + j];
+						}
+						c[i * C + j] = sum;
+					}
+				}
+			}
+		};
+
+		template <typename T>
+		struct FixedProduct<T, 2, 2, 2>
+		{
+			static void Run(const T* a, const T* b, T* c)
+			{
+				c[0] = a[0] * b[0] + a[1] * b[2];
+				c[1] = a[0] * b[1] + a[1] * b[3];
+				c[2] = a[2] * b[0] + a[3] * b[2];
+				c[3] = a[2] * b[1] + a[3] * b[3];
+			}
+		};
+
+		template <typename T>
+		struct FixedProduct<T, 2, 2, 1>
+		{
+			static void Run(const T* a, const T* b, T* c)
+			{
+				c[0] = a[0] * b[0] + a[1] * b[1];
+				c[1] = a[2] * b[0] + a[3] * b[1];
+			}
+		};
+
+		template <typename T>
+		struct FixedProduct<T, 3, 3, 3>
+		{
+			static void Run(const T* a, const T* b, T* c)
+			{
+				c[0] = a[0] * b[0] + a[1] * b[3] + a[2] * b[6];
+				c[1] = a[0] * b[1] + a[1] * b[4] + a[2] * b[7];
+				c[2] = a[0] * b[2] + a[1] * b[5] + a[2] * b[8];
+				c[3] = a[3] * b[0] + a[4] * b[3] + a[5] * b[6];
+				c[4] = a[3] * b[1] + a[4] * b[4] + a[5] * b[7];
+				c[5] = a[3] * b[2] + a[4] * b[5] + a[5] * b[8];
+				c[6] = a[6] * b[0] + a[7] * b[3] + a[8] * b[6];
+				c[7] = a[6] * b[1] + a[7] * b[4] + a[8] * b[7];
+				c[8] = a[6] * b[2] + a[7] * b[5] + a[8] * b[8];
+			}
+		};
+
+		template <typename T>
+		struct FixedProduct<T, 3, 3, 1>
+		{
+			static void Run(const T* a, const T* b, T* c)
+			{
+				c[0] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+				c[1] = a[3] * b[0] + a[4] * b[1] + a[5] * b[2];
+				c[2] = a[6] * b[0] + a[7] * b[1] + a[8] * b[2];
+			}
+		};
+	}
+
+
+	//
+	// Operators. Results are returned by value; at these sizes that is a handful of registers.
+	//
+	template <typename T, unsigned int R, unsigned int C>
+	inline FixedMatrix<T, R, C> operator+(const FixedMatrix<T, R, C>& lhs, const FixedMatrix<T, R, C>& rhs)
+	{
+		FixedMatrix<T, R, C> result;
+		for (size_t i = 0; i < FixedMatrix<T, R, C>::NumElements(); i++)
+		{
+			result.Data()[i] = lhs.Data()[i] + rhs.Data()[i];
+		}
+		return result;
+	}
+
+	template <typename T, unsigned int R, unsigned int C>
+	inline FixedMatrix<T, R, C> operator-(const FixedMatrix<T, R, C>& lhs, const FixedMatrix<T, R, C>& rhs)
+	{
+		FixedMatrix<T, R, C> result;
+		for (size_t i = 0; i < FixedMatrix<T, R, C>::NumElements(); i++)
+		{
+			result.Data()[i] = lhs.Data()[i] - rhs.Data()[i];
+		}
+		return result;
+	}
+
+	template <typename T, unsigned int R, unsigned int K, unsigned int C>
+	inline FixedMatrix<T, R, C> operator*(const FixedMatrix<T, R, K>& lhs, const FixedMatrix<T, K, C>& rhs)
+	{
+		FixedMatrix<T, R, C> result;
+		detail::FixedProduct<T, R, K, C>::Run(lhs.Data(), rhs.Data(), result.Data());
+		return result;
+	}
+
+	template <typename T, unsigned int R, unsigned int C>
+	inline FixedMatrix<T, R, C> operator*(const T s, const FixedMatrix<T, R, C>& mat)
+	{
+		FixedMatrix<T, R, C> result;
+		for (size_t i = 0; i < FixedMatrix<T, R, C>::NumElements(); i++)
+		{
+			result.Data()[i] = s * mat.Data()[i];
+		}
+		return result;
+	}
+
+	template <typename T, unsigned int R, unsigned int C>
+	inline FixedMatrix<T, R, C> operator*(const FixedMatrix<T, R, C>& mat, const T s)
+	{
+		return s * mat;
+	}
+
+	typedef FixedMatrix<double, 2, 2> Matrix2x2;
+	typedef FixedMatrix<double, 2, 1> Matrix2x1;
+	typedef FixedMatrix<double, 3, 3> Matrix3x3;
+}
+
+#endif
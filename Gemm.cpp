@@ -0,0 +1,446 @@
+
+#include "Gemm.hpp"
+#include "ThreadPool.hpp"
+#include "Tuning.hpp"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of the GEMM engine
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// The engine follows the usual Goto/BLIS structure:
+//
+//   for jc in steps of NC                       (columns of C and B)
+//     for pc in steps of KC                     (the shared dimension)
+//       pack B(pc:pc+KC, jc:jc+NC) into NR-wide micro-panels       -> stays in L3
+//       for ic in steps of MC                   (rows of C and A)
+//         pack A(ic:ic+MC, pc:pc+KC) into MR-tall micro-panels     -> stays in L2
+//         for each NR column strip, for each MR row strip
+//           micro-kernel: MR*NR block of C += packed A strip * packed B strip  (registers)
+//
+// Packing turns arbitrary strides into unit-stride streams, so the micro-kernel never sees the
+// layout of the operands.
+//
+namespace
+{
+	//
+	// Register tile per element type: MR*NR accumulators plus one row of B must fit in the
+	// register file, and a row of NR elements should fill whole vector registers, so the
+	// narrower types use a wider tile.
+	//
+	// The cache blocks MC, KC and NC come from the TuningParameters at run time: KC*NR fits in
+	// L1, MC*KC in L2 and KC*NC in L3. MC and NC must be multiples of MR and NR because the
+	// packing routines round every block up to whole micro-panels.
+	//
+	template <typename T>
+	struct GemmBlocking;
+
+	template <>
+	struct GemmBlocking<double>
+	{
+		static const unsigned int MR = 4;
+		static const unsigned int NR = 8;
+
+		static const kernel::GemmBlocks& Blocks(const kernel::TuningParameters& tuning)
+		{
+			return tuning.gemmDouble;
+		}
+	};
+
+	template <>
+	struct GemmBlocking<float>
+	{
+		static const unsigned int MR = 4;
+		static const unsigned int NR = 16;
+
+		static const kernel::GemmBlocks& Blocks(const kernel::TuningParameters& tuning)
+		{
+			return tuning.gemmFloat;
+		}
+	};
+
+	template <>
+	struct GemmBlocking<std::int32_t> : GemmBlocking<float>
+	{
+	};
+
+	//
+	// Products below this many multiply-adds skip packing entirely.
+	//
+	const double SmallProductFlops = 32.0 * 32.0 * 32.0;
+
+	//
+	// Number of output tiles handed out per thread, for load balancing.
+	//
+	const unsigned int TilesPerThread = 4;
+
+	template <typename T>
+	inline T& At(T* x, const std::ptrdiff_t rs, const std::ptrdiff_t cs,
+	             const std::ptrdiff_t i, const std::ptrdiff_t j)
+	{
+		return x[i * rs + j * cs];
+	}
+
+	/// \brief       Scale C by beta. A zero beta overwrites C so that uninitialised storage works.
+	template <typename T>
+	void ScaleC(const unsigned int m, const unsigned int n, const T beta,
+	            T* c, const std::ptrdiff_t rsc, const std::ptrdiff_t csc)
+	{
+		for (unsigned int i = 0; i < m; i++)
+		{
+			for (unsigned int j = 0; j < n; j++)
+			{
+				T& cij = At(c, rsc, csc, i, j);
+				cij = (beta == T(0)) ? T(0) : beta * cij;
+			}
+		}
+	}
+
+	/// \brief       Unblocked product for tiny shapes, where packing costs more than it saves.
+	template <typename T>
+	void SmallGemm(const unsigned int m, const unsigned int n, const unsigned int k,
+	               const T alpha,
+	               const T* a, const std::ptrdiff_t rsa, const std::ptrdiff_t csa,
+	               const T* b, const std::ptrdiff_t rsb, const std::ptrdiff_t csb,
+	               const T beta,
+	               T* c, const std::ptrdiff_t rsc, const std::ptrdiff_t csc)
+	{
+		for (unsigned int i = 0; i < m; i++)
+		{
+			for (unsigned int j = 0; j < n; j++)
+			{
+				T sum = 0;
+				for (unsigned int p = 0; p < k; p++)
+				{
+					sum += a[i * rsa + p * csa] * b[p * rsb + j * csb];
+				}
+				T& cij = At(c, rsc, csc, i, j);
+				cij = (beta == T(0)) ? alpha * sum : alpha * sum + beta * cij;
+			}
+		}
+	}
+
+	/// \brief       Pack an mc*kc block of A into MR-tall micro-panels, scaled by alpha.
+	///              Rows beyond mc are zero filled so the micro-kernel needs no edge cases.
+	///              A transposed operand (rsa == 1) has contiguous micro-panel columns.
+	template <typename T>
+	void PackA(const unsigned int mc, const unsigned int kc, const T alpha,
+	           const T* a, const std::ptrdiff_t rsa, const std::ptrdiff_t csa,
+	           T* packed)
+	{
+		const unsigned int MR = GemmBlocking<T>::MR;
+
+		for (unsigned int ir = 0; ir < mc; ir += MR)
+		{
+			const unsigned int mr = std::min(MR, mc - ir);
+			for (unsigned int p = 0; p < kc; p++)
+			{
+				unsigned int i = 0;
+				if (rsa == 1)
+				{
+					const T* acol = a + ir + p * csa;
+					for (; i < mr; i++)
+					{
+						packed[i] = alpha * acol[i];
+					}
+				}
+				for (; i < mr; i++)
+				{
+					packed[i] = alpha * a[(ir + i) * rsa + p * csa];
+				}
+				for (; i < MR; i++)
+				{
+					packed[i] = 0;
+				}
+				packed += MR;
+			}
+		}
+	}
+
+	/// \brief       Pack a kc*nc block of B into NR-wide micro-panels, zero filling the edge.
+	///              A transposed operand (rsb == 1) is read one contiguous column at a time.
+	template <typename T>
+	void PackB(const unsigned int kc, const unsigned int nc,
+	           const T* b, const std::ptrdiff_t rsb, const std::ptrdiff_t csb,
+	           T* packed)
+	{
+		const unsigned int NR = GemmBlocking<T>::NR;
+
+		for (unsigned int jr = 0; jr < nc; jr += NR)
+		{
+			const unsigned int nr = std::min(NR, nc - jr);
+			if (rsb == 1 && csb != 1)
+			{
+				for (unsigned int j = 0; j < NR; j++)
+				{
+					const T* bcol = b + (jr + j) * csb;
+					for (unsigned int p = 0; p < kc; p++)
+					{
+						packed[p * NR + j] = j < nr ? bcol[p] : T(0);
+					}
+				}
+				packed += kc * NR;
+				continue;
+			}
+			for (unsigned int p = 0; p < kc; p++)
+			{
+				const T* brow = b + p * rsb + jr * csb;
+				unsigned int j = 0;
+				if (csb == 1)
+				{
+					for (; j < nr; j++)
+					{
+						packed[j] = brow[j];
+					}
+				}
+				else
+				{
+					for (; j < nr; j++)
+					{
+						packed[j] = brow[j * csb];
+					}
+				}
+				for (; j < NR; j++)
+				{
+					packed[j] = 0;
+				}
+				packed += NR;
+			}
+		}
+	}
+
+	/// \brief       Register-tiled micro-kernel: C(mr*nr) = A(MR*kc) * B(kc*NR) + beta * C.
+	///              The MR*NR accumulators are kept in a local array the compiler maps to
+	///              registers; only the mr*nr corner is written back at the matrix edges.
+	template <typename T>
+	void MicroKernel(const unsigned int kc, const T* a, const T* b, const T beta,
+	                 T* c, const std::ptrdiff_t rsc, const std::ptrdiff_t csc,
+	                 const unsigned int mr, const unsigned int nr)
+	{
+		const unsigned int MR = GemmBlocking<T>::MR;
+		const unsigned int NR = GemmBlocking<T>::NR;
+
+		T ab[MR * NR];
+		for (unsigned int i = 0; i < MR * NR; i++)
+		{
+			ab[i] = 0;
+		}
+
+		for (unsigned int p = 0; p < kc; p++)
+		{
+			for (unsigned int i = 0; i < MR; i++)
+			{
+				const T ai = a[i];
+				for (unsigned int j = 0; j < NR; j++)
+				{
+					ab[i * NR + j] += ai * b[j];
+				}
+			}
+			a += MR;
+			b += NR;
+		}
+
+		for (unsigned int i = 0; i < mr; i++)
+		{
+			for (unsigned int j = 0; j < nr; j++)
+			{
+				T& cij = At(c, rsc, csc, i, j);
+				cij = (beta == T(0)) ? ab[i * NR + j] : ab[i * NR + j] + beta * cij;
+			}
+		}
+	}
+
+	/// \brief       Multiply a packed MC*KC block of A with a packed KC*NC panel of B.
+	template <typename T>
+	void MacroKernel(const unsigned int mc, const unsigned int nc, const unsigned int kc,
+	                 const T* packedA, const T* packedB, const T beta,
+	                 T* c, const std::ptrdiff_t rsc, const std::ptrdiff_t csc)
+	{
+		const unsigned int MR = GemmBlocking<T>::MR;
+		const unsigned int NR = GemmBlocking<T>::NR;
+
+		for (unsigned int jr = 0; jr < nc; jr += NR)
+		{
+			const unsigned int nr = std::min(NR, nc - jr);
+			for (unsigned int ir = 0; ir < mc; ir += MR)
+			{
+				const unsigned int mr = std::min(MR, mc - ir);
+				MicroKernel(kc, packedA + ir * kc, packedB + jr * kc, beta,
+				            c + ir * rsc + jr * csc, rsc, csc, mr, nr);
+			}
+		}
+	}
+
+	template <typename T>
+	void BlockedGemm(const kernel::GemmBlocks& blocks,
+	                 const unsigned int m, const unsigned int n, const unsigned int k,
+	                 const T alpha,
+	                 const T* a, const std::ptrdiff_t rsa, const std::ptrdiff_t csa,
+	                 const T* b, const std::ptrdiff_t rsb, const std::ptrdiff_t csb,
+	                 const T beta,
+	                 T* c, const std::ptrdiff_t rsc, const std::ptrdiff_t csc)
+	{
+		const unsigned int NR = GemmBlocking<T>::NR;
+		const unsigned int MC = blocks.mc;
+		const unsigned int KC = blocks.kc;
+		const unsigned int NC = blocks.nc;
+
+		//
+		// Packing buffers are kept per thread and only ever grow, so repeated products of
+		// similar shapes do not go back to the heap.
+		//
+		static thread_local std::vector<T> bufA;
+		static thread_local std::vector<T> bufB;
+		const size_t sizeA = static_cast<size_t>(MC) * KC;
+		const size_t sizeB = static_cast<size_t>(KC) * (std::min(NC, n) + NR);
+		if (bufA.size() < sizeA)
+		{
+			bufA.resize(sizeA);
+		}
+		if (bufB.size() < sizeB)
+		{
+			bufB.resize(sizeB);
+		}
+
+		for (unsigned int jc = 0; jc < n; jc += NC)
+		{
+			const unsigned int nc = std::min(NC, n - jc);
+			for (unsigned int pc = 0; pc < k; pc += KC)
+			{
+				const unsigned int kc = std::min(KC, k - pc);
+				const T betaBlock = (pc == 0) ? beta : T(1);
+				PackB(kc, nc, b + pc * rsb + jc * csb, rsb, csb, &bufB[0]);
+
+				for (unsigned int ic = 0; ic < m; ic += MC)
+				{
+					const unsigned int mc = std::min(MC, m - ic);
+					PackA(mc, kc, alpha, a + ic * rsa + pc * csa, rsa, csa, &bufA[0]);
+					MacroKernel(mc, nc, kc, &bufA[0], &bufB[0], betaBlock,
+					            c + ic * rsc + jc * csc, rsc, csc);
+				}
+			}
+		}
+	}
+
+	inline unsigned int RoundUp(const unsigned int x, const unsigned int multiple)
+	{
+		return (x + multiple - 1) / multiple * multiple;
+	}
+
+	/// \brief       Split C into a grid of tiles and run the blocked product of each tile on the
+	///              thread pool. Each tile packs its own panels, so workers share nothing but
+	///              the read-only operands.
+	template <typename T>
+	void ParallelGemm(const kernel::GemmBlocks& blocks, const unsigned int numThreads,
+	                  const unsigned int m, const unsigned int n, const unsigned int k,
+	                  const T alpha,
+	                  const T* a, const std::ptrdiff_t rsa, const std::ptrdiff_t csa,
+	                  const T* b, const std::ptrdiff_t rsb, const std::ptrdiff_t csb,
+	                  const T beta,
+	                  T* c, const std::ptrdiff_t rsc, const std::ptrdiff_t csc)
+	{
+		const unsigned int MR = GemmBlocking<T>::MR;
+		const unsigned int NR = GemmBlocking<T>::NR;
+
+		//
+		// Aim for roughly square tiles, whole micro-panels wide and tall.
+		//
+		const unsigned int targetTiles = numThreads * TilesPerThread;
+		const unsigned int maxRowParts = (m + MR - 1) / MR;
+		const unsigned int maxColParts = (n + NR - 1) / NR;
+
+		double colEstimate = std::sqrt(static_cast<double>(targetTiles) * n / m);
+		unsigned int colParts = static_cast<unsigned int>(colEstimate + 0.5);
+		colParts = std::max(1u, std::min(colParts, maxColParts));
+		unsigned int rowParts = (targetTiles + colParts - 1) / colParts;
+		rowParts = std::max(1u, std::min(rowParts, maxRowParts));
+
+		const unsigned int tileM = RoundUp((m + rowParts - 1) / rowParts, MR);
+		const unsigned int tileN = RoundUp((n + colParts - 1) / colParts, NR);
+		const unsigned int rowTiles = (m + tileM - 1) / tileM;
+		const unsigned int colTiles = (n + tileN - 1) / tileN;
+
+		ThreadPool::Instance().ParallelFor(static_cast<size_t>(rowTiles) * colTiles,
+			[&](size_t tile)
+			{
+				const unsigned int i0 = static_cast<unsigned int>(tile / colTiles) * tileM;
+				const unsigned int j0 = static_cast<unsigned int>(tile % colTiles) * tileN;
+				BlockedGemm(blocks, std::min(tileM, m - i0), std::min(tileN, n - j0), k,
+				            alpha,
+				            a + i0 * rsa, rsa, csa,
+				            b + j0 * csb, rsb, csb,
+				            beta,
+				            c + i0 * rsc + j0 * csc, rsc, csc);
+			});
+	}
+}
+
+
+/// \brief       General matrix multiply, C = alpha * A * B + beta * C, on strided storage.
+/// \param[in]   m, n, k. A is m*k, B is k*n, C is m*n.
+/// \param[in]   alpha. Scale applied to the product.
+/// \param[in]   a, rsa, csa. A and its row and column strides.
+/// \param[in]   b, rsb, csb. B and its row and column strides.
+/// \param[in]   beta. Scale applied to the previous contents of C.
+/// \param[out]  c, rsc, csc. C and its row and column strides.
+template <typename T>
+void kernel::Gemm(const unsigned int m,
+                  const unsigned int n,
+                  const unsigned int k,
+                  const T alpha,
+                  const T* a, const std::ptrdiff_t rsa, const std::ptrdiff_t csa,
+                  const T* b, const std::ptrdiff_t rsb, const std::ptrdiff_t csb,
+                  const T beta,
+                  T* c, const std::ptrdiff_t rsc, const std::ptrdiff_t csc)
+{
+	if (m == 0 || n == 0)
+	{
+		return;
+	}
+
+	if (k == 0 || alpha == T(0))
+	{
+		ScaleC(m, n, beta, c, rsc, csc);
+		return;
+	}
+
+	const double flops = static_cast<double>(m) * n * k;
+	if (flops <= SmallProductFlops)
+	{
+		SmallGemm(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+		return;
+	}
+
+	//
+	// Products below the parallel threshold run on the calling thread only. Dispatching to the
+	// pool costs a few microseconds, which small products cannot win back.
+	//
+	const kernel::TuningParameters tuning = kernel::Tuning();
+	const kernel::GemmBlocks& blocks = GemmBlocking<T>::Blocks(tuning);
+	const unsigned int numThreads = ThreadPool::NumThreads();
+	if (numThreads > 1 && flops >= tuning.gemmParallelFlops)
+	{
+		ParallelGemm(blocks, numThreads, m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+		return;
+	}
+
+	BlockedGemm(blocks, m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, csc);
+}
+
+
+#define NUMERIC_INSTANTIATE_GEMM(T)                                                          \
+	template void kernel::Gemm<T>(const unsigned int, const unsigned int, const unsigned int,  \
+		const T, const T*, const std::ptrdiff_t, const std::ptrdiff_t,                          \
+		const T*, const std::ptrdiff_t, const std::ptrdiff_t,                                   \
+		const T, T*, const std::ptrdiff_t, const std::ptrdiff_t);
+
+NUMERIC_INSTANTIATE_GEMM(float)
+NUMERIC_INSTANTIATE_GEMM(double)
+NUMERIC_INSTANTIATE_GEMM(std::int32_t)
+
+#undef NUMERIC_INSTANTIATE_GEMM
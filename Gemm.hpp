@@ -0,0 +1,31 @@
+#ifndef Numeric_Gemm_HPP
+#define Numeric_Gemm_HPP
+
+#include <cstddef>
+
+namespace numeric
+{
+	namespace kernel
+	{
+		//
+		// Function : General matrix multiply on raw storage,
+		//      C = alpha * A * B + beta * C
+		//      A is m*k, B is k*n and C is m*n. Element (i,j) of X lives at x[i*rsx + j*csx],
+		//      so row-major, column-major and transposed operands are all expressed by strides.
+		//
+		// Note: C must not overlap A or B. When beta is zero, C is not read.
+		//       Instantiated for float, double and std::int32_t.
+		//
+		template <typename T>
+		void Gemm(const unsigned int m,
+		          const unsigned int n,
+		          const unsigned int k,
+		          const T alpha,
+		          const T* a, const std::ptrdiff_t rsa, const std::ptrdiff_t csa,
+		          const T* b, const std::ptrdiff_t rsb, const std::ptrdiff_t csb,
+		          const T beta,
+		          T* c, const std::ptrdiff_t rsc, const std::ptrdiff_t csc);
+	}
+}
+
+#endif
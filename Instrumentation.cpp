@@ -0,0 +1,218 @@
+
+#include "Instrumentation.hpp"
+#include <cstdio>
+#include <sstream>
+
+using namespace numeric;
+using namespace numeric::instrumentation;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of Instrumentation
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Names in Operation order.
+	//
+	const char* const OperationNames[NumOperations] =
+	{
+		"Matrix::DotMul",
+		"Matrix::Mul",
+		"Matrix::StrassenMul",
+		"Matrix::Mul(scalar)",
+		"Matrix::Add",
+		"Matrix::Sub",
+		"Matrix::DotMul(view)",
+		"Matrix::Mul(view)",
+		"Matrix::Add(view)",
+		"Matrix::Sub(view)",
+		"Matrix::Gemm",
+		"Matrix::Axpby",
+		"Matrix::Gemm(view)",
+		"Matrix::Axpby(view)",
+		"Matrix::Zero",
+		"Matrix::Ones",
+		"Matrix::Max",
+		"Matrix::Min",
+		"Matrix::Sum",
+		"Matrix::Mean",
+		"Matrix::Norm",
+		"Matrix::Dot",
+		"Matrix::RowReduce",
+		"Matrix::ColReduce",
+		"Matrix::Transpose",
+		"Matrix::Matrix(copy)",
+		"Matrix::operator=(copy)",
+		"Matrix expression",
+		"AffineTransform",
+		"AffineTransform(point)",
+		"AffineTransformPoints",
+		"InverseAffineTransform",
+		"CombineAffineTransform",
+		"CombineAffineTransformPrefixes",
+		"CombineAffineTransforms",
+		"EstimateAffineTransform",
+		"EstimateAffineTransformRansac"
+	};
+
+	//
+	// Zero-initialised as objects of static storage duration.
+	//
+	Counters                   g_operations[NumOperations];
+	std::atomic<std::uint64_t> g_allocations;
+	std::atomic<std::uint64_t> g_allocatedBytes;
+	std::atomic<std::uint64_t> g_bytesCopied;
+
+	std::string JsonString(const char* text)
+	{
+		std::string quoted = "\"";
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				quoted += '\\';
+			}
+			quoted += *c;
+		}
+		return quoted + "\"";
+	}
+}
+
+
+/// \brief      Name of an operation, e.g. "Matrix::Mul".
+const char* numeric::instrumentation::OperationName(const Operation op)
+{
+	return op >= 0 && op < NumOperations ? OperationNames[op] : "";
+}
+
+
+/// \brief      True when the library was built with NUMERIC_INSTRUMENTATION.
+bool numeric::instrumentation::Enabled()
+{
+#if defined(NUMERIC_INSTRUMENTATION)
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+/// \brief      Read every counter.
+Snapshot numeric::instrumentation::TakeSnapshot()
+{
+	Snapshot snapshot;
+	snapshot.operations.resize(NumOperations);
+	for (int op = 0; op < NumOperations; op++)
+	{
+		OperationStats& stats = snapshot.operations[op];
+		stats.name = OperationNames[op];
+		stats.calls = g_operations[op].calls.load(std::memory_order_relaxed);
+		stats.elements = g_operations[op].elements.load(std::memory_order_relaxed);
+		stats.flops = g_operations[op].flops.load(std::memory_order_relaxed);
+		stats.nanoseconds = g_operations[op].nanoseconds.load(std::memory_order_relaxed);
+	}
+	snapshot.allocations = g_allocations.load(std::memory_order_relaxed);
+	snapshot.allocatedBytes = g_allocatedBytes.load(std::memory_order_relaxed);
+	snapshot.bytesCopied = g_bytesCopied.load(std::memory_order_relaxed);
+	return snapshot;
+}
+
+
+/// \brief      Zero every counter.
+void numeric::instrumentation::Reset()
+{
+	for (int op = 0; op < NumOperations; op++)
+	{
+		g_operations[op].calls.store(0, std::memory_order_relaxed);
+		g_operations[op].elements.store(0, std::memory_order_relaxed);
+		g_operations[op].flops.store(0, std::memory_order_relaxed);
+		g_operations[op].nanoseconds.store(0, std::memory_order_relaxed);
+	}
+	g_allocations.store(0, std::memory_order_relaxed);
+	g_allocatedBytes.store(0, std::memory_order_relaxed);
+	g_bytesCopied.store(0, std::memory_order_relaxed);
+}
+
+
+/// \brief      One line per operation that was called, then the allocation totals.
+/// \param[in]  snapshot.
+std::string numeric::instrumentation::ToText(const Snapshot& snapshot)
+{
+	std::ostringstream os;
+	char line[256];
+	std::snprintf(line, sizeof(line), "%-32s %12s %16s %16s %14s %10s\n",
+	              "operation", "calls", "elements", "flops", "time (ms)", "GFLOP/s");
+	os << line;
+	for (size_t i = 0; i < snapshot.operations.size(); i++)
+	{
+		const OperationStats& stats = snapshot.operations[i];
+		if (stats.calls == 0)
+		{
+			continue;
+		}
+		const double gflops = stats.nanoseconds > 0 ?
+			static_cast<double>(stats.flops) / static_cast<double>(stats.nanoseconds) : 0.0;
+		std::snprintf(line, sizeof(line), "%-32s %12llu %16llu %16llu %14.3f %10.3f\n",
+		              stats.name,
+		              static_cast<unsigned long long>(stats.calls),
+		              static_cast<unsigned long long>(stats.elements),
+		              static_cast<unsigned long long>(stats.flops),
+		              static_cast<double>(stats.nanoseconds) * 1e-6,
+		              gflops);
+		os << line;
+	}
+	os << "allocations " << snapshot.allocations
+	   << ", allocated bytes " << snapshot.allocatedBytes
+	   << ", bytes copied " << snapshot.bytesCopied << "\n";
+	return os.str();
+}
+
+
+/// \brief      Every operation, called or not, as a JSON object.
+/// \param[in]  snapshot.
+std::string numeric::instrumentation::ToJson(const Snapshot& snapshot)
+{
+	std::ostringstream os;
+	os << "{\n  \"operations\": [\n";
+	for (size_t i = 0; i < snapshot.operations.size(); i++)
+	{
+		const OperationStats& stats = snapshot.operations[i];
+		os << "    {\"name\": " << JsonString(stats.name)
+		   << ", \"calls\": " << stats.calls
+		   << ", \"elements\": " << stats.elements
+		   << ", \"flops\": " << stats.flops
+		   << ", \"nanoseconds\": " << stats.nanoseconds
+		   << "}" << (i + 1 < snapshot.operations.size() ? "," : "") << "\n";
+	}
+	os << "  ],\n"
+	   << "  \"allocations\": " << snapshot.allocations << ",\n"
+	   << "  \"allocated_bytes\": " << snapshot.allocatedBytes << ",\n"
+	   << "  \"bytes_copied\": " << snapshot.bytesCopied << "\n"
+	   << "}\n";
+	return os.str();
+}
+
+
+Counters& numeric::instrumentation::CountersOf(const Operation op)
+{
+	return g_operations[op];
+}
+
+
+void numeric::instrumentation::CountFlops(const Operation op, const std::uint64_t flops)
+{
+	g_operations[op].flops.fetch_add(flops, std::memory_order_relaxed);
+}
+
+
+void numeric::instrumentation::CountAllocation(const size_t bytes)
+{
+	g_allocations.fetch_add(1, std::memory_order_relaxed);
+	g_allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+
+void numeric::instrumentation::CountCopy(const size_t bytes)
+{
+	g_bytesCopied.fetch_add(bytes, std::memory_order_relaxed);
+}
@@ -0,0 +1,180 @@
+#ifndef Numeric_Instrumentation_HPP
+#define Numeric_Instrumentation_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// Instrumentation of the public Matrix and affine-transform functions. It is compiled in when
+// the library and its users are built with -DNUMERIC_INSTRUMENTATION (the CMake option
+// NUMERIC_ENABLE_INSTRUMENTATION); otherwise the NUMERIC_INSTRUMENT_* macros expand to nothing,
+// their arguments are not evaluated, and the snapshot functions below report zeros.
+//
+#if defined(NUMERIC_INSTRUMENTATION)
+	#define NUMERIC_INSTRUMENT_OPERATION(op, elements, flops) \
+		const numeric::instrumentation::ScopedOperation numericScopedOperation_((op), (elements), (flops))
+	#define NUMERIC_INSTRUMENT_FLOPS(op, flops)  numeric::instrumentation::CountFlops((op), (flops))
+	#define NUMERIC_INSTRUMENT_ALLOCATION(bytes) numeric::instrumentation::CountAllocation(bytes)
+	#define NUMERIC_INSTRUMENT_COPY(bytes)       numeric::instrumentation::CountCopy(bytes)
+#else
+	#define NUMERIC_INSTRUMENT_OPERATION(op, elements, flops) ((void)0)
+	#define NUMERIC_INSTRUMENT_FLOPS(op, flops)               ((void)0)
+	#define NUMERIC_INSTRUMENT_ALLOCATION(bytes)              ((void)0)
+	#define NUMERIC_INSTRUMENT_COPY(bytes)                    ((void)0)
+#endif
+
+namespace numeric
+{
+	namespace instrumentation
+	{
+		//
+		// Instrumented operations. Names are given by OperationName.
+		//
+		enum Operation
+		{
+			OpMatrixDotMul,
+			OpMatrixMul,
+			OpMatrixStrassenMul,
+			OpMatrixScale,
+			OpMatrixAdd,
+			OpMatrixSub,
+			OpViewDotMul,
+			OpViewMul,
+			OpViewAdd,
+			OpViewSub,
+			OpMatrixGemm,
+			OpMatrixAxpby,
+			OpViewGemm,
+			OpViewAxpby,
+			OpMatrixZero,
+			OpMatrixOnes,
+			OpMatrixMax,
+			OpMatrixMin,
+			OpMatrixSum,
+			OpMatrixMean,
+			OpMatrixNorm,
+			OpMatrixDot,
+			OpMatrixRowReduce,
+			OpMatrixColReduce,
+			OpMatrixTranspose,
+			OpMatrixCopyConstruct,
+			OpMatrixCopyAssign,
+			OpMatrixExpression,
+			OpAffineTransform,
+			OpAffineTransformPoint,
+			OpAffineTransformPoints,
+			OpInverseAffineTransform,
+			OpCombineAffineTransform,
+			OpCombineAffineTransformPrefixes,
+			OpCombineAffineTransforms,
+			OpEstimateAffineTransform,
+			OpEstimateAffineTransformRansac,
+			NumOperations
+		};
+
+		const char* OperationName(const Operation op);
+
+		//
+		// Totals of one operation. Times are wall-clock and inclusive: an operation that calls
+		// another public function counts the callee's time too. Matrix expressions count the
+		// flops of the products they contain.
+		//
+		struct OperationStats
+		{
+			const char*   name;
+			std::uint64_t calls;
+			std::uint64_t elements;
+			std::uint64_t flops;
+			std::uint64_t nanoseconds;
+		};
+
+		//
+		// Allocations are the storage blocks matrices take from their Allocator; bytes copied
+		// are the elements moved by copy construction, copy assignment and Reserve.
+		//
+		struct Snapshot
+		{
+			std::vector<OperationStats> operations;
+			std::uint64_t               allocations;
+			std::uint64_t               allocatedBytes;
+			std::uint64_t               bytesCopied;
+		};
+
+		//
+		// Function : Whether the library was built with instrumentation.
+		//
+		bool Enabled();
+
+		//
+		// Function : The counters so far, one entry per Operation in enum order. Counters are
+		//      updated without locks, so a snapshot taken while other threads work is a
+		//      consistent set of values only per counter.
+		//
+		Snapshot TakeSnapshot();
+
+		//
+		// Function : Set every counter to zero.
+		//
+		void Reset();
+
+		//
+		// Function : Format a snapshot as an aligned table, skipping operations never called,
+		//      or as a JSON object with "operations", "allocations", "allocated_bytes" and
+		//      "bytes_copied" members.
+		//
+		std::string ToText(const Snapshot& snapshot);
+		std::string ToJson(const Snapshot& snapshot);
+
+		//
+		// The counters behind the macros; not meant to be used directly.
+		//
+		struct Counters
+		{
+			std::atomic<std::uint64_t> calls;
+			std::atomic<std::uint64_t> elements;
+			std::atomic<std::uint64_t> flops;
+			std::atomic<std::uint64_t> nanoseconds;
+		};
+
+		Counters& CountersOf(const Operation op);
+		void      CountFlops(const Operation op, const std::uint64_t flops);
+		void      CountAllocation(const size_t bytes);
+		void      CountCopy(const size_t bytes);
+
+		//
+		// Class : Counts one call of op and adds the time until it goes out of scope.
+		//
+		class ScopedOperation
+		{
+		public:
+			ScopedOperation(const Operation op, const std::uint64_t elements, const std::uint64_t flops)
+				: m_counters(CountersOf(op)), m_start(std::chrono::steady_clock::now())
+			{
+				m_counters.calls.fetch_add(1, std::memory_order_relaxed);
+				m_counters.elements.fetch_add(elements, std::memory_order_relaxed);
+				m_counters.flops.fetch_add(flops, std::memory_order_relaxed);
+			}
+
+			~ScopedOperation()
+			{
+				const std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - m_start;
+				m_counters.nanoseconds.fetch_add(static_cast<std::uint64_t>(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), std::memory_order_relaxed);
+			}
+
+		private:
+			ScopedOperation(const ScopedOperation&);
+			ScopedOperation& operator=(const ScopedOperation&);
+
+		private:
+			Counters&                             m_counters;
+			std::chrono::steady_clock::time_point m_start;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,287 @@
+
+#include "LUDecomposition.hpp"
+#include "Gemm.hpp"
+#include "Triangular.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of LUDecomposition
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Columns per panel. The trailing update is a GEMM with this inner dimension.
+	//
+	const unsigned int PanelWidth = 128;
+}
+
+
+template <typename T>
+BasicLUDecomposition<T>::BasicLUDecomposition()
+	: m_singular(false)
+{
+}
+
+
+/// \brief     Factor mat.
+/// \param[in] mat. Square matrix.
+template <typename T>
+BasicLUDecomposition<T>::BasicLUDecomposition(const BasicMatrix<T>& mat)
+	: m_singular(false)
+{
+	Factorize(mat);
+}
+
+
+/// \brief     Compute P * A = L * U.
+/// \param[in] mat. Square matrix.
+template <typename T>
+void BasicLUDecomposition<T>::Factorize(const BasicMatrix<T>& mat)
+{
+	if (mat.Rows() != mat.Cols())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	const unsigned int n = mat.Rows();
+	m_lu.Resize(n, n);
+	std::copy(mat.Data(), mat.Data() + mat.NumElements(), m_lu.Data());
+	m_pivots.resize(n);
+	m_singular = false;
+
+	T* a = m_lu.Data();
+	for (unsigned int k = 0; k < n; k += PanelWidth)
+	{
+		const unsigned int nb = std::min(PanelWidth, n - k);
+		FactorPanel(k, nb);
+
+		const unsigned int next = k + nb;
+		if (next < n)
+		{
+			//
+			// U12 = L11^-1 * A12, then A22 -= L21 * U12.
+			//
+			kernel::SolveTriangular<T>(true, true, nb, n - next,
+				a + k * n + k, n, 1,
+				a + k * n + next, n);
+			kernel::Gemm<T>(n - next, n - next, nb,
+				T(-1), a + next * n + k, n, 1,
+				a + k * n + next, n, 1,
+				T(1), a + next * n + next, n, 1);
+		}
+	}
+}
+
+
+/// \brief     Unblocked factorization of columns [k, k + nb) of rows [k, n). Pivot rows are
+///            swapped across the full width, so the interchanges also reach the parts of L
+///            already computed and the trailing columns still to be updated.
+/// \param[in] k. First column of the panel.
+/// \param[in] nb. Width of the panel.
+template <typename T>
+void BasicLUDecomposition<T>::FactorPanel(const unsigned int k, const unsigned int nb)
+{
+	const unsigned int n = m_lu.Rows();
+	const unsigned int end = k + nb;
+	T* a = m_lu.Data();
+
+	for (unsigned int j = k; j < end; j++)
+	{
+		unsigned int pivot = j;
+		T largest = std::abs(a[j * n + j]);
+		for (unsigned int i = j + 1; i < n; i++)
+		{
+			const T value = std::abs(a[i * n + j]);
+			if (value > largest)
+			{
+				largest = value;
+				pivot = i;
+			}
+		}
+
+		m_pivots[j] = pivot;
+		if (pivot != j)
+		{
+			std::swap_ranges(a + j * n, a + (j + 1) * n, a + pivot * n);
+		}
+
+		const T diag = a[j * n + j];
+		if (diag == T(0))
+		{
+			m_singular = true;
+			continue;
+		}
+
+		const T inv = T(1) / diag;
+		const T* uj = a + j * n;
+		for (unsigned int i = j + 1; i < n; i++)
+		{
+			T* ai = a + i * n;
+			const T l = ai[j] * inv;
+			ai[j] = l;
+			for (unsigned int c = j + 1; c < end; c++)
+			{
+				ai[c] -= l * uj[c];
+			}
+		}
+	}
+}
+
+
+template <typename T>
+unsigned int BasicLUDecomposition<T>::Size() const
+{
+	return m_lu.Rows();
+}
+
+
+template <typename T>
+bool BasicLUDecomposition<T>::IsSingular() const
+{
+	return m_singular;
+}
+
+
+/// \brief      Solve A * X = B using the stored factors.
+/// \param[in]  b. n*nrhs right-hand sides.
+/// \param[out] x. n*nrhs solutions; may be b.
+template <typename T>
+void BasicLUDecomposition<T>::Solve(const BasicMatrix<T>& b, BasicMatrix<T>& x) const
+{
+	const unsigned int n = Size();
+	if (b.Rows() != n || x.Rows() != n || x.Cols() != b.Cols())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+	if (m_singular)
+	{
+		throw std::runtime_error("Matrix is singular");
+	}
+
+	if (&x != &b)
+	{
+		std::copy(b.Data(), b.Data() + b.NumElements(), x.Data());
+	}
+
+	const unsigned int nrhs = x.Cols();
+	T* px = x.Data();
+	for (unsigned int i = 0; i < n; i++)
+	{
+		if (m_pivots[i] != i)
+		{
+			std::swap_ranges(px + i * nrhs, px + (i + 1) * nrhs, px + m_pivots[i] * nrhs);
+		}
+	}
+
+	const T* lu = m_lu.Data();
+	kernel::SolveTriangular<T>(true, true, n, nrhs, lu, n, 1, px, nrhs);
+	kernel::SolveTriangular<T>(false, false, n, nrhs, lu, n, 1, px, nrhs);
+}
+
+
+/// \brief      Compute the inverse by solving against the identity.
+/// \param[out] inv. n*n matrix.
+template <typename T>
+void BasicLUDecomposition<T>::Inverse(BasicMatrix<T>& inv) const
+{
+	const unsigned int n = Size();
+	if (inv.Rows() != n || inv.Cols() != n)
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	BasicMatrix<T>::Zero(inv);
+	for (unsigned int i = 0; i < n; i++)
+	{
+		inv(i, i) = T(1);
+	}
+	Solve(inv, inv);
+}
+
+
+/// \brief  The determinant: the product of the pivots, negated for an odd number of row
+///         interchanges, or zero for a singular matrix, whose other pivots may overflow.
+template <typename T>
+T BasicLUDecomposition<T>::Determinant() const
+{
+	if (m_singular)
+	{
+		return T(0);
+	}
+
+	const unsigned int n = Size();
+	T det = T(1);
+	for (unsigned int i = 0; i < n; i++)
+	{
+		det *= m_lu.Data()[i * n + i];
+		if (m_pivots[i] != i)
+		{
+			det = -det;
+		}
+	}
+	return det;
+}
+
+
+template <typename T>
+const BasicMatrix<T>& BasicLUDecomposition<T>::Factors() const
+{
+	return m_lu;
+}
+
+
+template <typename T>
+const std::vector<unsigned int>& BasicLUDecomposition<T>::Pivots() const
+{
+	return m_pivots;
+}
+
+
+/// \brief      Solve A * X = B.
+/// \param[in]  a. n*n matrix.
+/// \param[in]  b. n*nrhs right-hand sides.
+/// \param[out] x. n*nrhs solutions; may be b.
+template <typename T>
+void numeric::Solve(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& x)
+{
+	BasicLUDecomposition<T>(a).Solve(b, x);
+}
+
+
+/// \brief      Invert a square matrix.
+/// \param[in]  a. n*n matrix.
+/// \param[out] inv. n*n matrix; may be a.
+template <typename T>
+void numeric::Inverse(const BasicMatrix<T>& a, BasicMatrix<T>& inv)
+{
+	BasicLUDecomposition<T>(a).Inverse(inv);
+}
+
+
+template <typename T>
+T numeric::Determinant(const BasicMatrix<T>& a)
+{
+	return BasicLUDecomposition<T>(a).Determinant();
+}
+
+
+#define NUMERIC_INSTANTIATE_LU(T)                                                              \
+	template class numeric::BasicLUDecomposition<T>;                                           \
+	template void numeric::Solve<T>(const BasicMatrix<T>&, const BasicMatrix<T>&,              \
+	                                BasicMatrix<T>&);                                          \
+	template void numeric::Inverse<T>(const BasicMatrix<T>&, BasicMatrix<T>&);                 \
+	template T numeric::Determinant<T>(const BasicMatrix<T>&);
+
+NUMERIC_INSTANTIATE_LU(float)
+NUMERIC_INSTANTIATE_LU(double)
+
+#undef NUMERIC_INSTANTIATE_LU
@@ -0,0 +1,81 @@
+#ifndef Numeric_LUDecomposition_HPP
+#define Numeric_LUDecomposition_HPP
+
+#include <vector>
+#include <stdexcept>
+#include "Matrix.hpp"
+
+namespace numeric
+{
+	//
+	// Class : LU factorization with partial pivoting, P * A = L * U, of a square matrix.
+	//
+	// The factorization is right-looking and blocked: each panel of columns is factored with
+	// row pivoting, and the trailing matrix is then updated with one GEMM call, so almost all
+	// of the work runs on the fast matrix-multiply path. The factors are kept, so one
+	// factorization serves any number of Solve, Inverse and Determinant calls.
+	//
+	// A matrix with an exactly zero pivot is reported by IsSingular(); Solve and Inverse then
+	// throw std::runtime_error, and Determinant returns zero.
+	//
+	// Instantiated for float and double.
+	//
+	template <typename T>
+	class BasicLUDecomposition
+	{
+	public:
+		typedef T ElemType;
+
+	public:
+		BasicLUDecomposition();
+		explicit BasicLUDecomposition(const BasicMatrix<T>& mat);
+
+		//
+		// Factor a square matrix, replacing any previous factorization.
+		//
+		void Factorize(const BasicMatrix<T>& mat);
+
+		unsigned int Size() const;
+		bool         IsSingular() const;
+
+		//
+		// Solve A * X = B for every column of B. B and X are n*nrhs and may be the same matrix.
+		//
+		void Solve(const BasicMatrix<T>& b, BasicMatrix<T>& x) const;
+		void Inverse(BasicMatrix<T>& inv) const;
+		T    Determinant() const;
+
+		//
+		// L (below the diagonal, unit diagonal implied) and U (on and above it) packed in one
+		// matrix, and the row interchanges: row i was swapped with row Pivots()[i].
+		//
+		const BasicMatrix<T>&            Factors() const;
+		const std::vector<unsigned int>& Pivots() const;
+
+	private:
+		void FactorPanel(const unsigned int k, const unsigned int nb);
+
+	private:
+		BasicMatrix<T>            m_lu;
+		std::vector<unsigned int> m_pivots;
+		bool                      m_singular;
+	};
+
+	typedef BasicLUDecomposition<float>  LUDecompositionF;
+	typedef BasicLUDecomposition<double> LUDecomposition;
+
+	//
+	// Function : One-off solve, inverse and determinant. Each factors the matrix; keep a
+	//      BasicLUDecomposition to reuse the factorization.
+	//
+	template <typename T>
+	void Solve(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& x);
+
+	template <typename T>
+	void Inverse(const BasicMatrix<T>& a, BasicMatrix<T>& inv);
+
+	template <typename T>
+	T Determinant(const BasicMatrix<T>& a);
+}
+
+#endif
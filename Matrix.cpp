@@ -1,7 +1,18 @@
 
 #include "Matrix.hpp"
+#include "Gemm.hpp"
+#include "ElementWise.hpp"
+#include "Transpose.hpp"
+#include "Reduction.hpp"
+#include "Strassen.hpp"
+#include "Instrumentation.hpp"
 #include <iostream>
 #include <stdexcept>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 using namespace numeric;
 
@@ -9,93 +20,77 @@ using namespace numeric;
 //Implementation of Matrix
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-Matrix numeric::operator+(const Matrix& lhmat, const Matrix& rhmat)
+/// \brief       Element-wise multiplication of two matrices.
+/// \param[in]   lhmat. Matrix.
+/// \param[in]   rhmat. Matrix.
+/// \param[out]  resultMat. Matrix.
+template <typename T>
+void BasicMatrix<T>::DotMul(const BasicMatrix& lhmat, const BasicMatrix& rhmat, BasicMatrix& resultMat)
 {
-	// Guardian 
-	if (lhmat.Rows() != rhmat.Rows() || lhmat.Cols() != rhmat.Cols())
+	if (lhmat.Rows() != rhmat.Rows() ||
+		lhmat.Cols() != rhmat.Cols() ||
+		resultMat.Rows() != lhmat.Rows() ||
+		resultMat.Cols() != rhmat.Cols())
 	{
 		throw std::invalid_argument(
 			"Dimension mismatch"
 			);
 	}
 
-	int m = lhmat.Rows();
-	int n = lhmat.Cols();
-	int l = rhmat.Cols();
-
-	Matrix resultMat(m, l);
-	for (int i = 0; i < m; i++)
-	{
-		for (int j = 0; j < l; j++)
-		{
-			ElemType lval = lhmat.GetElemAt(i, j);
-			ElemType rval = rhmat.GetElemAt(i, j);
-			resultMat.SetElemAt(i, j, lval + rval);
-		}
-	}
-	return resultMat;
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixDotMul, lhmat.NumElements(), lhmat.NumElements());
+	kernel::Mul<ElemType>(lhmat.NumElements(), lhmat.m_elements, rhmat.m_elements, resultMat.m_elements);
 }
 
-Matrix numeric::operator*(const Matrix& lhmat, const Matrix& rhmat)
+
+/// \brief       Matrix multiplication of two matrices.
+/// \param[in]   lhmat. Matrix.
+/// \param[in]   rhmat. Matrix.
+/// \param[out]  resultMat. Matrix.
+template <typename T>
+void BasicMatrix<T>::Mul(const BasicMatrix& lhmat, const BasicMatrix& rhmat, BasicMatrix& resultMat)
 {
-	// Guardian 
-	if (lhmat.Cols() != rhmat.Rows())
+	if (lhmat.Cols() != rhmat.Rows() ||
+		resultMat.Rows() != lhmat.Rows() ||
+		resultMat.Cols() != rhmat.Cols())
 	{
 		throw std::invalid_argument(
 			"Dimension mismatch"
 			);
 	}
 
-	int m = lhmat.Rows();
-	int n = lhmat.Cols();
-	int l = rhmat.Cols();
-
-	Matrix resultMat(m, l);
-	for (int i = 0; i < m; i++)
+	//
+	// The engine writes C while it still reads A and B, so an aliased result goes through a
+	// temporary.
+	//
+	if (&resultMat == &lhmat || &resultMat == &rhmat)
 	{
-		for (int j = 0; j < l; j++)
-		{
-			ElemType sum = 0;
-			for (int k = 0; k < n; k++)
-			{
-				sum += (lhmat.GetElemAt(i, k) * rhmat.GetElemAt(k, j));
-			}
-			resultMat.SetElemAt(i, j, sum);
-		}
+		BasicMatrix tmp(resultMat.Rows(), resultMat.Cols());
+		BasicMatrix::Mul(lhmat, rhmat, tmp);
+		resultMat = tmp;
+		return;
 	}
-	return resultMat;
-}
 
-Matrix numeric::operator*(const ElemType lhd, const Matrix& rhmat)
-{
-	int m = rhmat.Rows();
-	int n = rhmat.Cols();
-	Matrix resultMat(m, n);
-	for (int i = 0; i < m; i++)
-	{
-		for (int j = 0; j < n; j++)
-		{
-			ElemType value = rhmat.GetElemAt(i, j);
-			resultMat.SetElemAt(i, j, lhd * value);
-		}
-	}
-	return resultMat;
-}
+	unsigned int m = lhmat.Rows();
+	unsigned int n = lhmat.Cols();
+	unsigned int l = rhmat.Cols();
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixMul, resultMat.NumElements(),
+		2 * static_cast<std::uint64_t>(m) * n * l);
 
-Matrix numeric::operator*(const Matrix& lhmat, const ElemType rhd)
-{
-	return (rhd * lhmat);
+	kernel::Gemm<ElemType>(m, l, n,
+		1, lhmat.m_elements, n, 1,
+		rhmat.m_elements, l, 1,
+		0, resultMat.m_elements, l, 1);
 }
 
 
-/// \brief       Element-wise multiplication of two matrices.
+/// \brief       Matrix multiplication by Strassen-Winograd.
 /// \param[in]   lhmat. Matrix.
 /// \param[in]   rhmat. Matrix.
 /// \param[out]  resultMat. Matrix.
-void Matrix::DotMul(const Matrix& lhmat, const Matrix& rhmat, Matrix& resultMat)
+template <typename T>
+void BasicMatrix<T>::StrassenMul(const BasicMatrix& lhmat, const BasicMatrix& rhmat, BasicMatrix& resultMat)
 {
-	if (lhmat.Rows() != rhmat.Rows() ||
-		lhmat.Cols() != rhmat.Cols() ||
+	if (lhmat.Cols() != rhmat.Rows() ||
 		resultMat.Rows() != lhmat.Rows() ||
 		resultMat.Cols() != rhmat.Cols())
 	{
@@ -104,51 +99,167 @@ void Matrix::DotMul(const Matrix& lhmat, const Matrix& rhmat, Matrix& resultMat)
 			);
 	}
 
-	int m = lhmat.Rows();
-	int n = lhmat.Cols();
+	if (&resultMat == &lhmat || &resultMat == &rhmat)
+	{
+		BasicMatrix tmp(resultMat.Rows(), resultMat.Cols());
+		BasicMatrix::StrassenMul(lhmat, rhmat, tmp);
+		resultMat = tmp;
+		return;
+	}
+
+	unsigned int m = lhmat.Rows();
+	unsigned int n = lhmat.Cols();
+	unsigned int l = rhmat.Cols();
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixStrassenMul, resultMat.NumElements(),
+		2 * static_cast<std::uint64_t>(m) * n * l);
 
-	for (int i = 0; i < m; i++)
+	const unsigned int crossover = kernel::StrassenCrossover();
+	static thread_local std::vector<T> workspace;
+	const size_t size = kernel::StrassenWorkspaceSize(m, l, n, crossover);
+	if (workspace.size() < size)
 	{
-		for (int j = 0; j < n; j++)
-		{
-			ElemType val = lhmat.GetElemAt(i, j) * rhmat.GetElemAt(i, j);
-			resultMat.SetElemAt(i, j, val);
-		}
+		workspace.resize(size);
 	}
+	kernel::StrassenGemm<ElemType>(m, l, n,
+		lhmat.m_elements, n,
+		rhmat.m_elements, l,
+		resultMat.m_elements, l,
+		crossover, workspace.empty() ? NULL : &workspace[0]);
 }
 
 
-/// \brief       Matrix multiplication of two matrices.
+/// \brief       Matrix multiplication with optionally transposed operands.
 /// \param[in]   lhmat. Matrix.
+/// \param[in]   lhTrans. Trans to use lhmat^T.
 /// \param[in]   rhmat. Matrix.
+/// \param[in]   rhTrans. Trans to use rhmat^T.
 /// \param[out]  resultMat. Matrix.
-void Matrix::Mul(const Matrix& lhmat, const Matrix& rhmat, Matrix& resultMat)
+template <typename T>
+void BasicMatrix<T>::Mul(const BasicMatrix& lhmat, const TransposeFlag lhTrans,
+                         const BasicMatrix& rhmat, const TransposeFlag rhTrans,
+                         BasicMatrix& resultMat)
 {
-	if (lhmat.Cols() != rhmat.Rows() ||
-		resultMat.Rows() != lhmat.Rows() ||
-		resultMat.Cols() != rhmat.Cols())
+	const unsigned int m = lhTrans == Trans ? lhmat.Cols() : lhmat.Rows();
+	const unsigned int k = lhTrans == Trans ? lhmat.Rows() : lhmat.Cols();
+	const unsigned int kr = rhTrans == Trans ? rhmat.Cols() : rhmat.Rows();
+	const unsigned int n = rhTrans == Trans ? rhmat.Rows() : rhmat.Cols();
+	if (k != kr ||
+		resultMat.Rows() != m ||
+		resultMat.Cols() != n)
 	{
 		throw std::invalid_argument(
 			"Dimension mismatch"
 			);
 	}
 
-	int m = lhmat.Rows();
-	int n = lhmat.Cols();
-	int l = rhmat.Cols();
+	if (&resultMat == &lhmat || &resultMat == &rhmat)
+	{
+		BasicMatrix tmp(resultMat.Rows(), resultMat.Cols());
+		BasicMatrix::Mul(lhmat, lhTrans, rhmat, rhTrans, tmp);
+		resultMat = tmp;
+		return;
+	}
+
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixMul, resultMat.NumElements(),
+		2 * static_cast<std::uint64_t>(m) * n * k);
+
+	//
+	// Element (i,j) of a row-major X is x[i * cols + j] and of X^T it is x[j * cols + i].
+	//
+	const std::ptrdiff_t lhCols = lhmat.Cols();
+	const std::ptrdiff_t rhCols = rhmat.Cols();
+	kernel::Gemm<ElemType>(m, n, k,
+		1, lhmat.m_elements, lhTrans == Trans ? 1 : lhCols, lhTrans == Trans ? lhCols : 1,
+		rhmat.m_elements, rhTrans == Trans ? 1 : rhCols, rhTrans == Trans ? rhCols : 1,
+		0, resultMat.m_elements, n, 1);
+}
+
 
-	for (int i = 0; i < m; i++)
+/// \brief          c = alpha * op(a) * op(b) + beta * c.
+/// \param[in]      alpha. Scale of the product.
+/// \param[in]      a, aTrans. Left operand and whether to transpose it.
+/// \param[in]      b, bTrans. Right operand and whether to transpose it.
+/// \param[in]      beta. Scale of c; zero ignores its contents.
+/// \param[in,out]  c. Matrix.
+template <typename T>
+void BasicMatrix<T>::Gemm(const ElemType alpha,
+                          const BasicMatrix& a, const TransposeFlag aTrans,
+                          const BasicMatrix& b, const TransposeFlag bTrans,
+                          const ElemType beta, BasicMatrix& c)
+{
+	const unsigned int m = aTrans == Trans ? a.Cols() : a.Rows();
+	const unsigned int k = aTrans == Trans ? a.Rows() : a.Cols();
+	const unsigned int kb = bTrans == Trans ? b.Cols() : b.Rows();
+	const unsigned int n = bTrans == Trans ? b.Rows() : b.Cols();
+	if (k != kb ||
+		c.Rows() != m ||
+		c.Cols() != n)
 	{
-		for (int j = 0; j < l; j++)
-		{
-			ElemType sum = 0;
-			for (int k = 0; k < n; k++)
-			{
-				sum += (lhmat.GetElemAt(i, k) * rhmat.GetElemAt(k, j));
-			}
-			resultMat.SetElemAt(i, j, sum);
-		}
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	if (&c == &a || &c == &b)
+	{
+		BasicMatrix tmp(m, n);
+		BasicMatrix::Mul(a, aTrans, b, bTrans, tmp);
+		BasicMatrix::Axpby(alpha, tmp, beta, c);
+		return;
 	}
+
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixGemm, c.NumElements(),
+		2 * static_cast<std::uint64_t>(m) * n * k);
+	const std::ptrdiff_t aCols = a.Cols();
+	const std::ptrdiff_t bCols = b.Cols();
+	kernel::Gemm<ElemType>(m, n, k,
+		alpha, a.m_elements, aTrans == Trans ? 1 : aCols, aTrans == Trans ? aCols : 1,
+		b.m_elements, bTrans == Trans ? 1 : bCols, bTrans == Trans ? bCols : 1,
+		beta, c.m_elements, n, 1);
+}
+
+
+/// \brief          y = alpha * x + beta * y.
+/// \param[in]      alpha. Scale of x.
+/// \param[in]      x. Matrix.
+/// \param[in]      beta. Scale of y; zero ignores its contents.
+/// \param[in,out]  y. Matrix.
+template <typename T>
+void BasicMatrix<T>::Axpby(const ElemType alpha, const BasicMatrix& x, const ElemType beta, BasicMatrix& y)
+{
+	if (x.Rows() != y.Rows() || x.Cols() != y.Cols())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixAxpby, x.NumElements(), 3 * x.NumElements());
+	kernel::Axpby<ElemType>(x.NumElements(), alpha, x.m_elements, beta, y.m_elements);
+}
+
+
+/// \brief       Transpose a matrix.
+/// \param[in]   mat. Matrix.
+/// \param[out]  result. Matrix of cols * rows; may be mat when mat is square.
+template <typename T>
+void BasicMatrix<T>::Transpose(const BasicMatrix& mat, BasicMatrix& result)
+{
+	if (result.Rows() != mat.Cols() || result.Cols() != mat.Rows())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixTranspose, mat.NumElements(), 0);
+	if (&result == &mat)
+	{
+		kernel::TransposeInPlace<ElemType>(mat.m_rows, result.m_elements, mat.m_cols);
+		return;
+	}
+	kernel::Transpose<ElemType>(mat.m_rows, mat.m_cols, mat.m_elements, mat.m_cols,
+	                            result.m_elements, result.m_cols);
 }
 
 
@@ -156,18 +267,18 @@ void Matrix::Mul(const Matrix& lhmat, const Matrix& rhmat, Matrix& resultMat)
 /// \param[in]   lhmat. Matrix.
 /// \param[in]   s. a scalar.
 /// \param[out]  resultMat. Matrix.
-void Matrix::Mul(const Matrix& mat, const ElemType s, Matrix& result)
+template <typename T>
+void BasicMatrix<T>::Mul(const BasicMatrix& mat, const ElemType s, BasicMatrix& result)
 {
-	int m = mat.Rows();
-	int n = mat.Cols();
-	for (int i = 0; i < m; i++)
+	if (result.Rows() != mat.Rows() || result.Cols() != mat.Cols())
 	{
-		for (int j = 0; j < n; j++)
-		{
-			ElemType value = mat.GetElemAt(i, j);
-			result.SetElemAt(i, j, s * value);
-		}
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
 	}
+
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixScale, mat.NumElements(), mat.NumElements());
+	kernel::Scale<ElemType>(mat.NumElements(), s, mat.m_elements, result.m_elements);
 }
 
 
@@ -175,30 +286,22 @@ void Matrix::Mul(const Matrix& mat, const ElemType s, Matrix& result)
 /// \param[in]   lhmat. Matrix.
 /// \param[in]   rhmat. Matrix.
 /// \param[out]  result. Matrix.
-void Matrix::Add(const Matrix& lhmat, const Matrix& rhmat, Matrix& result)
+template <typename T>
+void BasicMatrix<T>::Add(const BasicMatrix& lhmat, const BasicMatrix& rhmat, BasicMatrix& result)
 {
 	// Guardian 
 	if (lhmat.Rows() != rhmat.Rows() ||
-		lhmat.Cols() != rhmat.Cols())
+		lhmat.Cols() != rhmat.Cols() ||
+		result.Rows() != lhmat.Rows() ||
+		result.Cols() != lhmat.Cols())
 	{
 		throw std::invalid_argument(
 			"Dimension mismatch"
 			);
 	}
 
-	int m = lhmat.Rows();
-	int n = lhmat.Cols();
-	int l = rhmat.Cols();
-
-	for (int i = 0; i < m; i++)
-	{
-		for (int j = 0; j < l; j++)
-		{
-			ElemType lval = lhmat.GetElemAt(i, j);
-			ElemType rval = rhmat.GetElemAt(i, j);
-			result.SetElemAt(i, j, lval + rval);
-		}
-	}
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixAdd, lhmat.NumElements(), lhmat.NumElements());
+	kernel::Add<ElemType>(lhmat.NumElements(), lhmat.m_elements, rhmat.m_elements, result.m_elements);
 }
 
 
@@ -206,119 +309,501 @@ void Matrix::Add(const Matrix& lhmat, const Matrix& rhmat, Matrix& result)
 /// \param[in]   lhmat. Matrix.
 /// \param[in]   rhmat. Matrix.
 /// \param[out]  result. Matrix.
-void Matrix::Sub(const Matrix& lhmat, const Matrix& rhmat, Matrix& result)
+template <typename T>
+void BasicMatrix<T>::Sub(const BasicMatrix& lhmat, const BasicMatrix& rhmat, BasicMatrix& result)
 {
 	// Guardian 
-	if (lhmat.Rows() != rhmat.Rows() || lhmat.Cols() != rhmat.Cols())
+	if (lhmat.Rows() != rhmat.Rows() ||
+		lhmat.Cols() != rhmat.Cols() ||
+		result.Rows() != lhmat.Rows() ||
+		result.Cols() != lhmat.Cols())
 	{
 		throw std::invalid_argument(
 			"Dimension mismatch"
 			);
 	}
 
-	int m = lhmat.Rows();
-	int n = lhmat.Cols();
-	int l = rhmat.Cols();
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixSub, lhmat.NumElements(), lhmat.NumElements());
+	kernel::Sub<ElemType>(lhmat.NumElements(), lhmat.m_elements, rhmat.m_elements, result.m_elements);
+}
+
+namespace
+{
+	//
+	// Lowest and one-past-highest address a view touches.
+	//
+	template <typename T>
+	void Span(const MatrixView<const T>& view, const T*& lo, const T*& hi)
+	{
+		const std::ptrdiff_t lastRow = static_cast<std::ptrdiff_t>(view.Rows() - 1) * view.RowStride();
+		const std::ptrdiff_t lastCol = static_cast<std::ptrdiff_t>(view.Cols() - 1) * view.ColStride();
+		lo = view.Data() + std::min<std::ptrdiff_t>(lastRow, 0) + std::min<std::ptrdiff_t>(lastCol, 0);
+		hi = view.Data() + std::max<std::ptrdiff_t>(lastRow, 0) + std::max<std::ptrdiff_t>(lastCol, 0) + 1;
+	}
+
+	template <typename T>
+	bool Overlaps(const MatrixView<const T>& a, const MatrixView<const T>& b)
+	{
+		const T* aLo;
+		const T* aHi;
+		const T* bLo;
+		const T* bHi;
+		Span(a, aLo, aHi);
+		Span(b, bLo, bHi);
+		return aLo < bHi && bLo < aHi;
+	}
+
+	template <typename T>
+	bool SameLayout(const MatrixView<const T>& a, const MatrixView<const T>& b)
+	{
+		return a.Data() == b.Data() && a.RowStride() == b.RowStride() && a.ColStride() == b.ColStride();
+	}
 
-	for (int i = 0; i < m; i++)
+	template <typename T>
+	void CopyView(const MatrixView<const T>& src, const MatrixView<T>& dst)
 	{
-		for (int j = 0; j < l; j++)
+		for (unsigned int i = 0; i < src.Rows(); i++)
 		{
-			ElemType lval = lhmat.GetElemAt(i, j);
-			ElemType rval = rhmat.GetElemAt(i, j);
-			result.SetElemAt(i, j, lval - rval);
+			const T* srcRow = src.Data() + i * src.RowStride();
+			T* dstRow = dst.Data() + i * dst.RowStride();
+			for (unsigned int j = 0; j < src.Cols(); j++)
+			{
+				dstRow[j * dst.ColStride()] = srcRow[j * src.ColStride()];
+			}
 		}
 	}
-}
 
-/// \brief          Set all the elements of a matrix to zero.
-/// \param[in,out]  mat. Matrix.
-void Matrix::Zero(Matrix& mat)
-{
-	int m = mat.Rows();
-	int n = mat.Cols();
-	for (int i = 0; i < m; i++)
+	template <typename T>
+	struct ViewAddOp
 	{
-		for (int j = 0; j < n; j++)
+		static void Kernel(const size_t n, const T* x, const T* y, T* z) { kernel::Add<T>(n, x, y, z); }
+		static T    Apply(const T a, const T b)                          { return a + b; }
+	};
+
+	template <typename T>
+	struct ViewSubOp
+	{
+		static void Kernel(const size_t n, const T* x, const T* y, T* z) { kernel::Sub<T>(n, x, y, z); }
+		static T    Apply(const T a, const T b)                          { return a - b; }
+	};
+
+	template <typename T>
+	struct ViewMulOp
+	{
+		static void Kernel(const size_t n, const T* x, const T* y, T* z) { kernel::Mul<T>(n, x, y, z); }
+		static T    Apply(const T a, const T b)                          { return a * b; }
+	};
+
+	//
+	// z = op(x, y) over views of equal shape. Rows that are contiguous in all three go through
+	// the SIMD kernels; other layouts fall back to a strided loop. An output that overlaps an
+	// input with a different layout would be overwritten before it is read, so it is computed
+	// into a temporary first.
+	//
+	template <typename T, typename Op>
+	void ElementWiseViews(const MatrixView<const T>& x, const MatrixView<const T>& y, const MatrixView<T>& z)
+	{
+		if (x.Rows() != y.Rows() ||
+			x.Cols() != y.Cols() ||
+			z.Rows() != x.Rows() ||
+			z.Cols() != x.Cols())
+		{
+			throw std::invalid_argument(
+				"Dimension mismatch"
+				);
+		}
+
+		const MatrixView<const T> out(z);
+		if ((Overlaps(out, x) && !SameLayout(out, x)) || (Overlaps(out, y) && !SameLayout(out, y)))
 		{
-			mat.SetElemAt(i, j, 0);
+			BasicMatrix<T> tmp(z.Rows(), z.Cols());
+			ElementWiseViews<T, Op>(x, y, tmp.View());
+			CopyView<T>(tmp.View(), z);
+			return;
+		}
+
+		if (x.HasContiguousRows() && y.HasContiguousRows() && z.HasContiguousRows())
+		{
+			for (unsigned int i = 0; i < z.Rows(); i++)
+			{
+				Op::Kernel(z.Cols(), x.Data() + i * x.RowStride(), y.Data() + i * y.RowStride(),
+				           z.Data() + i * z.RowStride());
+			}
+			return;
+		}
+
+		for (unsigned int i = 0; i < z.Rows(); i++)
+		{
+			const T* xRow = x.Data() + i * x.RowStride();
+			const T* yRow = y.Data() + i * y.RowStride();
+			T* zRow = z.Data() + i * z.RowStride();
+			for (unsigned int j = 0; j < z.Cols(); j++)
+			{
+				zRow[j * z.ColStride()] = Op::Apply(xRow[j * x.ColStride()], yRow[j * y.ColStride()]);
+			}
 		}
 	}
 }
 
 
-/// \brief          Set all the elements of a matrix to one.
-/// \param[in,out]  mat. Matrix.
-void Matrix::Ones(Matrix& mat)
+/// \brief       Element-wise multiplication of two views.
+/// \param[in]   lhmat. View.
+/// \param[in]   rhmat. View.
+/// \param[out]  result. View.
+template <typename T>
+void BasicMatrix<T>::DotMul(const ConstViewType& lhmat, const ConstViewType& rhmat, const ViewType& result)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpViewDotMul, static_cast<std::uint64_t>(result.Rows()) * result.Cols(),
+		static_cast<std::uint64_t>(result.Rows()) * result.Cols());
+	ElementWiseViews<T, ViewMulOp<T> >(lhmat, rhmat, result);
+}
+
+
+/// \brief       Matrix multiplication of two views. The strides are handed to the GEMM engine,
+///              so transposed and sub-block operands are multiplied without copies.
+/// \param[in]   lhmat. View.
+/// \param[in]   rhmat. View.
+/// \param[out]  result. View.
+template <typename T>
+void BasicMatrix<T>::Mul(const ConstViewType& lhmat, const ConstViewType& rhmat, const ViewType& result)
+{
+	if (lhmat.Cols() != rhmat.Rows() ||
+		result.Rows() != lhmat.Rows() ||
+		result.Cols() != rhmat.Cols())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	const ConstViewType out(result);
+	if (Overlaps(out, lhmat) || Overlaps(out, rhmat))
+	{
+		BasicMatrix tmp(result.Rows(), result.Cols());
+		BasicMatrix::Mul(lhmat, rhmat, tmp.View());
+		CopyView<T>(tmp.View(), result);
+		return;
+	}
+
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpViewMul, static_cast<std::uint64_t>(result.Rows()) * result.Cols(),
+		2 * static_cast<std::uint64_t>(lhmat.Rows()) * rhmat.Cols() * lhmat.Cols());
+	kernel::Gemm<ElemType>(lhmat.Rows(), rhmat.Cols(), lhmat.Cols(),
+		1, lhmat.Data(), lhmat.RowStride(), lhmat.ColStride(),
+		rhmat.Data(), rhmat.RowStride(), rhmat.ColStride(),
+		0, result.Data(), result.RowStride(), result.ColStride());
+}
+
+
+/// \brief       Add two views.
+/// \param[in]   lhmat. View.
+/// \param[in]   rhmat. View.
+/// \param[out]  result. View.
+template <typename T>
+void BasicMatrix<T>::Add(const ConstViewType& lhmat, const ConstViewType& rhmat, const ViewType& result)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpViewAdd, static_cast<std::uint64_t>(result.Rows()) * result.Cols(),
+		static_cast<std::uint64_t>(result.Rows()) * result.Cols());
+	ElementWiseViews<T, ViewAddOp<T> >(lhmat, rhmat, result);
+}
+
+
+/// \brief       Subtract two views.
+/// \param[in]   lhmat. View.
+/// \param[in]   rhmat. View.
+/// \param[out]  result. View.
+template <typename T>
+void BasicMatrix<T>::Sub(const ConstViewType& lhmat, const ConstViewType& rhmat, const ViewType& result)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpViewSub, static_cast<std::uint64_t>(result.Rows()) * result.Cols(),
+		static_cast<std::uint64_t>(result.Rows()) * result.Cols());
+	ElementWiseViews<T, ViewSubOp<T> >(lhmat, rhmat, result);
+}
+
+
+/// \brief          c = alpha * a * b + beta * c on views. Transposes and blocks are given by
+///                 the strides of the views.
+/// \param[in]      alpha. Scale of the product.
+/// \param[in]      a, b. Views.
+/// \param[in]      beta. Scale of c; zero ignores its contents.
+/// \param[in,out]  c. View.
+template <typename T>
+void BasicMatrix<T>::Gemm(const ElemType alpha, const ConstViewType& a, const ConstViewType& b,
+                          const ElemType beta, const ViewType& c)
 {
-	int m = mat.Rows();
-	int n = mat.Cols();
-	for (int i = 0; i < m; i++)
+	if (a.Cols() != b.Rows() ||
+		c.Rows() != a.Rows() ||
+		c.Cols() != b.Cols())
 	{
-		for (int j = 0; j < n; j++)
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	const ConstViewType out(c);
+	if (Overlaps(out, a) || Overlaps(out, b))
+	{
+		BasicMatrix tmp(c.Rows(), c.Cols());
+		BasicMatrix::Mul(a, b, tmp.View());
+		BasicMatrix::Axpby(alpha, tmp.View(), beta, c);
+		return;
+	}
+
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpViewGemm, static_cast<std::uint64_t>(c.Rows()) * c.Cols(),
+		2 * static_cast<std::uint64_t>(a.Rows()) * b.Cols() * a.Cols());
+	kernel::Gemm<ElemType>(a.Rows(), b.Cols(), a.Cols(),
+		alpha, a.Data(), a.RowStride(), a.ColStride(),
+		b.Data(), b.RowStride(), b.ColStride(),
+		beta, c.Data(), c.RowStride(), c.ColStride());
+}
+
+
+/// \brief          y = alpha * x + beta * y on views.
+/// \param[in]      alpha. Scale of x.
+/// \param[in]      x. View.
+/// \param[in]      beta. Scale of y; zero ignores its contents.
+/// \param[in,out]  y. View.
+template <typename T>
+void BasicMatrix<T>::Axpby(const ElemType alpha, const ConstViewType& x, const ElemType beta, const ViewType& y)
+{
+	if (x.Rows() != y.Rows() || x.Cols() != y.Cols())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	const ConstViewType out(y);
+	if (Overlaps(out, x) && !SameLayout(out, x))
+	{
+		BasicMatrix tmp(x.Rows(), x.Cols());
+		CopyView<T>(x, tmp.View());
+		BasicMatrix::Axpby(alpha, tmp.View(), beta, y);
+		return;
+	}
+
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpViewAxpby, static_cast<std::uint64_t>(x.Rows()) * x.Cols(),
+		3 * static_cast<std::uint64_t>(x.Rows()) * x.Cols());
+	if (x.HasContiguousRows() && y.HasContiguousRows())
+	{
+		for (unsigned int i = 0; i < y.Rows(); i++)
 		{
-			mat.SetElemAt(i, j, 1);
+			kernel::Axpby<ElemType>(y.Cols(), alpha, x.Data() + i * x.RowStride(), beta, y.Data() + i * y.RowStride());
 		}
+		return;
 	}
+
+	for (unsigned int i = 0; i < y.Rows(); i++)
+	{
+		const T* xRow = x.Data() + i * x.RowStride();
+		T* yRow = y.Data() + i * y.RowStride();
+		for (unsigned int j = 0; j < y.Cols(); j++)
+		{
+			T& yij = yRow[j * y.ColStride()];
+			yij = beta == T(0) ? alpha * xRow[j * x.ColStride()] : alpha * xRow[j * x.ColStride()] + beta * yij;
+		}
+	}
+}
+
+
+/// \brief          Set all the elements of a matrix to zero.
+/// \param[in,out]  mat. Matrix.
+template <typename T>
+void BasicMatrix<T>::Zero(BasicMatrix& mat)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixZero, mat.NumElements(), 0);
+	kernel::Fill<ElemType>(mat.NumElements(), 0, mat.m_elements);
+}
+
+
+/// \brief          Set all the elements of a matrix to one.
+/// \param[in,out]  mat. Matrix.
+template <typename T>
+void BasicMatrix<T>::Ones(BasicMatrix& mat)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixOnes, mat.NumElements(), 0);
+	kernel::Fill<ElemType>(mat.NumElements(), 1, mat.m_elements);
 }
 
 
 /// \brief      Find the maximum of the elements of a matrix.
 /// \param[in]  mat. Matrix.
 /// \return     the maximum element.
-ElemType Matrix::Max(Matrix& mat)
+template <typename T>
+T BasicMatrix<T>::Max(const BasicMatrix& mat)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixMax, mat.NumElements(), mat.NumElements());
+	return kernel::ParallelReduce<ElemType>(ReduceMax, mat.NumElements(), mat.m_elements);
+}
+
+
+/// \brief Find the minimum of the elements of a matrix.
+/// \param[in]  mat. Matrix.
+/// \return     the minimum element.
+template <typename T>
+T BasicMatrix<T>::Min(const BasicMatrix& mat)
 {
-	ElemType maxVal = -DBL_MAX;
-	int rows = mat.Rows();
-	int cols = mat.Cols();
-	for (int i = 0; i < rows; i++)
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixMin, mat.NumElements(), mat.NumElements());
+	return kernel::ParallelReduce<ElemType>(ReduceMin, mat.NumElements(), mat.m_elements);
+}
+
+
+/// \brief      Find the first maximum of the elements of a matrix, in row-major order.
+/// \param[in]  mat. Matrix.
+/// \param[out] row, col. Position of the maximum.
+/// \return     the maximum element.
+template <typename T>
+T BasicMatrix<T>::Max(const BasicMatrix& mat, unsigned int& row, unsigned int& col)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixMax, mat.NumElements(), mat.NumElements());
+	const size_t index = kernel::ParallelArgMax<ElemType>(mat.NumElements(), mat.m_elements);
+	if (index >= mat.NumElements())
 	{
-		for (int j = 0; j < cols; j++)
-		{
-			ElemType val = mat.GetElemAt(i, j);
-			maxVal = val > maxVal ? val : maxVal;
-		}
+		throw std::invalid_argument(
+			"Matrix has no comparable elements"
+			);
 	}
-	return maxVal;
+	row = static_cast<unsigned int>(index / mat.m_cols);
+	col = static_cast<unsigned int>(index % mat.m_cols);
+	return mat.m_elements[index];
 }
 
 
-/// \brief Find the minimum of the elements of a matrix.
+/// \brief      Find the first minimum of the elements of a matrix, in row-major order.
 /// \param[in]  mat. Matrix.
+/// \param[out] row, col. Position of the minimum.
 /// \return     the minimum element.
-ElemType Matrix::Min(Matrix& mat)
+template <typename T>
+T BasicMatrix<T>::Min(const BasicMatrix& mat, unsigned int& row, unsigned int& col)
 {
-	ElemType minVal = DBL_MAX;
-	int rows = mat.Rows();
-	int cols = mat.Cols();
-	for (int i = 0; i < rows; i++)
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixMin, mat.NumElements(), mat.NumElements());
+	const size_t index = kernel::ParallelArgMin<ElemType>(mat.NumElements(), mat.m_elements);
+	if (index >= mat.NumElements())
 	{
-		for (int j = 0; j < cols; j++)
-		{
-			ElemType val = mat.GetElemAt(i, j);
-			minVal = val < minVal ? val : minVal;
-		}
+		throw std::invalid_argument(
+			"Matrix has no comparable elements"
+			);
+	}
+	row = static_cast<unsigned int>(index / mat.m_cols);
+	col = static_cast<unsigned int>(index % mat.m_cols);
+	return mat.m_elements[index];
+}
+
+
+/// \brief      Sum of the elements of a matrix.
+/// \param[in]  mat. Matrix.
+template <typename T>
+T BasicMatrix<T>::Sum(const BasicMatrix& mat)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixSum, mat.NumElements(), mat.NumElements());
+	return kernel::ParallelReduce<ElemType>(ReduceSum, mat.NumElements(), mat.m_elements);
+}
+
+
+/// \brief      Mean of the elements of a matrix, zero when it is empty.
+/// \param[in]  mat. Matrix.
+template <typename T>
+T BasicMatrix<T>::Mean(const BasicMatrix& mat)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixMean, mat.NumElements(), mat.NumElements());
+	return kernel::ParallelReduce<ElemType>(ReduceMean, mat.NumElements(), mat.m_elements);
+}
+
+
+/// \brief      Element-wise norm of a matrix.
+/// \param[in]  mat. Matrix.
+/// \param[in]  type. NormL1, NormL2 (Frobenius) or NormInf.
+template <typename T>
+T BasicMatrix<T>::Norm(const BasicMatrix& mat, const NormType type)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixNorm, mat.NumElements(),
+	                             2 * mat.NumElements());
+	ReduceOp op = ReduceNormL2;
+	if (type == NormL1)
+	{
+		op = ReduceNormL1;
+	}
+	else if (type == NormInf)
+	{
+		op = ReduceNormInf;
+	}
+	return kernel::ParallelReduce<ElemType>(op, mat.NumElements(), mat.m_elements);
+}
+
+
+/// \brief      Sum of the products of corresponding elements of two matrices.
+/// \param[in]  lhmat. Left matrix.
+/// \param[in]  rhmat. Right matrix of the same shape.
+template <typename T>
+T BasicMatrix<T>::Dot(const BasicMatrix& lhmat, const BasicMatrix& rhmat)
+{
+	if (lhmat.m_rows != rhmat.m_rows || lhmat.m_cols != rhmat.m_cols)
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
 	}
-	return minVal;
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixDot, lhmat.NumElements(),
+	                             2 * lhmat.NumElements());
+	return kernel::ParallelDot<ElemType>(lhmat.NumElements(), lhmat.m_elements, rhmat.m_elements);
 }
 
 
-Matrix::Matrix()
+/// \brief      Reduce each row of a matrix.
+/// \param[in]  mat. Matrix.
+/// \param[in]  op. Reduction.
+/// \param[out] result. rows*1 matrix.
+template <typename T>
+void BasicMatrix<T>::RowReduce(const BasicMatrix& mat, const ReduceOp op, BasicMatrix& result)
+{
+	if (result.m_rows != mat.m_rows || result.m_cols != 1)
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixRowReduce, mat.NumElements(), mat.NumElements());
+	kernel::ReduceRows<ElemType>(op, mat.m_rows, mat.m_cols, mat.m_elements, mat.m_cols, result.m_elements);
+}
+
+
+/// \brief      Reduce each column of a matrix.
+/// \param[in]  mat. Matrix.
+/// \param[in]  op. Reduction.
+/// \param[out] result. 1*cols matrix.
+template <typename T>
+void BasicMatrix<T>::ColReduce(const BasicMatrix& mat, const ReduceOp op, BasicMatrix& result)
+{
+	if (result.m_rows != 1 || result.m_cols != mat.m_cols)
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixColReduce, mat.NumElements(), mat.NumElements());
+	kernel::ReduceCols<ElemType>(op, mat.m_rows, mat.m_cols, mat.m_elements, mat.m_cols, result.m_elements);
+}
+
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix()
 {
 	m_rows = 0;
 	m_cols = 0;
 	m_elements = NULL;
-	m_capacity = 1e5;
+	m_capacity = 0;
+	m_allocator = Allocator::Current();
 }
 
 
-Matrix::~Matrix()
+template <typename T>
+BasicMatrix<T>::~BasicMatrix()
 {
 	Clear();
 }
 
 
-Matrix::Matrix(const unsigned int rows, const unsigned int cols)
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const unsigned int rows, const unsigned int cols)
 {
 	if (rows <= 0 || cols <= 0)
 	{
@@ -326,29 +811,78 @@ Matrix::Matrix(const unsigned int rows, const unsigned int cols)
 			"Rows and cols cann't be smaller than one."
 			);
 	}
+	m_rows = 0;
+	m_cols = 0;
+	m_elements = NULL;
+	m_capacity = 0;
+	m_allocator = Allocator::Current();
+	AllocStorage(static_cast<size_t>(rows) * cols);
 	m_rows = rows;
 	m_cols = cols;
-	m_elements = new ElemType[m_rows * m_cols];
 }
 
 
-Matrix::Matrix(const Matrix& mat)
+/// \brief     Construct a rows * cols matrix whose storage comes from the given allocator.
+/// \param[in] rows.
+/// \param[in] cols.
+/// \param[in] allocator. Must outlive the matrix.
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const unsigned int rows, const unsigned int cols, Allocator& allocator)
 {
-	m_rows = mat.m_rows;
-	m_cols = mat.m_cols;
-	m_elements = new ElemType[m_rows * m_cols];
-	for (unsigned int i = 0; i < m_rows; i++)
+	if (rows <= 0 || cols <= 0)
 	{
-		for (unsigned int j = 0; j < m_cols; j++)
-		{
-			ElemType value = mat.GetElemAt(i, j);
-			SetElemAt(i, j, value);
-		}
+		throw std::invalid_argument(
+			"Rows and cols cann't be smaller than one."
+			);
 	}
+	m_rows = 0;
+	m_cols = 0;
+	m_elements = NULL;
+	m_capacity = 0;
+	m_allocator = &allocator;
+	AllocStorage(static_cast<size_t>(rows) * cols);
+	m_rows = rows;
+	m_cols = cols;
+}
+
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix& mat)
+{
+	NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixCopyConstruct, mat.NumElements(), 0);
+	m_rows = 0;
+	m_cols = 0;
+	m_elements = NULL;
+	m_capacity = 0;
+	m_allocator = Allocator::Current();
+	AllocStorage(mat.NumElements());
+	m_rows = mat.m_rows;
+	m_cols = mat.m_cols;
+	std::copy(mat.m_elements, mat.m_elements + mat.NumElements(), m_elements);
+	NUMERIC_INSTRUMENT_COPY(mat.NumElements() * sizeof(ElemType));
+}
+
+
+/// \brief          Take over the storage of mat, which is left empty.
+/// \param[in,out]  mat. Matrix.
+template <typename T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix&& mat) noexcept
+{
+	m_rows = mat.m_rows;
+	m_cols = mat.m_cols;
+	m_capacity = mat.m_capacity;
+	m_elements = mat.m_elements;
+	m_allocator = mat.m_allocator;
+
+	mat.m_rows = 0;
+	mat.m_cols = 0;
+	mat.m_capacity = 0;
+	mat.m_elements = NULL;
 }
 
 
-const Matrix& Matrix::operator=(const Matrix& mat)
+template <typename T>
+const BasicMatrix<T>& BasicMatrix<T>::operator=(const BasicMatrix& mat)
 {
 	if (this->Cols() != mat.Cols() || this->Rows() != mat.Rows())
 	{
@@ -357,22 +891,36 @@ const Matrix& Matrix::operator=(const Matrix& mat)
 			);
 	}
 
-	unsigned int m = mat.Rows();
-	unsigned int n = mat.Cols();
+	if (this != &mat)
+	{
+		NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixCopyAssign, mat.NumElements(), 0);
+		std::copy(mat.m_elements, mat.m_elements + mat.NumElements(), m_elements);
+		NUMERIC_INSTRUMENT_COPY(mat.NumElements() * sizeof(ElemType));
+	}
+	return *this;
+}
 
-	for (unsigned int i = 0; i < m; i++)
+
+/// \brief     Move assignment. Like copy assignment it requires equal shapes, and it swaps
+///            the storage of the two matrices instead of copying the elements.
+/// \param[in] mat. Matrix.
+template <typename T>
+const BasicMatrix<T>& BasicMatrix<T>::operator=(BasicMatrix&& mat)
+{
+	if (this->Cols() != mat.Cols() || this->Rows() != mat.Rows())
 	{
-		for (unsigned int j = 0; j < n; j++)
-		{
-			ElemType value = mat.GetElemAt(i, j);
-			this->SetElemAt(i, j, value);
-		}
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
 	}
+
+	Swap(mat);
 	return *this;
 }
 
 
-ElemType& Matrix::operator()(const unsigned int row, const unsigned int col)
+template <typename T>
+T& BasicMatrix<T>::operator()(const unsigned int row, const unsigned int col)
 {
 	if (row >= m_rows || col >= m_cols)
 	{
@@ -384,7 +932,8 @@ ElemType& Matrix::operator()(const unsigned int row, const unsigned int col)
 
 /// \brief  Return the number of rows
 /// \return Number of rows	
-unsigned int Matrix::Rows() const
+template <typename T>
+unsigned int BasicMatrix<T>::Rows() const
 {
 	return m_rows;
 }
@@ -392,25 +941,36 @@ unsigned int Matrix::Rows() const
 
 /// \brief  Return the number of columns
 /// \return Number of columns 
-unsigned int Matrix::Cols() const
+template <typename T>
+unsigned int BasicMatrix<T>::Cols() const
 {
 	return m_cols;
 }
 
 
 /// \brief  Return the size of the storage space currently allocated for the matrix.
-/// \return Size of the storage space currently allocated for the matrix. 
-unsigned int Matrix::Capacity() const
+/// \return Number of elements the storage can hold, which is at least rows * cols. 
+template <typename T>
+size_t BasicMatrix<T>::Capacity() const
 {
 	return m_capacity;
 }
 
 
+/// \brief  Return the number of elements, rows * cols.
+template <typename T>
+size_t BasicMatrix<T>::NumElements() const
+{
+	return static_cast<size_t>(m_rows) * m_cols;
+}
+
+
 /// \brief     Return the (i,j) element.
 /// \param[in] row. 
 /// \param[in] col.
 /// \return    The (i,j) element
-ElemType Matrix::GetElemAt(const unsigned int row, const unsigned int col) const
+template <typename T>
+T BasicMatrix<T>::GetElemAt(const unsigned int row, const unsigned int col) const
 {
 	if (row >= m_rows || col >= m_cols)
 	{
@@ -424,7 +984,8 @@ ElemType Matrix::GetElemAt(const unsigned int row, const unsigned int col) const
 /// \param[in] row. 
 /// \param[in] col.
 /// \param[in] value.
-void Matrix::SetElemAt(const unsigned int row, const unsigned int col, const ElemType value)
+template <typename T>
+void BasicMatrix<T>::SetElemAt(const unsigned int row, const unsigned int col, const ElemType value)
 {
 	if (row >= m_rows || col >= m_cols)
 	{
@@ -434,15 +995,128 @@ void Matrix::SetElemAt(const unsigned int row, const unsigned int col, const Ele
 }
 
 
+/// \brief     Make sure the storage can hold numElements without reallocating. The elements
+///            are kept.
+/// \param[in] numElements.
+template <typename T>
+void BasicMatrix<T>::Reserve(const size_t numElements)
+{
+	if (numElements <= m_capacity)
+	{
+		return;
+	}
+
+	size_t reserved = 0;
+	ElemType* elements = static_cast<ElemType*>(m_allocator->Allocate(numElements * sizeof(ElemType), reserved));
+	NUMERIC_INSTRUMENT_ALLOCATION(reserved);
+	if (m_elements != NULL)
+	{
+		std::copy(m_elements, m_elements + NumElements(), elements);
+		NUMERIC_INSTRUMENT_COPY(NumElements() * sizeof(ElemType));
+		m_allocator->Deallocate(m_elements, m_capacity * sizeof(ElemType));
+	}
+	m_elements = elements;
+	m_capacity = reserved / sizeof(ElemType);
+}
+
+
+/// \brief     Change the shape of the matrix. The storage is reused when it has the capacity,
+///            otherwise it grows. The first min(old, new) elements in row-major order are kept.
+/// \param[in] rows.
+/// \param[in] cols.
+template <typename T>
+void BasicMatrix<T>::Resize(const unsigned int rows, const unsigned int cols)
+{
+	if (rows <= 0 || cols <= 0)
+	{
+		throw std::invalid_argument(
+			"Rows and cols cann't be smaller than one."
+			);
+	}
+	Reserve(static_cast<size_t>(rows) * cols);
+	m_rows = rows;
+	m_cols = cols;
+}
+
+
 /// \brief Clear the memory.
-void Matrix::Clear()
+template <typename T>
+void BasicMatrix<T>::Clear()
 {
-	delete[] m_elements;
+	if (m_elements != NULL)
+	{
+		m_allocator->Deallocate(m_elements, m_capacity * sizeof(ElemType));
+	}
 	m_elements = NULL;
+	m_capacity = 0;
+	m_rows = 0;
+	m_cols = 0;
+}
+
+
+/// \brief     Allocate storage for an empty matrix.
+/// \param[in] numElements.
+template <typename T>
+void BasicMatrix<T>::AllocStorage(const size_t numElements)
+{
+	if (numElements == 0)
+	{
+		return;
+	}
+	size_t reserved = 0;
+	m_elements = static_cast<ElemType*>(m_allocator->Allocate(numElements * sizeof(ElemType), reserved));
+	NUMERIC_INSTRUMENT_ALLOCATION(reserved);
+	m_capacity = reserved / sizeof(ElemType);
 }
 
+/// \brief          Exchange the contents of two matrices without copying elements.
+/// \param[in,out]  mat. Matrix.
+template <typename T>
+void BasicMatrix<T>::Swap(BasicMatrix& mat)
+{
+	std::swap(m_rows, mat.m_rows);
+	std::swap(m_cols, mat.m_cols);
+	std::swap(m_capacity, mat.m_capacity);
+	std::swap(m_elements, mat.m_elements);
+	std::swap(m_allocator, mat.m_allocator);
+}
+
+
+/// \brief  Replace the matrix with its transpose.
+template <typename T>
+void BasicMatrix<T>::TransposeInPlace()
+{
+	if (m_rows == m_cols)
+	{
+		Transpose(*this, *this);
+		return;
+	}
+
+	BasicMatrix tmp(m_cols, m_rows, *m_allocator);
+	Transpose(*this, tmp);
+	Swap(tmp);
+}
+
+
+/// \brief  Return the underlying row-major storage.
+template <typename T>
+T* BasicMatrix<T>::Data()
+{
+	return m_elements;
+}
+
+
+/// \brief  Return the underlying row-major storage.
+template <typename T>
+const T* BasicMatrix<T>::Data() const
+{
+	return m_elements;
+}
+
+
 /// \brief Print the elements of the matrix. This is mainly for debugging.
-void Matrix::PrintOut() const
+template <typename T>
+void BasicMatrix<T>::PrintOut() const
 {
 	for (int i = 0; i < m_rows; i++)
 	{
@@ -454,3 +1128,10 @@ void Matrix::PrintOut() const
 	}
 }
 
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Explicit instantiations
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template class numeric::BasicMatrix<float>;
+template class numeric::BasicMatrix<double>;
+template class numeric::BasicMatrix<std::int32_t>;
@@ -1,60 +1,178 @@
 #ifndef Numeric_Matrix_HPP
 #define Numeric_Matrix_HPP
 
+#include "Allocator.hpp"
+#include "Reduction.hpp"
 #include <iostream>
 #include <stdexcept>
+#include <cstddef>
+#include <cstdint>
 
 namespace numeric
 {
-	//
-	// Define the matrix element type. Alternatively, we may use template.
-	//
-	#define ElemType double
+	template <typename Derived> struct MatrixExpr;
+	template <typename T> class MatrixView;
 
 	//
-	// Class : A light-weight matrix class. 
+	// Class : A light-weight matrix class over the element type T. It is explicitly
+	//         instantiated for float, double and std::int32_t; Matrix is the double version.
 	// 
 	// Warning : When a set of matrices are needed, std::vector<Matrix> or 
 	//           std::vector<Matrix*> is recommended. 
 	//
-	class Matrix
+	// Note  : The operators +, - and * (see MatrixExpr.hpp) build lazy expressions that are
+	//         evaluated in one pass when they are assigned to a Matrix.
+	//
+	// Note  : Storage is 64-byte aligned and comes from Allocator::Current() unless an allocator
+	//         is given; see Allocator.hpp. A matrix gives its buffer back to the allocator it
+	//         came from, and Resize reuses the buffer while it has the Capacity().
+	//
+	template <typename T>
+	class BasicMatrix
 	{
+	public:
+		typedef T                   ElemType;
+		typedef MatrixView<T>       ViewType;
+		typedef MatrixView<const T> ConstViewType;
+
 		//
-		// WARNING: Performance might be unacceptable when matrices are very large.
+		// Whether an operand of Mul is used as it is or transposed.
 		//
-		friend Matrix operator+(const Matrix& lhmat, const Matrix& rhmat);
-		friend Matrix operator*(const Matrix& lhmat, const Matrix& rhmat);
-		friend Matrix operator*(const ElemType  lhd, const Matrix& rhmat);
-		friend Matrix operator*(const Matrix& lhmat, const ElemType  rhd);
+		enum TransposeFlag
+		{
+			NoTrans,
+			Trans
+		};
+
 	public:
 		//
 		// Better performance.
 		//
-		static void DotMul(const Matrix& lhmat, const Matrix& rhmat, Matrix& result);
-		static void Mul(const Matrix& lhmat, const Matrix& rhmat, Matrix& result);
-		static void Mul(const Matrix& mat, const ElemType  s, Matrix& result);
-		static void Add(const Matrix& lhmat, const Matrix& rhmat, Matrix& result);
-		static void Sub(const Matrix& lhmat, const Matrix& rhmat, Matrix& result);
+		static void DotMul(const BasicMatrix& lhmat, const BasicMatrix& rhmat, BasicMatrix& result);
+		static void Mul(const BasicMatrix& lhmat, const BasicMatrix& rhmat, BasicMatrix& result);
+		static void Mul(const BasicMatrix& mat, const ElemType  s, BasicMatrix& result);
+		static void Add(const BasicMatrix& lhmat, const BasicMatrix& rhmat, BasicMatrix& result);
+		static void Sub(const BasicMatrix& lhmat, const BasicMatrix& rhmat, BasicMatrix& result);
+
+		//
+		// result = op(lhmat) * op(rhmat), where op transposes its operand when the flag is Trans.
+		// The flags only change the strides the GEMM packing stage reads with, so the
+		// transposes are never formed.
+		//
+		static void Mul(const BasicMatrix& lhmat, const TransposeFlag lhTrans,
+		                const BasicMatrix& rhmat, const TransposeFlag rhTrans,
+		                BasicMatrix& result);
+
+		//
+		// result = lhmat * rhmat by the Strassen-Winograd recursion of Strassen.hpp, with the
+		// crossover of kernel::StrassenCrossover(). It does fewer flops than Mul for large
+		// products at some cost in accuracy; see MeasureStrassenAccuracy. The workspace is
+		// kept per thread and reused across calls.
+		//
+		static void StrassenMul(const BasicMatrix& lhmat, const BasicMatrix& rhmat, BasicMatrix& result);
+
+		//
+		// Fused updates of an existing matrix that allocate nothing:
+		//      Gemm:  c = alpha * op(a) * op(b) + beta * c
+		//      Axpby: y = alpha * x + beta * y
+		// When beta is zero, the output is only written. A c that is a or b is computed
+		// through a temporary.
+		//
+		static void Gemm(const ElemType alpha,
+		                 const BasicMatrix& a, const TransposeFlag aTrans,
+		                 const BasicMatrix& b, const TransposeFlag bTrans,
+		                 const ElemType beta, BasicMatrix& c);
+		static void Axpby(const ElemType alpha, const BasicMatrix& x, const ElemType beta, BasicMatrix& y);
+
+		//
+		// result = mat^T with a cache-oblivious blocked copy (see Transpose.hpp); result must be
+		// cols*rows. Passing mat as result transposes a square matrix in place.
+		//
+		static void Transpose(const BasicMatrix& mat, BasicMatrix& result);
+
+		//
+		// The same operations on views (see MatrixView.hpp), so that blocks, rows, columns and
+		// transposes of larger matrices are used in place. A result that overlaps an operand
+		// is computed through a temporary.
+		//
+		static void DotMul(const ConstViewType& lhmat, const ConstViewType& rhmat, const ViewType& result);
+		static void Mul(const ConstViewType& lhmat, const ConstViewType& rhmat, const ViewType& result);
+		static void Add(const ConstViewType& lhmat, const ConstViewType& rhmat, const ViewType& result);
+		static void Sub(const ConstViewType& lhmat, const ConstViewType& rhmat, const ViewType& result);
+		static void Gemm(const ElemType alpha, const ConstViewType& a, const ConstViewType& b,
+		                 const ElemType beta, const ViewType& c);
+		static void Axpby(const ElemType alpha, const ConstViewType& x, const ElemType beta, const ViewType& y);
+
+		static void Zero(BasicMatrix& mat);
+		static void Ones(BasicMatrix& mat);
 
-		static void Zero(Matrix& mat);
-		static void Ones(Matrix& mat);
+		//
+		// Reductions over all the elements (see Reduction.hpp). They run on the ThreadPool and
+		// give the same result for any number of threads. Max and Min skip NaNs; the overloads
+		// with row and col also report where the first such element is, and throw
+		// std::invalid_argument when there is none.
+		//
+		static ElemType Max(const BasicMatrix& mat);
+		static ElemType Min(const BasicMatrix& mat);
+		static ElemType Max(const BasicMatrix& mat, unsigned int& row, unsigned int& col);
+		static ElemType Min(const BasicMatrix& mat, unsigned int& row, unsigned int& col);
+		static ElemType Sum(const BasicMatrix& mat);
+		static ElemType Mean(const BasicMatrix& mat);
+		static ElemType Norm(const BasicMatrix& mat, const NormType type);
+		static ElemType Dot(const BasicMatrix& lhmat, const BasicMatrix& rhmat);
 
-		static ElemType Max(Matrix& mat);
-		static ElemType Min(Matrix& mat);
+		//
+		// Reduce each row into a rows*1 result, or each column into a 1*cols result.
+		//
+		static void RowReduce(const BasicMatrix& mat, const ReduceOp op, BasicMatrix& result);
+		static void ColReduce(const BasicMatrix& mat, const ReduceOp op, BasicMatrix& result);
 
 	public:
-		Matrix();
-		Matrix(const unsigned int rows, const unsigned int cols);
-		Matrix(const Matrix& mat);
-		virtual ~Matrix();
+		BasicMatrix();
+		BasicMatrix(const unsigned int rows, const unsigned int cols);
+		BasicMatrix(const unsigned int rows, const unsigned int cols, Allocator& allocator);
+		BasicMatrix(const BasicMatrix& mat);
+		BasicMatrix(BasicMatrix&& mat) noexcept;
+		template <typename E>
+		BasicMatrix(const MatrixExpr<E>& expr);
+		virtual ~BasicMatrix();
 
-		const Matrix& operator=(const Matrix& mat);
+		const BasicMatrix& operator=(const BasicMatrix& mat);
+		const BasicMatrix& operator=(BasicMatrix&& mat);
+		template <typename E>
+		const BasicMatrix& operator=(const MatrixExpr<E>& expr);
 		ElemType&     operator()(const unsigned int row, const unsigned int col);
 
 		unsigned int Rows()     const;
 		unsigned int Cols()     const;
-		unsigned int Capacity() const;
+		size_t       Capacity() const;
+		size_t       NumElements() const;
+		void         Reserve(const size_t numElements);
+		void         Resize(const unsigned int rows, const unsigned int cols);
 		void         Clear();
+		void         Swap(BasicMatrix& mat);
+
+		//
+		// Replace the matrix with its transpose. Square matrices are transposed in place; other
+		// shapes go through a temporary and then swap their rows and cols.
+		//
+		void         TransposeInPlace();
+
+		ElemType*       Data();
+		const ElemType* Data() const;
+
+		ViewType      View();
+		ConstViewType View() const;
+		ViewType      Block(const unsigned int row, const unsigned int col,
+		                    const unsigned int rows, const unsigned int cols);
+		ConstViewType Block(const unsigned int row, const unsigned int col,
+		                    const unsigned int rows, const unsigned int cols) const;
+		ViewType      Row(const unsigned int row);
+		ConstViewType Row(const unsigned int row) const;
+		ViewType      Col(const unsigned int col);
+		ConstViewType Col(const unsigned int col) const;
+		ViewType      Transposed();
+		ConstViewType Transposed() const;
 
 		ElemType GetElemAt(const unsigned int row, const unsigned int col) const;
 		void   SetElemAt(const unsigned int row, const unsigned int col, const ElemType value);
@@ -65,13 +183,30 @@ namespace numeric
 		//
 		void PrintOut() const;
 
+	private:
+		void AllocStorage(const size_t numElements);
+
 	private:
 		unsigned int m_rows;
 		unsigned int m_cols;
-		unsigned int m_capacity;
+		size_t       m_capacity;
 		ElemType*    m_elements;
+		Allocator*   m_allocator;
 	};
+
+	typedef BasicMatrix<float>        MatrixF;
+	typedef BasicMatrix<double>       Matrix;
+	typedef BasicMatrix<std::int32_t> MatrixI;
+
+	//
+	// Element type of Matrix, kept for code written before Matrix became a template.
+	//
+	typedef Matrix::ElemType ElemType;
 }
+
+#include "MatrixView.hpp"
+#include "MatrixExpr.hpp"
+
 #endif 
 
 
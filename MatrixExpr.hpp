@@ -0,0 +1,639 @@
+#ifndef Numeric_MatrixExpr_HPP
+#define Numeric_MatrixExpr_HPP
+
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "Matrix.hpp"
+#include "Gemm.hpp"
+#include "Instrumentation.hpp"
+#include "ElementWise.hpp"
+
+//
+// Lazy matrix expressions.
+//
+// The operators +, -, scalar * and matrix * on Matrix operands do not compute anything; they
+// return small expression objects that record the operands. The work happens when an
+// expression is assigned to (or used to construct) a Matrix:
+//
+//   - chains of +, - and scalar * are evaluated in a single fused loop straight into the
+//     destination, without any intermediate Matrix;
+//   - a matrix product term, possibly scaled, is computed by the GEMM engine directly into the
+//     destination, and sums/differences with it are folded into GEMM's alpha and beta, so
+//     d = A*x + t copies t into d and then accumulates A*x on top of it.
+//
+// The only heap allocations left are for the destination itself, for a product operand that is
+// an expression rather than a Matrix, for a sum operand that holds a product further down
+// (d = C + (C + A*B)) and cannot be built in the destination, and for a destination that a
+// product reads from (d = A*d), which has to be computed out of place. A product is never
+// evaluated element by element.
+//
+// Expressions hold references to the Matrix objects they read, so they must not outlive them:
+// assign them to a Matrix rather than keeping them in an `auto` variable.
+//
+namespace numeric
+{
+	//
+	// Common base of all expression nodes, used to recognise them in the operators.
+	//
+	struct MatrixExprBase
+	{
+	};
+
+	template <typename Derived>
+	struct MatrixExpr : public MatrixExprBase
+	{
+		const Derived& Self() const
+		{
+			return static_cast<const Derived&>(*this);
+		}
+	};
+
+	//
+	// Leaf : A Matrix operand.
+	//
+	template <typename T>
+	class MatrixLeafExpr : public MatrixExpr<MatrixLeafExpr<T> >
+	{
+	public:
+		typedef T Scalar;
+		enum { HasProduct = 0 };
+
+		explicit MatrixLeafExpr(const BasicMatrix<T>& mat)
+			: m_data(mat.Data()), m_rows(mat.Rows()), m_cols(mat.Cols())
+		{
+		}
+
+		unsigned int Rows() const { return m_rows; }
+		unsigned int Cols() const { return m_cols; }
+
+		Scalar Coeff(const size_t index) const
+		{
+			return m_data[index];
+		}
+
+		const Scalar* Data() const { return m_data; }
+
+		bool Reads(const Scalar* p) const        { return m_data == p; }
+		bool ProductReads(const Scalar*) const   { return false; }
+
+	private:
+		const Scalar*   m_data;
+		unsigned int    m_rows;
+		unsigned int    m_cols;
+	};
+
+	struct ExprAddOp
+	{
+		static const int Sign = 1;
+		template <typename T>
+		static T Apply(const T a, const T b) { return a + b; }
+	};
+
+	struct ExprSubOp
+	{
+		static const int Sign = -1;
+		template <typename T>
+		static T Apply(const T a, const T b) { return a - b; }
+	};
+
+	//
+	// Node : Element-wise sum or difference.
+	//
+	template <typename L, typename R, typename Op>
+	class MatrixBinaryExpr : public MatrixExpr<MatrixBinaryExpr<L, R, Op> >
+	{
+	public:
+		typedef typename L::Scalar Scalar;
+		enum { HasProduct = L::HasProduct || R::HasProduct };
+
+		static_assert(std::is_same<typename L::Scalar, typename R::Scalar>::value,
+		              "Operands must have the same element type");
+
+		MatrixBinaryExpr(const L& lhs, const R& rhs)
+			: m_lhs(lhs), m_rhs(rhs)
+		{
+			// Guardian
+			if (lhs.Rows() != rhs.Rows() || lhs.Cols() != rhs.Cols())
+			{
+				throw std::invalid_argument(
+					"Dimension mismatch"
+					);
+			}
+		}
+
+		unsigned int Rows() const { return m_lhs.Rows(); }
+		unsigned int Cols() const { return m_lhs.Cols(); }
+
+		Scalar Coeff(const size_t index) const
+		{
+			return Op::Apply(m_lhs.Coeff(index), m_rhs.Coeff(index));
+		}
+
+		const L& Lhs() const { return m_lhs; }
+		const R& Rhs() const { return m_rhs; }
+
+		bool Reads(const Scalar* p) const
+		{
+			return m_lhs.Reads(p) || m_rhs.Reads(p);
+		}
+
+		bool ProductReads(const Scalar* p) const
+		{
+			return m_lhs.ProductReads(p) || m_rhs.ProductReads(p);
+		}
+
+	private:
+		L m_lhs;
+		R m_rhs;
+	};
+
+	//
+	// Node : Scalar times an expression.
+	//
+	template <typename E>
+	class MatrixScaleExpr : public MatrixExpr<MatrixScaleExpr<E> >
+	{
+	public:
+		typedef typename E::Scalar Scalar;
+		enum { HasProduct = E::HasProduct };
+
+		MatrixScaleExpr(const Scalar s, const E& expr)
+			: m_scalar(s), m_expr(expr)
+		{
+		}
+
+		unsigned int Rows() const { return m_expr.Rows(); }
+		unsigned int Cols() const { return m_expr.Cols(); }
+
+		Scalar Coeff(const size_t index) const
+		{
+			return m_scalar * m_expr.Coeff(index);
+		}
+
+		Scalar Factor() const { return m_scalar; }
+		const E& Inner() const  { return m_expr; }
+
+		bool Reads(const Scalar* p) const        { return m_expr.Reads(p); }
+		bool ProductReads(const Scalar* p) const { return m_expr.ProductReads(p); }
+
+	private:
+		Scalar m_scalar;
+		E        m_expr;
+	};
+
+	//
+	// Node : Matrix product. It has no Coeff: it is only ever evaluated by the GEMM engine,
+	// into the destination or into a temporary.
+	//
+	template <typename L, typename R>
+	class MatrixProductExpr : public MatrixExpr<MatrixProductExpr<L, R> >
+	{
+	public:
+		typedef typename L::Scalar Scalar;
+		enum { HasProduct = 1 };
+
+		static_assert(std::is_same<typename L::Scalar, typename R::Scalar>::value,
+		              "Operands must have the same element type");
+
+		MatrixProductExpr(const L& lhs, const R& rhs)
+			: m_lhs(lhs), m_rhs(rhs)
+		{
+			// Guardian
+			if (lhs.Cols() != rhs.Rows())
+			{
+				throw std::invalid_argument(
+					"Dimension mismatch"
+					);
+			}
+		}
+
+		unsigned int Rows() const { return m_lhs.Rows(); }
+		unsigned int Cols() const { return m_rhs.Cols(); }
+
+		const L& Lhs() const { return m_lhs; }
+		const R& Rhs() const { return m_rhs; }
+
+		bool Reads(const Scalar* p) const
+		{
+			return m_lhs.Reads(p) || m_rhs.Reads(p);
+		}
+
+		bool ProductReads(const Scalar* p) const
+		{
+			return Reads(p);
+		}
+
+	private:
+		L m_lhs;
+		R m_rhs;
+	};
+
+	namespace detail
+	{
+		//
+		// Map an operator argument to its expression node: a matrix becomes a leaf, expression
+		// nodes are used as they are, anything else has no Type and drops the overload.
+		//
+		template <typename T, typename Enable = void>
+		struct ExprOf
+		{
+		};
+
+		template <typename T>
+		struct ExprOf<BasicMatrix<T> >
+		{
+			typedef MatrixLeafExpr<T> Type;
+			static Type Get(const BasicMatrix<T>& mat) { return MatrixLeafExpr<T>(mat); }
+		};
+
+		template <typename T>
+		struct ExprOf<T, typename std::enable_if<std::is_base_of<MatrixExprBase, T>::value>::type>
+		{
+			typedef T Type;
+			static const T& Get(const T& expr) { return expr; }
+		};
+
+		//
+		// Product terms, A*B or s*(A*B), can be accumulated by GEMM:
+		//      dest = alpha * term + beta * dest
+		//
+		template <typename E>
+		struct ProductTerm
+		{
+			enum { Value = 0 };
+		};
+
+		//
+		// Storage for a product operand: a leaf is used in place, any other expression is
+		// evaluated into a matrix first.
+		//
+		template <typename E>
+		class ProductOperand
+		{
+		public:
+			typedef typename E::Scalar Scalar;
+			explicit ProductOperand(const E& expr) : m_value(expr) {}
+			const Scalar* Data() const { return m_value.Data(); }
+		private:
+			BasicMatrix<Scalar> m_value;
+		};
+
+		template <typename T>
+		class ProductOperand<MatrixLeafExpr<T> >
+		{
+		public:
+			explicit ProductOperand(const MatrixLeafExpr<T>& leaf) : m_data(leaf.Data()) {}
+			const T* Data() const { return m_data; }
+		private:
+			const T* m_data;
+		};
+
+		template <typename T, typename L, typename R>
+		void GemmInto(BasicMatrix<T>& dest, const MatrixProductExpr<L, R>& product,
+		              const T alpha, const T beta)
+		{
+			const ProductOperand<L> lhs(product.Lhs());
+			const ProductOperand<R> rhs(product.Rhs());
+			const unsigned int m = product.Rows();
+			const unsigned int n = product.Cols();
+			const unsigned int k = product.Lhs().Cols();
+			NUMERIC_INSTRUMENT_FLOPS(instrumentation::OpMatrixExpression, 2 * static_cast<std::uint64_t>(m) * n * k);
+			kernel::Gemm<T>(m, n, k,
+				alpha, lhs.Data(), k, 1,
+				rhs.Data(), n, 1,
+				beta, dest.Data(), n, 1);
+		}
+
+		template <typename L, typename R>
+		struct ProductTerm<MatrixProductExpr<L, R> >
+		{
+			enum { Value = 1 };
+
+			template <typename T>
+			static void Gemm(BasicMatrix<T>& dest, const MatrixProductExpr<L, R>& term,
+			                 const T alpha, const T beta)
+			{
+				GemmInto(dest, term, alpha, beta);
+			}
+		};
+
+		template <typename L, typename R>
+		struct ProductTerm<MatrixScaleExpr<MatrixProductExpr<L, R> > >
+		{
+			enum { Value = 1 };
+
+			template <typename T>
+			static void Gemm(BasicMatrix<T>& dest, const MatrixScaleExpr<MatrixProductExpr<L, R> >& term,
+			                 const T alpha, const T beta)
+			{
+				GemmInto(dest, term.Inner(), static_cast<T>(alpha * term.Factor()), beta);
+			}
+		};
+
+		//
+		// An operand of a sum whose products lie deeper in the tree. A side with products is
+		// evaluated into a temporary, by GEMM; a side without them is read in place.
+		//
+		template <typename E, bool Evaluate = E::HasProduct != 0>
+		class SumOperand
+		{
+		public:
+			typedef typename E::Scalar Scalar;
+			explicit SumOperand(const E& expr) : m_expr(expr) {}
+			Scalar Coeff(const size_t index) const { return m_expr.Coeff(index); }
+		private:
+			const E& m_expr;
+		};
+
+		template <typename E>
+		class SumOperand<E, true>
+		{
+		public:
+			typedef typename E::Scalar Scalar;
+			explicit SumOperand(const E& expr) : m_value(expr) {}
+			Scalar Coeff(const size_t index) const { return m_value.Data()[index]; }
+		private:
+			BasicMatrix<Scalar> m_value;
+		};
+
+		typedef std::integral_constant<bool, false> NoProduct;
+		typedef std::integral_constant<bool, true>  WithProduct;
+
+		template <typename T, typename E>
+		void Assign(BasicMatrix<T>& dest, const E& expr);
+
+		//
+		// Element-wise expressions: one fused loop. Reading the destination is harmless
+		// because every element only depends on the same element of its operands.
+		//
+		template <typename T, typename E>
+		void AssignElementWise(BasicMatrix<T>& dest, const E& expr)
+		{
+			T* out = dest.Data();
+			const size_t n = dest.NumElements();
+			for (size_t i = 0; i < n; i++)
+			{
+				out[i] = expr.Coeff(i);
+			}
+		}
+
+		//
+		// The plain two-operand forms go to the SIMD kernels.
+		//
+		template <typename T>
+		void AssignElementWise(BasicMatrix<T>& dest, const MatrixLeafExpr<T>& leaf)
+		{
+			if (leaf.Data() != dest.Data())
+			{
+				std::copy(leaf.Data(), leaf.Data() + dest.NumElements(), dest.Data());
+			}
+		}
+
+		template <typename T>
+		void AssignElementWise(BasicMatrix<T>& dest,
+			const MatrixBinaryExpr<MatrixLeafExpr<T>, MatrixLeafExpr<T>, ExprAddOp>& expr)
+		{
+			kernel::Add<T>(dest.NumElements(), expr.Lhs().Data(), expr.Rhs().Data(), dest.Data());
+		}
+
+		template <typename T>
+		void AssignElementWise(BasicMatrix<T>& dest,
+			const MatrixBinaryExpr<MatrixLeafExpr<T>, MatrixLeafExpr<T>, ExprSubOp>& expr)
+		{
+			kernel::Sub<T>(dest.NumElements(), expr.Lhs().Data(), expr.Rhs().Data(), dest.Data());
+		}
+
+		template <typename T>
+		void AssignElementWise(BasicMatrix<T>& dest, const MatrixScaleExpr<MatrixLeafExpr<T> >& expr)
+		{
+			kernel::Scale<T>(dest.NumElements(), expr.Factor(), expr.Inner().Data(), dest.Data());
+		}
+
+		//
+		// Expressions containing products. The caller guarantees that no product reads the
+		// destination.
+		//
+		template <typename T, typename L, typename R>
+		void AssignProduct(BasicMatrix<T>& dest, const MatrixProductExpr<L, R>& expr)
+		{
+			GemmInto(dest, expr, T(1), T(0));
+		}
+
+		template <typename T, typename E>
+		void AssignScaled(BasicMatrix<T>& dest, const MatrixScaleExpr<E>& expr,
+		                  std::integral_constant<bool, true>)
+		{
+			ProductTerm<MatrixScaleExpr<E> >::Gemm(dest, expr, T(1), T(0));
+		}
+
+		template <typename T, typename E>
+		void AssignScaled(BasicMatrix<T>& dest, const MatrixScaleExpr<E>& expr,
+		                  std::integral_constant<bool, false>)
+		{
+			Assign(dest, expr.Inner());
+			kernel::Scale<T>(dest.NumElements(), expr.Factor(), dest.Data(), dest.Data());
+		}
+
+		template <typename T, typename E>
+		void AssignProduct(BasicMatrix<T>& dest, const MatrixScaleExpr<E>& expr)
+		{
+			AssignScaled(dest, expr,
+				std::integral_constant<bool, ProductTerm<MatrixScaleExpr<E> >::Value != 0>());
+		}
+
+		//
+		// rest op P: write rest, then let GEMM accumulate the product with alpha = +-1.
+		//
+		template <typename T, typename L, typename R, typename Op>
+		void AssignSum(BasicMatrix<T>& dest, const MatrixBinaryExpr<L, R, Op>& expr,
+		               std::integral_constant<int, 2>)
+		{
+			Assign(dest, expr.Lhs());
+			ProductTerm<R>::Gemm(dest, expr.Rhs(), static_cast<T>(Op::Sign), T(1));
+		}
+
+		//
+		// P op rest: write rest, then GEMM computes P + (+-1) * rest.
+		//
+		template <typename T, typename L, typename R, typename Op>
+		void AssignSum(BasicMatrix<T>& dest, const MatrixBinaryExpr<L, R, Op>& expr,
+		               std::integral_constant<int, 1>)
+		{
+			Assign(dest, expr.Rhs());
+			ProductTerm<L>::Gemm(dest, expr.Lhs(), T(1), static_cast<T>(Op::Sign));
+		}
+
+		//
+		// Products deeper in the tree: a side with products is evaluated into the destination
+		// when the other side does not read it, and everything else into temporaries, so every
+		// product still goes through GEMM. The sides are then combined in one element-wise
+		// pass, which may read the destination.
+		//
+		template <typename T, typename L, typename R, typename Op>
+		void AssignSum(BasicMatrix<T>& dest, const MatrixBinaryExpr<L, R, Op>& expr,
+		               std::integral_constant<int, 0>)
+		{
+			T* out = dest.Data();
+			const size_t n = dest.NumElements();
+
+			if (R::HasProduct && !expr.Lhs().Reads(dest.Data()))
+			{
+				Assign(dest, expr.Rhs());
+				const SumOperand<L> lhs(expr.Lhs());
+				for (size_t i = 0; i < n; i++)
+				{
+					out[i] = Op::Apply(lhs.Coeff(i), out[i]);
+				}
+			}
+			else if (L::HasProduct && !expr.Rhs().Reads(dest.Data()))
+			{
+				Assign(dest, expr.Lhs());
+				const SumOperand<R> rhs(expr.Rhs());
+				for (size_t i = 0; i < n; i++)
+				{
+					out[i] = Op::Apply(out[i], rhs.Coeff(i));
+				}
+			}
+			else
+			{
+				const SumOperand<L> lhs(expr.Lhs());
+				const SumOperand<R> rhs(expr.Rhs());
+				for (size_t i = 0; i < n; i++)
+				{
+					out[i] = Op::Apply(lhs.Coeff(i), rhs.Coeff(i));
+				}
+			}
+		}
+
+		template <typename T, typename L, typename R, typename Op>
+		void AssignProduct(BasicMatrix<T>& dest, const MatrixBinaryExpr<L, R, Op>& expr)
+		{
+			AssignSum(dest, expr, std::integral_constant<int,
+				ProductTerm<R>::Value ? 2 : (ProductTerm<L>::Value ? 1 : 0)>());
+		}
+
+		template <typename T, typename E>
+		void AssignDispatch(BasicMatrix<T>& dest, const E& expr, NoProduct)
+		{
+			AssignElementWise(dest, expr);
+		}
+
+		template <typename T, typename E>
+		void AssignDispatch(BasicMatrix<T>& dest, const E& expr, WithProduct)
+		{
+			if (expr.ProductReads(dest.Data()))
+			{
+				BasicMatrix<T> tmp(dest.Rows(), dest.Cols());
+				AssignProduct(tmp, expr);
+				dest.Swap(tmp);
+			}
+			else
+			{
+				AssignProduct(dest, expr);
+			}
+		}
+
+		/// \brief       Evaluate expr into dest, which already has the right shape.
+		template <typename T, typename E>
+		void Assign(BasicMatrix<T>& dest, const E& expr)
+		{
+			static_assert(std::is_same<T, typename E::Scalar>::value,
+			              "Expression and destination must have the same element type");
+			AssignDispatch(dest, expr, std::integral_constant<bool, E::HasProduct != 0>());
+		}
+	}
+
+	//
+	// Operators
+	//
+	template <typename L, typename R>
+	inline MatrixBinaryExpr<typename detail::ExprOf<L>::Type, typename detail::ExprOf<R>::Type, ExprAddOp>
+	operator+(const L& lhs, const R& rhs)
+	{
+		return MatrixBinaryExpr<typename detail::ExprOf<L>::Type,
+		                        typename detail::ExprOf<R>::Type,
+		                        ExprAddOp>(detail::ExprOf<L>::Get(lhs), detail::ExprOf<R>::Get(rhs));
+	}
+
+	template <typename L, typename R>
+	inline MatrixBinaryExpr<typename detail::ExprOf<L>::Type, typename detail::ExprOf<R>::Type, ExprSubOp>
+	operator-(const L& lhs, const R& rhs)
+	{
+		return MatrixBinaryExpr<typename detail::ExprOf<L>::Type,
+		                        typename detail::ExprOf<R>::Type,
+		                        ExprSubOp>(detail::ExprOf<L>::Get(lhs), detail::ExprOf<R>::Get(rhs));
+	}
+
+	template <typename L, typename R>
+	inline MatrixProductExpr<typename detail::ExprOf<L>::Type, typename detail::ExprOf<R>::Type>
+	operator*(const L& lhs, const R& rhs)
+	{
+		return MatrixProductExpr<typename detail::ExprOf<L>::Type,
+		                         typename detail::ExprOf<R>::Type>(detail::ExprOf<L>::Get(lhs),
+		                                                           detail::ExprOf<R>::Get(rhs));
+	}
+
+	template <typename R>
+	inline MatrixScaleExpr<typename detail::ExprOf<R>::Type>
+	operator*(const typename detail::ExprOf<R>::Type::Scalar lhd, const R& rhs)
+	{
+		return MatrixScaleExpr<typename detail::ExprOf<R>::Type>(lhd, detail::ExprOf<R>::Get(rhs));
+	}
+
+	template <typename L>
+	inline MatrixScaleExpr<typename detail::ExprOf<L>::Type>
+	operator*(const L& lhs, const typename detail::ExprOf<L>::Type::Scalar rhd)
+	{
+		return MatrixScaleExpr<typename detail::ExprOf<L>::Type>(rhd, detail::ExprOf<L>::Get(lhs));
+	}
+
+	//
+	// Matrix members that take expressions.
+	//
+	template <typename T>
+	template <typename E>
+	BasicMatrix<T>::BasicMatrix(const MatrixExpr<E>& expr)
+		: m_rows(0), m_cols(0), m_capacity(0), m_elements(NULL), m_allocator(Allocator::Current())
+	{
+		const E& e = expr.Self();
+		if (e.Rows() <= 0 || e.Cols() <= 0)
+		{
+			throw std::invalid_argument(
+				"Rows and cols cann't be smaller than one."
+				);
+		}
+		NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixExpression, static_cast<std::uint64_t>(e.Rows()) * e.Cols(), 0);
+		AllocStorage(static_cast<size_t>(e.Rows()) * e.Cols());
+		m_rows = e.Rows();
+		m_cols = e.Cols();
+		try
+		{
+			detail::Assign(*this, e);
+		}
+		catch (...)
+		{
+			Clear();
+			throw;
+		}
+	}
+
+	template <typename T>
+	template <typename E>
+	const BasicMatrix<T>& BasicMatrix<T>::operator=(const MatrixExpr<E>& expr)
+	{
+		const E& e = expr.Self();
+		if (this->Cols() != e.Cols() || this->Rows() != e.Rows())
+		{
+			throw std::invalid_argument(
+				"Dimension mismatch"
+				);
+		}
+		NUMERIC_INSTRUMENT_OPERATION(instrumentation::OpMatrixExpression, static_cast<std::uint64_t>(e.Rows()) * e.Cols(), 0);
+		detail::Assign(*this, e);
+		return *this;
+	}
+}
+
+#endif
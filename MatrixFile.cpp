@@ -0,0 +1,507 @@
+
+#include "MatrixFile.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of MatrixFile
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	const char          Magic[8] = { 'N', 'U', 'M', 'A', 'T', 'R', 'I', 'X' };
+	const std::uint32_t ByteOrderMark = 0x01020304;
+	const std::uint32_t SwappedByteOrderMark = 0x04030201;
+
+	template <typename T> struct ElemTypeOf;
+	template <> struct ElemTypeOf<float>        { static const MatrixFileElemType Value = MatrixFileFloat32; };
+	template <> struct ElemTypeOf<double>       { static const MatrixFileElemType Value = MatrixFileFloat64; };
+	template <> struct ElemTypeOf<std::int32_t> { static const MatrixFileElemType Value = MatrixFileInt32; };
+
+	//
+	// The header as read from a file, with the fields in the byte order of this machine.
+	//
+	struct Header
+	{
+		bool          swapped;
+		std::uint32_t version;
+		std::uint32_t elemType;
+		std::uint32_t elemSize;
+		std::uint32_t rows;
+		std::uint32_t cols;
+		std::uint32_t alignment;
+		std::uint64_t dataOffset;
+		std::uint64_t dataBytes;
+	};
+
+	template <typename U>
+	void Put(unsigned char* header, const size_t offset, const U value)
+	{
+		std::memcpy(header + offset, &value, sizeof(U));
+	}
+
+	template <typename U>
+	U Get(const unsigned char* header, const size_t offset, const bool swapped)
+	{
+		U value;
+		std::memcpy(&value, header + offset, sizeof(U));
+		if (swapped)
+		{
+			unsigned char* bytes = reinterpret_cast<unsigned char*>(&value);
+			std::reverse(bytes, bytes + sizeof(U));
+		}
+		return value;
+	}
+
+	/// \brief      Decode and check a header.
+	/// \param[in]  bytes. The first MatrixFileHeaderBytes of the file.
+	/// \param[in]  fileBytes. Size of the whole file.
+	Header ParseHeader(const unsigned char* bytes, const std::uint64_t fileBytes)
+	{
+		if (fileBytes < MatrixFileHeaderBytes || std::memcmp(bytes, Magic, sizeof(Magic)) != 0)
+		{
+			throw std::runtime_error("Not a matrix file");
+		}
+
+		Header header;
+		const std::uint32_t mark = Get<std::uint32_t>(bytes, 12, false);
+		if (mark != ByteOrderMark && mark != SwappedByteOrderMark)
+		{
+			throw std::runtime_error("Not a matrix file");
+		}
+		header.swapped = mark == SwappedByteOrderMark;
+		header.version = Get<std::uint32_t>(bytes, 8, header.swapped);
+		if (header.version != MatrixFileVersion)
+		{
+			throw std::runtime_error("Unsupported matrix file version");
+		}
+
+		header.elemType = Get<std::uint32_t>(bytes, 16, header.swapped);
+		header.elemSize = Get<std::uint32_t>(bytes, 20, header.swapped);
+		header.rows = Get<std::uint32_t>(bytes, 24, header.swapped);
+		header.cols = Get<std::uint32_t>(bytes, 28, header.swapped);
+		header.alignment = Get<std::uint32_t>(bytes, 32, header.swapped);
+		header.dataOffset = Get<std::uint64_t>(bytes, 40, header.swapped);
+		header.dataBytes = Get<std::uint64_t>(bytes, 48, header.swapped);
+
+		//
+		// Every size is checked by division, so a crafted header cannot wrap a product or a sum
+		// around and point the data past the end of the file.
+		//
+		const std::uint64_t maxBytes = std::numeric_limits<std::uint64_t>::max();
+		const std::uint32_t expectedSize = header.elemType == MatrixFileFloat64 ? 8 : 4;
+		if (header.elemType < MatrixFileFloat32 || header.elemType > MatrixFileInt32 ||
+			header.elemSize != expectedSize ||
+			header.rows == 0 || header.cols == 0 ||
+			header.rows > maxBytes / header.cols / header.elemSize ||
+			header.alignment == 0 || header.dataOffset % header.alignment != 0 ||
+			header.dataOffset % header.elemSize != 0 ||
+			header.dataOffset < MatrixFileHeaderBytes || header.dataOffset > fileBytes ||
+			header.dataBytes != static_cast<std::uint64_t>(header.rows) * header.cols * header.elemSize ||
+			header.dataBytes > fileBytes - header.dataOffset)
+		{
+			throw std::runtime_error("Corrupt matrix file header");
+		}
+		return header;
+	}
+
+	//
+	// Closes a FILE* on every path out of a function.
+	//
+	class FileCloser
+	{
+	public:
+		explicit FileCloser(std::FILE* file)
+			: m_file(file)
+		{
+		}
+
+		~FileCloser()
+		{
+			if (m_file != NULL)
+			{
+				std::fclose(m_file);
+			}
+		}
+
+		std::FILE* Release()
+		{
+			std::FILE* file = m_file;
+			m_file = NULL;
+			return file;
+		}
+
+	private:
+		std::FILE* m_file;
+	};
+
+	/// \brief  Write the header of a rows*cols matrix of the given element type.
+	bool WriteHeader(std::FILE* out, const MatrixFileElemType type, const size_t elemSize,
+	                 const unsigned int rows, const unsigned int cols)
+	{
+		unsigned char header[MatrixFileHeaderBytes];
+		std::memset(header, 0, sizeof(header));
+		std::memcpy(header, Magic, sizeof(Magic));
+		Put<std::uint32_t>(header, 8, MatrixFileVersion);
+		Put<std::uint32_t>(header, 12, ByteOrderMark);
+		Put<std::uint32_t>(header, 16, type);
+		Put<std::uint32_t>(header, 20, static_cast<std::uint32_t>(elemSize));
+		Put<std::uint32_t>(header, 24, rows);
+		Put<std::uint32_t>(header, 28, cols);
+		Put<std::uint32_t>(header, 32, static_cast<std::uint32_t>(MatrixFileHeaderBytes));
+		Put<std::uint64_t>(header, 40, MatrixFileHeaderBytes);
+		Put<std::uint64_t>(header, 48, static_cast<std::uint64_t>(rows) * cols * elemSize);
+		return std::fwrite(header, 1, sizeof(header), out) == sizeof(header);
+	}
+
+	/// \brief  Move an open file to a byte offset, which may be beyond 2 GiB.
+	bool Seek(std::FILE* file, const std::uint64_t offset)
+	{
+#if defined(_WIN32)
+		return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+		return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+	}
+
+	/// \brief  Size of an open file in bytes, leaving the position at the start.
+	std::uint64_t FileSize(std::FILE* file)
+	{
+#if defined(_WIN32)
+		const __int64 end = _fseeki64(file, 0, SEEK_END) == 0 ? _ftelli64(file) : -1;
+#else
+		const off_t end = fseeko(file, 0, SEEK_END) == 0 ? ftello(file) : -1;
+#endif
+		std::rewind(file);
+		return end > 0 ? static_cast<std::uint64_t>(end) : 0;
+	}
+}
+
+
+/// \brief      Write a matrix file.
+/// \param[in]  path. File name; an existing file is replaced.
+/// \param[in]  view. The elements, written row by row.
+template <typename T>
+void numeric::SaveMatrix(const std::string& path, const MatrixView<const T>& view)
+{
+	//
+	// LoadMatrix cannot give back an empty matrix, so none is written.
+	//
+	if (view.Rows() == 0 || view.Cols() == 0)
+	{
+		throw std::invalid_argument(
+			"Rows and cols cann't be smaller than one."
+			);
+	}
+
+	std::FILE* out = std::fopen(path.c_str(), "wb");
+	if (out == NULL)
+	{
+		throw std::runtime_error("Cannot open " + path + " for writing");
+	}
+	FileCloser closer(out);
+	bool written = WriteHeader(out, ElemTypeOf<T>::Value, sizeof(T), view.Rows(), view.Cols());
+
+	const unsigned int rows = view.Rows();
+	const unsigned int cols = view.Cols();
+	if (written && view.HasContiguousRows() && view.RowStride() == static_cast<std::ptrdiff_t>(cols))
+	{
+		written = std::fwrite(view.Data(), sizeof(T), view.NumElements(), out) == view.NumElements();
+	}
+	else
+	{
+		std::vector<T> row(cols);
+		for (unsigned int i = 0; written && i < rows; i++)
+		{
+			for (unsigned int j = 0; j < cols; j++)
+			{
+				row[j] = view.Data()[i * view.RowStride() + j * view.ColStride()];
+			}
+			written = std::fwrite(&row[0], sizeof(T), cols, out) == cols;
+		}
+	}
+
+	if (!written || std::fclose(closer.Release()) != 0)
+	{
+		throw std::runtime_error("Cannot write " + path);
+	}
+}
+
+
+template <typename T>
+void numeric::SaveMatrix(const std::string& path, const BasicMatrix<T>& mat)
+{
+	numeric::SaveMatrix<T>(path, MatrixView<const T>(mat));
+}
+
+
+/// \brief      Create a rows*cols matrix file whose elements are all zero. Where the file
+///             system supports it the data is left as a hole and takes no space until written.
+template <typename T>
+void numeric::CreateMatrixFile(const std::string& path, const unsigned int rows, const unsigned int cols)
+{
+	if (rows <= 0 || cols <= 0)
+	{
+		throw std::invalid_argument(
+			"Rows and cols cann't be smaller than one."
+			);
+	}
+
+	std::FILE* out = std::fopen(path.c_str(), "wb");
+	if (out == NULL)
+	{
+		throw std::runtime_error("Cannot open " + path + " for writing");
+	}
+	FileCloser closer(out);
+
+	const std::uint64_t end = MatrixFileHeaderBytes + static_cast<std::uint64_t>(rows) * cols * sizeof(T);
+	const unsigned char zero = 0;
+	bool written = WriteHeader(out, ElemTypeOf<T>::Value, sizeof(T), rows, cols);
+	written = written && Seek(out, end - 1);
+	written = written && std::fwrite(&zero, 1, 1, out) == 1;
+	if (!written || std::fclose(closer.Release()) != 0)
+	{
+		throw std::runtime_error("Cannot write " + path);
+	}
+}
+
+
+/// \brief      Read a matrix file into memory.
+/// \param[in]  path. File name.
+/// \param[out] mat. Resized to the shape stored in the file.
+template <typename T>
+void numeric::LoadMatrix(const std::string& path, BasicMatrix<T>& mat)
+{
+	std::FILE* in = std::fopen(path.c_str(), "rb");
+	if (in == NULL)
+	{
+		throw std::runtime_error("Cannot open " + path);
+	}
+	FileCloser closer(in);
+
+	unsigned char bytes[MatrixFileHeaderBytes];
+	const std::uint64_t fileBytes = FileSize(in);
+	if (std::fread(bytes, 1, sizeof(bytes), in) != sizeof(bytes))
+	{
+		throw std::runtime_error("Not a matrix file");
+	}
+
+	const Header header = ParseHeader(bytes, fileBytes);
+	if (header.elemType != static_cast<std::uint32_t>(ElemTypeOf<T>::Value))
+	{
+		throw std::invalid_argument(
+			"Element type mismatch"
+			);
+	}
+
+	mat.Resize(header.rows, header.cols);
+	if (!Seek(in, header.dataOffset) ||
+		std::fread(mat.Data(), sizeof(T), mat.NumElements(), in) != mat.NumElements())
+	{
+		throw std::runtime_error("Cannot read " + path);
+	}
+
+	if (header.swapped)
+	{
+		T* data = mat.Data();
+		for (size_t i = 0; i < mat.NumElements(); i++)
+		{
+			unsigned char* elem = reinterpret_cast<unsigned char*>(data + i);
+			std::reverse(elem, elem + sizeof(T));
+		}
+	}
+}
+
+
+/// \brief     Map a matrix file and check its header.
+/// \param[in] path. File name.
+MappedMatrixFile::MappedMatrixFile(const std::string& path)
+	: m_mapping(NULL), m_mappedBytes(0), m_rows(0), m_cols(0),
+	  m_elemType(MatrixFileFloat64), m_dataOffset(0)
+{
+#if defined(_WIN32)
+	m_file = NULL;
+	m_mappingHandle = NULL;
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+	                          FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Cannot open " + path);
+	}
+	LARGE_INTEGER size;
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	}
+	void* view = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (view == NULL)
+	{
+		if (mapping != NULL)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		throw std::runtime_error("Cannot map " + path);
+	}
+	m_file = file;
+	m_mappingHandle = mapping;
+	m_mapping = view;
+	m_mappedBytes = static_cast<size_t>(size.QuadPart);
+#else
+	const int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Cannot open " + path);
+	}
+	struct stat status;
+	void* view = MAP_FAILED;
+	if (fstat(fd, &status) == 0 && status.st_size > 0)
+	{
+		view = mmap(NULL, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (view == MAP_FAILED)
+	{
+		throw std::runtime_error("Cannot map " + path);
+	}
+	m_mapping = view;
+	m_mappedBytes = static_cast<size_t>(status.st_size);
+#endif
+
+	Header header;
+	try
+	{
+		header = ParseHeader(static_cast<const unsigned char*>(m_mapping), m_mappedBytes);
+		if (header.swapped)
+		{
+			throw std::runtime_error("Matrix file has the other byte order; use LoadMatrix");
+		}
+	}
+	catch (...)
+	{
+		Unmap();
+		throw;
+	}
+
+	m_rows = header.rows;
+	m_cols = header.cols;
+	m_elemType = static_cast<MatrixFileElemType>(header.elemType);
+	m_dataOffset = static_cast<size_t>(header.dataOffset);
+}
+
+
+MappedMatrixFile::~MappedMatrixFile()
+{
+	Unmap();
+}
+
+
+void MappedMatrixFile::Unmap()
+{
+	if (m_mapping == NULL)
+	{
+		return;
+	}
+#if defined(_WIN32)
+	UnmapViewOfFile(m_mapping);
+	CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+	CloseHandle(static_cast<HANDLE>(m_file));
+#else
+	munmap(m_mapping, m_mappedBytes);
+#endif
+	m_mapping = NULL;
+}
+
+
+unsigned int MappedMatrixFile::Rows() const
+{
+	return m_rows;
+}
+
+
+unsigned int MappedMatrixFile::Cols() const
+{
+	return m_cols;
+}
+
+
+MatrixFileElemType MappedMatrixFile::ElemType() const
+{
+	return m_elemType;
+}
+
+
+const void* MappedMatrixFile::ElementData(const MatrixFileElemType type) const
+{
+	if (type != m_elemType)
+	{
+		throw std::invalid_argument(
+			"Element type mismatch"
+			);
+	}
+	return static_cast<const unsigned char*>(m_mapping) + m_dataOffset;
+}
+
+
+/// \brief  A read-only view of the mapped elements.
+template <typename T>
+MatrixView<const T> MappedMatrixFile::View() const
+{
+	const T* data = static_cast<const T*>(ElementData(ElemTypeOf<T>::Value));
+	return MatrixView<const T>(data, m_rows, m_cols, m_cols, 1);
+}
+
+
+/// \brief     Hint that rows [rowBegin, rowEnd) will be read soon.
+void MappedMatrixFile::Prefetch(const unsigned int rowBegin, const unsigned int rowEnd) const
+{
+	const unsigned int end = std::min(rowEnd, m_rows);
+	if (rowBegin >= end)
+	{
+		return;
+	}
+
+	const size_t elemSize = m_elemType == MatrixFileFloat64 ? 8 : 4;
+	const size_t rowBytes = static_cast<size_t>(m_cols) * elemSize;
+	size_t first = m_dataOffset + rowBegin * rowBytes;
+	const size_t last = m_dataOffset + end * rowBytes;
+#if defined(_WIN32)
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = static_cast<unsigned char*>(m_mapping) + first;
+	range.NumberOfBytes = last - first;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	const size_t pageBytes = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	first -= first % pageBytes;
+	madvise(static_cast<unsigned char*>(m_mapping) + first, last - first, MADV_WILLNEED);
+#endif
+}
+
+
+#define NUMERIC_INSTANTIATE_MATRIXFILE(T)                                                      \
+	template void numeric::SaveMatrix<T>(const std::string&, const BasicMatrix<T>&);           \
+	template void numeric::SaveMatrix<T>(const std::string&, const MatrixView<const T>&);      \
+	template void numeric::LoadMatrix<T>(const std::string&, BasicMatrix<T>&);                 \
+	template void numeric::CreateMatrixFile<T>(const std::string&, const unsigned int,         \
+	                                           const unsigned int);                            \
+	template MatrixView<const T> MappedMatrixFile::View<T>() const;
+
+NUMERIC_INSTANTIATE_MATRIXFILE(float)
+NUMERIC_INSTANTIATE_MATRIXFILE(double)
+NUMERIC_INSTANTIATE_MATRIXFILE(std::int32_t)
+
+#undef NUMERIC_INSTANTIATE_MATRIXFILE
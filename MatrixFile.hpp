@@ -0,0 +1,132 @@
+#ifndef Numeric_MatrixFile_HPP
+#define Numeric_MatrixFile_HPP
+
+#include <string>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include "Matrix.hpp"
+
+namespace numeric
+{
+	//
+	// Binary matrix files.
+	//
+	// A file is a HeaderBytes header followed by the elements in row-major order. All header
+	// fields are stored in the byte order of the machine that wrote the file:
+	//
+	//      offset  size  field
+	//      0       8     magic "NUMATRIX"
+	//      8       4     format version, MatrixFileVersion
+	//      12      4     byte-order mark 0x01020304, read back as 0x04030201 on a machine of
+	//                    the other byte order
+	//      16      4     element type, a MatrixFileElemType
+	//      20      4     element size in bytes
+	//      24      4     rows
+	//      28      4     cols
+	//      32      4     alignment of the element data within the file, in bytes
+	//      36      4     reserved, zero
+	//      40      8     offset of the element data, a multiple of the alignment
+	//      48      8     size of the element data in bytes
+	//      56      8     reserved, zero
+	//
+	// The data starts on a HeaderBytes boundary, so once the file is mapped the elements are
+	// as aligned as a Matrix buffer and are used in place.
+	//
+	const std::uint32_t MatrixFileVersion = 1;
+	const size_t        MatrixFileHeaderBytes = 64;
+
+	enum MatrixFileElemType
+	{
+		MatrixFileFloat32 = 1,
+		MatrixFileFloat64 = 2,
+		MatrixFileInt32   = 3
+	};
+
+	//
+	// Function : Write a matrix, or any view of one, to path. Instantiated for float, double and
+	//      std::int32_t. Throws std::invalid_argument for an empty matrix, which no file can
+	//      hold, and std::runtime_error when the file cannot be written.
+	//
+	template <typename T>
+	void SaveMatrix(const std::string& path, const BasicMatrix<T>& mat);
+
+	template <typename T>
+	void SaveMatrix(const std::string& path, const MatrixView<const T>& view);
+
+	template <typename T>
+	inline void SaveMatrix(const std::string& path, const MatrixView<T>& view)
+	{
+		SaveMatrix<T>(path, MatrixView<const T>(view));
+	}
+
+	//
+	// Function : Create a rows*cols file of zeros, to be filled in place. The elements start at
+	//      MatrixFileHeaderBytes. Instantiated for float, double and std::int32_t.
+	//
+	template <typename T>
+	void CreateMatrixFile(const std::string& path, const unsigned int rows, const unsigned int cols);
+
+	//
+	// Function : Read a whole file into mat, which is resized. Files written on a machine of
+	//      the other byte order are converted. Throws std::runtime_error for a missing or
+	//      malformed file and std::invalid_argument when the element type is not T.
+	//
+	template <typename T>
+	void LoadMatrix(const std::string& path, BasicMatrix<T>& mat);
+
+
+	//
+	// Class : A matrix file mapped read-only into memory.
+	//
+	// Opening reads only the header; View() then refers to the mapped pages directly, so the
+	// operating system reads the parts of the matrix that are used, when they are first used,
+	// and may drop them again under memory pressure. The views are read-only and stay valid
+	// while the MappedMatrixFile exists.
+	//
+	// A file in the other byte order cannot be used in place; opening it throws
+	// std::runtime_error and LoadMatrix has to be used instead.
+	//
+	class MappedMatrixFile
+	{
+	public:
+		explicit MappedMatrixFile(const std::string& path);
+		~MappedMatrixFile();
+
+		unsigned int       Rows()     const;
+		unsigned int       Cols()     const;
+		MatrixFileElemType ElemType() const;
+
+		//
+		// The whole matrix; throws std::invalid_argument when the file does not hold T.
+		//
+		template <typename T>
+		MatrixView<const T> View() const;
+
+		//
+		// Ask the operating system to start reading rows [rowBegin, rowEnd) in the background.
+		//
+		void Prefetch(const unsigned int rowBegin, const unsigned int rowEnd) const;
+
+	private:
+		MappedMatrixFile(const MappedMatrixFile&);
+		MappedMatrixFile& operator=(const MappedMatrixFile&);
+
+		const void* ElementData(const MatrixFileElemType type) const;
+		void        Unmap();
+
+	private:
+		void*              m_mapping;
+		size_t             m_mappedBytes;
+		unsigned int       m_rows;
+		unsigned int       m_cols;
+		MatrixFileElemType m_elemType;
+		size_t             m_dataOffset;
+#if defined(_WIN32)
+		void*              m_file;
+		void*              m_mappingHandle;
+#endif
+	};
+}
+
+#endif
@@ -0,0 +1,323 @@
+
+#include "MatrixFuture.hpp"
+#include "TaskScheduler.hpp"
+#include "Gemm.hpp"
+#include "ElementWise.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of MatrixFuture
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Results are split into bands of about this many elements, enough work per task that
+	// scheduling is negligible while a chain still has many bands in flight.
+	//
+	const size_t BandElements = 65536;
+
+	/// \brief  Rows per band, at least one even for an empty matrix.
+	unsigned int BandRows(const unsigned int rows, const unsigned int cols)
+	{
+		const size_t bandRows = cols == 0 ? 1 : std::max<size_t>(1, BandElements / cols);
+		return static_cast<unsigned int>(std::max<size_t>(1, std::min<size_t>(rows, bandRows)));
+	}
+}
+
+
+namespace numeric
+{
+	namespace detail
+	{
+		//
+		// Class : The result shared by the copies of a future, with the tasks that fill it, one
+		//         per band of BandRows rows. A future made from a value has no tasks.
+		//
+		template <typename T>
+		class MatrixFutureState
+		{
+		public:
+			explicit MatrixFutureState(const BasicMatrix<T>& mat)
+				: value(mat),
+				  bandRows(BandRows(mat.Rows(), mat.Cols())),
+				  remaining(0)
+			{
+			}
+
+			MatrixFutureState(const unsigned int rows, const unsigned int cols)
+				: value(rows > 0 && cols > 0 ? BasicMatrix<T>(rows, cols) : BasicMatrix<T>()),
+				  bandRows(BandRows(rows, cols)),
+				  remaining(0)
+			{
+			}
+
+			/// \brief  Order task after the bands that hold rows [begin, end).
+			void OrderAfterRows(Task& task, const unsigned int begin, const unsigned int end)
+			{
+				if (bands.empty())
+				{
+					return;
+				}
+				for (unsigned int b = begin / bandRows; b <= (end - 1) / bandRows; b++)
+				{
+					task.After(*bands[b]);
+				}
+			}
+
+			void SetError(const std::exception_ptr& e)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error)
+				{
+					error = e;
+				}
+			}
+
+			std::exception_ptr Error()
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				return error;
+			}
+
+		public:
+			BasicMatrix<T>                     value;
+			const unsigned int                 bandRows;
+			std::vector<std::unique_ptr<Task> > bands;
+			std::atomic<size_t>                remaining;
+			std::mutex                         mutex;
+			std::exception_ptr                 error;
+		};
+	}
+}
+
+
+namespace
+{
+	template <typename T>
+	using StatePtr = std::shared_ptr<detail::MatrixFutureState<T> >;
+
+	/// \brief      Issue a rows*cols result computed band by band from lh and rh.
+	/// \param[in]  order. order(task, begin, end) orders the task of rows [begin, end) after
+	///             the operand bands it reads.
+	/// \param[in]  compute. compute(lh, rh, begin, end, result) fills rows [begin, end).
+	template <typename T, typename Order, typename Compute>
+	StatePtr<T> Issue(const unsigned int rows, const unsigned int cols,
+	                  const StatePtr<T>& lh, const StatePtr<T>& rh,
+	                  const Order& order, const Compute& compute)
+	{
+		StatePtr<T> result = std::make_shared<detail::MatrixFutureState<T> >(rows, cols);
+		const unsigned int bandRows = result->bandRows;
+		const size_t numBands = (rows + bandRows - 1) / bandRows;
+		result->remaining = numBands;
+		result->bands.reserve(numBands);
+
+		for (size_t b = 0; b < numBands; b++)
+		{
+			const unsigned int begin = static_cast<unsigned int>(b * bandRows);
+			const unsigned int end = std::min(rows, begin + bandRows);
+
+			//
+			// The task holds the result it belongs to until it has run; see Task.
+			//
+			result->bands.push_back(std::unique_ptr<Task>(new Task([=]()
+			{
+				std::exception_ptr error = lh->Error();
+				if (!error)
+				{
+					error = rh->Error();
+				}
+				if (error)
+				{
+					result->SetError(error);
+				}
+				else
+				{
+					try
+					{
+						compute(lh->value, rh->value, begin, end, result->value);
+					}
+					catch (...)
+					{
+						result->SetError(std::current_exception());
+					}
+				}
+				result->remaining--;
+			})));
+			order(*result->bands.back(), begin, end);
+		}
+
+		TaskScheduler& scheduler = TaskScheduler::Instance();
+		for (size_t b = 0; b < numBands; b++)
+		{
+			scheduler.Submit(*result->bands[b]);
+		}
+		return result;
+	}
+
+	/// \brief      Issue an element-wise operation; band b of the result reads the same rows
+	///             of both operands.
+	template <typename T, typename Kernel>
+	StatePtr<T> IssueElementWise(const StatePtr<T>& lh, const StatePtr<T>& rh, const Kernel& kernel)
+	{
+		if (lh->value.Rows() != rh->value.Rows() || lh->value.Cols() != rh->value.Cols())
+		{
+			throw std::invalid_argument(
+				"Dimension mismatch"
+				);
+		}
+
+		const unsigned int cols = lh->value.Cols();
+		return Issue<T>(lh->value.Rows(), cols, lh, rh,
+			[&](Task& task, const unsigned int begin, const unsigned int end)
+			{
+				lh->OrderAfterRows(task, begin, end);
+				rh->OrderAfterRows(task, begin, end);
+			},
+			[=](const BasicMatrix<T>& x, const BasicMatrix<T>& y, const unsigned int begin,
+			    const unsigned int end, BasicMatrix<T>& z)
+			{
+				const size_t offset = static_cast<size_t>(begin) * cols;
+				kernel(static_cast<size_t>(end - begin) * cols, x.Data() + offset, y.Data() + offset,
+				       z.Data() + offset);
+			});
+	}
+}
+
+
+template <typename T>
+BasicMatrixFuture<T>::BasicMatrixFuture(const BasicMatrix<T>& value)
+	: m_state(std::make_shared<detail::MatrixFutureState<T> >(value))
+{
+}
+
+
+template <typename T>
+BasicMatrixFuture<T>::BasicMatrixFuture(const std::shared_ptr<detail::MatrixFutureState<T> >& state)
+	: m_state(state)
+{
+}
+
+
+template <typename T>
+unsigned int BasicMatrixFuture<T>::Rows() const
+{
+	return m_state->value.Rows();
+}
+
+
+template <typename T>
+unsigned int BasicMatrixFuture<T>::Cols() const
+{
+	return m_state->value.Cols();
+}
+
+
+template <typename T>
+bool BasicMatrixFuture<T>::IsReady() const
+{
+	return m_state->remaining == 0;
+}
+
+
+template <typename T>
+void BasicMatrixFuture<T>::Wait() const
+{
+	const detail::MatrixFutureState<T>* state = m_state.get();
+	TaskScheduler::Instance().RunUntil([state]() { return state->remaining == 0; });
+}
+
+
+template <typename T>
+const BasicMatrix<T>& BasicMatrixFuture<T>::Get() const
+{
+	Wait();
+	const std::exception_ptr error = m_state->Error();
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+	return m_state->value;
+}
+
+
+/// \brief      lhmat * rhmat. Band b of the result reads the same rows of lhmat and all of
+///             rhmat.
+template <typename T>
+BasicMatrixFuture<T> numeric::MulAsync(const BasicMatrixFuture<T>& lhmat, const BasicMatrixFuture<T>& rhmat)
+{
+	const StatePtr<T>& lh = lhmat.m_state;
+	const StatePtr<T>& rh = rhmat.m_state;
+	if (lh->value.Cols() != rh->value.Rows())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	const unsigned int k = lh->value.Cols();
+	const unsigned int n = rh->value.Cols();
+	return BasicMatrixFuture<T>(Issue<T>(lh->value.Rows(), n, lh, rh,
+		[&](Task& task, const unsigned int begin, const unsigned int end)
+		{
+			lh->OrderAfterRows(task, begin, end);
+			rh->OrderAfterRows(task, 0, rh->value.Rows());
+		},
+		[=](const BasicMatrix<T>& a, const BasicMatrix<T>& b, const unsigned int begin,
+		    const unsigned int end, BasicMatrix<T>& c)
+		{
+			kernel::Gemm<T>(end - begin, n, k, T(1),
+			                a.Data() + static_cast<size_t>(begin) * k, k, 1,
+			                b.Data(), n, 1,
+			                T(0), c.Data() + static_cast<size_t>(begin) * n, n, 1);
+		}));
+}
+
+
+template <typename T>
+BasicMatrixFuture<T> numeric::AddAsync(const BasicMatrixFuture<T>& lhmat, const BasicMatrixFuture<T>& rhmat)
+{
+	return BasicMatrixFuture<T>(IssueElementWise<T>(lhmat.m_state, rhmat.m_state,
+		[](const size_t n, const T* x, const T* y, T* z) { kernel::Add<T>(n, x, y, z); }));
+}
+
+
+template <typename T>
+BasicMatrixFuture<T> numeric::SubAsync(const BasicMatrixFuture<T>& lhmat, const BasicMatrixFuture<T>& rhmat)
+{
+	return BasicMatrixFuture<T>(IssueElementWise<T>(lhmat.m_state, rhmat.m_state,
+		[](const size_t n, const T* x, const T* y, T* z) { kernel::Sub<T>(n, x, y, z); }));
+}
+
+
+template <typename T>
+BasicMatrixFuture<T> numeric::DotMulAsync(const BasicMatrixFuture<T>& lhmat, const BasicMatrixFuture<T>& rhmat)
+{
+	return BasicMatrixFuture<T>(IssueElementWise<T>(lhmat.m_state, rhmat.m_state,
+		[](const size_t n, const T* x, const T* y, T* z) { kernel::Mul<T>(n, x, y, z); }));
+}
+
+
+#define NUMERIC_INSTANTIATE_MATRIX_FUTURE(T)                                                    \
+	template class numeric::BasicMatrixFuture<T>;                                               \
+	template BasicMatrixFuture<T> numeric::MulAsync<T>(const BasicMatrixFuture<T>&,             \
+	                                                   const BasicMatrixFuture<T>&);            \
+	template BasicMatrixFuture<T> numeric::AddAsync<T>(const BasicMatrixFuture<T>&,             \
+	                                                   const BasicMatrixFuture<T>&);            \
+	template BasicMatrixFuture<T> numeric::SubAsync<T>(const BasicMatrixFuture<T>&,             \
+	                                                   const BasicMatrixFuture<T>&);            \
+	template BasicMatrixFuture<T> numeric::DotMulAsync<T>(const BasicMatrixFuture<T>&,          \
+	                                                      const BasicMatrixFuture<T>&);
+
+NUMERIC_INSTANTIATE_MATRIX_FUTURE(float)
+NUMERIC_INSTANTIATE_MATRIX_FUTURE(double)
+NUMERIC_INSTANTIATE_MATRIX_FUTURE(std::int32_t)
+
+#undef NUMERIC_INSTANTIATE_MATRIX_FUTURE
@@ -0,0 +1,92 @@
+#ifndef Numeric_MatrixFuture_HPP
+#define Numeric_MatrixFuture_HPP
+
+#include <memory>
+#include "Matrix.hpp"
+
+namespace numeric
+{
+	namespace detail
+	{
+		template <typename T>
+		class MatrixFutureState;
+	}
+
+	//
+	// Class : Handle to a matrix that is computed asynchronously by the TaskScheduler.
+	//
+	// MulAsync, AddAsync, SubAsync and DotMulAsync take futures and return one at once. Each
+	// result is split into bands of rows, and every band is its own task, ordered after the
+	// bands of the operands it reads: the same rows of an element-wise operand, the same rows
+	// of the left operand of a product and all of its right operand. A chain of operations
+	// therefore forms a graph of band tasks, and a later operation starts on the bands that
+	// are ready while earlier ones are still running.
+	//
+	// Shapes are checked when an operation is issued. An error raised while computing a band
+	// is passed on to every result computed from it, and Get rethrows it. Futures are cheap
+	// to copy and share their result; a future made from a Matrix holds a copy of it. An
+	// empty matrix gives a future that is ready at once, and operations on empty futures
+	// give empty results.
+	//
+	// Instantiated for float, double and std::int32_t.
+	//
+	template <typename T>
+	class BasicMatrixFuture
+	{
+	public:
+		typedef T ElemType;
+
+	public:
+		explicit BasicMatrixFuture(const BasicMatrix<T>& value);
+
+		unsigned int Rows() const;
+		unsigned int Cols() const;
+
+		bool IsReady() const;
+
+		//
+		// Wait until the result is complete. The waiting thread runs queued tasks meanwhile.
+		//
+		void Wait() const;
+
+		//
+		// Wait, then return the result or rethrow the first error behind it.
+		//
+		const BasicMatrix<T>& Get() const;
+
+	private:
+		explicit BasicMatrixFuture(const std::shared_ptr<detail::MatrixFutureState<T> >& state);
+
+		template <typename U>
+		friend BasicMatrixFuture<U> MulAsync(const BasicMatrixFuture<U>& lhmat, const BasicMatrixFuture<U>& rhmat);
+		template <typename U>
+		friend BasicMatrixFuture<U> AddAsync(const BasicMatrixFuture<U>& lhmat, const BasicMatrixFuture<U>& rhmat);
+		template <typename U>
+		friend BasicMatrixFuture<U> SubAsync(const BasicMatrixFuture<U>& lhmat, const BasicMatrixFuture<U>& rhmat);
+		template <typename U>
+		friend BasicMatrixFuture<U> DotMulAsync(const BasicMatrixFuture<U>& lhmat, const BasicMatrixFuture<U>& rhmat);
+
+	private:
+		std::shared_ptr<detail::MatrixFutureState<T> > m_state;
+	};
+
+	//
+	// Function : Asynchronous versions of Matrix::Mul, Add, Sub and DotMul. Throw
+	//      std::invalid_argument on a dimension mismatch.
+	//
+	template <typename T>
+	BasicMatrixFuture<T> MulAsync(const BasicMatrixFuture<T>& lhmat, const BasicMatrixFuture<T>& rhmat);
+
+	template <typename T>
+	BasicMatrixFuture<T> AddAsync(const BasicMatrixFuture<T>& lhmat, const BasicMatrixFuture<T>& rhmat);
+
+	template <typename T>
+	BasicMatrixFuture<T> SubAsync(const BasicMatrixFuture<T>& lhmat, const BasicMatrixFuture<T>& rhmat);
+
+	template <typename T>
+	BasicMatrixFuture<T> DotMulAsync(const BasicMatrixFuture<T>& lhmat, const BasicMatrixFuture<T>& rhmat);
+
+	typedef BasicMatrixFuture<double> MatrixFuture;
+}
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef Numeric_MatrixView_HPP
+#define Numeric_MatrixView_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include "Matrix.hpp"
+
+namespace numeric
+{
+	//
+	// Class : A non-owning window onto matrix storage. Element (i,j) lives at
+	//         data[i * rowStride + j * colStride], so sub-blocks, single rows and columns and
+	//         transposes of a Matrix are all views of its buffer and nothing is copied.
+	//
+	// MatrixView<T> can write the elements, MatrixView<const T> only reads them; the first
+	// converts to the second. Views are accepted as inputs and outputs by Matrix::Mul, Add, Sub
+	// and DotMul.
+	//
+	// Warning : A view does not keep the matrix alive and is invalidated when the matrix is
+	//           destroyed, resized or swapped.
+	//
+	template <typename T>
+	class MatrixView
+	{
+	public:
+		typedef typename std::remove_const<T>::type ElemType;
+		typedef typename std::conditional<std::is_const<T>::value,
+		                                  const BasicMatrix<ElemType>,
+		                                  BasicMatrix<ElemType> >::type MatrixType;
+
+	public:
+		MatrixView(T* data,
+		           const unsigned int rows,
+		           const unsigned int cols,
+		           const std::ptrdiff_t rowStride,
+		           const std::ptrdiff_t colStride)
+			: m_data(data), m_rows(rows), m_cols(cols), m_rowStride(rowStride), m_colStride(colStride)
+		{
+		}
+
+		//
+		// The whole matrix.
+		//
+		MatrixView(MatrixType& mat)
+			: m_data(mat.Data()), m_rows(mat.Rows()), m_cols(mat.Cols()), m_rowStride(mat.Cols()), m_colStride(1)
+		{
+		}
+
+		//
+		// A writable view converts to a read-only one.
+		//
+		template <typename U>
+		MatrixView(const MatrixView<U>& view,
+		           typename std::enable_if<std::is_convertible<U*, T*>::value>::type* = NULL)
+			: m_data(view.Data()),
+			  m_rows(view.Rows()),
+			  m_cols(view.Cols()),
+			  m_rowStride(view.RowStride()),
+			  m_colStride(view.ColStride())
+		{
+		}
+
+		unsigned int   Rows()      const { return m_rows; }
+		unsigned int   Cols()      const { return m_cols; }
+		std::ptrdiff_t RowStride() const { return m_rowStride; }
+		std::ptrdiff_t ColStride() const { return m_colStride; }
+		T*             Data()      const { return m_data; }
+		size_t         NumElements() const { return static_cast<size_t>(m_rows) * m_cols; }
+
+		//
+		// True when the elements of each row are adjacent in memory.
+		//
+		bool HasContiguousRows() const { return m_colStride == 1; }
+
+		T& operator()(const unsigned int row, const unsigned int col) const
+		{
+			if (row >= m_rows || col >= m_cols)
+			{
+				throw std::out_of_range("Out of Range");
+			}
+			return m_data[row * m_rowStride + col * m_colStride];
+		}
+
+		//
+		// The rows * cols block whose top-left element is (row, col).
+		//
+		MatrixView Block(const unsigned int row,
+		                 const unsigned int col,
+		                 const unsigned int rows,
+		                 const unsigned int cols) const
+		{
+			if (rows <= 0 || cols <= 0)
+			{
+				throw std::invalid_argument(
+					"Rows and cols cann't be smaller than one."
+					);
+			}
+			if (row >= m_rows || col >= m_cols || rows > m_rows - row || cols > m_cols - col)
+			{
+				throw std::out_of_range("Out of Range");
+			}
+			return MatrixView(m_data + row * m_rowStride + col * m_colStride,
+			                  rows, cols, m_rowStride, m_colStride);
+		}
+
+		MatrixView Row(const unsigned int row) const
+		{
+			return Block(row, 0, 1, m_cols);
+		}
+
+		MatrixView Col(const unsigned int col) const
+		{
+			return Block(0, col, m_rows, 1);
+		}
+
+		MatrixView Transposed() const
+		{
+			return MatrixView(m_data, m_cols, m_rows, m_colStride, m_rowStride);
+		}
+
+	private:
+		T*             m_data;
+		unsigned int   m_rows;
+		unsigned int   m_cols;
+		std::ptrdiff_t m_rowStride;
+		std::ptrdiff_t m_colStride;
+	};
+
+
+	//
+	// Matrix members that return views.
+	//
+	template <typename T>
+	inline MatrixView<T> BasicMatrix<T>::View()
+	{
+		return MatrixView<T>(*this);
+	}
+
+	template <typename T>
+	inline MatrixView<const T> BasicMatrix<T>::View() const
+	{
+		return MatrixView<const T>(*this);
+	}
+
+	template <typename T>
+	inline MatrixView<T> BasicMatrix<T>::Block(const unsigned int row,
+	                                           const unsigned int col,
+	                                           const unsigned int rows,
+	                                           const unsigned int cols)
+	{
+		return View().Block(row, col, rows, cols);
+	}
+
+	template <typename T>
+	inline MatrixView<const T> BasicMatrix<T>::Block(const unsigned int row,
+	                                                 const unsigned int col,
+	                                                 const unsigned int rows,
+	                                                 const unsigned int cols) const
+	{
+		return View().Block(row, col, rows, cols);
+	}
+
+	template <typename T>
+	inline MatrixView<T> BasicMatrix<T>::Row(const unsigned int row)
+	{
+		return View().Row(row);
+	}
+
+	template <typename T>
+	inline MatrixView<const T> BasicMatrix<T>::Row(const unsigned int row) const
+	{
+		return View().Row(row);
+	}
+
+	template <typename T>
+	inline MatrixView<T> BasicMatrix<T>::Col(const unsigned int col)
+	{
+		return View().Col(col);
+	}
+
+	template <typename T>
+	inline MatrixView<const T> BasicMatrix<T>::Col(const unsigned int col) const
+	{
+		return View().Col(col);
+	}
+
+	template <typename T>
+	inline MatrixView<T> BasicMatrix<T>::Transposed()
+	{
+		return View().Transposed();
+	}
+
+	template <typename T>
+	inline MatrixView<const T> BasicMatrix<T>::Transposed() const
+	{
+		return View().Transposed();
+	}
+}
+
+#endif
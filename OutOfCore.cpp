@@ -0,0 +1,274 @@
+
+#include "OutOfCore.hpp"
+#include "MatrixFile.hpp"
+#include "Gemm.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <vector>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of OutOfCore
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Tile edges are multiples of this, so tiles line up with the GEMM blocking.
+	//
+	const size_t TileQuantum = 64;
+
+	//
+	// Two tiles each of A, B and C are held at once.
+	//
+	const size_t TilesInFlight = 6;
+
+	//
+	// Position of an operand tile, in tiles; a buffer remembers which tile it holds so a tile
+	// needed by two consecutive steps is loaded once.
+	//
+	struct TileId
+	{
+		TileId()
+			: row(~0u), col(~0u)
+		{
+		}
+
+		TileId(const unsigned int r, const unsigned int c)
+			: row(r), col(c)
+		{
+		}
+
+		bool operator==(const TileId& rh) const
+		{
+			return row == rh.row && col == rh.col;
+		}
+
+		unsigned int row;
+		unsigned int col;
+	};
+
+	/// \brief      Copy the rows*cols block at (row, col) of a mapped matrix into a packed buffer.
+	///             Touching the mapped pages is what reads them from disk.
+	template <typename T>
+	void LoadTile(const MatrixView<const T>& src,
+	              const unsigned int row, const unsigned int col,
+	              const unsigned int rows, const unsigned int cols,
+	              T* tile)
+	{
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			const T* from = src.Data() + (row + i) * src.RowStride() + col;
+			std::memcpy(tile + static_cast<size_t>(i) * cols, from, cols * sizeof(T));
+		}
+	}
+
+	/// \brief      Write a packed rows*cols tile into the result file at (row, col).
+	/// \param[in]  ld. Number of columns of the whole result.
+	template <typename T>
+	void StoreTile(std::FILE* out, const T* tile,
+	               const unsigned int row, const unsigned int col,
+	               const unsigned int rows, const unsigned int cols,
+	               const unsigned int ld)
+	{
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			const std::uint64_t offset = MatrixFileHeaderBytes +
+				(static_cast<std::uint64_t>(row + i) * ld + col) * sizeof(T);
+#if defined(_WIN32)
+			const bool positioned = _fseeki64(out, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+			const bool positioned = fseeko(out, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+			if (!positioned || std::fwrite(tile + static_cast<size_t>(i) * cols, sizeof(T), cols, out) != cols)
+			{
+				throw std::runtime_error("Cannot write the result file");
+			}
+		}
+	}
+}
+
+
+/// \brief      Multiply two matrix files tile by tile.
+/// \param[in]  lhPath. m*k matrix file.
+/// \param[in]  rhPath. k*n matrix file.
+/// \param[in]  resultPath. The m*n result file to create.
+/// \param[in]  options. Memory budget.
+template <typename T>
+void numeric::MultiplyMatrixFiles(const std::string& lhPath,
+                                  const std::string& rhPath,
+                                  const std::string& resultPath,
+                                  const OutOfCoreOptions& options)
+{
+	MappedMatrixFile lhFile(lhPath);
+	MappedMatrixFile rhFile(rhPath);
+	const MatrixView<const T> a = lhFile.View<T>();
+	const MatrixView<const T> b = rhFile.View<T>();
+	if (a.Cols() != b.Rows())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	const size_t edge = static_cast<size_t>(
+		std::sqrt(static_cast<double>(options.memoryBudget) / (TilesInFlight * sizeof(T)))) /
+		TileQuantum * TileQuantum;
+	if (edge < TileQuantum)
+	{
+		throw std::invalid_argument(
+			"Memory budget too small"
+			);
+	}
+
+	const unsigned int m = a.Rows();
+	const unsigned int k = a.Cols();
+	const unsigned int n = b.Cols();
+	const unsigned int tm = static_cast<unsigned int>(std::min<size_t>(edge, m));
+	const unsigned int tk = static_cast<unsigned int>(std::min<size_t>(edge, k));
+	const unsigned int tn = static_cast<unsigned int>(std::min<size_t>(edge, n));
+	const unsigned int rowTiles = (m + tm - 1) / tm;
+	const unsigned int depthTiles = (k + tk - 1) / tk;
+	const unsigned int colTiles = (n + tn - 1) / tn;
+	const size_t numSteps = static_cast<size_t>(rowTiles) * colTiles * depthTiles;
+
+	CreateMatrixFile<T>(resultPath, m, n);
+	std::FILE* out = std::fopen(resultPath.c_str(), "r+b");
+	if (out == NULL)
+	{
+		throw std::runtime_error("Cannot open " + resultPath + " for writing");
+	}
+
+	std::vector<T> aTiles[2];
+	std::vector<T> bTiles[2];
+	std::vector<T> cTiles[2];
+	for (unsigned int s = 0; s < 2; s++)
+	{
+		aTiles[s].resize(static_cast<size_t>(tm) * tk);
+		bTiles[s].resize(static_cast<size_t>(tk) * tn);
+		cTiles[s].resize(static_cast<size_t>(tm) * tn);
+	}
+	TileId aHeld[2];
+	TileId bHeld[2];
+
+	//
+	// Step s computes the contribution of depth tile s % depthTiles to result tile
+	// (s / depthTiles / colTiles, s / depthTiles % colTiles). Loading step s fills the free
+	// buffer of each operand unless the tile is already held.
+	//
+	const auto aTileOf = [&](const size_t s)
+	{
+		return TileId(static_cast<unsigned int>(s / depthTiles / colTiles), static_cast<unsigned int>(s % depthTiles));
+	};
+	const auto bTileOf = [&](const size_t s)
+	{
+		return TileId(static_cast<unsigned int>(s % depthTiles), static_cast<unsigned int>(s / depthTiles % colTiles));
+	};
+	const auto load = [&](const TileId aId, const unsigned int aSlot, const TileId bId, const unsigned int bSlot)
+	{
+		if (!(aHeld[aSlot] == aId))
+		{
+			LoadTile(a, aId.row * tm, aId.col * tk, std::min(tm, m - aId.row * tm),
+			         std::min(tk, k - aId.col * tk), &aTiles[aSlot][0]);
+		}
+		if (!(bHeld[bSlot] == bId))
+		{
+			LoadTile(b, bId.row * tk, bId.col * tn, std::min(tk, k - bId.row * tk),
+			         std::min(tn, n - bId.col * tn), &bTiles[bSlot][0]);
+		}
+	};
+
+	std::future<void> loading;
+	std::future<void> writing;
+	unsigned int aSlot = 0;
+	unsigned int bSlot = 0;
+	unsigned int cSlot = 0;
+	try
+	{
+		load(aTileOf(0), 0, bTileOf(0), 0);
+		aHeld[0] = aTileOf(0);
+		bHeld[0] = bTileOf(0);
+
+		for (size_t s = 0; s < numSteps; s++)
+		{
+			unsigned int aNext = aSlot;
+			unsigned int bNext = bSlot;
+			if (s + 1 < numSteps)
+			{
+				const TileId aId = aTileOf(s + 1);
+				const TileId bId = bTileOf(s + 1);
+				aNext = aHeld[aSlot] == aId ? aSlot : 1 - aSlot;
+				bNext = bHeld[bSlot] == bId ? bSlot : 1 - bSlot;
+				loading = std::async(std::launch::async, load, aId, aNext, bId, bNext);
+			}
+
+			const TileId aId = aHeld[aSlot];
+			const TileId bId = bHeld[bSlot];
+			const unsigned int rows = std::min(tm, m - aId.row * tm);
+			const unsigned int depth = std::min(tk, k - aId.col * tk);
+			const unsigned int cols = std::min(tn, n - bId.col * tn);
+			kernel::Gemm<T>(rows, cols, depth,
+				T(1), &aTiles[aSlot][0], depth, 1,
+				&bTiles[bSlot][0], cols, 1,
+				aId.col == 0 ? T(0) : T(1), &cTiles[cSlot][0], cols, 1);
+
+			if (aId.col + 1 == depthTiles)
+			{
+				if (writing.valid())
+				{
+					writing.get();
+				}
+				const T* tile = &cTiles[cSlot][0];
+				writing = std::async(std::launch::async, [=]()
+				{
+					StoreTile(out, tile, aId.row * tm, bId.col * tn, rows, cols, n);
+				});
+				cSlot = 1 - cSlot;
+			}
+
+			if (loading.valid())
+			{
+				loading.get();
+				aHeld[aNext] = aTileOf(s + 1);
+				bHeld[bNext] = bTileOf(s + 1);
+			}
+			aSlot = aNext;
+			bSlot = bNext;
+		}
+
+		if (writing.valid())
+		{
+			writing.get();
+		}
+	}
+	catch (...)
+	{
+		if (loading.valid())
+		{
+			loading.wait();
+		}
+		if (writing.valid())
+		{
+			writing.wait();
+		}
+		std::fclose(out);
+		throw;
+	}
+
+	if (std::fclose(out) != 0)
+	{
+		throw std::runtime_error("Cannot write " + resultPath);
+	}
+}
+
+
+template void numeric::MultiplyMatrixFiles<float>(const std::string&, const std::string&,
+                                                  const std::string&, const OutOfCoreOptions&);
+template void numeric::MultiplyMatrixFiles<double>(const std::string&, const std::string&,
+                                                   const std::string&, const OutOfCoreOptions&);
+template void numeric::MultiplyMatrixFiles<std::int32_t>(const std::string&, const std::string&,
+                                                         const std::string&, const OutOfCoreOptions&);
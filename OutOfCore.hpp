@@ -0,0 +1,54 @@
+#ifndef Numeric_OutOfCore_HPP
+#define Numeric_OutOfCore_HPP
+
+#include <string>
+#include <stdexcept>
+#include <cstddef>
+
+namespace numeric
+{
+	//
+	// Class : Settings of MultiplyMatrixFiles.
+	//
+	struct OutOfCoreOptions
+	{
+		OutOfCoreOptions()
+			: memoryBudget(static_cast<size_t>(1) << 30)
+		{
+		}
+
+		//
+		// Bytes of tile buffers the multiply may hold at once. Six square tiles are kept, two
+		// of each operand and two of the result, and the tile edge is the largest multiple of
+		// 64 that fits.
+		//
+		size_t memoryBudget;
+	};
+
+	//
+	// Function : resultPath = lhPath * rhPath for matrix files (see MatrixFile.hpp) that need
+	//      not fit in memory. Instantiated for float, double and std::int32_t.
+	//
+	//      The result is computed one tile at a time: the tiles of A and B it needs are copied
+	//      out of the mapped operand files and multiplied with kernel::Gemm, and the finished
+	//      tile is written to the result file. A background task loads the next pair of
+	//      operand tiles while the current one is multiplied, and another writes the previous
+	//      result tile, so disk I/O overlaps the arithmetic.
+	//
+	//      The operands are read through read-only mappings, whose pages belong to the
+	//      operating system's file cache and are reclaimed under memory pressure; only the
+	//      tile buffers count against the budget.
+	//
+	//      Throws std::invalid_argument("Dimension mismatch") when the inner dimensions
+	//      differ, std::invalid_argument when the budget is below six 64*64 tiles or an
+	//      operand does not hold T, and std::runtime_error for I/O failures. resultPath is
+	//      replaced and must not name an operand file.
+	//
+	template <typename T>
+	void MultiplyMatrixFiles(const std::string& lhPath,
+	                         const std::string& rhPath,
+	                         const std::string& resultPath,
+	                         const OutOfCoreOptions& options = OutOfCoreOptions());
+}
+
+#endif
@@ -0,0 +1,510 @@
+
+#include "QRDecomposition.hpp"
+#include "Gemm.hpp"
+#include "Triangular.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of QRDecomposition
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Columns per panel, the width of the compact WY blocks.
+	//
+	const unsigned int PanelWidth = 64;
+
+	//
+	// TSQR is used when every thread gets at least this many rows, and at least four times as
+	// many rows as there are columns.
+	//
+	const unsigned int MinRowsPerBlock = 1024;
+
+	/// \brief          Apply Q^T = I - V * T^T * V^T to an mk*nc block C.
+	/// \param[in]      v, ldv. mk*nb reflectors in place below the diagonal of the factored
+	///                 panel; the unit diagonal and the part above it are implied, not read.
+	/// \param[in]      t. nb*nb upper-triangular factor.
+	/// \param[in,out]  c, ldc. The block and its row stride.
+	template <typename T>
+	void ApplyBlockReflector(const T* v, const std::ptrdiff_t ldv, const T* t,
+	                         const unsigned int mk, const unsigned int nb, const unsigned int nc,
+	                         T* c, const std::ptrdiff_t ldc)
+	{
+		std::vector<T> w(static_cast<size_t>(nb) * nc);
+
+		//
+		// W = V^T * C: the unit lower-triangular top of V by hand, the rest with GEMM.
+		//
+		for (unsigned int i = 0; i < nb; i++)
+		{
+			T* wi = &w[static_cast<size_t>(i) * nc];
+			std::copy(c + i * ldc, c + i * ldc + nc, wi);
+			for (unsigned int p = i + 1; p < nb; p++)
+			{
+				const T vpi = v[p * ldv + i];
+				const T* cp = c + p * ldc;
+				for (unsigned int j = 0; j < nc; j++)
+				{
+					wi[j] += vpi * cp[j];
+				}
+			}
+		}
+		if (mk > nb)
+		{
+			kernel::Gemm<T>(nb, nc, mk - nb,
+				T(1), v + nb * ldv, 1, ldv,
+				c + nb * ldc, ldc, 1,
+				T(1), &w[0], nc, 1);
+		}
+
+		//
+		// W = T^T * W
+		//
+		for (unsigned int i = nb; i-- > 0; )
+		{
+			T* wi = &w[static_cast<size_t>(i) * nc];
+			const T tii = t[i * nb + i];
+			for (unsigned int j = 0; j < nc; j++)
+			{
+				wi[j] *= tii;
+			}
+			for (unsigned int p = 0; p < i; p++)
+			{
+				const T tpi = t[p * nb + i];
+				const T* wp = &w[static_cast<size_t>(p) * nc];
+				for (unsigned int j = 0; j < nc; j++)
+				{
+					wi[j] += tpi * wp[j];
+				}
+			}
+		}
+
+		//
+		// C -= V * W, again split into the triangular top and the GEMM below it.
+		//
+		if (mk > nb)
+		{
+			kernel::Gemm<T>(mk - nb, nc, nb,
+				T(-1), v + nb * ldv, ldv, 1,
+				&w[0], nc, 1,
+				T(1), c + nb * ldc, ldc, 1);
+		}
+		for (unsigned int i = 0; i < nb; i++)
+		{
+			T* ci = c + i * ldc;
+			const T* wi = &w[static_cast<size_t>(i) * nc];
+			for (unsigned int j = 0; j < nc; j++)
+			{
+				ci[j] -= wi[j];
+			}
+			for (unsigned int p = 0; p < i; p++)
+			{
+				const T vip = v[i * ldv + p];
+				const T* wp = &w[static_cast<size_t>(p) * nc];
+				for (unsigned int j = 0; j < nc; j++)
+				{
+					ci[j] -= vip * wp[j];
+				}
+			}
+		}
+	}
+}
+
+
+template <typename T>
+BasicQRDecomposition<T>::BasicQRDecomposition()
+	: m_rows(0), m_cols(0)
+{
+}
+
+
+template <typename T>
+BasicQRDecomposition<T>::BasicQRDecomposition(const BasicMatrix<T>& mat)
+	: m_rows(0), m_cols(0)
+{
+	Factorize(mat);
+}
+
+
+/// \brief     Compute A = Q * R, with TSQR for tall-skinny matrices.
+/// \param[in] mat. m*n matrix, m >= n.
+template <typename T>
+void BasicQRDecomposition<T>::Factorize(const BasicMatrix<T>& mat)
+{
+	const unsigned int m = mat.Rows();
+	const unsigned int n = mat.Cols();
+	if (m < n)
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	const unsigned int numThreads = ThreadPool::NumThreads();
+	const unsigned int rowsPerBlock = numThreads > 0 ? m / numThreads : m;
+	m_blocks.clear();
+	m_blockBegin.clear();
+	if (numThreads > 1 && rowsPerBlock >= MinRowsPerBlock && rowsPerBlock >= 4 * n)
+	{
+		FactorizeTsqr(mat, numThreads);
+	}
+	else
+	{
+		FactorizeHouseholder(mat.Data(), m, n, m_factors);
+	}
+	m_rows = m;
+	m_cols = n;
+}
+
+
+/// \brief     Blocked Householder QR of the row-major m*n matrix a.
+template <typename T>
+void BasicQRDecomposition<T>::FactorizeHouseholder(const T* a, const unsigned int m, const unsigned int n,
+                                                   Householder& factors)
+{
+	factors.qr.Resize(m, n);
+	std::copy(a, a + static_cast<size_t>(m) * n, factors.qr.Data());
+	factors.t.assign(static_cast<size_t>(n) * PanelWidth, T(0));
+
+	T* qr = factors.qr.Data();
+	std::vector<T> g;
+	std::vector<T> w(PanelWidth);
+	for (unsigned int k = 0; k < n; k += PanelWidth)
+	{
+		const unsigned int nb = std::min(PanelWidth, n - k);
+		const unsigned int mk = m - k;
+		T* t = &factors.t[static_cast<size_t>(k) * PanelWidth];
+
+		//
+		// Reduce the panel column by column. Each reflector H = I - tau * v * v^T has v(0) = 1;
+		// the rest of v replaces the column below the diagonal. Every column takes two passes
+		// over the rows: the first scales v and forms w = v^T * A for the rest of the panel, the
+		// second applies A -= tau * v * w and sums the squares of the next column.
+		//
+		T sigma = T(0);
+		for (unsigned int i = k + 1; i < m; i++)
+		{
+			const T value = qr[static_cast<size_t>(i) * n + k];
+			sigma += value * value;
+		}
+		for (unsigned int jj = 0; jj < nb; jj++)
+		{
+			const unsigned int j = k + jj;
+			const unsigned int c0 = j + 1;
+			const unsigned int c1 = k + nb;
+			T* rowJ = qr + static_cast<size_t>(j) * n;
+			const T alpha = rowJ[j];
+			if (sigma == T(0))
+			{
+				t[jj * nb + jj] = T(0);
+				sigma = T(0);
+				if (c0 < c1)
+				{
+					for (unsigned int i = c0 + 1; i < m; i++)
+					{
+						const T value = qr[static_cast<size_t>(i) * n + c0];
+						sigma += value * value;
+					}
+				}
+				continue;
+			}
+
+			const T norm = std::sqrt(alpha * alpha + sigma);
+			const T beta = alpha >= T(0) ? -norm : norm;
+			const T tau = (beta - alpha) / beta;
+			const T scale = T(1) / (alpha - beta);
+			t[jj * nb + jj] = tau;
+			rowJ[j] = beta;
+
+			for (unsigned int c = c0; c < c1; c++)
+			{
+				w[c - c0] = rowJ[c];
+			}
+			for (unsigned int i = j + 1; i < m; i++)
+			{
+				T* row = qr + static_cast<size_t>(i) * n;
+				const T vi = row[j] * scale;
+				row[j] = vi;
+				for (unsigned int c = c0; c < c1; c++)
+				{
+					w[c - c0] += vi * row[c];
+				}
+			}
+
+			sigma = T(0);
+			if (c0 == c1)
+			{
+				continue;
+			}
+			for (unsigned int c = c0; c < c1; c++)
+			{
+				w[c - c0] *= tau;
+				rowJ[c] -= w[c - c0];
+			}
+			for (unsigned int i = j + 1; i < m; i++)
+			{
+				T* row = qr + static_cast<size_t>(i) * n;
+				const T vi = row[j];
+				for (unsigned int c = c0; c < c1; c++)
+				{
+					row[c] -= vi * w[c - c0];
+				}
+				if (i > c0)
+				{
+					sigma += row[c0] * row[c0];
+				}
+			}
+		}
+
+		//
+		// T of the compact WY form, one column at a time from G = V^T * V:
+		//      T(0:j, j) = -tau_j * T(0:j, 0:j) * G(0:j, j)
+		//
+		const T* v = qr + static_cast<size_t>(k) * n + k;
+		g.assign(static_cast<size_t>(nb) * nb, T(0));
+		for (unsigned int r = 0; r < nb; r++)
+		{
+			for (unsigned int i = 0; i <= r; i++)
+			{
+				const T vri = i == r ? T(1) : v[r * n + i];
+				for (unsigned int j = i; j <= r; j++)
+				{
+					g[i * nb + j] += vri * (j == r ? T(1) : v[r * n + j]);
+				}
+			}
+		}
+		if (mk > nb)
+		{
+			kernel::Gemm<T>(nb, nb, mk - nb,
+				T(1), v + static_cast<size_t>(nb) * n, 1, n,
+				v + static_cast<size_t>(nb) * n, n, 1,
+				T(1), &g[0], nb, 1);
+		}
+		for (unsigned int j = 1; j < nb; j++)
+		{
+			const T tau = t[j * nb + j];
+			for (unsigned int i = 0; i < j; i++)
+			{
+				T sum = T(0);
+				for (unsigned int p = i; p < j; p++)
+				{
+					sum += t[i * nb + p] * g[p * nb + j];
+				}
+				t[i * nb + j] = -tau * sum;
+			}
+		}
+
+		if (k + nb < n)
+		{
+			ApplyBlockReflector<T>(v, n, t, mk, nb, n - k - nb,
+				qr + static_cast<size_t>(k) * n + k + nb, n);
+		}
+	}
+}
+
+
+/// \brief     TSQR: factor each row block in parallel, then factor the stacked R factors.
+/// \param[in] mat. m*n matrix.
+/// \param[in] numBlocks. Number of row blocks.
+template <typename T>
+void BasicQRDecomposition<T>::FactorizeTsqr(const BasicMatrix<T>& mat, const unsigned int numBlocks)
+{
+	const unsigned int m = mat.Rows();
+	const unsigned int n = mat.Cols();
+	m_blocks.resize(numBlocks);
+	m_blockBegin.resize(numBlocks + 1);
+	for (unsigned int i = 0; i <= numBlocks; i++)
+	{
+		m_blockBegin[i] = static_cast<unsigned int>(static_cast<unsigned long long>(m) * i / numBlocks);
+	}
+
+	ThreadPool::Instance().ParallelFor(numBlocks, [&](size_t i)
+	{
+		const unsigned int begin = m_blockBegin[i];
+		FactorizeHouseholder(mat.Data() + static_cast<size_t>(begin) * n,
+		                     m_blockBegin[i + 1] - begin, n, m_blocks[i]);
+	});
+
+	BasicMatrix<T> stacked(numBlocks * n, n);
+	BasicMatrix<T>::Zero(stacked);
+	for (unsigned int b = 0; b < numBlocks; b++)
+	{
+		const T* r = m_blocks[b].qr.Data();
+		for (unsigned int i = 0; i < n; i++)
+		{
+			std::copy(r + i * n + i, r + (i + 1) * n, stacked.Data() + (b * n + i) * n + i);
+		}
+	}
+	FactorizeHouseholder(stacked.Data(), numBlocks * n, n, m_factors);
+}
+
+
+/// \brief          Overwrite the factors.qr.Rows()*nrhs matrix b with Q^T * b.
+template <typename T>
+void BasicQRDecomposition<T>::ApplyHouseholderQt(const Householder& factors, T* b, const unsigned int nrhs)
+{
+	const unsigned int m = factors.qr.Rows();
+	const unsigned int n = factors.qr.Cols();
+	for (unsigned int k = 0; k < n; k += PanelWidth)
+	{
+		const unsigned int nb = std::min(PanelWidth, n - k);
+		ApplyBlockReflector<T>(factors.qr.Data() + static_cast<size_t>(k) * n + k, n,
+			&factors.t[static_cast<size_t>(k) * PanelWidth], m - k, nb, nrhs,
+			b + static_cast<size_t>(k) * nrhs, nrhs);
+	}
+}
+
+
+template <typename T>
+unsigned int BasicQRDecomposition<T>::Rows() const
+{
+	return m_rows;
+}
+
+
+template <typename T>
+unsigned int BasicQRDecomposition<T>::Cols() const
+{
+	return m_cols;
+}
+
+
+/// \brief  True when a diagonal entry of R is negligible next to the largest one, relative to
+///         the roundoff of the factorization.
+template <typename T>
+bool BasicQRDecomposition<T>::IsRankDeficient() const
+{
+	const unsigned int n = m_cols;
+	const T* qr = m_factors.qr.Data();
+	T largest = T(0);
+	for (unsigned int i = 0; i < n; i++)
+	{
+		largest = std::max(largest, std::abs(qr[i * n + i]));
+	}
+
+	const T tolerance = largest * std::numeric_limits<T>::epsilon() * std::max(m_rows, m_cols);
+	for (unsigned int i = 0; i < n; i++)
+	{
+		if (std::abs(qr[i * n + i]) <= tolerance)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/// \brief      The first n rows of Q^T * B.
+/// \param[in]  b. m*nrhs matrix.
+/// \param[out] qtb. n*nrhs matrix; may be b when m equals n.
+template <typename T>
+void BasicQRDecomposition<T>::ApplyQTranspose(const BasicMatrix<T>& b, BasicMatrix<T>& qtb) const
+{
+	const unsigned int n = m_cols;
+	const unsigned int nrhs = b.Cols();
+	if (b.Rows() != m_rows || qtb.Rows() != n || qtb.Cols() != nrhs)
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	if (m_blocks.empty())
+	{
+		BasicMatrix<T> work(b);
+		ApplyHouseholderQt(m_factors, work.Data(), nrhs);
+		std::copy(work.Data(), work.Data() + static_cast<size_t>(n) * nrhs, qtb.Data());
+		return;
+	}
+
+	//
+	// Each block contributes the top n rows of its own Q^T * B; the stacked results go
+	// through the second-level factorization.
+	//
+	const unsigned int numBlocks = static_cast<unsigned int>(m_blocks.size());
+	BasicMatrix<T> stacked(numBlocks * n, nrhs);
+	ThreadPool::Instance().ParallelFor(numBlocks, [&](size_t i)
+	{
+		const unsigned int begin = m_blockBegin[i];
+		const unsigned int rows = m_blockBegin[i + 1] - begin;
+		std::vector<T> work(b.Data() + static_cast<size_t>(begin) * nrhs,
+		                    b.Data() + static_cast<size_t>(begin + rows) * nrhs);
+		ApplyHouseholderQt(m_blocks[i], &work[0], nrhs);
+		std::copy(work.begin(), work.begin() + static_cast<size_t>(n) * nrhs,
+		          stacked.Data() + static_cast<size_t>(i) * n * nrhs);
+	});
+	ApplyHouseholderQt(m_factors, stacked.Data(), nrhs);
+	std::copy(stacked.Data(), stacked.Data() + static_cast<size_t>(n) * nrhs, qtb.Data());
+}
+
+
+/// \brief      Solve min ||A * X - B|| through R * X = (Q^T * B)(0:n, :).
+/// \param[in]  b. m*nrhs right-hand sides.
+/// \param[out] x. n*nrhs solutions.
+template <typename T>
+void BasicQRDecomposition<T>::LeastSquares(const BasicMatrix<T>& b, BasicMatrix<T>& x) const
+{
+	if (b.Rows() != m_rows || x.Rows() != m_cols || x.Cols() != b.Cols())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+	if (IsRankDeficient())
+	{
+		throw std::runtime_error("Matrix is rank deficient");
+	}
+
+	ApplyQTranspose(b, x);
+	kernel::SolveTriangular<T>(false, false, m_cols, x.Cols(), m_factors.qr.Data(), m_cols, 1, x.Data(), x.Cols());
+}
+
+
+/// \brief      Copy out R.
+/// \param[out] r. n*n matrix.
+template <typename T>
+void BasicQRDecomposition<T>::R(BasicMatrix<T>& r) const
+{
+	const unsigned int n = m_cols;
+	if (r.Rows() != n || r.Cols() != n)
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	const T* qr = m_factors.qr.Data();
+	T* pr = r.Data();
+	for (unsigned int i = 0; i < n; i++)
+	{
+		std::fill(pr + i * n, pr + i * n + i, T(0));
+		std::copy(qr + i * n + i, qr + (i + 1) * n, pr + i * n + i);
+	}
+}
+
+
+/// \brief      Least-squares solution of A * X = B.
+/// \param[in]  a. m*n matrix, m >= n.
+/// \param[in]  b. m*nrhs right-hand sides.
+/// \param[out] x. n*nrhs solutions.
+template <typename T>
+void numeric::LeastSquares(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& x)
+{
+	BasicQRDecomposition<T>(a).LeastSquares(b, x);
+}
+
+
+#define NUMERIC_INSTANTIATE_QR(T)                                                              \
+	template class numeric::BasicQRDecomposition<T>;                                           \
+	template void numeric::LeastSquares<T>(const BasicMatrix<T>&, const BasicMatrix<T>&,       \
+	                                       BasicMatrix<T>&);
+
+NUMERIC_INSTANTIATE_QR(float)
+NUMERIC_INSTANTIATE_QR(double)
+
+#undef NUMERIC_INSTANTIATE_QR
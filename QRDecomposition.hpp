@@ -0,0 +1,98 @@
+#ifndef Numeric_QRDecomposition_HPP
+#define Numeric_QRDecomposition_HPP
+
+#include <vector>
+#include <stdexcept>
+#include "Matrix.hpp"
+
+namespace numeric
+{
+	//
+	// Class : Householder QR factorization A = Q * R of an m*n matrix with m >= n.
+	//
+	// The factorization is blocked in compact WY form: each panel of columns is reduced by
+	// Householder reflections, which are accumulated as I - V * T * V^T and applied to the rest
+	// of the matrix with GEMM calls.
+	//
+	// Tall-skinny inputs use TSQR: the rows are split into one block per thread, each block is
+	// factored in parallel, and the stacked n*n R factors are factored once more. Q is kept
+	// implicitly in either case and only applied, never formed.
+	//
+	// Instantiated for float and double.
+	//
+	template <typename T>
+	class BasicQRDecomposition
+	{
+	public:
+		typedef T ElemType;
+
+	public:
+		BasicQRDecomposition();
+		explicit BasicQRDecomposition(const BasicMatrix<T>& mat);
+
+		void Factorize(const BasicMatrix<T>& mat);
+
+		unsigned int Rows() const;
+		unsigned int Cols() const;
+
+		//
+		// True when R has a diagonal entry that is negligible next to its largest one, in which
+		// case LeastSquares throws std::runtime_error.
+		//
+		bool IsRankDeficient() const;
+
+		//
+		// Minimise ||A * X - B|| for every column of B. B is m*nrhs and X is n*nrhs.
+		//
+		void LeastSquares(const BasicMatrix<T>& b, BasicMatrix<T>& x) const;
+
+		//
+		// The first n rows of Q^T * B, for an m*nrhs B, into an n*nrhs qtb.
+		//
+		void ApplyQTranspose(const BasicMatrix<T>& b, BasicMatrix<T>& qtb) const;
+
+		//
+		// The n*n upper-triangular factor R.
+		//
+		void R(BasicMatrix<T>& r) const;
+
+	private:
+		//
+		// Householder form: R on and above the diagonal, the reflectors below it, and the
+		// triangular factor T of each panel, stacked in panel order.
+		//
+		struct Householder
+		{
+			BasicMatrix<T> qr;
+			std::vector<T> t;
+		};
+
+		static void FactorizeHouseholder(const T* a, const unsigned int m, const unsigned int n,
+		                                 Householder& factors);
+		static void ApplyHouseholderQt(const Householder& factors, T* b, const unsigned int nrhs);
+		void FactorizeTsqr(const BasicMatrix<T>& mat, const unsigned int numBlocks);
+
+	private:
+		unsigned int m_rows;
+		unsigned int m_cols;
+		Householder  m_factors;
+
+		//
+		// TSQR form: the factorization of each row block, with its first row; m_factors then
+		// holds the factorization of the stacked R factors.
+		//
+		std::vector<Householder>  m_blocks;
+		std::vector<unsigned int> m_blockBegin;
+	};
+
+	typedef BasicQRDecomposition<float>  QRDecompositionF;
+	typedef BasicQRDecomposition<double> QRDecomposition;
+
+	//
+	// Function : Least-squares solution of A * X = B for m >= n, through QR.
+	//
+	template <typename T>
+	void LeastSquares(const BasicMatrix<T>& a, const BasicMatrix<T>& b, BasicMatrix<T>& x);
+}
+
+#endif
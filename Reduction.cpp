@@ -0,0 +1,413 @@
+
+#include "Reduction.hpp"
+#include "ElementWise.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of Reduction
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Buffers are reduced in chunks of this many elements. The chunking is the same for every
+	// thread count, which is what makes the results reproducible.
+	//
+	const size_t ChunkElements = 8192;
+
+	//
+	// Column reductions fold blocks of this many rows into one partial row each, and split
+	// the columns into strips of this width so that short, wide matrices still run in parallel.
+	//
+	const unsigned int RowBlock = 64;
+	const unsigned int ColStrip = 2048;
+
+	kernel::ReduceKernel KernelOf(const ReduceOp op)
+	{
+		switch (op)
+		{
+		case ReduceMax:
+			return kernel::ReduceKernelMax;
+		case ReduceMin:
+			return kernel::ReduceKernelMin;
+		case ReduceNormL1:
+			return kernel::ReduceKernelSumAbs;
+		case ReduceNormL2:
+			return kernel::ReduceKernelSumSquares;
+		case ReduceNormInf:
+			return kernel::ReduceKernelMaxAbs;
+		default:
+			return kernel::ReduceKernelSum;
+		}
+	}
+
+	template <typename T>
+	T Identity(const kernel::ReduceKernel k)
+	{
+		switch (k)
+		{
+		case kernel::ReduceKernelMax:
+			return std::numeric_limits<T>::lowest();
+		case kernel::ReduceKernelMin:
+			return std::numeric_limits<T>::max();
+		default:
+			return T(0);
+		}
+	}
+
+	template <typename T>
+	T Combine(const kernel::ReduceKernel k, const T a, const T b)
+	{
+		switch (k)
+		{
+		case kernel::ReduceKernelMax:
+		case kernel::ReduceKernelMaxAbs:
+			return b > a ? b : a;
+		case kernel::ReduceKernelMin:
+			return b < a ? b : a;
+		default:
+			return a + b;
+		}
+	}
+
+	/// \brief      Turn a reduced value into the result of op over count elements.
+	template <typename T>
+	T Finish(const ReduceOp op, const T value, const size_t count)
+	{
+		switch (op)
+		{
+		case ReduceMean:
+			return count > 0 ? static_cast<T>(value / static_cast<T>(count)) : T(0);
+		case ReduceNormL2:
+			return static_cast<T>(std::sqrt(value));
+		default:
+			return value;
+		}
+	}
+
+	size_t NumChunks(const size_t n)
+	{
+		return (n + ChunkElements - 1) / ChunkElements;
+	}
+
+	/// \brief      Combine the chunks [begin, end) by recursive halving; chunk(c) reduces one.
+	template <typename T, typename ChunkFn>
+	T ChunkTree(const kernel::ReduceKernel k, const ChunkFn& chunk, const size_t begin, const size_t end)
+	{
+		if (end - begin == 1)
+		{
+			return chunk(begin);
+		}
+		const size_t mid = begin + (end - begin) / 2;
+		return Combine<T>(k, ChunkTree<T>(k, chunk, begin, mid), ChunkTree<T>(k, chunk, mid, end));
+	}
+
+	/// \brief      Reduce numChunks chunks, in parallel when the pool has threads to spare. The
+	///             partial results are combined with the same tree as the serial path.
+	template <typename T, typename ChunkFn>
+	T ReduceChunks(const kernel::ReduceKernel k, const size_t numChunks, const ChunkFn& chunk)
+	{
+		if (numChunks == 0)
+		{
+			return Identity<T>(k);
+		}
+		if (numChunks == 1 || ThreadPool::NumThreads() <= 1)
+		{
+			return ChunkTree<T>(k, chunk, 0, numChunks);
+		}
+
+		std::vector<T> partials(numChunks);
+		ThreadPool::Instance().ParallelFor(numChunks, [&](size_t c)
+		{
+			partials[c] = chunk(c);
+		});
+		const T* results = &partials[0];
+		return ChunkTree<T>(k, [results](size_t c) { return results[c]; }, 0, numChunks);
+	}
+
+	template <typename T>
+	T ReduceBuffer(const kernel::ReduceKernel k, const size_t n, const T* x)
+	{
+		const T identity = Identity<T>(k);
+		return ReduceChunks<T>(k, NumChunks(n), [=](size_t c)
+		{
+			const size_t first = c * ChunkElements;
+			return kernel::Reduce<T>(k, std::min(ChunkElements, n - first), x + first, identity);
+		});
+	}
+
+	/// \brief      Serial version of ReduceBuffer, for calls already running on a worker.
+	template <typename T>
+	T ReduceBufferSerial(const kernel::ReduceKernel k, const size_t n, const T* x)
+	{
+		const size_t numChunks = NumChunks(n);
+		if (numChunks == 0)
+		{
+			return Identity<T>(k);
+		}
+		const T identity = Identity<T>(k);
+		return ChunkTree<T>(k, [=](size_t c)
+		{
+			const size_t first = c * ChunkElements;
+			return kernel::Reduce<T>(k, std::min(ChunkElements, n - first), x + first, identity);
+		}, 0, numChunks);
+	}
+
+	/// \brief      First index of the largest (Max) or smallest (Min) element.
+	template <typename T>
+	size_t ArgExtreme(const kernel::ReduceKernel k, const size_t n, const T* x)
+	{
+		const size_t numChunks = NumChunks(n);
+		if (numChunks == 0)
+		{
+			return n;
+		}
+
+		const T identity = Identity<T>(k);
+		std::vector<T> partials(numChunks);
+		const auto reduceChunk = [&](size_t c)
+		{
+			const size_t first = c * ChunkElements;
+			partials[c] = kernel::Reduce<T>(k, std::min(ChunkElements, n - first), x + first, identity);
+		};
+		if (numChunks > 1 && ThreadPool::NumThreads() > 1)
+		{
+			ThreadPool::Instance().ParallelFor(numChunks, reduceChunk);
+		}
+		else
+		{
+			for (size_t c = 0; c < numChunks; c++)
+			{
+				reduceChunk(c);
+			}
+		}
+
+		T best = identity;
+		for (size_t c = 0; c < numChunks; c++)
+		{
+			best = Combine<T>(k, best, partials[c]);
+		}
+
+		//
+		// A chunk of NaNs reports the identity, which may also be the extreme value of a later
+		// chunk, so every chunk that reports the extreme is searched until it is found.
+		//
+		for (size_t c = 0; c < numChunks; c++)
+		{
+			if (!(partials[c] == best))
+			{
+				continue;
+			}
+			const size_t first = c * ChunkElements;
+			const T* end = x + first + std::min(ChunkElements, n - first);
+			const T* hit = std::find(x + first, end, best);
+			if (hit != end)
+			{
+				return static_cast<size_t>(hit - x);
+			}
+		}
+		return n;
+	}
+
+	/// \brief      Combine the partial rows [begin, end) of a column reduction into row begin.
+	template <typename T>
+	void CombineRows(const kernel::ReduceKernel k, T* partials, const size_t cols,
+	                 const size_t begin, const size_t end)
+	{
+		if (end - begin == 1)
+		{
+			return;
+		}
+		const size_t mid = begin + (end - begin) / 2;
+		CombineRows(k, partials, cols, begin, mid);
+		CombineRows(k, partials, cols, mid, end);
+
+		T* dst = partials + begin * cols;
+		const T* src = partials + mid * cols;
+		switch (k)
+		{
+		case kernel::ReduceKernelMax:
+		case kernel::ReduceKernelMaxAbs:
+			kernel::Accumulate<T>(kernel::ReduceKernelMax, cols, src, dst);
+			break;
+		case kernel::ReduceKernelMin:
+			kernel::Accumulate<T>(kernel::ReduceKernelMin, cols, src, dst);
+			break;
+		default:
+			kernel::Add<T>(cols, dst, src, dst);
+			break;
+		}
+	}
+}
+
+
+/// \brief      Reduce a buffer.
+/// \param[in]  op. The reduction.
+/// \param[in]  n. Number of elements.
+/// \param[in]  x. Elements.
+template <typename T>
+T numeric::kernel::ParallelReduce(const ReduceOp op, const size_t n, const T* x)
+{
+	return Finish(op, ReduceBuffer(KernelOf(op), n, x), n);
+}
+
+
+/// \brief      Dot product of two buffers.
+template <typename T>
+T numeric::kernel::ParallelDot(const size_t n, const T* x, const T* y)
+{
+	return ReduceChunks<T>(kernel::ReduceKernelSum, NumChunks(n), [=](size_t c)
+	{
+		const size_t first = c * ChunkElements;
+		return kernel::Dot<T>(std::min(ChunkElements, n - first), x + first, y + first);
+	});
+}
+
+
+/// \brief      Index of the first largest element.
+template <typename T>
+size_t numeric::kernel::ParallelArgMax(const size_t n, const T* x)
+{
+	return ArgExtreme(kernel::ReduceKernelMax, n, x);
+}
+
+
+/// \brief      Index of the first smallest element.
+template <typename T>
+size_t numeric::kernel::ParallelArgMin(const size_t n, const T* x)
+{
+	return ArgExtreme(kernel::ReduceKernelMin, n, x);
+}
+
+
+/// \brief      Reduce every row.
+/// \param[in]  op. The reduction.
+/// \param[in]  rows, cols. Shape of x.
+/// \param[in]  x, ld. Row-major elements and the distance between rows.
+/// \param[out] out. rows results.
+template <typename T>
+void numeric::kernel::ReduceRows(const ReduceOp op, const unsigned int rows, const unsigned int cols,
+                                 const T* x, const std::ptrdiff_t ld, T* out)
+{
+	const kernel::ReduceKernel k = KernelOf(op);
+	const unsigned int numThreads = ThreadPool::NumThreads();
+	const size_t rowsPerGroup = std::max<size_t>(1, ChunkElements / std::max(cols, 1u));
+	const size_t numGroups = (rows + rowsPerGroup - 1) / rowsPerGroup;
+
+	//
+	// Few long rows are each reduced in parallel; many short ones are handed out in groups.
+	// Both paths give every row the result of ParallelReduce.
+	//
+	if (numThreads <= 1 || numGroups < numThreads)
+	{
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			out[i] = Finish(op, ReduceBuffer(k, cols, x + i * ld), cols);
+		}
+		return;
+	}
+
+	ThreadPool::Instance().ParallelFor(numGroups, [=](size_t g)
+	{
+		const size_t end = std::min<size_t>(rows, (g + 1) * rowsPerGroup);
+		for (size_t i = g * rowsPerGroup; i < end; i++)
+		{
+			out[i] = Finish(op, ReduceBufferSerial(k, cols, x + i * ld), cols);
+		}
+	});
+}
+
+
+/// \brief      Reduce every column.
+/// \param[in]  op. The reduction.
+/// \param[in]  rows, cols. Shape of x.
+/// \param[in]  x, ld. Row-major elements and the distance between rows.
+/// \param[out] out. cols results.
+template <typename T>
+void numeric::kernel::ReduceCols(const ReduceOp op, const unsigned int rows, const unsigned int cols,
+                                 const T* x, const std::ptrdiff_t ld, T* out)
+{
+	const kernel::ReduceKernel k = KernelOf(op);
+	const T identity = Identity<T>(k);
+	const size_t numBlocks = (rows + RowBlock - 1) / RowBlock;
+	const size_t numStrips = (cols + ColStrip - 1) / ColStrip;
+
+	//
+	// Block b folds rows [b * RowBlock, (b + 1) * RowBlock) into partial row b, in row order.
+	// The partial rows are then combined by recursive halving, like the chunks of a buffer.
+	//
+	std::vector<T> partials;
+	T* acc = out;
+	if (numBlocks > 1)
+	{
+		partials.resize(numBlocks * cols);
+		acc = &partials[0];
+	}
+
+	const auto task = [=](size_t t)
+	{
+		const size_t block = t / numStrips;
+		const unsigned int j0 = static_cast<unsigned int>(t % numStrips) * ColStrip;
+		const unsigned int width = std::min(ColStrip, cols - j0);
+		T* dst = acc + block * cols + j0;
+		kernel::Fill<T>(width, identity, dst);
+		const size_t end = std::min<size_t>(rows, (block + 1) * RowBlock);
+		for (size_t i = block * RowBlock; i < end; i++)
+		{
+			kernel::Accumulate<T>(k, width, x + i * ld + j0, dst);
+		}
+	};
+
+	const size_t numTasks = numBlocks * numStrips;
+	if (numTasks > 1 && ThreadPool::NumThreads() > 1)
+	{
+		ThreadPool::Instance().ParallelFor(numTasks, task);
+	}
+	else
+	{
+		for (size_t t = 0; t < numTasks; t++)
+		{
+			task(t);
+		}
+	}
+
+	if (numBlocks > 1)
+	{
+		CombineRows(k, acc, cols, 0, numBlocks);
+		std::copy(acc, acc + cols, out);
+	}
+	else if (numBlocks == 0)
+	{
+		std::fill(out, out + cols, identity);
+	}
+
+	for (unsigned int j = 0; j < cols; j++)
+	{
+		out[j] = Finish(op, out[j], rows);
+	}
+}
+
+
+#define NUMERIC_INSTANTIATE_REDUCTION(T)                                                          \
+	template T numeric::kernel::ParallelReduce<T>(const ReduceOp, const size_t, const T*);        \
+	template T numeric::kernel::ParallelDot<T>(const size_t, const T*, const T*);                 \
+	template size_t numeric::kernel::ParallelArgMax<T>(const size_t, const T*);                   \
+	template size_t numeric::kernel::ParallelArgMin<T>(const size_t, const T*);                   \
+	template void numeric::kernel::ReduceRows<T>(const ReduceOp, const unsigned int,              \
+	                                             const unsigned int, const T*,                    \
+	                                             const std::ptrdiff_t, T*);                       \
+	template void numeric::kernel::ReduceCols<T>(const ReduceOp, const unsigned int,              \
+	                                             const unsigned int, const T*,                    \
+	                                             const std::ptrdiff_t, T*);
+
+NUMERIC_INSTANTIATE_REDUCTION(float)
+NUMERIC_INSTANTIATE_REDUCTION(double)
+NUMERIC_INSTANTIATE_REDUCTION(std::int32_t)
+
+#undef NUMERIC_INSTANTIATE_REDUCTION
@@ -0,0 +1,83 @@
+#ifndef Numeric_Reduction_HPP
+#define Numeric_Reduction_HPP
+
+#include <cstddef>
+
+namespace numeric
+{
+	//
+	// Reductions of whole matrices, rows or columns (see Matrix::RowReduce and ColReduce).
+	// Sum, Mean, NormL1 and NormL2 propagate NaNs; Max, Min and NormInf skip them. The norms
+	// are taken over the elements: NormL1 adds |a_ij|, NormL2 is the Frobenius norm and NormInf
+	// is the largest |a_ij|, which are the usual vector norms for a single row or column.
+	//
+	enum ReduceOp
+	{
+		ReduceSum,
+		ReduceMean,
+		ReduceMax,
+		ReduceMin,
+		ReduceNormL1,
+		ReduceNormL2,
+		ReduceNormInf
+	};
+
+	enum NormType
+	{
+		NormL1,
+		NormL2,
+		NormInf,
+		NormFrobenius = NormL2
+	};
+
+	namespace kernel
+	{
+		//
+		// Parallel reductions on raw storage.
+		//
+		// Buffers are cut into chunks of a fixed size, each chunk is reduced by the vectorised
+		// kernels of ElementWise.hpp, and the chunk results are combined by recursive halving
+		// of the chunk range. Neither the chunks nor the combination order depend on the
+		// number of threads, so results are bitwise reproducible for any ThreadPool size.
+		// Instantiated for float, double and std::int32_t.
+		//
+
+		//
+		// Function : op over the n elements of x. An empty buffer gives zero, and the lowest
+		//      or highest value of T for Max and Min.
+		//
+		template <typename T>
+		T ParallelReduce(const ReduceOp op, const size_t n, const T* x);
+
+		//
+		// Function : Sum of x[i] * y[i].
+		//
+		template <typename T>
+		T ParallelDot(const size_t n, const T* x, const T* y);
+
+		//
+		// Function : Index of the first largest (smallest) element, NaNs skipped, or n when
+		//      there is none.
+		//
+		template <typename T>
+		size_t ParallelArgMax(const size_t n, const T* x);
+
+		template <typename T>
+		size_t ParallelArgMin(const size_t n, const T* x);
+
+		//
+		// Function : Reduce each row of a rows*cols row-major block with leading dimension ld
+		//      into out[i], or each column into out[j]. A row gives the same value as
+		//      ParallelReduce over it.
+		//
+		template <typename T>
+		void ReduceRows(const ReduceOp op, const unsigned int rows, const unsigned int cols,
+		                const T* x, const std::ptrdiff_t ld, T* out);
+
+		template <typename T>
+		void ReduceCols(const ReduceOp op, const unsigned int rows, const unsigned int cols,
+		                const T* x, const std::ptrdiff_t ld, T* out);
+	}
+}
+
+#endif
@@ -0,0 +1,417 @@
+#ifndef Numeric_SimdVector_HPP
+#define Numeric_SimdVector_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "CpuFeatures.hpp"
+
+#if NUMERIC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+//
+// Thin wrappers over one SIMD register per instruction set, so that kernels can be written once
+// as templates over Vec<T> and compiled for every ISA. A kernel file includes its loops once
+// per namespace below, inside the matching NUMERIC_TARGET_BEGIN_<ISA> block.
+//
+// Vec<T> is specialised for float, double and std::int32_t. Every Vec<T> provides
+//      Type, Width, Load, Store, Set1, Add, Sub, Mul, Max, Min, SwapPairs, CountLessEqual,
+//      ReduceMax, ReduceMin
+// SwapPairs exchanges lanes 2k and 2k+1, which turns interleaved (x, y) pairs into (y, x); the
+// scalar Vec has a single lane and returns it unchanged.
+// Max and Min return the second operand when either is NaN, like the scalar a > b ? a : b.
+// CountLessEqual returns the number of lanes with a <= b; NaN lanes are not counted.
+//
+namespace numeric
+{
+	namespace simd
+	{
+		/// \brief  Number of set bits of a lane mask.
+		inline size_t PopCount(unsigned int mask)
+		{
+			size_t count = 0;
+			for (; mask != 0; mask &= mask - 1)
+			{
+				count++;
+			}
+			return count;
+		}
+
+		namespace scalar
+		{
+			template <typename T>
+			struct Vec
+			{
+				typedef T Type;
+				static const size_t Width = 1;
+
+				static inline Type Load(const T* p)            { return *p; }
+				static inline void Store(T* p, const Type v)   { *p = v; }
+				static inline Type Set1(const T s)             { return s; }
+				static inline Type Add(const Type a, const Type b) { return a + b; }
+				static inline Type Sub(const Type a, const Type b) { return a - b; }
+				static inline Type Mul(const Type a, const Type b) { return a * b; }
+				static inline Type Max(const Type a, const Type b) { return a > b ? a : b; }
+				static inline Type Min(const Type a, const Type b) { return a < b ? a : b; }
+				static inline Type SwapPairs(const Type v)     { return v; }
+				static inline size_t CountLessEqual(const Type a, const Type b) { return a <= b ? 1 : 0; }
+				static inline T    ReduceMax(const Type v)     { return v; }
+				static inline T    ReduceMin(const Type v)     { return v; }
+			};
+		}
+
+#if NUMERIC_X86_SIMD
+		namespace sse2
+		{
+NUMERIC_TARGET_BEGIN_SSE2
+			template <typename T>
+			struct Vec;
+
+			template <>
+			struct Vec<double>
+			{
+				typedef __m128d Type;
+				static const size_t Width = 2;
+
+				static inline Type Load(const double* p)         { return _mm_loadu_pd(p); }
+				static inline void Store(double* p, const Type v) { _mm_storeu_pd(p, v); }
+				static inline Type Set1(const double s)           { return _mm_set1_pd(s); }
+				static inline Type Add(const Type a, const Type b) { return _mm_add_pd(a, b); }
+				static inline Type Sub(const Type a, const Type b) { return _mm_sub_pd(a, b); }
+				static inline Type Mul(const Type a, const Type b) { return _mm_mul_pd(a, b); }
+				static inline Type Max(const Type a, const Type b) { return _mm_max_pd(a, b); }
+				static inline Type Min(const Type a, const Type b) { return _mm_min_pd(a, b); }
+				static inline Type SwapPairs(const Type v)         { return _mm_shuffle_pd(v, v, 1); }
+
+				static inline size_t CountLessEqual(const Type a, const Type b)
+				{
+					return PopCount(static_cast<unsigned int>(_mm_movemask_pd(_mm_cmple_pd(a, b))));
+				}
+
+				static inline double ReduceMax(const Type v)
+				{
+					return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v)));
+				}
+
+				static inline double ReduceMin(const Type v)
+				{
+					return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v)));
+				}
+			};
+
+			template <>
+			struct Vec<float>
+			{
+				typedef __m128 Type;
+				static const size_t Width = 4;
+
+				static inline Type Load(const float* p)          { return _mm_loadu_ps(p); }
+				static inline void Store(float* p, const Type v) { _mm_storeu_ps(p, v); }
+				static inline Type Set1(const float s)            { return _mm_set1_ps(s); }
+				static inline Type Add(const Type a, const Type b) { return _mm_add_ps(a, b); }
+				static inline Type Sub(const Type a, const Type b) { return _mm_sub_ps(a, b); }
+				static inline Type Mul(const Type a, const Type b) { return _mm_mul_ps(a, b); }
+				static inline Type Max(const Type a, const Type b) { return _mm_max_ps(a, b); }
+				static inline Type Min(const Type a, const Type b) { return _mm_min_ps(a, b); }
+				static inline Type SwapPairs(const Type v)         { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+				static inline size_t CountLessEqual(const Type a, const Type b)
+				{
+					return PopCount(static_cast<unsigned int>(_mm_movemask_ps(_mm_cmple_ps(a, b))));
+				}
+
+				static inline float ReduceMax(const Type v)
+				{
+					const __m128 h = _mm_max_ps(v, _mm_movehl_ps(v, v));
+					return _mm_cvtss_f32(_mm_max_ss(h, _mm_shuffle_ps(h, h, 1)));
+				}
+
+				static inline float ReduceMin(const Type v)
+				{
+					const __m128 h = _mm_min_ps(v, _mm_movehl_ps(v, v));
+					return _mm_cvtss_f32(_mm_min_ss(h, _mm_shuffle_ps(h, h, 1)));
+				}
+			};
+
+			//
+			// SSE2 has no 32-bit multiply-low, max or min; they are built from the 64-bit
+			// multiply and from compare-and-select.
+			//
+			template <>
+			struct Vec<std::int32_t>
+			{
+				typedef __m128i Type;
+				static const size_t Width = 4;
+
+				static inline Type Load(const std::int32_t* p)
+				{
+					return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+				}
+
+				static inline void Store(std::int32_t* p, const Type v)
+				{
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+				}
+
+				static inline Type Set1(const std::int32_t s)     { return _mm_set1_epi32(s); }
+				static inline Type Add(const Type a, const Type b) { return _mm_add_epi32(a, b); }
+				static inline Type Sub(const Type a, const Type b) { return _mm_sub_epi32(a, b); }
+
+				static inline Type Mul(const Type a, const Type b)
+				{
+					const __m128i even = _mm_mul_epu32(a, b);
+					const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+					return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+					                          _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+				}
+
+				static inline Type Max(const Type a, const Type b)
+				{
+					const __m128i gt = _mm_cmpgt_epi32(a, b);
+					return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+				}
+
+				static inline Type Min(const Type a, const Type b)
+				{
+					const __m128i lt = _mm_cmplt_epi32(a, b);
+					return _mm_or_si128(_mm_and_si128(lt, a), _mm_andnot_si128(lt, b));
+				}
+
+				static inline Type SwapPairs(const Type v)         { return _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+				static inline size_t CountLessEqual(const Type a, const Type b)
+				{
+					const __m128i gt = _mm_cmpgt_epi32(a, b);
+					return 4 - PopCount(static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(gt))));
+				}
+
+				static inline std::int32_t ReduceMax(Type v)
+				{
+					v = Max(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+					v = Max(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+					return _mm_cvtsi128_si32(v);
+				}
+
+				static inline std::int32_t ReduceMin(Type v)
+				{
+					v = Min(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+					v = Min(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+					return _mm_cvtsi128_si32(v);
+				}
+			};
+NUMERIC_TARGET_END
+		}
+
+		namespace avx2
+		{
+NUMERIC_TARGET_BEGIN_AVX2
+			template <typename T>
+			struct Vec;
+
+			template <>
+			struct Vec<double>
+			{
+				typedef __m256d Type;
+				static const size_t Width = 4;
+
+				static inline Type Load(const double* p)         { return _mm256_loadu_pd(p); }
+				static inline void Store(double* p, const Type v) { _mm256_storeu_pd(p, v); }
+				static inline Type Set1(const double s)           { return _mm256_set1_pd(s); }
+				static inline Type Add(const Type a, const Type b) { return _mm256_add_pd(a, b); }
+				static inline Type Sub(const Type a, const Type b) { return _mm256_sub_pd(a, b); }
+				static inline Type Mul(const Type a, const Type b) { return _mm256_mul_pd(a, b); }
+				static inline Type Max(const Type a, const Type b) { return _mm256_max_pd(a, b); }
+				static inline Type Min(const Type a, const Type b) { return _mm256_min_pd(a, b); }
+				static inline Type SwapPairs(const Type v)         { return _mm256_permute_pd(v, 0x5); }
+
+				static inline size_t CountLessEqual(const Type a, const Type b)
+				{
+					return PopCount(static_cast<unsigned int>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LE_OQ))));
+				}
+
+				static inline double ReduceMax(const Type v)
+				{
+					const __m128d h = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+					return _mm_cvtsd_f64(_mm_max_sd(h, _mm_unpackhi_pd(h, h)));
+				}
+
+				static inline double ReduceMin(const Type v)
+				{
+					const __m128d h = _mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+					return _mm_cvtsd_f64(_mm_min_sd(h, _mm_unpackhi_pd(h, h)));
+				}
+			};
+
+			template <>
+			struct Vec<float>
+			{
+				typedef __m256 Type;
+				static const size_t Width = 8;
+
+				static inline Type Load(const float* p)          { return _mm256_loadu_ps(p); }
+				static inline void Store(float* p, const Type v) { _mm256_storeu_ps(p, v); }
+				static inline Type Set1(const float s)            { return _mm256_set1_ps(s); }
+				static inline Type Add(const Type a, const Type b) { return _mm256_add_ps(a, b); }
+				static inline Type Sub(const Type a, const Type b) { return _mm256_sub_ps(a, b); }
+				static inline Type Mul(const Type a, const Type b) { return _mm256_mul_ps(a, b); }
+				static inline Type Max(const Type a, const Type b) { return _mm256_max_ps(a, b); }
+				static inline Type Min(const Type a, const Type b) { return _mm256_min_ps(a, b); }
+				static inline Type SwapPairs(const Type v)         { return _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+				static inline size_t CountLessEqual(const Type a, const Type b)
+				{
+					return PopCount(static_cast<unsigned int>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ))));
+				}
+
+				static inline float ReduceMax(const Type v)
+				{
+					__m128 h = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+					h = _mm_max_ps(h, _mm_movehl_ps(h, h));
+					return _mm_cvtss_f32(_mm_max_ss(h, _mm_shuffle_ps(h, h, 1)));
+				}
+
+				static inline float ReduceMin(const Type v)
+				{
+					__m128 h = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+					h = _mm_min_ps(h, _mm_movehl_ps(h, h));
+					return _mm_cvtss_f32(_mm_min_ss(h, _mm_shuffle_ps(h, h, 1)));
+				}
+			};
+
+			template <>
+			struct Vec<std::int32_t>
+			{
+				typedef __m256i Type;
+				static const size_t Width = 8;
+
+				static inline Type Load(const std::int32_t* p)
+				{
+					return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+				}
+
+				static inline void Store(std::int32_t* p, const Type v)
+				{
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+				}
+
+				static inline Type Set1(const std::int32_t s)     { return _mm256_set1_epi32(s); }
+				static inline Type Add(const Type a, const Type b) { return _mm256_add_epi32(a, b); }
+				static inline Type Sub(const Type a, const Type b) { return _mm256_sub_epi32(a, b); }
+				static inline Type Mul(const Type a, const Type b) { return _mm256_mullo_epi32(a, b); }
+				static inline Type Max(const Type a, const Type b) { return _mm256_max_epi32(a, b); }
+				static inline Type Min(const Type a, const Type b) { return _mm256_min_epi32(a, b); }
+				static inline Type SwapPairs(const Type v)         { return _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+				static inline size_t CountLessEqual(const Type a, const Type b)
+				{
+					const __m256i gt = _mm256_cmpgt_epi32(a, b);
+					return 8 - PopCount(static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(gt))));
+				}
+
+				static inline std::int32_t ReduceMax(const Type v)
+				{
+					__m128i h = _mm_max_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+					h = _mm_max_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(1, 0, 3, 2)));
+					h = _mm_max_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(2, 3, 0, 1)));
+					return _mm_cvtsi128_si32(h);
+				}
+
+				static inline std::int32_t ReduceMin(const Type v)
+				{
+					__m128i h = _mm_min_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+					h = _mm_min_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(1, 0, 3, 2)));
+					h = _mm_min_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(2, 3, 0, 1)));
+					return _mm_cvtsi128_si32(h);
+				}
+			};
+NUMERIC_TARGET_END
+		}
+
+		namespace avx512
+		{
+NUMERIC_TARGET_BEGIN_AVX512
+			template <typename T>
+			struct Vec;
+
+			template <>
+			struct Vec<double>
+			{
+				typedef __m512d Type;
+				static const size_t Width = 8;
+
+				static inline Type Load(const double* p)         { return _mm512_loadu_pd(p); }
+				static inline void Store(double* p, const Type v) { _mm512_storeu_pd(p, v); }
+				static inline Type Set1(const double s)           { return _mm512_set1_pd(s); }
+				static inline Type Add(const Type a, const Type b) { return _mm512_add_pd(a, b); }
+				static inline Type Sub(const Type a, const Type b) { return _mm512_sub_pd(a, b); }
+				static inline Type Mul(const Type a, const Type b) { return _mm512_mul_pd(a, b); }
+				static inline Type Max(const Type a, const Type b) { return _mm512_max_pd(a, b); }
+				static inline Type Min(const Type a, const Type b) { return _mm512_min_pd(a, b); }
+				static inline Type SwapPairs(const Type v)         { return _mm512_permute_pd(v, 0x55); }
+
+				static inline size_t CountLessEqual(const Type a, const Type b)
+				{
+					return PopCount(static_cast<unsigned int>(_mm512_cmp_pd_mask(a, b, _CMP_LE_OQ)));
+				}
+
+				static inline double ReduceMax(const Type v)
+				{
+					const __m256d q = _mm256_max_pd(_mm512_castpd512_pd256(v), _mm512_extractf64x4_pd(v, 1));
+					const __m128d h = _mm_max_pd(_mm256_castpd256_pd128(q), _mm256_extractf128_pd(q, 1));
+					return _mm_cvtsd_f64(_mm_max_sd(h, _mm_unpackhi_pd(h, h)));
+				}
+
+				static inline double ReduceMin(const Type v)
+				{
+					const __m256d q = _mm256_min_pd(_mm512_castpd512_pd256(v), _mm512_extractf64x4_pd(v, 1));
+					const __m128d h = _mm_min_pd(_mm256_castpd256_pd128(q), _mm256_extractf128_pd(q, 1));
+					return _mm_cvtsd_f64(_mm_min_sd(h, _mm_unpackhi_pd(h, h)));
+				}
+			};
+
+			template <>
+			struct Vec<float>
+			{
+				typedef __m512 Type;
+				static const size_t Width = 16;
+
+				static inline Type Load(const float* p)          { return _mm512_loadu_ps(p); }
+				static inline void Store(float* p, const Type v) { _mm512_storeu_ps(p, v); }
+				static inline Type Set1(const float s)            { return _mm512_set1_ps(s); }
+				static inline Type Add(const Type a, const Type b) { return _mm512_add_ps(a, b); }
+				static inline Type Sub(const Type a, const Type b) { return _mm512_sub_ps(a, b); }
+				static inline Type Mul(const Type a, const Type b) { return _mm512_mul_ps(a, b); }
+				static inline Type Max(const Type a, const Type b) { return _mm512_max_ps(a, b); }
+				static inline Type Min(const Type a, const Type b) { return _mm512_min_ps(a, b); }
+				static inline Type SwapPairs(const Type v)         { return _mm512_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1)); }
+				static inline size_t CountLessEqual(const Type a, const Type b) { return PopCount(_mm512_cmp_ps_mask(a, b, _CMP_LE_OQ)); }
+				static inline float ReduceMax(const Type v)        { return _mm512_reduce_max_ps(v); }
+				static inline float ReduceMin(const Type v)        { return _mm512_reduce_min_ps(v); }
+			};
+
+			template <>
+			struct Vec<std::int32_t>
+			{
+				typedef __m512i Type;
+				static const size_t Width = 16;
+
+				static inline Type Load(const std::int32_t* p)          { return _mm512_loadu_si512(p); }
+				static inline void Store(std::int32_t* p, const Type v) { _mm512_storeu_si512(p, v); }
+				static inline Type Set1(const std::int32_t s)           { return _mm512_set1_epi32(s); }
+				static inline Type Add(const Type a, const Type b)      { return _mm512_add_epi32(a, b); }
+				static inline Type Sub(const Type a, const Type b)      { return _mm512_sub_epi32(a, b); }
+				static inline Type Mul(const Type a, const Type b)      { return _mm512_mullo_epi32(a, b); }
+				static inline Type Max(const Type a, const Type b)      { return _mm512_max_epi32(a, b); }
+				static inline Type Min(const Type a, const Type b)      { return _mm512_min_epi32(a, b); }
+				static inline Type SwapPairs(const Type v)              { return _mm512_shuffle_epi32(v, _MM_PERM_CDAB); }
+				static inline size_t CountLessEqual(const Type a, const Type b) { return PopCount(_mm512_cmple_epi32_mask(a, b)); }
+				static inline std::int32_t ReduceMax(const Type v)      { return _mm512_reduce_max_epi32(v); }
+				static inline std::int32_t ReduceMin(const Type v)      { return _mm512_reduce_min_epi32(v); }
+			};
+NUMERIC_TARGET_END
+		}
+#endif
+	}
+}
+
+#endif
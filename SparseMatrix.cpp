@@ -0,0 +1,667 @@
+
+#include "SparseMatrix.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstdint>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of SparseMatrix
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// A block handed to a worker covers at least this many nonzeros, and there are at most a
+	// few blocks per thread so that uneven rows still balance out.
+	//
+	const size_t MinNonZerosPerBlock = 16384;
+	const size_t BlocksPerThread = 4;
+
+	/// \brief     Split the outer indices [0, outer) into blocks of about the same number of
+	///            nonzeros.
+	/// \param[in] blocksPerThread. At most this many blocks per ThreadPool thread.
+	/// \return    Block boundaries, from 0 to outer.
+	std::vector<unsigned int> Partition(const std::vector<size_t>& offsets, const unsigned int outer,
+	                                    const size_t blocksPerThread = BlocksPerThread)
+	{
+		const size_t nnz = offsets[outer];
+		size_t numBlocks = 1;
+		if (ThreadPool::NumThreads() > 1)
+		{
+			numBlocks = std::min(static_cast<size_t>(ThreadPool::NumThreads()) * blocksPerThread,
+			                     nnz / MinNonZerosPerBlock);
+			numBlocks = std::max(numBlocks, static_cast<size_t>(1));
+		}
+
+		std::vector<unsigned int> bounds(numBlocks + 1, 0);
+		for (size_t b = 1; b < numBlocks; b++)
+		{
+			const size_t target = nnz / numBlocks * b;
+			const unsigned int k = static_cast<unsigned int>(
+				std::lower_bound(offsets.begin(), offsets.begin() + outer + 1, target) - offsets.begin());
+			bounds[b] = std::max(bounds[b - 1], std::min(k, outer));
+		}
+		bounds[numBlocks] = outer;
+		return bounds;
+	}
+
+	/// \brief  Run body(block, begin, end) over every block, in parallel when there are several.
+	template <typename F>
+	void ForEachBlock(const std::vector<unsigned int>& bounds, const F& body)
+	{
+		const size_t numBlocks = bounds.size() - 1;
+		if (numBlocks == 1)
+		{
+			body(0, bounds[0], bounds[1]);
+			return;
+		}
+		ThreadPool::Instance().ParallelFor(numBlocks, [&](size_t b)
+		{
+			body(b, bounds[b], bounds[b + 1]);
+		});
+	}
+}
+
+
+template <typename T>
+BasicSparseMatrix<T>::BasicSparseMatrix()
+	: m_rows(0), m_cols(0), m_order(RowMajor), m_offsets(1, 0)
+{
+}
+
+
+/// \brief     An empty rows*cols matrix.
+template <typename T>
+BasicSparseMatrix<T>::BasicSparseMatrix(const unsigned int rows, const unsigned int cols,
+                                        const StorageOrder order)
+	: m_rows(rows), m_cols(cols), m_order(order)
+{
+	m_offsets.assign(static_cast<size_t>(OuterSize()) + 1, 0);
+}
+
+
+/// \brief     The nonzeros of a dense matrix.
+/// \param[in] mat. Matrix.
+/// \param[in] order. Storage order.
+template <typename T>
+BasicSparseMatrix<T>::BasicSparseMatrix(const BasicMatrix<T>& mat, const StorageOrder order)
+	: m_rows(mat.Rows()), m_cols(mat.Cols()), m_order(RowMajor)
+{
+	const unsigned int rows = m_rows;
+	const unsigned int cols = m_cols;
+	const T* a = mat.Data();
+	m_offsets.assign(static_cast<size_t>(rows) + 1, 0);
+	for (unsigned int i = 0; i < rows; i++)
+	{
+		const T* row = a + static_cast<size_t>(i) * cols;
+		m_offsets[i + 1] = m_offsets[i] + (cols - std::count(row, row + cols, T(0)));
+	}
+
+	m_indices.resize(m_offsets[rows]);
+	m_values.resize(m_offsets[rows]);
+	size_t p = 0;
+	for (unsigned int i = 0; i < rows; i++)
+	{
+		const T* row = a + static_cast<size_t>(i) * cols;
+		for (unsigned int j = 0; j < cols; j++)
+		{
+			if (row[j] != T(0))
+			{
+				m_indices[p] = j;
+				m_values[p] = row[j];
+				p++;
+			}
+		}
+	}
+	ChangeOrder(order);
+}
+
+
+/// \brief     Adopt compressed arrays after checking them.
+template <typename T>
+BasicSparseMatrix<T>::BasicSparseMatrix(const unsigned int rows, const unsigned int cols,
+                                        const StorageOrder order,
+                                        const std::vector<size_t>& offsets,
+                                        const std::vector<unsigned int>& indices,
+                                        const std::vector<ElemType>& values)
+	: m_rows(rows), m_cols(cols), m_order(order),
+	  m_offsets(offsets), m_indices(indices), m_values(values)
+{
+	const unsigned int outer = OuterSize();
+	const unsigned int inner = InnerSize();
+	bool valid = m_offsets.size() == static_cast<size_t>(outer) + 1 &&
+		m_offsets[0] == 0 &&
+		m_offsets[outer] == m_indices.size() &&
+		m_indices.size() == m_values.size();
+	for (unsigned int k = 0; valid && k < outer; k++)
+	{
+		valid = m_offsets[k] <= m_offsets[k + 1] && m_offsets[k + 1] <= m_indices.size();
+		for (size_t p = m_offsets[k]; valid && p < m_offsets[k + 1]; p++)
+		{
+			valid = m_indices[p] < inner && (p == m_offsets[k] || m_indices[p - 1] < m_indices[p]);
+		}
+	}
+	if (!valid)
+	{
+		throw std::invalid_argument(
+			"Invalid sparse structure"
+			);
+	}
+}
+
+
+/// \brief     Build from (row, col, value) triplets. They are bucketed by inner index and then
+///            by outer index, which leaves every outer index with sorted inner indices, and
+///            repeats are then summed.
+template <typename T>
+void BasicSparseMatrix<T>::SetFromTriplets(const size_t count,
+                                           const unsigned int* rows,
+                                           const unsigned int* cols,
+                                           const ElemType* values)
+{
+	for (size_t t = 0; t < count; t++)
+	{
+		if (rows[t] >= m_rows || cols[t] >= m_cols)
+		{
+			throw std::out_of_range("Out of Range");
+		}
+	}
+
+	const unsigned int outer = OuterSize();
+	const unsigned int inner = InnerSize();
+	const unsigned int* outerIndex = m_order == RowMajor ? rows : cols;
+	const unsigned int* innerIndex = m_order == RowMajor ? cols : rows;
+
+	std::vector<size_t> innerOffsets(static_cast<size_t>(inner) + 1, 0);
+	for (size_t t = 0; t < count; t++)
+	{
+		innerOffsets[innerIndex[t] + 1]++;
+	}
+	for (unsigned int j = 0; j < inner; j++)
+	{
+		innerOffsets[j + 1] += innerOffsets[j];
+	}
+	std::vector<size_t> byInner(count);
+	for (size_t t = 0; t < count; t++)
+	{
+		byInner[innerOffsets[innerIndex[t]]++] = t;
+	}
+
+	std::vector<size_t> offsets(static_cast<size_t>(outer) + 1, 0);
+	for (size_t t = 0; t < count; t++)
+	{
+		offsets[outerIndex[t] + 1]++;
+	}
+	for (unsigned int k = 0; k < outer; k++)
+	{
+		offsets[k + 1] += offsets[k];
+	}
+	std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+	std::vector<unsigned int> indices(count);
+	std::vector<ElemType> sorted(count);
+	for (size_t q = 0; q < count; q++)
+	{
+		const size_t t = byInner[q];
+		const size_t p = next[outerIndex[t]]++;
+		indices[p] = innerIndex[t];
+		sorted[p] = values[t];
+	}
+
+	//
+	// Sum repeats, compacting in place.
+	//
+	size_t w = 0;
+	for (unsigned int k = 0; k < outer; k++)
+	{
+		const size_t begin = offsets[k];
+		const size_t end = offsets[k + 1];
+		offsets[k] = w;
+		for (size_t p = begin; p < end; p++)
+		{
+			if (w > offsets[k] && indices[w - 1] == indices[p])
+			{
+				sorted[w - 1] += sorted[p];
+			}
+			else
+			{
+				indices[w] = indices[p];
+				sorted[w] = sorted[p];
+				w++;
+			}
+		}
+	}
+	offsets[outer] = w;
+	indices.resize(w);
+	sorted.resize(w);
+
+	m_offsets.swap(offsets);
+	m_indices.swap(indices);
+	m_values.swap(sorted);
+}
+
+
+/// \brief      Expand into a dense matrix.
+/// \param[out] mat. Rows()*Cols() matrix.
+template <typename T>
+void BasicSparseMatrix<T>::ToMatrix(BasicMatrix<T>& mat) const
+{
+	if (mat.Rows() != m_rows || mat.Cols() != m_cols)
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	BasicMatrix<T>::Zero(mat);
+	T* a = mat.Data();
+	const size_t outerStride = m_order == RowMajor ? m_cols : 1;
+	const size_t innerStride = m_order == RowMajor ? 1 : m_cols;
+	for (unsigned int k = 0; k < OuterSize(); k++)
+	{
+		for (size_t p = m_offsets[k]; p < m_offsets[k + 1]; p++)
+		{
+			a[k * outerStride + m_indices[p] * innerStride] = m_values[p];
+		}
+	}
+}
+
+
+/// \brief     Re-compress along the other dimension, a transpose of the storage.
+template <typename T>
+void BasicSparseMatrix<T>::ChangeOrder(const StorageOrder order)
+{
+	if (order == m_order)
+	{
+		return;
+	}
+
+	const unsigned int outer = OuterSize();
+	const unsigned int inner = InnerSize();
+	const size_t nnz = m_indices.size();
+	std::vector<size_t> offsets(static_cast<size_t>(inner) + 1, 0);
+	for (size_t p = 0; p < nnz; p++)
+	{
+		offsets[m_indices[p] + 1]++;
+	}
+	for (unsigned int j = 0; j < inner; j++)
+	{
+		offsets[j + 1] += offsets[j];
+	}
+
+	std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+	std::vector<unsigned int> indices(nnz);
+	std::vector<ElemType> values(nnz);
+	for (unsigned int k = 0; k < outer; k++)
+	{
+		for (size_t p = m_offsets[k]; p < m_offsets[k + 1]; p++)
+		{
+			const size_t q = next[m_indices[p]]++;
+			indices[q] = k;
+			values[q] = m_values[p];
+		}
+	}
+
+	m_order = order;
+	m_offsets.swap(offsets);
+	m_indices.swap(indices);
+	m_values.swap(values);
+}
+
+
+/// \brief       y = mat * x.
+/// \param[in]   mat. Sparse matrix.
+/// \param[in]   x. Cols() elements.
+/// \param[out]  y. Rows() elements.
+template <typename T>
+void BasicSparseMatrix<T>::Mul(const BasicSparseMatrix& mat, const ElemType* x, ElemType* y)
+{
+	const size_t* offsets = &mat.m_offsets[0];
+	const unsigned int* indices = mat.m_indices.empty() ? 0 : &mat.m_indices[0];
+	const T* values = mat.m_values.empty() ? 0 : &mat.m_values[0];
+
+	if (mat.m_order == RowMajor)
+	{
+		ForEachBlock(Partition(mat.m_offsets, mat.OuterSize()), [&](size_t, unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				T sum = T(0);
+				for (size_t p = offsets[i]; p < offsets[i + 1]; p++)
+				{
+					sum += values[p] * x[indices[p]];
+				}
+				y[i] = sum;
+			}
+		});
+		return;
+	}
+
+	//
+	// CSC scatters into y: each block of columns accumulates into its own rows-long buffer,
+	// the first one into y, and the buffers are then added into y in block order. There is
+	// at most one block per thread, and the buffers are kept per calling thread and reused, so
+	// a multiply allocates nothing once they have grown.
+	//
+	const unsigned int rows = mat.m_rows;
+	const std::vector<unsigned int> bounds = Partition(mat.m_offsets, mat.OuterSize(), 1);
+	const size_t numBlocks = bounds.size() - 1;
+	static thread_local std::vector<T> partial;
+	if (partial.size() < (numBlocks - 1) * static_cast<size_t>(rows))
+	{
+		partial.resize((numBlocks - 1) * static_cast<size_t>(rows));
+	}
+	T* buffers = partial.empty() ? 0 : &partial[0];
+	ForEachBlock(bounds, [&](size_t b, unsigned int begin, unsigned int end)
+	{
+		T* acc = b == 0 ? y : buffers + (b - 1) * static_cast<size_t>(rows);
+		std::fill(acc, acc + rows, T(0));
+		for (unsigned int j = begin; j < end; j++)
+		{
+			const T xj = x[j];
+			for (size_t p = offsets[j]; p < offsets[j + 1]; p++)
+			{
+				acc[indices[p]] += values[p] * xj;
+			}
+		}
+	});
+	if (numBlocks > 1)
+	{
+		ThreadPool::Instance().ParallelFor(numBlocks, [&](size_t r)
+		{
+			const size_t i0 = rows * r / numBlocks;
+			const size_t i1 = rows * (r + 1) / numBlocks;
+			for (size_t b = 1; b < numBlocks; b++)
+			{
+				const T* acc = buffers + (b - 1) * static_cast<size_t>(rows);
+				for (size_t i = i0; i < i1; i++)
+				{
+					y[i] += acc[i];
+				}
+			}
+		});
+	}
+}
+
+
+/// \brief       Sparse times dense matrix multiplication.
+/// \param[in]   lhmat. Sparse m*n matrix.
+/// \param[in]   rhmat. Dense n*k matrix.
+/// \param[out]  result. Dense m*k matrix.
+template <typename T>
+void BasicSparseMatrix<T>::Mul(const BasicSparseMatrix& lhmat, const BasicMatrix<T>& rhmat, BasicMatrix<T>& result)
+{
+	if (lhmat.Cols() != rhmat.Rows() ||
+		result.Rows() != lhmat.Rows() ||
+		result.Cols() != rhmat.Cols())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	if (&result == &rhmat)
+	{
+		BasicMatrix<T> tmp(result.Rows(), result.Cols());
+		BasicSparseMatrix::Mul(lhmat, rhmat, tmp);
+		result = tmp;
+		return;
+	}
+
+	const unsigned int k = rhmat.Cols();
+	if (k == 1)
+	{
+		BasicSparseMatrix::Mul(lhmat, rhmat.Data(), result.Data());
+		return;
+	}
+
+	const size_t* offsets = &lhmat.m_offsets[0];
+	const unsigned int* indices = lhmat.m_indices.empty() ? 0 : &lhmat.m_indices[0];
+	const T* values = lhmat.m_values.empty() ? 0 : &lhmat.m_values[0];
+	const T* b = rhmat.Data();
+	T* c = result.Data();
+
+	if (lhmat.m_order == RowMajor)
+	{
+		//
+		// Row i of the result is a combination of the rows of rhmat picked by row i of lhmat.
+		//
+		ForEachBlock(Partition(lhmat.m_offsets, lhmat.m_rows), [&](size_t, unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				T* ci = c + static_cast<size_t>(i) * k;
+				std::fill(ci, ci + k, T(0));
+				for (size_t p = offsets[i]; p < offsets[i + 1]; p++)
+				{
+					const T a = values[p];
+					const T* bj = b + static_cast<size_t>(indices[p]) * k;
+					for (unsigned int j = 0; j < k; j++)
+					{
+						ci[j] += a * bj[j];
+					}
+				}
+			}
+		});
+		return;
+	}
+
+	//
+	// CSC: the product is run on a CSR copy, so that each nonzero is read once and each block
+	// of result rows has a single writer. The copy is one pass over the nonzeros, against
+	// the k passes of the product.
+	//
+	BasicSparseMatrix csr(lhmat);
+	csr.ChangeOrder(RowMajor);
+	BasicSparseMatrix::Mul(csr, rhmat, result);
+}
+
+
+/// \brief       Add two sparse matrices.
+/// \param[in]   lhmat. Sparse matrix.
+/// \param[in]   rhmat. Sparse matrix.
+/// \param[out]  result. Sparse matrix; may be lhmat or rhmat.
+template <typename T>
+void BasicSparseMatrix<T>::Add(const BasicSparseMatrix& lhmat, const BasicSparseMatrix& rhmat, BasicSparseMatrix& result)
+{
+	if (lhmat.Rows() != rhmat.Rows() ||
+		lhmat.Cols() != rhmat.Cols() ||
+		result.Rows() != lhmat.Rows() ||
+		result.Cols() != lhmat.Cols())
+	{
+		throw std::invalid_argument(
+			"Dimension mismatch"
+			);
+	}
+
+	//
+	// Both operands are merged in the order of the result, converting copies where needed.
+	//
+	const StorageOrder order = result.m_order;
+	BasicSparseMatrix lhcopy;
+	BasicSparseMatrix rhcopy;
+	const BasicSparseMatrix* lh = &lhmat;
+	const BasicSparseMatrix* rh = &rhmat;
+	if (lh->m_order != order)
+	{
+		lhcopy = lhmat;
+		lhcopy.ChangeOrder(order);
+		lh = &lhcopy;
+	}
+	if (rh->m_order != order)
+	{
+		rhcopy = rhmat;
+		rhcopy.ChangeOrder(order);
+		rh = &rhcopy;
+	}
+
+	//
+	// Each block merges its outer indices into local arrays; the blocks are then stitched
+	// together in order.
+	//
+	const unsigned int outer = lh->OuterSize();
+	std::vector<size_t> work(static_cast<size_t>(outer) + 1);
+	for (unsigned int k = 0; k <= outer; k++)
+	{
+		work[k] = lh->m_offsets[k] + rh->m_offsets[k];
+	}
+	const std::vector<unsigned int> bounds = Partition(work, outer);
+	const size_t numBlocks = bounds.size() - 1;
+	std::vector<std::vector<unsigned int> > blockIndices(numBlocks);
+	std::vector<std::vector<ElemType> > blockValues(numBlocks);
+	std::vector<size_t> counts(outer);
+
+	ForEachBlock(bounds, [&](size_t b, unsigned int begin, unsigned int end)
+	{
+		std::vector<unsigned int>& indices = blockIndices[b];
+		std::vector<ElemType>& values = blockValues[b];
+		indices.reserve(work[end] - work[begin]);
+		values.reserve(work[end] - work[begin]);
+		for (unsigned int k = begin; k < end; k++)
+		{
+			const size_t before = indices.size();
+			size_t p = lh->m_offsets[k];
+			size_t q = rh->m_offsets[k];
+			const size_t pEnd = lh->m_offsets[k + 1];
+			const size_t qEnd = rh->m_offsets[k + 1];
+			while (p < pEnd || q < qEnd)
+			{
+				unsigned int index;
+				ElemType value;
+				if (q == qEnd || (p < pEnd && lh->m_indices[p] < rh->m_indices[q]))
+				{
+					index = lh->m_indices[p];
+					value = lh->m_values[p++];
+				}
+				else if (p == pEnd || rh->m_indices[q] < lh->m_indices[p])
+				{
+					index = rh->m_indices[q];
+					value = rh->m_values[q++];
+				}
+				else
+				{
+					index = lh->m_indices[p];
+					value = lh->m_values[p++] + rh->m_values[q++];
+				}
+				if (value != ElemType(0))
+				{
+					indices.push_back(index);
+					values.push_back(value);
+				}
+			}
+			counts[k] = indices.size() - before;
+		}
+	});
+
+	BasicSparseMatrix sum(lhmat.Rows(), lhmat.Cols(), order);
+	for (unsigned int k = 0; k < outer; k++)
+	{
+		sum.m_offsets[k + 1] = sum.m_offsets[k] + counts[k];
+	}
+	sum.m_indices.resize(sum.m_offsets[outer]);
+	sum.m_values.resize(sum.m_offsets[outer]);
+	ForEachBlock(bounds, [&](size_t b, unsigned int begin, unsigned int)
+	{
+		std::copy(blockIndices[b].begin(), blockIndices[b].end(), sum.m_indices.begin() + sum.m_offsets[begin]);
+		std::copy(blockValues[b].begin(), blockValues[b].end(), sum.m_values.begin() + sum.m_offsets[begin]);
+	});
+	result.Swap(sum);
+}
+
+
+template <typename T>
+unsigned int BasicSparseMatrix<T>::Rows() const
+{
+	return m_rows;
+}
+
+
+template <typename T>
+unsigned int BasicSparseMatrix<T>::Cols() const
+{
+	return m_cols;
+}
+
+
+template <typename T>
+size_t BasicSparseMatrix<T>::NonZeros() const
+{
+	return m_indices.size();
+}
+
+
+template <typename T>
+typename BasicSparseMatrix<T>::StorageOrder BasicSparseMatrix<T>::Order() const
+{
+	return m_order;
+}
+
+
+template <typename T>
+void BasicSparseMatrix<T>::Swap(BasicSparseMatrix& mat)
+{
+	std::swap(m_rows, mat.m_rows);
+	std::swap(m_cols, mat.m_cols);
+	std::swap(m_order, mat.m_order);
+	m_offsets.swap(mat.m_offsets);
+	m_indices.swap(mat.m_indices);
+	m_values.swap(mat.m_values);
+}
+
+
+template <typename T>
+const std::vector<size_t>& BasicSparseMatrix<T>::Offsets() const
+{
+	return m_offsets;
+}
+
+
+template <typename T>
+const std::vector<unsigned int>& BasicSparseMatrix<T>::Indices() const
+{
+	return m_indices;
+}
+
+
+template <typename T>
+const std::vector<T>& BasicSparseMatrix<T>::Values() const
+{
+	return m_values;
+}
+
+
+/// \brief     Value at (row, col), zero when it is not stored.
+template <typename T>
+T BasicSparseMatrix<T>::GetElemAt(const unsigned int row, const unsigned int col) const
+{
+	if (row >= m_rows || col >= m_cols)
+	{
+		throw std::out_of_range("Out of Range");
+	}
+
+	const unsigned int k = m_order == RowMajor ? row : col;
+	const unsigned int index = m_order == RowMajor ? col : row;
+	const std::vector<unsigned int>::const_iterator begin = m_indices.begin() + m_offsets[k];
+	const std::vector<unsigned int>::const_iterator end = m_indices.begin() + m_offsets[k + 1];
+	const std::vector<unsigned int>::const_iterator it = std::lower_bound(begin, end, index);
+	return it != end && *it == index ? m_values[it - m_indices.begin()] : T(0);
+}
+
+
+template <typename T>
+unsigned int BasicSparseMatrix<T>::OuterSize() const
+{
+	return m_order == RowMajor ? m_rows : m_cols;
+}
+
+
+template <typename T>
+unsigned int BasicSparseMatrix<T>::InnerSize() const
+{
+	return m_order == RowMajor ? m_cols : m_rows;
+}
+
+
+template class numeric::BasicSparseMatrix<float>;
+template class numeric::BasicSparseMatrix<double>;
+template class numeric::BasicSparseMatrix<std::int32_t>;
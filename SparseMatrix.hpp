@@ -0,0 +1,115 @@
+#ifndef Numeric_SparseMatrix_HPP
+#define Numeric_SparseMatrix_HPP
+
+#include <vector>
+#include <stdexcept>
+#include <cstddef>
+#include "Matrix.hpp"
+
+namespace numeric
+{
+	//
+	// Class : Compressed sparse matrix over the element type T, in compressed sparse row (CSR,
+	//         RowMajor) or compressed sparse column (CSC, ColMajor) order. Instantiated for
+	//         float, double and std::int32_t; SparseMatrix is the double version.
+	//
+	// The outer dimension is the rows for RowMajor and the columns for ColMajor. Offsets() has
+	// one entry per outer index plus one; the nonzeros of outer index k are at positions
+	// [Offsets()[k], Offsets()[k + 1]) of Indices(), which holds their inner indices in
+	// increasing order without repeats, and of Values().
+	//
+	// The static Mul and Add follow BasicMatrix: the result must already have the right shape,
+	// otherwise std::invalid_argument("Dimension mismatch") is thrown. Products and sums are
+	// split across the ThreadPool in blocks of about the same number of nonzeros.
+	//
+	template <typename T>
+	class BasicSparseMatrix
+	{
+	public:
+		typedef T ElemType;
+
+		enum StorageOrder
+		{
+			RowMajor,
+			ColMajor
+		};
+
+	public:
+		//
+		// result = lhmat * rhmat for a dense rhmat; with one column this is SpMV.
+		//
+		static void Mul(const BasicSparseMatrix& lhmat, const BasicMatrix<T>& rhmat, BasicMatrix<T>& result);
+
+		//
+		// y = mat * x, with x of Cols() and y of Rows() elements. y must not overlap x.
+		//
+		static void Mul(const BasicSparseMatrix& mat, const ElemType* x, ElemType* y);
+
+		//
+		// result = lhmat + rhmat, in the storage order of result. Entries that cancel to zero
+		// are dropped. result may be either operand.
+		//
+		static void Add(const BasicSparseMatrix& lhmat, const BasicSparseMatrix& rhmat, BasicSparseMatrix& result);
+
+	public:
+		BasicSparseMatrix();
+		BasicSparseMatrix(const unsigned int rows, const unsigned int cols,
+		                  const StorageOrder order = RowMajor);
+		explicit BasicSparseMatrix(const BasicMatrix<T>& mat, const StorageOrder order = RowMajor);
+
+		//
+		// From compressed arrays, which are checked as described above; std::invalid_argument
+		// is thrown if they are not consistent.
+		//
+		BasicSparseMatrix(const unsigned int rows, const unsigned int cols, const StorageOrder order,
+		                  const std::vector<size_t>& offsets,
+		                  const std::vector<unsigned int>& indices,
+		                  const std::vector<ElemType>& values);
+
+		//
+		// Replace the contents with count (row, col, value) triplets in any order. Repeated
+		// positions are summed; a position outside the matrix throws std::out_of_range.
+		//
+		void SetFromTriplets(const size_t count,
+		                     const unsigned int* rows,
+		                     const unsigned int* cols,
+		                     const ElemType* values);
+
+		void ToMatrix(BasicMatrix<T>& mat) const;
+
+		//
+		// Convert between CSR and CSC in place.
+		//
+		void ChangeOrder(const StorageOrder order);
+
+		unsigned int Rows()     const;
+		unsigned int Cols()     const;
+		size_t       NonZeros() const;
+		StorageOrder Order()    const;
+		void         Swap(BasicSparseMatrix& mat);
+
+		const std::vector<size_t>&       Offsets() const;
+		const std::vector<unsigned int>& Indices() const;
+		const std::vector<ElemType>&     Values()  const;
+
+		ElemType GetElemAt(const unsigned int row, const unsigned int col) const;
+
+	private:
+		unsigned int OuterSize() const;
+		unsigned int InnerSize() const;
+
+	private:
+		unsigned int              m_rows;
+		unsigned int              m_cols;
+		StorageOrder              m_order;
+		std::vector<size_t>       m_offsets;
+		std::vector<unsigned int> m_indices;
+		std::vector<ElemType>     m_values;
+	};
+
+	typedef BasicSparseMatrix<float>        SparseMatrixF;
+	typedef BasicSparseMatrix<double>       SparseMatrix;
+	typedef BasicSparseMatrix<std::int32_t> SparseMatrixI;
+}
+
+#endif
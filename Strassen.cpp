@@ -0,0 +1,340 @@
+
+#include "Strassen.hpp"
+#include "Gemm.hpp"
+#include "ElementWise.hpp"
+#include "ThreadPool.hpp"
+#include "Tuning.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of Strassen
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Block additions of at least this many elements are split across the ThreadPool.
+	//
+	const size_t ParallelBlockElements = 1 << 16;
+
+	bool Recurses(const unsigned int m, const unsigned int n, const unsigned int k,
+	              const unsigned int crossover)
+	{
+		return std::min(m, std::min(n, k)) >= std::max(crossover, 2u);
+	}
+
+	/// \brief      z = x + y (subtract: z = x - y) over a rows*cols block, row by row.
+	template <typename T>
+	void AddBlock(const bool subtract, const unsigned int rows, const unsigned int cols,
+	              const T* x, const std::ptrdiff_t ldx,
+	              const T* y, const std::ptrdiff_t ldy,
+	              T* z, const std::ptrdiff_t ldz)
+	{
+		const auto row = [=](size_t i)
+		{
+			if (subtract)
+			{
+				kernel::Sub<T>(cols, x + i * ldx, y + i * ldy, z + i * ldz);
+			}
+			else
+			{
+				kernel::Add<T>(cols, x + i * ldx, y + i * ldy, z + i * ldz);
+			}
+		};
+
+		if (static_cast<size_t>(rows) * cols >= ParallelBlockElements && ThreadPool::NumThreads() > 1)
+		{
+			ThreadPool::Instance().ParallelFor(rows, row);
+		}
+		else
+		{
+			for (unsigned int i = 0; i < rows; i++)
+			{
+				row(i);
+			}
+		}
+	}
+
+	template <typename T>
+	void Add(const unsigned int rows, const unsigned int cols,
+	         const T* x, const std::ptrdiff_t ldx, const T* y, const std::ptrdiff_t ldy,
+	         T* z, const std::ptrdiff_t ldz)
+	{
+		AddBlock(false, rows, cols, x, ldx, y, ldy, z, ldz);
+	}
+
+	template <typename T>
+	void Sub(const unsigned int rows, const unsigned int cols,
+	         const T* x, const std::ptrdiff_t ldx, const T* y, const std::ptrdiff_t ldy,
+	         T* z, const std::ptrdiff_t ldz)
+	{
+		AddBlock(true, rows, cols, x, ldx, y, ldy, z, ldz);
+	}
+
+	/// \brief      One level of Strassen-Winograd on even m, n and k.
+	///
+	///             The schedule keeps the seven products in the four quadrants of C and three
+	///             temporaries, X for an A quadrant, Y for a B quadrant and Z for a C quadrant:
+	///                 S1 = A21 + A22  S2 = S1 - A11  S3 = A11 - A21  S4 = A12 - S2
+	///                 T1 = B12 - B11  T2 = B22 - T1  T3 = B22 - B12  T4 = T2 - B21
+	///                 P1 = A11 B11  P2 = A12 B21  P3 = S4 B22  P4 = A22 T4
+	///                 P5 = S1 T1    P6 = S2 T2    P7 = S3 T3
+	///                 C11 = P1 + P2             C12 = P1 + P6 + P5 + P3
+	///                 C21 = P1 + P6 + P7 - P4   C22 = P1 + P6 + P7 + P5
+	template <typename T>
+	void StrassenLevel(const unsigned int m, const unsigned int n, const unsigned int k,
+	                   const T* a, const std::ptrdiff_t lda,
+	                   const T* b, const std::ptrdiff_t ldb,
+	                   T* c, const std::ptrdiff_t ldc,
+	                   const unsigned int crossover, T* workspace)
+	{
+		const unsigned int hm = m / 2;
+		const unsigned int hn = n / 2;
+		const unsigned int hk = k / 2;
+
+		const T* a11 = a;
+		const T* a12 = a + hk;
+		const T* a21 = a + hm * lda;
+		const T* a22 = a21 + hk;
+		const T* b11 = b;
+		const T* b12 = b + hn;
+		const T* b21 = b + hk * ldb;
+		const T* b22 = b21 + hn;
+		T* c11 = c;
+		T* c12 = c + hn;
+		T* c21 = c + hm * ldc;
+		T* c22 = c21 + hn;
+
+		T* x = workspace;
+		T* y = x + static_cast<size_t>(hm) * hk;
+		T* z = y + static_cast<size_t>(hk) * hn;
+		T* deeper = z + static_cast<size_t>(hm) * hn;
+
+		Sub(hm, hk, a11, lda, a21, lda, x, hk);                                  // X = S3
+		Sub(hk, hn, b22, ldb, b12, ldb, y, hn);                                  // Y = T3
+		kernel::StrassenGemm(hm, hn, hk, x, hk, y, hn, c21, ldc, crossover, deeper);  // C21 = P7
+		Add(hm, hk, a21, lda, a22, lda, x, hk);                                  // X = S1
+		Sub(hk, hn, b12, ldb, b11, ldb, y, hn);                                  // Y = T1
+		kernel::StrassenGemm(hm, hn, hk, x, hk, y, hn, c22, ldc, crossover, deeper);  // C22 = P5
+		Sub(hm, hk, x, hk, a11, lda, x, hk);                                     // X = S2
+		Sub(hk, hn, b22, ldb, y, hn, y, hn);                                     // Y = T2
+		kernel::StrassenGemm(hm, hn, hk, x, hk, y, hn, c12, ldc, crossover, deeper);  // C12 = P6
+		Sub(hm, hk, a12, lda, x, hk, x, hk);                                     // X = S4
+		kernel::StrassenGemm(hm, hn, hk, x, hk, b22, ldb, c11, ldc, crossover, deeper); // C11 = P3
+		kernel::StrassenGemm(hm, hn, hk, a11, lda, b11, ldb, z, hn, crossover, deeper); // Z = P1
+		Add(hm, hn, z, hn, c12, ldc, c12, ldc);                                  // C12 = P1 + P6
+		Add(hm, hn, c12, ldc, c21, ldc, c21, ldc);                               // C21 += C12
+		Add(hm, hn, c12, ldc, c22, ldc, c12, ldc);                               // C12 += P5
+		Add(hm, hn, c21, ldc, c22, ldc, c22, ldc);                               // C22 = C21 + P5
+		Add(hm, hn, c12, ldc, c11, ldc, c12, ldc);                               // C12 += P3
+		Sub(hk, hn, y, hn, b21, ldb, y, hn);                                     // Y = T4
+		kernel::StrassenGemm(hm, hn, hk, a22, lda, y, hn, c11, ldc, crossover, deeper); // C11 = P4
+		Sub(hm, hn, c21, ldc, c11, ldc, c21, ldc);                               // C21 -= P4
+		kernel::StrassenGemm(hm, hn, hk, a12, lda, b21, ldb, c11, ldc, crossover, deeper); // C11 = P2
+		Add(hm, hn, z, hn, c11, ldc, c11, ldc);                                  // C11 += P1
+	}
+
+	/// \brief      Frobenius norm in long double.
+	template <typename T>
+	long double Norm(const std::vector<T>& x)
+	{
+		long double sum = 0;
+		for (size_t i = 0; i < x.size(); i++)
+		{
+			sum += static_cast<long double>(x[i]) * x[i];
+		}
+		return std::sqrt(sum);
+	}
+
+	/// \brief      y = M x for a size*size row-major M, in long double.
+	template <typename T, typename V>
+	std::vector<long double> MulVector(const unsigned int size, const std::vector<T>& mat,
+	                                   const std::vector<V>& x)
+	{
+		std::vector<long double> y(size);
+		for (unsigned int i = 0; i < size; i++)
+		{
+			long double sum = 0;
+			const T* row = &mat[static_cast<size_t>(i) * size];
+			for (unsigned int j = 0; j < size; j++)
+			{
+				sum += static_cast<long double>(row[j]) * x[j];
+			}
+			y[i] = sum;
+		}
+		return y;
+	}
+
+	long double Distance(const std::vector<long double>& x, const std::vector<long double>& y)
+	{
+		long double sum = 0;
+		for (size_t i = 0; i < x.size(); i++)
+		{
+			sum += (x[i] - y[i]) * (x[i] - y[i]);
+		}
+		return std::sqrt(sum);
+	}
+}
+
+
+/// \brief      Workspace needed by StrassenGemm: three half-size temporaries per level.
+size_t numeric::kernel::StrassenWorkspaceSize(const unsigned int m, const unsigned int n,
+                                              const unsigned int k, const unsigned int crossover)
+{
+	if (!Recurses(m, n, k, crossover))
+	{
+		return 0;
+	}
+	const size_t hm = m / 2;
+	const size_t hn = n / 2;
+	const size_t hk = k / 2;
+	return hm * hk + hk * hn + hm * hn +
+	       StrassenWorkspaceSize(static_cast<unsigned int>(hm), static_cast<unsigned int>(hn),
+	                             static_cast<unsigned int>(hk), crossover);
+}
+
+
+unsigned int numeric::kernel::StrassenLevels(const unsigned int m, const unsigned int n,
+                                             const unsigned int k, const unsigned int crossover)
+{
+	unsigned int levels = 0;
+	for (unsigned int hm = m, hn = n, hk = k; Recurses(hm, hn, hk, crossover); hm /= 2, hn /= 2, hk /= 2)
+	{
+		levels++;
+	}
+	return levels;
+}
+
+
+unsigned int numeric::kernel::StrassenCrossover()
+{
+	return kernel::Tuning().strassenCrossover;
+}
+
+
+void numeric::kernel::SetStrassenCrossover(const unsigned int crossover)
+{
+	kernel::TuningParameters tuning = kernel::Tuning();
+	tuning.strassenCrossover = crossover;
+	kernel::SetTuning(tuning);
+}
+
+
+/// \brief      C = A * B by Strassen-Winograd with peeling of odd dimensions.
+template <typename T>
+void numeric::kernel::StrassenGemm(const unsigned int m,
+                                   const unsigned int n,
+                                   const unsigned int k,
+                                   const T* a, const std::ptrdiff_t lda,
+                                   const T* b, const std::ptrdiff_t ldb,
+                                   T* c, const std::ptrdiff_t ldc,
+                                   const unsigned int crossover,
+                                   T* workspace)
+{
+	if (!Recurses(m, n, k, crossover))
+	{
+		kernel::Gemm<T>(m, n, k, T(1), a, lda, 1, b, ldb, 1, T(0), c, ldc, 1);
+		return;
+	}
+
+	const unsigned int m2 = m & ~1u;
+	const unsigned int n2 = n & ~1u;
+	const unsigned int k2 = k & ~1u;
+	StrassenLevel(m2, n2, k2, a, lda, b, ldb, c, ldc, crossover, workspace);
+
+	//
+	// Peel the odd row, column and inner index:
+	//      C[0:m2, 0:n2] += A[0:m2, k-1] * B[k-1, 0:n2]
+	//      C[0:m, n-1]    = A[0:m, :] * B[:, n-1]
+	//      C[m-1, 0:n2]   = A[m-1, :] * B[:, 0:n2]
+	//
+	if (k2 != k)
+	{
+		kernel::Gemm<T>(m2, n2, 1, T(1), a + k2, lda, 1, b + k2 * ldb, ldb, 1, T(1), c, ldc, 1);
+	}
+	if (n2 != n)
+	{
+		kernel::Gemm<T>(m, 1, k, T(1), a, lda, 1, b + n2, ldb, 1, T(0), c + n2, ldc, 1);
+	}
+	if (m2 != m)
+	{
+		kernel::Gemm<T>(1, n2, k, T(1), a + m2 * lda, lda, 1, b, ldb, 1, T(0), c + m2 * ldc, ldc, 1);
+	}
+}
+
+
+/// \brief      Compare StrassenGemm and Gemm with the exact product along a random vector.
+/// \param[in]  size. Order of the square product.
+/// \param[in]  crossover. Crossover for StrassenGemm.
+/// \param[in]  seed. Seed of the random operands.
+template <typename T>
+StrassenAccuracy numeric::MeasureStrassenAccuracy(const unsigned int size, const unsigned int crossover,
+                                                  const unsigned int seed)
+{
+	const size_t elems = static_cast<size_t>(size) * size;
+	std::mt19937 engine(seed);
+	std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+
+	std::vector<T> a(elems);
+	std::vector<T> b(elems);
+	std::vector<double> x(size);
+	for (size_t i = 0; i < elems; i++)
+	{
+		a[i] = static_cast<T>(uniform(engine));
+		b[i] = static_cast<T>(uniform(engine));
+	}
+	for (unsigned int i = 0; i < size; i++)
+	{
+		x[i] = uniform(engine);
+	}
+
+	std::vector<T> strassen(elems);
+	std::vector<T> classical(elems);
+	std::vector<T> workspace(kernel::StrassenWorkspaceSize(size, size, size, crossover));
+	kernel::StrassenGemm<T>(size, size, size, &a[0], size, &b[0], size, &strassen[0], size,
+	                        crossover, workspace.empty() ? NULL : &workspace[0]);
+	kernel::Gemm<T>(size, size, size, T(1), &a[0], size, 1, &b[0], size, 1,
+	                T(0), &classical[0], size, 1);
+
+	const std::vector<long double> exact = MulVector(size, a, MulVector(size, b, x));
+	const long double scale = Norm(a) * Norm(b) * Norm(x);
+
+	StrassenAccuracy accuracy;
+	accuracy.size = size;
+	accuracy.crossover = crossover;
+	accuracy.levels = kernel::StrassenLevels(size, size, size, crossover);
+	accuracy.strassenError = static_cast<double>(Distance(MulVector(size, strassen, x), exact) / scale);
+	accuracy.classicalError = static_cast<double>(Distance(MulVector(size, classical, x), exact) / scale);
+	accuracy.maxDifference = 0;
+	for (size_t i = 0; i < elems; i++)
+	{
+		const double difference = std::fabs(static_cast<double>(strassen[i]) - classical[i]);
+		accuracy.maxDifference = std::max(accuracy.maxDifference, difference);
+	}
+	return accuracy;
+}
+
+
+#define NUMERIC_INSTANTIATE_STRASSEN(T)                                                         \
+	template void numeric::kernel::StrassenGemm<T>(const unsigned int, const unsigned int,       \
+	                                               const unsigned int,                          \
+	                                               const T*, const std::ptrdiff_t,              \
+	                                               const T*, const std::ptrdiff_t,              \
+	                                               T*, const std::ptrdiff_t,                    \
+	                                               const unsigned int, T*);
+
+NUMERIC_INSTANTIATE_STRASSEN(float)
+NUMERIC_INSTANTIATE_STRASSEN(double)
+NUMERIC_INSTANTIATE_STRASSEN(std::int32_t)
+
+#undef NUMERIC_INSTANTIATE_STRASSEN
+
+template StrassenAccuracy numeric::MeasureStrassenAccuracy<float>(const unsigned int, const unsigned int,
+                                                                  const unsigned int);
+template StrassenAccuracy numeric::MeasureStrassenAccuracy<double>(const unsigned int, const unsigned int,
+                                                                   const unsigned int);
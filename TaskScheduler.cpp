@@ -0,0 +1,373 @@
+
+#include "TaskScheduler.hpp"
+#include "ThreadPool.hpp"
+#include <stdexcept>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of Task
+///////////////////////////////////////////////////////////////////////////////////////////////////
+Task::Task(const std::function<void()>& work)
+	: m_work(work),
+	  m_pending(1),
+	  m_done(false),
+	  m_closed(false)
+{
+}
+
+
+/// \brief      Order this task after predecessor.
+/// \param[in]  predecessor. A task that has been or will be submitted.
+void Task::After(Task& predecessor)
+{
+	m_pending++;
+	{
+		std::lock_guard<std::mutex> lock(predecessor.m_mutex);
+		if (!predecessor.m_closed)
+		{
+			predecessor.m_successors.push_back(this);
+			return;
+		}
+	}
+	//
+	// The predecessor has already finished.
+	//
+	m_pending--;
+}
+
+
+bool Task::IsDone() const
+{
+	return m_done;
+}
+
+
+std::exception_ptr Task::Error() const
+{
+	return m_done ? m_error : std::exception_ptr();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of TaskScheduler
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// The index of the worker deque owned by the current thread, or -1 off the workers.
+	//
+	thread_local int t_workerIndex = -1;
+}
+
+
+/// \brief  Return the process-wide scheduler, creating it on first use.
+TaskScheduler& TaskScheduler::Instance()
+{
+	static TaskScheduler scheduler;
+	return scheduler;
+}
+
+
+/// \brief     Change the number of threads that run tasks.
+/// \param[in] numThreads. Total thread count including a waiting thread. Zero restores the
+///            ThreadPool size.
+void TaskScheduler::SetNumThreads(const unsigned int numThreads)
+{
+	Instance().Resize(numThreads > 0 ? numThreads : ThreadPool::NumThreads());
+}
+
+
+unsigned int TaskScheduler::NumThreads()
+{
+	return Instance().m_numThreads;
+}
+
+
+TaskScheduler::TaskScheduler()
+	: m_numThreads(1),
+	  m_queued(0),
+	  m_waiting(0),
+	  m_stop(false)
+{
+	Resize(ThreadPool::NumThreads());
+}
+
+
+TaskScheduler::~TaskScheduler()
+{
+	StopWorkers();
+}
+
+
+/// \brief      Release a task's guard reference and queue it when nothing else holds it back.
+/// \param[in]  task. The task.
+void TaskScheduler::Submit(Task& task)
+{
+	if (--task.m_pending == 0)
+	{
+		Enqueue(&task);
+	}
+}
+
+
+/// \brief      Help with the queued work until done() holds.
+/// \param[in]  done. Condition to wait for.
+void TaskScheduler::RunUntil(const std::function<bool()>& done)
+{
+	const int self = t_workerIndex;
+	while (!done())
+	{
+		Task* task = FindTask(self);
+		if (task != NULL)
+		{
+			Execute(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_queued > 0 || done())
+		{
+			continue;
+		}
+		if (m_stop && self >= 0)
+		{
+			//
+			// The workers are being joined and this one waits inside a task. Sleeping would
+			// leave StopWorkers waiting for it forever, so the task fails instead.
+			//
+			throw std::runtime_error("The task scheduler stopped while a task was waiting");
+		}
+		m_waiting++;
+		m_wake.wait(lock);
+		m_waiting--;
+	}
+}
+
+
+void TaskScheduler::Resize(const unsigned int numThreads)
+{
+	if (t_workerIndex >= 0)
+	{
+		throw std::runtime_error("The task scheduler cannot be resized from one of its tasks");
+	}
+	std::lock_guard<std::mutex> resizeLock(m_resizeMutex);
+	if (numThreads == m_numThreads && m_workers.size() + 1 == numThreads)
+	{
+		return;
+	}
+	StopWorkers();
+
+	//
+	// Tasks left on the old worker deques are handed to whoever runs next.
+	//
+	{
+		std::lock_guard<std::mutex> lock(m_shared.mutex);
+		for (size_t i = 0; i < m_queues.size(); i++)
+		{
+			m_shared.tasks.insert(m_shared.tasks.end(), m_queues[i]->tasks.begin(), m_queues[i]->tasks.end());
+		}
+	}
+	m_queues.clear();
+
+	StartWorkers(numThreads - 1);
+	m_numThreads = numThreads;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+	}
+	m_wake.notify_all();
+}
+
+
+void TaskScheduler::StartWorkers(const unsigned int numWorkers)
+{
+	m_stop = false;
+	for (unsigned int i = 0; i < numWorkers; i++)
+	{
+		m_queues.push_back(std::unique_ptr<Queue>(new Queue));
+	}
+	for (unsigned int i = 0; i < numWorkers; i++)
+	{
+		m_workers.push_back(std::thread(&TaskScheduler::WorkerLoop, this, static_cast<int>(i)));
+	}
+}
+
+
+void TaskScheduler::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+}
+
+
+void TaskScheduler::WorkerLoop(const int self)
+{
+	t_workerIndex = self;
+	ThreadPool::SerialRegion serial;
+
+	while (true)
+	{
+		Task* task = FindTask(self);
+		if (task != NULL)
+		{
+			Execute(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_stop)
+		{
+			return;
+		}
+		if (m_queued > 0)
+		{
+			continue;
+		}
+		m_wake.wait(lock);
+	}
+}
+
+
+/// \brief      Queue a ready task: on the current worker's own deque, or on the shared queue
+///             when called from any other thread.
+void TaskScheduler::Enqueue(Task* task)
+{
+	const int self = t_workerIndex;
+	Queue& queue = self >= 0 ? *m_queues[self] : m_shared;
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(task);
+	}
+	m_queued++;
+
+	//
+	// Taking the lock orders the count above before any waiter's check of it.
+	//
+	bool waiters = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		waiters = m_waiting > 0;
+	}
+	if (waiters)
+	{
+		m_wake.notify_all();
+	}
+	else
+	{
+		m_wake.notify_one();
+	}
+}
+
+
+/// \brief      Take the next task for the thread with deque self (-1 for none): the newest
+///             task of its own deque, else the oldest shared one, else the oldest task of
+///             another deque.
+Task* TaskScheduler::FindTask(const int self)
+{
+	Task* task = NULL;
+	if (self >= 0 && (task = PopBack(*m_queues[self])) != NULL)
+	{
+		return task;
+	}
+	if ((task = PopFront(m_shared)) != NULL)
+	{
+		return task;
+	}
+
+	std::unique_lock<std::mutex> resizeLock(m_resizeMutex, std::defer_lock);
+	if (self < 0)
+	{
+		resizeLock.lock();
+	}
+	const size_t numQueues = m_queues.size();
+	const size_t start = self >= 0 ? static_cast<size_t>(self) + 1 : 0;
+	for (size_t i = 0; i < numQueues; i++)
+	{
+		const size_t victim = (start + i) % numQueues;
+		if (static_cast<int>(victim) != self && (task = PopFront(*m_queues[victim])) != NULL)
+		{
+			return task;
+		}
+	}
+	return NULL;
+}
+
+
+Task* TaskScheduler::PopFront(Queue& queue)
+{
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tasks.empty())
+	{
+		return NULL;
+	}
+	Task* task = queue.tasks.front();
+	queue.tasks.pop_front();
+	m_queued--;
+	return task;
+}
+
+
+Task* TaskScheduler::PopBack(Queue& queue)
+{
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tasks.empty())
+	{
+		return NULL;
+	}
+	Task* task = queue.tasks.back();
+	queue.tasks.pop_back();
+	m_queued--;
+	return task;
+}
+
+
+/// \brief      Run a task, release its successors and wake the threads waiting in RunUntil.
+void TaskScheduler::Execute(Task* task)
+{
+	ThreadPool::SerialRegion serial;
+
+	//
+	// The work is moved out first and destroyed last: it may hold the only reference to the
+	// object that owns the task, which is not touched again once it is marked done.
+	//
+	std::function<void()> work;
+	work.swap(task->m_work);
+	try
+	{
+		work();
+	}
+	catch (...)
+	{
+		task->m_error = std::current_exception();
+	}
+
+	std::vector<Task*> successors;
+	{
+		std::lock_guard<std::mutex> lock(task->m_mutex);
+		task->m_closed = true;
+		successors.swap(task->m_successors);
+	}
+	for (size_t i = 0; i < successors.size(); i++)
+	{
+		Submit(*successors[i]);
+	}
+	task->m_done = true;
+
+	bool waiters = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		waiters = m_waiting > 0;
+	}
+	if (waiters)
+	{
+		m_wake.notify_all();
+	}
+}
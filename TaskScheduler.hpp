@@ -0,0 +1,141 @@
+#ifndef Numeric_TaskScheduler_HPP
+#define Numeric_TaskScheduler_HPP
+
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace numeric
+{
+	//
+	// Class : A node of a task graph run by the TaskScheduler.
+	//
+	// A submitted task runs once every task it was ordered After has finished. A task whose
+	// work throws still counts as finished, and the exception is kept in Error(). The work is
+	// released as soon as it has run, so a task may be owned by an object its work holds on
+	// to. A submitted task must stay alive until it has run.
+	//
+	class Task
+	{
+	public:
+		explicit Task(const std::function<void()>& work);
+
+		//
+		// Run this task only after predecessor has finished. Must be called before Submit.
+		//
+		void After(Task& predecessor);
+
+		bool               IsDone() const;
+		std::exception_ptr Error()  const;
+
+	private:
+		Task(const Task&);
+		Task& operator=(const Task&);
+
+		friend class TaskScheduler;
+
+	private:
+		std::function<void()> m_work;
+		std::atomic<int>      m_pending;
+		std::atomic<bool>     m_done;
+		std::mutex            m_mutex;
+		bool                  m_closed;
+		std::vector<Task*>    m_successors;
+		std::exception_ptr    m_error;
+	};
+
+
+	//
+	// Class : The library-owned work-stealing scheduler that runs task graphs.
+	//
+	// Every worker keeps a deque of ready tasks. A worker pushes the tasks its own work makes
+	// ready onto the back of its deque and pops from the back, so dependent work tends to stay
+	// on the core whose cache holds its inputs. An idle worker takes tasks submitted from
+	// other threads, then steals from the front of the other deques. Tasks run with
+	// ThreadPool::SerialRegion, so the kernels inside them do not fan out again.
+	//
+	// The thread count follows the conventions of ThreadPool and starts at the ThreadPool
+	// size: it includes a thread that waits in RunUntil, which runs tasks while it waits, so a
+	// scheduler of one thread runs everything on the waiting thread.
+	//
+	class TaskScheduler
+	{
+	public:
+		static TaskScheduler& Instance();
+
+		//
+		// Restart the workers with a new thread count. Throws std::runtime_error when called
+		// from a task, whose worker would have to join itself. A task that is waiting in
+		// RunUntil on a worker when the workers stop fails with std::runtime_error.
+		//
+		static void         SetNumThreads(const unsigned int numThreads);
+		static unsigned int NumThreads();
+
+	public:
+		~TaskScheduler();
+
+		//
+		// Queue task to run once its predecessors have finished.
+		//
+		void Submit(Task& task);
+
+		//
+		// Run tasks on the calling thread until done() returns true. done is checked again
+		// every time a task finishes.
+		//
+		void RunUntil(const std::function<bool()>& done);
+
+	private:
+		struct Queue
+		{
+			std::mutex        mutex;
+			std::deque<Task*> tasks;
+		};
+
+	private:
+		TaskScheduler();
+		TaskScheduler(const TaskScheduler&);
+		TaskScheduler& operator=(const TaskScheduler&);
+
+		void  Resize(const unsigned int numThreads);
+		void  StartWorkers(const unsigned int numWorkers);
+		void  StopWorkers();
+		void  WorkerLoop(const int self);
+		void  Enqueue(Task* task);
+		Task* FindTask(const int self);
+		Task* PopFront(Queue& queue);
+		Task* PopBack(Queue& queue);
+		void  Execute(Task* task);
+
+	private:
+		std::vector<std::thread>            m_workers;
+		std::vector<std::unique_ptr<Queue>> m_queues;
+		Queue                               m_shared;
+
+		//
+		// Written under m_resizeMutex by Resize; NumThreads reads it from any thread.
+		//
+		std::atomic<unsigned int>           m_numThreads;
+
+		//
+		// Held while the workers and their queues are replaced, and by threads outside the
+		// pool while they steal from the worker queues.
+		//
+		std::mutex m_resizeMutex;
+
+		std::mutex              m_mutex;
+		std::condition_variable m_wake;
+		std::atomic<long>       m_queued;
+		unsigned int            m_waiting;
+		bool                    m_stop;
+	};
+}
+
+#endif
@@ -0,0 +1,243 @@
+
+#include "ThreadPool.hpp"
+#include <cstdlib>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of ThreadPool
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Set on pool workers and on a thread while it is inside ParallelFor, so that nested
+	// parallel regions run inline instead of waiting on workers that are already busy.
+	//
+	thread_local bool t_inParallelRegion = false;
+
+	unsigned int DefaultNumThreads()
+	{
+		const char* env = std::getenv("NUMERIC_NUM_THREADS");
+		if (env != NULL)
+		{
+			const long requested = std::strtol(env, NULL, 10);
+			if (requested > 0)
+			{
+				return static_cast<unsigned int>(requested);
+			}
+		}
+
+		const unsigned int hardware = std::thread::hardware_concurrency();
+		return hardware > 0 ? hardware : 1;
+	}
+}
+
+
+/// \brief  Return the process-wide pool, creating it on first use.
+ThreadPool& ThreadPool::Instance()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+
+/// \brief     Change the number of threads used by parallel kernels.
+/// \param[in] numThreads. Total thread count including the caller. Zero restores the default.
+void ThreadPool::SetNumThreads(const unsigned int numThreads)
+{
+	Instance().Resize(numThreads > 0 ? numThreads : DefaultNumThreads());
+}
+
+
+/// \brief  Return the number of threads used by parallel kernels, including the caller.
+unsigned int ThreadPool::NumThreads()
+{
+	return Instance().m_numThreads;
+}
+
+
+ThreadPool::SerialRegion::SerialRegion()
+	: m_previous(t_inParallelRegion)
+{
+	t_inParallelRegion = true;
+}
+
+
+ThreadPool::SerialRegion::~SerialRegion()
+{
+	t_inParallelRegion = m_previous;
+}
+
+
+ThreadPool::ThreadPool()
+	: m_numThreads(1),
+	  m_generation(0),
+	  m_active(0),
+	  m_stop(false),
+	  m_body(NULL),
+	  m_count(0),
+	  m_next(0)
+{
+	Resize(DefaultNumThreads());
+}
+
+
+ThreadPool::~ThreadPool()
+{
+	StopWorkers();
+}
+
+
+/// \brief       Run body(i) for i in [0, count) on the pool and the calling thread.
+/// \param[in]   count. Number of iterations.
+/// \param[in]   body. Work for one iteration.
+void ThreadPool::ParallelFor(const size_t count, const std::function<void(size_t)>& body)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (count == 1 || m_workers.empty() || t_inParallelRegion)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			body(i);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> submitLock(m_submitMutex);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_body = &body;
+		m_count = count;
+		m_next = 0;
+		m_error = std::exception_ptr();
+		m_active = static_cast<unsigned int>(m_workers.size());
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	t_inParallelRegion = true;
+	RunIterations();
+	t_inParallelRegion = false;
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (m_active > 0)
+		{
+			m_done.wait(lock);
+		}
+		m_body = NULL;
+		error = m_error;
+	}
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+
+void ThreadPool::Resize(const unsigned int numThreads)
+{
+	std::lock_guard<std::mutex> submitLock(m_submitMutex);
+	if (numThreads == m_numThreads && m_workers.size() + 1 == numThreads)
+	{
+		return;
+	}
+	StopWorkers();
+	StartWorkers(numThreads - 1);
+	m_numThreads = numThreads;
+}
+
+
+void ThreadPool::StartWorkers(const unsigned int numWorkers)
+{
+	m_stop = false;
+	for (unsigned int i = 0; i < numWorkers; i++)
+	{
+		//
+		// Workers start from the current generation, so a job submitted before a new worker
+		// first takes the lock is still picked up by it.
+		//
+		m_workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, m_generation));
+	}
+}
+
+
+void ThreadPool::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+}
+
+
+void ThreadPool::WorkerLoop(unsigned long seen)
+{
+	t_inParallelRegion = true;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		while (!m_stop && m_generation == seen)
+		{
+			m_wake.wait(lock);
+		}
+		if (m_stop)
+		{
+			return;
+		}
+		seen = m_generation;
+
+		lock.unlock();
+		RunIterations();
+		lock.lock();
+
+		if (--m_active == 0)
+		{
+			m_done.notify_all();
+		}
+	}
+}
+
+
+/// \brief  Claim and run iterations of the current job until none are left.
+void ThreadPool::RunIterations()
+{
+	while (true)
+	{
+		const size_t i = m_next.fetch_add(1);
+		if (i >= m_count)
+		{
+			return;
+		}
+
+		try
+		{
+			(*m_body)(i);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_error)
+			{
+				m_error = std::current_exception();
+			}
+			//
+			// Skip the remaining iterations.
+			//
+			m_next = m_count;
+		}
+	}
+}
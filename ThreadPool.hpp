@@ -0,0 +1,95 @@
+#ifndef Numeric_ThreadPool_HPP
+#define Numeric_ThreadPool_HPP
+
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace numeric
+{
+	//
+	// Class : The library-owned pool of worker threads used by the parallel kernels.
+	//
+	// The pool is created on first use. Its size is taken from the environment variable
+	// NUMERIC_NUM_THREADS when set, otherwise from the number of hardware threads, and can be
+	// changed at any time with SetNumThreads. The thread count includes the calling thread,
+	// which always takes part in the work, so a pool of one thread runs everything inline.
+	//
+	class ThreadPool
+	{
+	public:
+		static ThreadPool& Instance();
+
+		static void         SetNumThreads(const unsigned int numThreads);
+		static unsigned int NumThreads();
+
+		//
+		// Class : While one is alive, ParallelFor calls made on the thread that created it run
+		//      inline, as they do inside a parallel region. Threads outside the pool that run
+		//      kernels side by side, such as TaskScheduler workers, use it so that they do not
+		//      queue up behind each other on the pool.
+		//
+		class SerialRegion
+		{
+		public:
+			SerialRegion();
+			~SerialRegion();
+
+		private:
+			SerialRegion(const SerialRegion&);
+			SerialRegion& operator=(const SerialRegion&);
+
+			bool m_previous;
+		};
+
+	public:
+		~ThreadPool();
+
+		//
+		// Run body(i) for every i in [0, count) and return when all calls have finished.
+		// Iterations are handed out dynamically. Calls made from inside a running body are
+		// executed serially on the calling thread. The first exception thrown by body is
+		// rethrown to the caller once every worker has stopped.
+		//
+		void ParallelFor(const size_t count, const std::function<void(size_t)>& body);
+
+	private:
+		ThreadPool();
+		ThreadPool(const ThreadPool&);
+		ThreadPool& operator=(const ThreadPool&);
+
+		void Resize(const unsigned int numThreads);
+		void StartWorkers(const unsigned int numWorkers);
+		void StopWorkers();
+		void WorkerLoop(unsigned long seen);
+		void RunIterations();
+
+	private:
+		std::vector<std::thread> m_workers;
+
+		//
+		// Written under m_submitMutex by Resize; NumThreads reads it from any thread.
+		//
+		std::atomic<unsigned int> m_numThreads;
+
+		std::mutex              m_submitMutex;
+		std::mutex              m_mutex;
+		std::condition_variable m_wake;
+		std::condition_variable m_done;
+		unsigned long           m_generation;
+		unsigned int            m_active;
+		bool                    m_stop;
+
+		const std::function<void(size_t)>* m_body;
+		size_t                             m_count;
+		std::atomic<size_t>                m_next;
+		std::exception_ptr                 m_error;
+	};
+}
+
+#endif
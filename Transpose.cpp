@@ -0,0 +1,177 @@
+
+#include "Transpose.hpp"
+#include "ThreadPool.hpp"
+#include "Tuning.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of Transpose
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Parallel transposes are split into bands of at least this many rows or columns.
+	//
+	const unsigned int MinBandEdge = 64;
+
+	template <typename T>
+	void TransposeBlock(const unsigned int baseEdge, const unsigned int rows, const unsigned int cols,
+	                    const T* src, const std::ptrdiff_t lds,
+	                    T* dst, const std::ptrdiff_t ldd)
+	{
+		if (rows <= baseEdge && cols <= baseEdge)
+		{
+			for (unsigned int i = 0; i < rows; i++)
+			{
+				const T* srcRow = src + i * lds;
+				for (unsigned int j = 0; j < cols; j++)
+				{
+					dst[j * ldd + i] = srcRow[j];
+				}
+			}
+			return;
+		}
+
+		if (rows >= cols)
+		{
+			const unsigned int half = rows / 2;
+			TransposeBlock(baseEdge, half, cols, src, lds, dst, ldd);
+			TransposeBlock(baseEdge, rows - half, cols, src + half * lds, lds, dst + half, ldd);
+		}
+		else
+		{
+			const unsigned int half = cols / 2;
+			TransposeBlock(baseEdge, rows, half, src, lds, dst, ldd);
+			TransposeBlock(baseEdge, rows, cols - half, src + half, lds, dst + half * ldd, ldd);
+		}
+	}
+
+	/// \brief      Exchange the rows*cols block a with the transpose of the cols*rows block b.
+	///             The blocks must not overlap.
+	template <typename T>
+	void SwapTransposed(const unsigned int baseEdge, const unsigned int rows, const unsigned int cols,
+	                    T* a, T* b, const std::ptrdiff_t ld)
+	{
+		if (rows <= baseEdge && cols <= baseEdge)
+		{
+			for (unsigned int i = 0; i < rows; i++)
+			{
+				T* aRow = a + i * ld;
+				for (unsigned int j = 0; j < cols; j++)
+				{
+					std::swap(aRow[j], b[j * ld + i]);
+				}
+			}
+			return;
+		}
+
+		if (rows >= cols)
+		{
+			const unsigned int half = rows / 2;
+			SwapTransposed(baseEdge, half, cols, a, b, ld);
+			SwapTransposed(baseEdge, rows - half, cols, a + half * ld, b + half, ld);
+		}
+		else
+		{
+			const unsigned int half = cols / 2;
+			SwapTransposed(baseEdge, rows, half, a, b, ld);
+			SwapTransposed(baseEdge, rows, cols - half, a + half, b + half * ld, ld);
+		}
+	}
+
+	template <typename T>
+	void TransposeSquare(const unsigned int baseEdge, const unsigned int n, T* a, const std::ptrdiff_t lda)
+	{
+		if (n <= baseEdge)
+		{
+			for (unsigned int i = 1; i < n; i++)
+			{
+				for (unsigned int j = 0; j < i; j++)
+				{
+					std::swap(a[i * lda + j], a[j * lda + i]);
+				}
+			}
+			return;
+		}
+
+		const unsigned int half = n / 2;
+		TransposeSquare(baseEdge, half, a, lda);
+		TransposeSquare(baseEdge, n - half, a + half * lda + half, lda);
+		SwapTransposed(baseEdge, half, n - half, a + half, a + half * lda, lda);
+	}
+}
+
+
+/// \brief      dst = src^T.
+/// \param[in]  rows, cols. Shape of src.
+/// \param[in]  src, lds. Source block and its leading dimension.
+/// \param[out] dst, ldd. Destination block and its leading dimension.
+template <typename T>
+void numeric::kernel::Transpose(const unsigned int rows, const unsigned int cols,
+                                const T* src, const std::ptrdiff_t lds,
+                                T* dst, const std::ptrdiff_t ldd)
+{
+	//
+	// Recursion stops at blocks no longer than baseEdge on either side. The default 8*8 block
+	// touches at most eight cache lines of each operand, which an 8-way L1 holds even when a
+	// power-of-two leading dimension maps all of them to the same set.
+	//
+	const kernel::TuningParameters tuning = kernel::Tuning();
+	const unsigned int baseEdge = tuning.transposeBaseEdge;
+	const unsigned int numThreads = ThreadPool::NumThreads();
+	if (numThreads <= 1 || static_cast<size_t>(rows) * cols < tuning.transposeParallelElements)
+	{
+		TransposeBlock(baseEdge, rows, cols, src, lds, dst, ldd);
+		return;
+	}
+
+	//
+	// Bands run along the longer side, each a whole number of base blocks.
+	//
+	const bool byRows = rows >= cols;
+	const unsigned int edge = byRows ? rows : cols;
+	unsigned int band = std::max(MinBandEdge, (edge + 4 * numThreads - 1) / (4 * numThreads));
+	band = (band + baseEdge - 1) / baseEdge * baseEdge;
+	const size_t numBands = (edge + band - 1) / band;
+
+	ThreadPool::Instance().ParallelFor(numBands, [=](size_t b)
+	{
+		const unsigned int begin = static_cast<unsigned int>(b) * band;
+		const unsigned int count = std::min(band, edge - begin);
+		if (byRows)
+		{
+			TransposeBlock(baseEdge, count, cols, src + begin * lds, lds, dst + begin, ldd);
+		}
+		else
+		{
+			TransposeBlock(baseEdge, rows, count, src + begin, lds, dst + begin * ldd, ldd);
+		}
+	});
+}
+
+
+/// \brief          a = a^T for a square block.
+/// \param[in]      n. Order of a.
+/// \param[in,out]  a, lda. The block and its leading dimension.
+template <typename T>
+void numeric::kernel::TransposeInPlace(const unsigned int n, T* a, const std::ptrdiff_t lda)
+{
+	TransposeSquare(kernel::Tuning().transposeBaseEdge, n, a, lda);
+}
+
+
+#define NUMERIC_INSTANTIATE_TRANSPOSE(T)                                                          \
+	template void numeric::kernel::Transpose<T>(const unsigned int, const unsigned int,           \
+	                                            const T*, const std::ptrdiff_t,                   \
+	                                            T*, const std::ptrdiff_t);                        \
+	template void numeric::kernel::TransposeInPlace<T>(const unsigned int, T*, const std::ptrdiff_t);
+
+NUMERIC_INSTANTIATE_TRANSPOSE(float)
+NUMERIC_INSTANTIATE_TRANSPOSE(double)
+NUMERIC_INSTANTIATE_TRANSPOSE(std::int32_t)
+
+#undef NUMERIC_INSTANTIATE_TRANSPOSE
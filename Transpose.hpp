@@ -0,0 +1,37 @@
+#ifndef Numeric_Transpose_HPP
+#define Numeric_Transpose_HPP
+
+#include <cstddef>
+
+namespace numeric
+{
+	namespace kernel
+	{
+		//
+		// Function : Out-of-place transpose, dst = src^T, of a rows*cols row-major block with
+		//      leading dimension lds into a cols*rows block with leading dimension ldd.
+		//
+		//      The block is halved along its longer side until the pieces fit in cache, so
+		//      both the reads and the writes stay local at every cache level without tuning
+		//      for any of them. Large blocks are split into bands across the ThreadPool. The
+		//      edge of the smallest blocks and the size split across threads come from
+		//      TuningParameters.
+		//
+		// Note: dst must not overlap src. Instantiated for float, double and std::int32_t.
+		//
+		template <typename T>
+		void Transpose(const unsigned int rows, const unsigned int cols,
+		               const T* src, const std::ptrdiff_t lds,
+		               T* dst, const std::ptrdiff_t ldd);
+
+		//
+		// Function : In-place transpose of an n*n row-major block with leading dimension lda.
+		//      The diagonal blocks are transposed recursively and each pair of off-diagonal
+		//      blocks is swapped with the same cache-oblivious recursion.
+		//
+		template <typename T>
+		void TransposeInPlace(const unsigned int n, T* a, const std::ptrdiff_t lda);
+	}
+}
+
+#endif
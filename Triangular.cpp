@@ -0,0 +1,148 @@
+
+#include "Triangular.hpp"
+#include "Gemm.hpp"
+#include <algorithm>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of the triangular solve
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Rows of B solved by substitution at a time; the rest of the work is GEMM.
+	//
+	const unsigned int BlockSize = 64;
+
+	/// \brief  b[i,:] -= s * b[p,:]
+	template <typename T>
+	inline void SubScaledRow(const unsigned int nrhs, const T s, const T* bp, T* bi)
+	{
+		for (unsigned int j = 0; j < nrhs; j++)
+		{
+			bi[j] -= s * bp[j];
+		}
+	}
+
+	/// \brief  Forward substitution on rows [begin, end) of B, using only the diagonal block.
+	template <typename T>
+	void SolveLowerBlock(const bool unitDiagonal, const unsigned int begin, const unsigned int end,
+	                     const unsigned int nrhs,
+	                     const T* a, const std::ptrdiff_t rsa, const std::ptrdiff_t csa,
+	                     T* b, const std::ptrdiff_t ldb)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			T* bi = b + i * ldb;
+			for (unsigned int p = begin; p < i; p++)
+			{
+				SubScaledRow(nrhs, a[i * rsa + p * csa], b + p * ldb, bi);
+			}
+			if (!unitDiagonal)
+			{
+				const T inv = T(1) / a[i * rsa + i * csa];
+				for (unsigned int j = 0; j < nrhs; j++)
+				{
+					bi[j] *= inv;
+				}
+			}
+		}
+	}
+
+	/// \brief  Back substitution on rows [begin, end) of B, using only the diagonal block.
+	template <typename T>
+	void SolveUpperBlock(const bool unitDiagonal, const unsigned int begin, const unsigned int end,
+	                     const unsigned int nrhs,
+	                     const T* a, const std::ptrdiff_t rsa, const std::ptrdiff_t csa,
+	                     T* b, const std::ptrdiff_t ldb)
+	{
+		for (unsigned int i = end; i-- > begin; )
+		{
+			T* bi = b + i * ldb;
+			for (unsigned int p = i + 1; p < end; p++)
+			{
+				SubScaledRow(nrhs, a[i * rsa + p * csa], b + p * ldb, bi);
+			}
+			if (!unitDiagonal)
+			{
+				const T inv = T(1) / a[i * rsa + i * csa];
+				for (unsigned int j = 0; j < nrhs; j++)
+				{
+					bi[j] *= inv;
+				}
+			}
+		}
+	}
+}
+
+
+/// \brief          Blocked triangular solve, left-looking: each block of rows of B first
+///                 subtracts the contribution of the rows already solved (one GEMM), then is
+///                 solved against its diagonal block.
+/// \param[in]      lower. Whether A is lower or upper triangular.
+/// \param[in]      unitDiagonal. Whether the diagonal of A is taken as ones.
+/// \param[in]      n. Order of A.
+/// \param[in]      nrhs. Number of columns of B.
+/// \param[in]      a, rsa, csa. A and its strides.
+/// \param[in,out]  b, ldb. B on input, X on output.
+template <typename T>
+void kernel::SolveTriangular(const bool lower,
+                             const bool unitDiagonal,
+                             const unsigned int n,
+                             const unsigned int nrhs,
+                             const T* a, const std::ptrdiff_t rsa, const std::ptrdiff_t csa,
+                             T* b, const std::ptrdiff_t ldb)
+{
+	if (n == 0 || nrhs == 0)
+	{
+		return;
+	}
+
+	if (lower)
+	{
+		for (unsigned int ib = 0; ib < n; ib += BlockSize)
+		{
+			const unsigned int nb = std::min(BlockSize, n - ib);
+			if (ib > 0)
+			{
+				kernel::Gemm<T>(nb, nrhs, ib,
+					T(-1), a + ib * rsa, rsa, csa,
+					b, ldb, 1,
+					T(1), b + ib * ldb, ldb, 1);
+			}
+			SolveLowerBlock(unitDiagonal, ib, ib + nb, nrhs, a, rsa, csa, b, ldb);
+		}
+	}
+	else
+	{
+		const unsigned int numBlocks = (n + BlockSize - 1) / BlockSize;
+		for (unsigned int blk = numBlocks; blk-- > 0; )
+		{
+			const unsigned int ib = blk * BlockSize;
+			const unsigned int nb = std::min(BlockSize, n - ib);
+			const unsigned int solved = ib + nb;
+			if (solved < n)
+			{
+				kernel::Gemm<T>(nb, nrhs, n - solved,
+					T(-1), a + ib * rsa + solved * csa, rsa, csa,
+					b + solved * ldb, ldb, 1,
+					T(1), b + ib * ldb, ldb, 1);
+			}
+			SolveUpperBlock(unitDiagonal, ib, solved, nrhs, a, rsa, csa, b, ldb);
+		}
+	}
+}
+
+
+#define NUMERIC_INSTANTIATE_TRIANGULAR(T)                                                      \
+	template void kernel::SolveTriangular<T>(const bool, const bool,                           \
+	                                         const unsigned int, const unsigned int,           \
+	                                         const T*, const std::ptrdiff_t,                   \
+	                                         const std::ptrdiff_t,                             \
+	                                         T*, const std::ptrdiff_t);
+
+NUMERIC_INSTANTIATE_TRIANGULAR(float)
+NUMERIC_INSTANTIATE_TRIANGULAR(double)
+
+#undef NUMERIC_INSTANTIATE_TRIANGULAR
@@ -0,0 +1,30 @@
+#ifndef Numeric_Triangular_HPP
+#define Numeric_Triangular_HPP
+
+#include <cstddef>
+
+namespace numeric
+{
+	namespace kernel
+	{
+		//
+		// Function : Solve A * X = B in place for a triangular n*n matrix A and n*nrhs B,
+		//      overwriting B with X. Element (i,j) of A lives at a[i*rsa + j*csa], so the
+		//      transpose of a stored triangle is passed by swapping the strides. B is row-major
+		//      with row stride ldb. Only the triangle named by lower is read; with unitDiagonal
+		//      its diagonal is taken as ones.
+		//
+		// Note: The solve is blocked so that most of the work is a GEMM update.
+		//       Instantiated for float and double.
+		//
+		template <typename T>
+		void SolveTriangular(const bool lower,
+		                     const bool unitDiagonal,
+		                     const unsigned int n,
+		                     const unsigned int nrhs,
+		                     const T* a, const std::ptrdiff_t rsa, const std::ptrdiff_t csa,
+		                     T* b, const std::ptrdiff_t ldb);
+	}
+}
+
+#endif
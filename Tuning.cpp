@@ -0,0 +1,842 @@
+
+#include "Tuning.hpp"
+#include "ElementWise.hpp"
+#include "Gemm.hpp"
+#include "Strassen.hpp"
+#include "ThreadPool.hpp"
+#include "Transpose.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace numeric;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+//Implementation of the kernel tuning
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+	//
+	// Register tile sizes the GEMM blocks are rounded to, see GemmBlocks.
+	//
+	const unsigned int GemmBlockRowMultiple = 4;
+	const unsigned int GemmBlockColMultiple = 16;
+
+	//
+	// Largest packed block of A (mc*kc) or panel of B (kc*nc), in bytes. No cache holds more,
+	// and every thread running a product allocates both, so larger blocks only cost memory.
+	//
+	const unsigned long long MaxPackedBytes = 32ull << 20;
+
+	//
+	// Each candidate is timed in this many rounds of at least MinRoundSeconds, and scored by
+	// its fastest round, which is the one least disturbed by the rest of the machine.
+	//
+	const unsigned int TimingRounds = 3;
+	const double       MinRoundSeconds = 0.005;
+
+	//
+	// Order of the products the GEMM blocks are measured on.
+	//
+	const unsigned int GemmTuningOrder = 512;
+
+	//
+	// Order of the product the Strassen crossover is measured on, and the crossovers tried.
+	// The last one runs the product without recursion.
+	//
+	const unsigned int StrassenTuningOrder = 1024;
+	const unsigned int StrassenCrossovers[] = {128, 256, 512, 1024, 2048};
+
+	enum TuningState
+	{
+		NotLoaded,
+		Loading,
+		Loaded
+	};
+
+	struct AtomicGemmBlocks
+	{
+		std::atomic<unsigned int> mc;
+		std::atomic<unsigned int> kc;
+		std::atomic<unsigned int> nc;
+
+		kernel::GemmBlocks Load() const
+		{
+			kernel::GemmBlocks blocks;
+			blocks.mc = mc.load(std::memory_order_relaxed);
+			blocks.kc = kc.load(std::memory_order_relaxed);
+			blocks.nc = nc.load(std::memory_order_relaxed);
+			return blocks;
+		}
+
+		void Store(const kernel::GemmBlocks& blocks)
+		{
+			mc.store(blocks.mc, std::memory_order_relaxed);
+			kc.store(blocks.kc, std::memory_order_relaxed);
+			nc.store(blocks.nc, std::memory_order_relaxed);
+		}
+	};
+
+	//
+	// The parameters in use, one atomic per field, so reading them costs a few plain loads
+	// and replacing them allocates nothing. A reader racing with Set may see a mix of the old
+	// and the new fields, which is harmless: Validate checks every field on its own, so any
+	// mix of two valid sets is valid too. Writers hold writeMutex, so that the store of a
+	// loaded cache cannot undo a SetTuning made while it was being read.
+	//
+	class TuningRegistry
+	{
+	public:
+		TuningRegistry()
+			: state(NotLoaded)
+		{
+			Set(kernel::DefaultTuning());
+		}
+
+		kernel::TuningParameters Current() const
+		{
+			kernel::TuningParameters tuning;
+			tuning.gemmFloat = m_gemmFloat.Load();
+			tuning.gemmDouble = m_gemmDouble.Load();
+			tuning.gemmParallelFlops = m_gemmParallelFlops.load(std::memory_order_relaxed);
+			tuning.transposeBaseEdge = m_transposeBaseEdge.load(std::memory_order_relaxed);
+			tuning.transposeParallelElements = m_transposeParallelElements.load(std::memory_order_relaxed);
+			tuning.strassenCrossover = m_strassenCrossover.load(std::memory_order_relaxed);
+			tuning.elementWiseIsa = ElementWiseIsa();
+			return tuning;
+		}
+
+		kernel::Isa ElementWiseIsa() const
+		{
+			return static_cast<kernel::Isa>(m_elementWiseIsa.load(std::memory_order_relaxed));
+		}
+
+		void Set(const kernel::TuningParameters& tuning)
+		{
+			m_gemmFloat.Store(tuning.gemmFloat);
+			m_gemmDouble.Store(tuning.gemmDouble);
+			m_gemmParallelFlops.store(tuning.gemmParallelFlops, std::memory_order_relaxed);
+			m_transposeBaseEdge.store(tuning.transposeBaseEdge, std::memory_order_relaxed);
+			m_transposeParallelElements.store(tuning.transposeParallelElements, std::memory_order_relaxed);
+			m_strassenCrossover.store(tuning.strassenCrossover, std::memory_order_relaxed);
+			m_elementWiseIsa.store(tuning.elementWiseIsa, std::memory_order_relaxed);
+		}
+
+	public:
+		std::atomic<int> state;
+		std::mutex       writeMutex;
+
+	private:
+		AtomicGemmBlocks          m_gemmFloat;
+		AtomicGemmBlocks          m_gemmDouble;
+		std::atomic<double>       m_gemmParallelFlops;
+		std::atomic<unsigned int> m_transposeBaseEdge;
+		std::atomic<size_t>       m_transposeParallelElements;
+		std::atomic<unsigned int> m_strassenCrossover;
+		std::atomic<int>          m_elementWiseIsa;
+	};
+
+	//
+	// The candidate Tune is timing, on the thread that runs it. The kernels that thread calls
+	// see the candidate; every other thread keeps the parameters in use.
+	//
+	thread_local const kernel::TuningParameters* t_trial = NULL;
+
+	class TrialTuning
+	{
+	public:
+		explicit TrialTuning(const kernel::TuningParameters& candidate)
+			: m_previous(t_trial)
+		{
+			t_trial = &candidate;
+		}
+
+		~TrialTuning()
+		{
+			t_trial = m_previous;
+		}
+
+	private:
+		TrialTuning(const TrialTuning&);
+		TrialTuning& operator=(const TrialTuning&);
+
+		const kernel::TuningParameters* m_previous;
+	};
+
+	TuningRegistry& Registry()
+	{
+		static TuningRegistry registry;
+		return registry;
+	}
+
+	/// \brief  Throw std::invalid_argument unless every kernel can run with tuning.
+	void Validate(const kernel::TuningParameters& tuning)
+	{
+		const kernel::GemmBlocks* blocks[] = {&tuning.gemmFloat, &tuning.gemmDouble};
+		const unsigned long long elementSizes[] = {sizeof(float), sizeof(double)};
+		for (int i = 0; i < 2; i++)
+		{
+			const unsigned long long maxElements = MaxPackedBytes / elementSizes[i];
+			if (blocks[i]->mc == 0 || blocks[i]->mc % GemmBlockRowMultiple != 0 ||
+				blocks[i]->kc == 0 ||
+				blocks[i]->nc == 0 || blocks[i]->nc % GemmBlockColMultiple != 0 ||
+				static_cast<unsigned long long>(blocks[i]->mc) * blocks[i]->kc > maxElements ||
+				static_cast<unsigned long long>(blocks[i]->kc) * blocks[i]->nc > maxElements)
+			{
+				throw std::invalid_argument(
+					"Invalid GEMM block sizes"
+					);
+			}
+		}
+
+		if (!(tuning.gemmParallelFlops >= 0) || tuning.transposeBaseEdge == 0 ||
+			tuning.transposeParallelElements == 0 || tuning.strassenCrossover == 0)
+		{
+			throw std::invalid_argument(
+				"Invalid tuning parameters"
+				);
+		}
+
+		if (tuning.elementWiseIsa < kernel::IsaScalar || tuning.elementWiseIsa > kernel::ActiveIsa())
+		{
+			throw std::invalid_argument(
+				"The tuned instruction set is not available"
+				);
+		}
+	}
+
+	bool AutoTuneRequested()
+	{
+		const char* env = std::getenv("NUMERIC_AUTOTUNE");
+		return env != NULL && std::strtol(env, NULL, 10) > 0;
+	}
+
+	/// \brief  Set tuning unless SetTuning has been called since loading started.
+	void StoreLoaded(TuningRegistry& registry, const kernel::TuningParameters& tuning)
+	{
+		std::lock_guard<std::mutex> lock(registry.writeMutex);
+		if (registry.state.load(std::memory_order_relaxed) == Loading)
+		{
+			registry.Set(tuning);
+		}
+	}
+
+	/// \brief  Read the cache of this CPU, or tune and write it when NUMERIC_AUTOTUNE asks for
+	///         it. Runs on the first thread to ask; Tuning() calls made meanwhile see the
+	///         parameters already set. A SetTuning made meanwhile wins over the loaded ones.
+	void LoadOnce(TuningRegistry& registry)
+	{
+		int expected = NotLoaded;
+		if (!registry.state.compare_exchange_strong(expected, Loading))
+		{
+			return;
+		}
+
+		//
+		// A missing cache, a failed search or an unwritable cache directory all leave usable
+		// parameters in place, so none of them is an error here.
+		//
+		try
+		{
+			const std::string path = kernel::TuningCachePath();
+			try
+			{
+				StoreLoaded(registry, kernel::LoadTuning(path));
+			}
+			catch (const std::exception&)
+			{
+				if (AutoTuneRequested())
+				{
+					const kernel::TuningParameters tuned = kernel::Tune();
+					StoreLoaded(registry, tuned);
+					kernel::SaveTuning(path, tuned);
+				}
+			}
+		}
+		catch (const std::exception&)
+		{
+		}
+
+		std::lock_guard<std::mutex> lock(registry.writeMutex);
+		registry.state.store(Loaded, std::memory_order_release);
+	}
+
+	/// \brief  The registry, with the cache of this CPU read on the first call.
+	TuningRegistry& LoadedRegistry()
+	{
+		TuningRegistry& registry = Registry();
+		if (registry.state.load(std::memory_order_acquire) != Loaded)
+		{
+			LoadOnce(registry);
+		}
+		return registry;
+	}
+
+	/// \brief  Seconds per call of work, the fastest of TimingRounds rounds.
+	template <typename Work>
+	double TimePerCall(const Work& work)
+	{
+		typedef std::chrono::steady_clock Clock;
+
+		work();
+		double best = std::numeric_limits<double>::max();
+		for (unsigned int round = 0; round < TimingRounds; round++)
+		{
+			const Clock::time_point start = Clock::now();
+			unsigned int calls = 0;
+			double elapsed = 0;
+			do
+			{
+				work();
+				calls++;
+				elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+			}
+			while (elapsed < MinRoundSeconds);
+			best = std::min(best, elapsed / calls);
+		}
+		return best;
+	}
+
+	/// \brief  Time work under each candidate set by apply, and keep the fastest in tuning.
+	template <typename Candidate, typename Apply, typename Work>
+	void PickFastest(kernel::TuningParameters& tuning, const std::vector<Candidate>& candidates,
+	                 const Apply& apply, const Work& work)
+	{
+		kernel::TuningParameters best = tuning;
+		double bestTime = std::numeric_limits<double>::max();
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			kernel::TuningParameters candidate = tuning;
+			apply(candidate, candidates[i]);
+			const TrialTuning trial(candidate);
+			const double time = TimePerCall(work);
+			if (time < bestTime)
+			{
+				bestTime = time;
+				best = candidate;
+			}
+		}
+		tuning = best;
+	}
+
+	/// \brief      The smallest size from which the parallel path wins at every measured size.
+	/// \param[in]  sizes. Increasing problem sizes.
+	/// \param[in]  run. run(size, parallel) times one call on the serial or parallel path.
+	/// \return     That size, or 0 when the parallel path does not win at the largest one.
+	template <typename Run>
+	double ParallelCrossover(const std::vector<double>& sizes, const Run& run)
+	{
+		double crossover = 0;
+		for (size_t i = sizes.size(); i-- > 0;)
+		{
+			if (run(sizes[i], true) >= run(sizes[i], false))
+			{
+				break;
+			}
+			crossover = sizes[i];
+		}
+		return crossover;
+	}
+
+	template <typename T>
+	std::vector<T> TuningData(const size_t n)
+	{
+		std::vector<T> data(n);
+		for (size_t i = 0; i < n; i++)
+		{
+			data[i] = static_cast<T>(static_cast<int>(i % 13) - 6);
+		}
+		return data;
+	}
+
+	/// \brief  Tune mc and kc of the blocks for T on one thread, kc first.
+	template <typename T>
+	void TuneGemmBlocks(kernel::TuningParameters& tuning, kernel::GemmBlocks kernel::TuningParameters::* blocks)
+	{
+		const unsigned int n = GemmTuningOrder;
+		const std::vector<T> a = TuningData<T>(static_cast<size_t>(n) * n);
+		const std::vector<T> b = TuningData<T>(static_cast<size_t>(n) * n);
+		std::vector<T> c(static_cast<size_t>(n) * n);
+		const auto product = [&]()
+		{
+			kernel::Gemm<T>(n, n, n, T(1), &a[0], n, 1, &b[0], n, 1, T(0), &c[0], n, 1);
+		};
+
+		const double parallelFlops = tuning.gemmParallelFlops;
+		tuning.gemmParallelFlops = std::numeric_limits<double>::max();
+
+		const unsigned int kcs[] = {128, 192, 256, 320, 384, 512};
+		PickFastest(tuning, std::vector<unsigned int>(kcs, kcs + sizeof(kcs) / sizeof(kcs[0])),
+			[=](kernel::TuningParameters& candidate, const unsigned int kc) { (candidate.*blocks).kc = kc; },
+			product);
+
+		const unsigned int mcs[] = {64, 96, 128, 192, 256};
+		PickFastest(tuning, std::vector<unsigned int>(mcs, mcs + sizeof(mcs) / sizeof(mcs[0])),
+			[=](kernel::TuningParameters& candidate, const unsigned int mc) { (candidate.*blocks).mc = mc; },
+			product);
+
+		tuning.gemmParallelFlops = parallelFlops;
+	}
+
+	/// \brief  The smallest square double product worth splitting across the ThreadPool.
+	void TuneGemmParallelFlops(kernel::TuningParameters& tuning)
+	{
+		const unsigned int orders[] = {48, 64, 96, 128, 192, 256, 384};
+		std::vector<double> sizes;
+		for (size_t i = 0; i < sizeof(orders) / sizeof(orders[0]); i++)
+		{
+			sizes.push_back(static_cast<double>(orders[i]) * orders[i] * orders[i]);
+		}
+
+		const unsigned int maxOrder = orders[sizeof(orders) / sizeof(orders[0]) - 1];
+		const std::vector<double> a = TuningData<double>(static_cast<size_t>(maxOrder) * maxOrder);
+		const std::vector<double> b = TuningData<double>(static_cast<size_t>(maxOrder) * maxOrder);
+		std::vector<double> c(static_cast<size_t>(maxOrder) * maxOrder);
+
+		const double crossover = ParallelCrossover(sizes, [&](const double flops, const bool parallel)
+		{
+			kernel::TuningParameters candidate = tuning;
+			candidate.gemmParallelFlops = parallel ? 0 : std::numeric_limits<double>::max();
+			const TrialTuning trial(candidate);
+			const unsigned int n = static_cast<unsigned int>(std::cbrt(flops) + 0.5);
+			return TimePerCall([&]()
+			{
+				kernel::Gemm<double>(n, n, n, 1.0, &a[0], n, 1, &b[0], n, 1, 0.0, &c[0], n, 1);
+			});
+		});
+
+		if (crossover > 0)
+		{
+			tuning.gemmParallelFlops = crossover;
+		}
+	}
+
+	/// \brief  The transpose base edge on one thread, then the smallest transpose worth
+	///         splitting across the ThreadPool, both on double.
+	void TuneTranspose(kernel::TuningParameters& tuning)
+	{
+		const unsigned int maxEdge = 1024;
+		const std::vector<double> src = TuningData<double>(static_cast<size_t>(maxEdge) * maxEdge);
+		std::vector<double> dst(src.size());
+
+		const size_t parallelElements = tuning.transposeParallelElements;
+		tuning.transposeParallelElements = std::numeric_limits<size_t>::max();
+
+		const unsigned int edges[] = {4, 8, 16, 32};
+		PickFastest(tuning, std::vector<unsigned int>(edges, edges + sizeof(edges) / sizeof(edges[0])),
+			[](kernel::TuningParameters& candidate, const unsigned int edge) { candidate.transposeBaseEdge = edge; },
+			[&]() { kernel::Transpose<double>(maxEdge, maxEdge, &src[0], maxEdge, &dst[0], maxEdge); });
+
+		tuning.transposeParallelElements = parallelElements;
+		if (ThreadPool::NumThreads() > 1)
+		{
+			std::vector<double> sizes;
+			for (unsigned int edge = 64; edge <= maxEdge; edge *= 2)
+			{
+				sizes.push_back(static_cast<double>(edge) * edge);
+			}
+
+			const double crossover = ParallelCrossover(sizes, [&](const double elements, const bool parallel)
+			{
+				kernel::TuningParameters candidate = tuning;
+				candidate.transposeParallelElements = parallel ? 1 : std::numeric_limits<size_t>::max();
+				const TrialTuning trial(candidate);
+				const unsigned int edge = static_cast<unsigned int>(std::sqrt(elements) + 0.5);
+				return TimePerCall([&]()
+				{
+					kernel::Transpose<double>(edge, edge, &src[0], edge, &dst[0], edge);
+				});
+			});
+
+			if (crossover > 0)
+			{
+				tuning.transposeParallelElements = static_cast<size_t>(crossover);
+			}
+		}
+	}
+
+	/// \brief  The Strassen crossover that runs a double product fastest on the current
+	///         ThreadPool.
+	void TuneStrassen(kernel::TuningParameters& tuning)
+	{
+		const unsigned int n = StrassenTuningOrder;
+		const std::vector<double> a = TuningData<double>(static_cast<size_t>(n) * n);
+		const std::vector<double> b = TuningData<double>(static_cast<size_t>(n) * n);
+		std::vector<double> c(static_cast<size_t>(n) * n);
+
+		//
+		// The smallest crossover runs the most levels and needs the largest workspace.
+		//
+		std::vector<double> workspace(kernel::StrassenWorkspaceSize(n, n, n, StrassenCrossovers[0]));
+
+		PickFastest(tuning, std::vector<unsigned int>(StrassenCrossovers,
+		                        StrassenCrossovers + sizeof(StrassenCrossovers) / sizeof(StrassenCrossovers[0])),
+			[](kernel::TuningParameters& candidate, const unsigned int crossover) { candidate.strassenCrossover = crossover; },
+			[&]()
+			{
+				kernel::StrassenGemm<double>(n, n, n, &a[0], n, &b[0], n, &c[0], n,
+				                             kernel::StrassenCrossover(), &workspace[0]);
+			});
+	}
+
+	/// \brief  The instruction set that runs a mix of element-wise kernels fastest, on
+	///         buffers that fit in L2.
+	void TuneElementWise(kernel::TuningParameters& tuning)
+	{
+		const size_t n = 16384;
+		const std::vector<double> xd = TuningData<double>(n);
+		std::vector<double> yd = TuningData<double>(n);
+		const std::vector<float> xf = TuningData<float>(n);
+		std::vector<float> yf = TuningData<float>(n);
+		volatile double sink = 0;
+
+		std::vector<kernel::Isa> isas;
+		for (int isa = kernel::IsaScalar; isa <= kernel::ActiveIsa(); isa++)
+		{
+			isas.push_back(static_cast<kernel::Isa>(isa));
+		}
+
+		PickFastest(tuning, isas,
+			[](kernel::TuningParameters& candidate, const kernel::Isa isa) { candidate.elementWiseIsa = isa; },
+			[&]()
+			{
+				kernel::Add<double>(n, &xd[0], &yd[0], &yd[0]);
+				kernel::Axpby<double>(n, 0.5, &xd[0], 0.5, &yd[0]);
+				kernel::Add<float>(n, &xf[0], &yf[0], &yf[0]);
+				kernel::Axpby<float>(n, 0.5f, &xf[0], 0.5f, &yf[0]);
+				sink = sink + kernel::Dot<double>(n, &xd[0], &yd[0]) + kernel::Dot<float>(n, &xf[0], &yf[0]);
+			});
+	}
+
+	/// \brief  The file-name-safe form of a CPU model: letters and digits, other runs as '-'.
+	std::string FileNamePart(const std::string& model)
+	{
+		std::string part;
+		for (size_t i = 0; i < model.size(); i++)
+		{
+			const unsigned char ch = static_cast<unsigned char>(model[i]);
+			if (std::isalnum(ch))
+			{
+				part += static_cast<char>(ch);
+			}
+			else if (!part.empty() && part[part.size() - 1] != '-')
+			{
+				part += '-';
+			}
+		}
+		while (!part.empty() && part[part.size() - 1] == '-')
+		{
+			part.erase(part.size() - 1);
+		}
+		return part.empty() ? "unknown" : part;
+	}
+
+	std::string Trim(const std::string& text)
+	{
+		const size_t begin = text.find_first_not_of(" \t\r");
+		if (begin == std::string::npos)
+		{
+			return std::string();
+		}
+		return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+	}
+
+	bool ParseIsa(const std::string& name, kernel::Isa& isa)
+	{
+		for (int i = kernel::IsaScalar; i <= kernel::IsaAvx512; i++)
+		{
+			if (name == kernel::IsaName(static_cast<kernel::Isa>(i)))
+			{
+				isa = static_cast<kernel::Isa>(i);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// \brief  Parse a whole non-negative number; streams would wrap "-1" into an unsigned.
+	template <typename U>
+	bool ParseNumber(const std::string& text, U& value)
+	{
+		if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0])))
+		{
+			return false;
+		}
+		std::istringstream in(text);
+		in >> value;
+		return !in.fail() && in.eof();
+	}
+}
+
+
+/// \brief  Return the parameters tuned on the machines the library was written on.
+kernel::TuningParameters kernel::DefaultTuning()
+{
+	TuningParameters tuning;
+	tuning.gemmFloat.mc = 128;
+	tuning.gemmFloat.kc = 384;
+	tuning.gemmFloat.nc = 4096;
+	tuning.gemmDouble.mc = 128;
+	tuning.gemmDouble.kc = 256;
+	tuning.gemmDouble.nc = 2048;
+	tuning.gemmParallelFlops = 128.0 * 128.0 * 128.0;
+	tuning.transposeBaseEdge = 8;
+	tuning.transposeParallelElements = size_t(1) << 16;
+
+	//
+	// Below 512 the eighth of the flops that a Strassen level saves is eaten by the fifteen
+	// block additions, which stream memory.
+	//
+	tuning.strassenCrossover = 512;
+	tuning.elementWiseIsa = ActiveIsa();
+	return tuning;
+}
+
+
+/// \brief  Return the parameters in use, reading the cache of this CPU on the first call, or
+///         the candidate Tune is timing on this thread.
+kernel::TuningParameters kernel::Tuning()
+{
+	if (t_trial != NULL)
+	{
+		return *t_trial;
+	}
+	return LoadedRegistry().Current();
+}
+
+
+/// \brief  Return Tuning().elementWiseIsa with a single load.
+kernel::Isa kernel::ElementWiseIsa()
+{
+	if (t_trial != NULL)
+	{
+		return t_trial->elementWiseIsa;
+	}
+	return LoadedRegistry().ElementWiseIsa();
+}
+
+
+/// \brief      Replace the parameters in use. A set before the first Tuning() call also keeps
+///             the cache from being read.
+/// \param[in]  tuning. The new parameters.
+void kernel::SetTuning(const TuningParameters& tuning)
+{
+	Validate(tuning);
+	TuningRegistry& registry = Registry();
+	std::lock_guard<std::mutex> lock(registry.writeMutex);
+	registry.Set(tuning);
+	registry.state.store(Loaded, std::memory_order_release);
+}
+
+
+/// \brief  Measure every parameter in turn, each with the winners found before it.
+/// \return The fastest parameters found; the ones in use are left unchanged.
+kernel::TuningParameters kernel::Tune()
+{
+	TuningParameters tuning = Tuning();
+	TuneElementWise(tuning);
+	TuneGemmBlocks<float>(tuning, &TuningParameters::gemmFloat);
+	TuneGemmBlocks<double>(tuning, &TuningParameters::gemmDouble);
+	if (ThreadPool::NumThreads() > 1)
+	{
+		TuneGemmParallelFlops(tuning);
+	}
+	TuneTranspose(tuning);
+	TuneStrassen(tuning);
+	return tuning;
+}
+
+
+std::string kernel::TuningCachePath()
+{
+	const char* path = std::getenv("NUMERIC_TUNING_CACHE");
+	if (path != NULL && *path != '\0')
+	{
+		return path;
+	}
+
+	std::string directory = ".";
+	const char* xdgCache = std::getenv("XDG_CACHE_HOME");
+	const char* home = std::getenv("HOME");
+	if (xdgCache != NULL && *xdgCache != '\0')
+	{
+		directory = xdgCache;
+	}
+	else if (home != NULL && *home != '\0')
+	{
+		directory = std::string(home) + "/.cache";
+	}
+	return directory + "/numeric-tuning-" + FileNamePart(CpuModel()) + ".txt";
+}
+
+
+/// \brief      Write tuning to path. The file is written under a temporary name and renamed,
+///             so a process starting meanwhile never reads half of it.
+/// \param[in]  path. The cache file.
+/// \param[in]  tuning. The parameters.
+void kernel::SaveTuning(const std::string& path, const TuningParameters& tuning)
+{
+	const std::string temporary = path + ".tmp";
+	std::FILE* out = std::fopen(temporary.c_str(), "w");
+	if (out == NULL)
+	{
+		throw std::runtime_error("Cannot open " + path + " for writing");
+	}
+
+	const int written = std::fprintf(out,
+		"# numeric kernel tuning\n"
+		"cpu = %s\n"
+		"isa = %s\n"
+		"gemm.float.mc = %u\n"
+		"gemm.float.kc = %u\n"
+		"gemm.float.nc = %u\n"
+		"gemm.double.mc = %u\n"
+		"gemm.double.kc = %u\n"
+		"gemm.double.nc = %u\n"
+		"gemm.parallel_flops = %.0f\n"
+		"transpose.base_edge = %u\n"
+		"transpose.parallel_elements = %lu\n"
+		"strassen.crossover = %u\n"
+		"elementwise.isa = %s\n",
+		CpuModel().c_str(), IsaName(ActiveIsa()),
+		tuning.gemmFloat.mc, tuning.gemmFloat.kc, tuning.gemmFloat.nc,
+		tuning.gemmDouble.mc, tuning.gemmDouble.kc, tuning.gemmDouble.nc,
+		tuning.gemmParallelFlops,
+		tuning.transposeBaseEdge, static_cast<unsigned long>(tuning.transposeParallelElements),
+		tuning.strassenCrossover,
+		IsaName(tuning.elementWiseIsa));
+	const bool closed = std::fclose(out) == 0;
+
+	if (written < 0 || !closed)
+	{
+		std::remove(temporary.c_str());
+		throw std::runtime_error("Cannot write " + path);
+	}
+	if (std::rename(temporary.c_str(), path.c_str()) != 0)
+	{
+		//
+		// Some platforms do not rename over an existing file.
+		//
+		std::remove(path.c_str());
+		if (std::rename(temporary.c_str(), path.c_str()) != 0)
+		{
+			std::remove(temporary.c_str());
+			throw std::runtime_error("Cannot write " + path);
+		}
+	}
+}
+
+
+/// \brief      Read a cache file written by SaveTuning on this CPU model.
+/// \param[in]  path. The cache file.
+/// \return     The parameters, with defaults for missing keys.
+kernel::TuningParameters kernel::LoadTuning(const std::string& path)
+{
+	std::ifstream in(path.c_str());
+	if (!in)
+	{
+		throw std::runtime_error("Cannot open " + path);
+	}
+
+	TuningParameters tuning = DefaultTuning();
+	std::string cpu;
+	std::string isa;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		line = Trim(line);
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		const size_t equals = line.find('=');
+		if (equals == std::string::npos)
+		{
+			throw std::runtime_error("Malformed tuning cache " + path);
+		}
+		const std::string key = Trim(line.substr(0, equals));
+		const std::string value = Trim(line.substr(equals + 1));
+
+		unsigned long count = 0;
+		bool parsed = true;
+		if (key == "cpu")
+		{
+			cpu = value;
+		}
+		else if (key == "isa")
+		{
+			isa = value;
+		}
+		else if (key == "gemm.float.mc")
+		{
+			parsed = ParseNumber(value, tuning.gemmFloat.mc);
+		}
+		else if (key == "gemm.float.kc")
+		{
+			parsed = ParseNumber(value, tuning.gemmFloat.kc);
+		}
+		else if (key == "gemm.float.nc")
+		{
+			parsed = ParseNumber(value, tuning.gemmFloat.nc);
+		}
+		else if (key == "gemm.double.mc")
+		{
+			parsed = ParseNumber(value, tuning.gemmDouble.mc);
+		}
+		else if (key == "gemm.double.kc")
+		{
+			parsed = ParseNumber(value, tuning.gemmDouble.kc);
+		}
+		else if (key == "gemm.double.nc")
+		{
+			parsed = ParseNumber(value, tuning.gemmDouble.nc);
+		}
+		else if (key == "gemm.parallel_flops")
+		{
+			parsed = ParseNumber(value, tuning.gemmParallelFlops);
+		}
+		else if (key == "transpose.base_edge")
+		{
+			parsed = ParseNumber(value, tuning.transposeBaseEdge);
+		}
+		else if (key == "transpose.parallel_elements")
+		{
+			parsed = ParseNumber(value, count);
+			tuning.transposeParallelElements = static_cast<size_t>(count);
+		}
+		else if (key == "strassen.crossover")
+		{
+			parsed = ParseNumber(value, tuning.strassenCrossover);
+		}
+		else if (key == "elementwise.isa")
+		{
+			parsed = ParseIsa(value, tuning.elementWiseIsa);
+		}
+		//
+		// Unknown keys are skipped, so older builds read caches written by newer ones.
+		//
+
+		if (!parsed)
+		{
+			throw std::runtime_error("Malformed tuning cache " + path);
+		}
+	}
+
+	if (cpu != CpuModel() || isa != IsaName(ActiveIsa()))
+	{
+		throw std::runtime_error("The tuning cache " + path + " is for another CPU");
+	}
+	Validate(tuning);
+	return tuning;
+}
@@ -0,0 +1,135 @@
+#ifndef Numeric_Tuning_HPP
+#define Numeric_Tuning_HPP
+
+#include <cstddef>
+#include <string>
+#include "CpuFeatures.hpp"
+
+namespace numeric
+{
+	namespace kernel
+	{
+		//
+		// Cache blocks of the GEMM engine (see Gemm.cpp): a packed mc*kc block of A should stay
+		// in L2 and a packed kc*nc panel of B in L3. mc must be a multiple of 4 and nc a
+		// multiple of 16, the register tile sizes the packing rounds up to, and neither the
+		// block nor the panel may exceed 32 MiB.
+		//
+		struct GemmBlocks
+		{
+			unsigned int mc;
+			unsigned int kc;
+			unsigned int nc;
+		};
+
+		//
+		// The kernel parameters that depend on the machine rather than on the operands.
+		//
+		// The defaults suit the cores the library was written on; Tune measures better values
+		// for the current one. std::int32_t products use the float blocks, which have the same
+		// element size and register tile.
+		//
+		struct TuningParameters
+		{
+			GemmBlocks   gemmFloat;
+			GemmBlocks   gemmDouble;
+
+			//
+			// Products of at least this many multiply-adds are split across the ThreadPool.
+			//
+			double       gemmParallelFlops;
+
+			//
+			// Transposes recurse down to blocks of at most this edge, and run on the ThreadPool
+			// from this many elements.
+			//
+			unsigned int transposeBaseEdge;
+			size_t       transposeParallelElements;
+
+			//
+			// Matrix::StrassenMul recurses while every dimension is at least this, see
+			// StrassenCrossover.
+			//
+			unsigned int strassenCrossover;
+
+			//
+			// The instruction set of the element-wise and reduction kernels, at most ActiveIsa().
+			// The widest one is not always the fastest: some cores lower their clock for 512-bit
+			// instructions.
+			//
+			Isa          elementWiseIsa;
+		};
+
+		//
+		// Function : The parameters the library starts with, before any cache is read.
+		//
+		TuningParameters DefaultTuning();
+
+		//
+		// Function : The parameters in use.
+		//
+		// The first call reads the tuning cache of this CPU, TuningCachePath(). When there is
+		// no usable cache and the environment variable NUMERIC_AUTOTUNE is set to a nonzero
+		// number, it runs Tune instead, uses the result and writes the cache, so only the first
+		// process on a machine pays for the search. Other threads that ask while this runs are
+		// not held up; they get whichever parameters are set at the time.
+		//
+		// While Tune times a candidate, calls on the thread running Tune get the candidate.
+		//
+		TuningParameters Tuning();
+
+		//
+		// Function : Tuning().elementWiseIsa, without copying the other fields. The
+		//      element-wise kernels read it on every call.
+		//
+		Isa ElementWiseIsa();
+
+		//
+		// Function : Replace the parameters for every call that starts afterwards. Throws
+		//      std::invalid_argument when a block size breaks the rules of GemmBlocks, a value
+		//      is zero or the instruction set is wider than ActiveIsa().
+		//
+		// A set before the first Tuning() call also keeps the cache from being read, and one
+		// made while the cache is being read wins over it.
+		//
+		void SetTuning(const TuningParameters& tuning);
+
+		//
+		// Function : Measure candidate parameters on this machine and return the fastest.
+		//
+		// Searched: the GEMM mc and kc of each type on a 512^3 product (nc is kept), the
+		// smallest product and transpose worth splitting across the current ThreadPool
+		// (kept when it has one thread), the transpose base edge, the Strassen crossover on a
+		// 1024^3 double product with the current ThreadPool, and the element-wise instruction
+		// set. The crossover is chosen on speed alone; each level it adds also costs accuracy,
+		// see MeasureStrassenAccuracy. It takes a few seconds. Candidates are tried on the calling thread
+		// only and the parameters in use are left unchanged, so pass the result to SetTuning
+		// to adopt it. Other threads computing meanwhile do not change the outcome but skew the
+		// timings.
+		//
+		TuningParameters Tune();
+
+		//
+		// Function : Where the tuning cache of this CPU lives: the environment variable
+		//      NUMERIC_TUNING_CACHE when set, else numeric-tuning-<model>.txt, named after
+		//      CpuModel(), in $XDG_CACHE_HOME, $HOME/.cache or the working directory.
+		//
+		std::string TuningCachePath();
+
+		//
+		// Function : Write parameters to a cache file, as "key = value" lines together with the
+		//      CPU model and instruction set they were measured on. Throws std::runtime_error
+		//      when the file cannot be written.
+		//
+		void SaveTuning(const std::string& path, const TuningParameters& tuning);
+
+		//
+		// Function : Read a cache file. Keys that are missing keep their defaults. Throws
+		//      std::runtime_error when the file is missing or malformed or was written on
+		//      another CPU model, and std::invalid_argument as SetTuning does.
+		//
+		TuningParameters LoadTuning(const std::string& path);
+	}
+}
+
+#endif
@@ -0,0 +1,823 @@
+
+//
+// Benchmark of the Matrix and affine-transform entry points.
+//
+//      numeric_benchmark [--max-size N] [--threads 1,2,4] [--min-time seconds]
+//                        [--filter text] [--json file] [--baseline file] [--threshold ratio]
+//                        [--accuracy] [--tune]
+//
+// Square shapes are swept in powers of two from 2x2 to --max-size (8192 by default), tall-skinny
+// shapes have 16 columns and up to --max-size^2 / 16 rows, and every case runs at each thread
+// count (1 and the number of hardware threads by default). Each case reports ns/op, GFLOP/s and
+// GB/s from a nominal operation count and memory traffic, and the number of Allocator blocks
+// and heap allocations per call.
+//
+// --json writes the results, one per line. --baseline reads such a file and flags every case
+// that became slower by more than --threshold (0.10 by default); the exit code is then 1.
+//
+// --accuracy prints the error of StrassenMul against Mul for square sizes from 256 to
+// --max-size and every crossover that gives at least one level, instead of timing anything.
+//
+// --tune measures the kernel parameters for this CPU on the default number of threads, writes
+// them to the tuning cache that every later process reads at start-up and prints them.
+//
+#include "Matrix.hpp"
+#include "AffinePipeline.hpp"
+#include "AffineTransform.hpp"
+#include "AffineTransformParams.hpp"
+#include "Allocator.hpp"
+#include "CpuFeatures.hpp"
+#include "MatrixFuture.hpp"
+#include "Strassen.hpp"
+#include "TaskScheduler.hpp"
+#include "ThreadPool.hpp"
+#include "Tuning.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace numeric;
+
+namespace
+{
+	std::atomic<size_t> g_heapAllocations(0);
+}
+
+//
+// Every heap allocation of the process is counted.
+//
+void* operator new(std::size_t bytes)
+{
+	g_heapAllocations++;
+	void* p = std::malloc(bytes > 0 ? bytes : 1);
+	if (p == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+namespace
+{
+	//
+	// Counts the blocks handed out to matrices and forwards to the allocator it replaces.
+	//
+	class CountingAllocator : public Allocator
+	{
+	public:
+		explicit CountingAllocator(Allocator* inner)
+			: m_inner(inner), m_count(0)
+		{
+		}
+
+		virtual void* Allocate(const size_t bytes, size_t& reserved)
+		{
+			m_count++;
+			return m_inner->Allocate(bytes, reserved);
+		}
+
+		virtual void Deallocate(void* p, const size_t reserved)
+		{
+			m_inner->Deallocate(p, reserved);
+		}
+
+		size_t Count() const
+		{
+			return m_count;
+		}
+
+	private:
+		Allocator*          m_inner;
+		std::atomic<size_t> m_count;
+	};
+
+	struct Result
+	{
+		std::string  name;
+		std::string  shape;
+		unsigned int threads;
+		double       nsPerOp;
+		double       gflops;
+		double       gbps;
+		double       allocsPerOp;
+		double       heapAllocsPerOp;
+	};
+
+	struct Options
+	{
+		Options()
+			: maxSize(8192), minTime(0.1), threshold(0.10), accuracy(false), tune(false)
+		{
+		}
+
+		unsigned int              maxSize;
+		double                    minTime;
+		double                    threshold;
+		bool                      accuracy;
+		bool                      tune;
+		std::vector<unsigned int> threads;
+		std::string               filter;
+		std::string               json;
+		std::string               baseline;
+	};
+
+	volatile double g_sink;
+
+	void Fill(Matrix& mat, const double seed)
+	{
+		double* p = mat.Data();
+		for (size_t i = 0; i < mat.NumElements(); i++)
+		{
+			p[i] = seed + static_cast<double>(i % 97) * 0.01;
+		}
+	}
+
+	std::string Shape(const unsigned int rows, const unsigned int cols)
+	{
+		std::ostringstream os;
+		os << rows << "x" << cols;
+		return os.str();
+	}
+
+	std::string Shape(const unsigned int m, const unsigned int k, const unsigned int n)
+	{
+		std::ostringstream os;
+		os << m << "x" << k << "x" << n;
+		return os.str();
+	}
+
+	class Runner
+	{
+	public:
+		Runner(const Options& options, CountingAllocator& allocator)
+			: m_options(options), m_allocator(allocator), m_threads(1)
+		{
+		}
+
+		void SetThreads(const unsigned int threads)
+		{
+			m_threads = threads;
+			ThreadPool::SetNumThreads(threads);
+			TaskScheduler::SetNumThreads(threads);
+		}
+
+		bool Wanted(const std::string& name) const
+		{
+			return m_options.filter.empty() || name.find(m_options.filter) != std::string::npos;
+		}
+
+		/// \brief     Time op, doubling the number of calls until a batch takes minTime.
+		/// \param[in] flops, bytes. Nominal work of one call.
+		template <typename F>
+		void Run(const std::string& name, const std::string& shape,
+		         const double flops, const double bytes, const F& op)
+		{
+			op();
+
+			size_t calls = 1;
+			double seconds = 0;
+			size_t blocks = 0;
+			size_t heap = 0;
+			for (;;)
+			{
+				const size_t blocks0 = m_allocator.Count();
+				const size_t heap0 = g_heapAllocations;
+				const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+				for (size_t i = 0; i < calls; i++)
+				{
+					op();
+				}
+				seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+				blocks = m_allocator.Count() - blocks0;
+				heap = g_heapAllocations - heap0;
+				if (seconds >= m_options.minTime || calls >= (static_cast<size_t>(1) << 32))
+				{
+					break;
+				}
+				calls *= 2;
+			}
+
+			Result r;
+			r.name = name;
+			r.shape = shape;
+			r.threads = m_threads;
+			r.nsPerOp = seconds * 1e9 / calls;
+			r.gflops = flops / r.nsPerOp;
+			r.gbps = bytes / r.nsPerOp;
+			r.allocsPerOp = static_cast<double>(blocks) / calls;
+			r.heapAllocsPerOp = static_cast<double>(heap) / calls;
+			m_results.push_back(r);
+
+			std::printf("%-24s %-20s %3u %14.1f ns %9.3f GFLOP/s %9.3f GB/s %7.2f allocs %7.2f heap\n",
+			            r.name.c_str(), r.shape.c_str(), r.threads, r.nsPerOp, r.gflops, r.gbps,
+			            r.allocsPerOp, r.heapAllocsPerOp);
+			std::fflush(stdout);
+		}
+
+		const std::vector<Result>& Results() const
+		{
+			return m_results;
+		}
+
+	private:
+		const Options&      m_options;
+		CountingAllocator&  m_allocator;
+		unsigned int        m_threads;
+		std::vector<Result> m_results;
+	};
+
+	/// \brief  Matrix entry points on a rows*cols shape; Mul multiplies by a cols*cols matrix.
+	void RunMatrixCases(Runner& runner, const unsigned int rows, const unsigned int cols)
+	{
+		const double elems = static_cast<double>(rows) * cols;
+		Matrix a(rows, cols);
+		Matrix b(rows, cols);
+		Matrix c(rows, cols);
+		Fill(a, 1.0);
+		Fill(b, 2.0);
+
+		if (runner.Wanted("Mul") || runner.Wanted("operator*") || runner.Wanted("StrassenMul"))
+		{
+			Matrix square(cols, cols);
+			Fill(square, 3.0);
+			const double flops = 2.0 * elems * cols;
+			const double bytes = 8.0 * (2 * elems + static_cast<double>(cols) * cols);
+			if (runner.Wanted("Mul"))
+			{
+				runner.Run("Mul", Shape(rows, cols, cols), flops, bytes, [&]()
+				{
+					Matrix::Mul(a, square, c);
+				});
+			}
+			if (runner.Wanted("StrassenMul"))
+			{
+				runner.Run("StrassenMul", Shape(rows, cols, cols), flops, bytes, [&]()
+				{
+					Matrix::StrassenMul(a, square, c);
+				});
+			}
+			if (runner.Wanted("operator*"))
+			{
+				runner.Run("operator*", Shape(rows, cols, cols), flops, bytes, [&]()
+				{
+					c = a * square;
+				});
+			}
+		}
+		if (runner.Wanted("MulAddAsync"))
+		{
+			//
+			// a * square + b as two dependent operations, the Add starting on finished bands.
+			//
+			Matrix square(cols, cols);
+			Fill(square, 3.0);
+			const MatrixFuture fa(a);
+			const MatrixFuture fb(b);
+			const MatrixFuture fsquare(square);
+			runner.Run("MulAddAsync", Shape(rows, cols, cols), 2.0 * elems * cols + elems,
+			           8.0 * (4 * elems + static_cast<double>(cols) * cols), [&]()
+			{
+				g_sink = AddAsync(MulAsync(fa, fsquare), fb).Get().Data()[0];
+			});
+		}
+		if (runner.Wanted("Gemm"))
+		{
+			Matrix square(cols, cols);
+			Fill(square, 3.0);
+			runner.Run("Gemm", Shape(rows, cols, cols), 2.0 * elems * cols + 2.0 * elems,
+			           8.0 * (3 * elems + static_cast<double>(cols) * cols), [&]()
+			{
+				Matrix::Gemm(0.5, a, Matrix::NoTrans, square, Matrix::NoTrans, 0.5, c);
+			});
+		}
+		if (runner.Wanted("Axpby"))
+		{
+			runner.Run("Axpby", Shape(rows, cols), 3.0 * elems, 24.0 * elems, [&]()
+			{
+				Matrix::Axpby(0.5, a, 0.5, c);
+			});
+		}
+		if (runner.Wanted("MulTransposed"))
+		{
+			Matrix gram(cols, cols);
+			runner.Run("MulTransposed", Shape(cols, rows, cols), 2.0 * elems * cols,
+			           8.0 * (2 * elems + static_cast<double>(cols) * cols), [&]()
+			{
+				Matrix::Mul(a, Matrix::Trans, b, Matrix::NoTrans, gram);
+			});
+		}
+		if (runner.Wanted("Transpose"))
+		{
+			Matrix transposed(cols, rows);
+			runner.Run("Transpose", Shape(rows, cols), 0.0, 16.0 * elems, [&]()
+			{
+				Matrix::Transpose(a, transposed);
+			});
+		}
+		if (runner.Wanted("Add"))
+		{
+			runner.Run("Add", Shape(rows, cols), elems, 24.0 * elems, [&]()
+			{
+				Matrix::Add(a, b, c);
+			});
+		}
+		if (runner.Wanted("DotMul"))
+		{
+			runner.Run("DotMul", Shape(rows, cols), elems, 24.0 * elems, [&]()
+			{
+				Matrix::DotMul(a, b, c);
+			});
+		}
+		if (runner.Wanted("Max"))
+		{
+			runner.Run("Max", Shape(rows, cols), elems, 8.0 * elems, [&]()
+			{
+				g_sink = Matrix::Max(a);
+			});
+		}
+		if (runner.Wanted("Min"))
+		{
+			runner.Run("Min", Shape(rows, cols), elems, 8.0 * elems, [&]()
+			{
+				g_sink = Matrix::Min(a);
+			});
+		}
+		if (runner.Wanted("Sum"))
+		{
+			runner.Run("Sum", Shape(rows, cols), elems, 8.0 * elems, [&]()
+			{
+				g_sink = Matrix::Sum(a);
+			});
+		}
+		if (runner.Wanted("Norm"))
+		{
+			runner.Run("Norm", Shape(rows, cols), 2.0 * elems, 8.0 * elems, [&]()
+			{
+				g_sink = Matrix::Norm(a, numeric::NormL2);
+			});
+		}
+		if (runner.Wanted("Dot"))
+		{
+			runner.Run("Dot", Shape(rows, cols), 2.0 * elems, 16.0 * elems, [&]()
+			{
+				g_sink = Matrix::Dot(a, b);
+			});
+		}
+		if (runner.Wanted("RowReduce"))
+		{
+			Matrix sums(rows, 1);
+			runner.Run("RowReduce", Shape(rows, cols), elems, 8.0 * elems, [&]()
+			{
+				Matrix::RowReduce(a, numeric::ReduceSum, sums);
+			});
+		}
+		if (runner.Wanted("ColReduce"))
+		{
+			Matrix sums(1, cols);
+			runner.Run("ColReduce", Shape(rows, cols), elems, 8.0 * elems, [&]()
+			{
+				Matrix::ColReduce(a, numeric::ReduceSum, sums);
+			});
+		}
+		if (runner.Wanted("CopyConstructor"))
+		{
+			runner.Run("CopyConstructor", Shape(rows, cols), 0.0, 16.0 * elems, [&]()
+			{
+				Matrix copy(a);
+				g_sink = copy.Data()[0];
+			});
+		}
+	}
+
+	/// \brief  Point transforms of n points, as a 2*n matrix and as coordinate arrays, and
+	///         compositions of a chain of n transforms.
+	void RunAffineCases(Runner& runner, const unsigned int n)
+	{
+		const AffineTransformParams atp(1.1, 0.2, -0.3, 0.9, 5.0, -7.0);
+		const double flops = 8.0 * n;
+		const double bytes = 32.0 * n;
+
+		if (runner.Wanted("AffineTransform"))
+		{
+			Matrix p(2, n);
+			Matrix q(2, n);
+			Fill(p, 1.0);
+			runner.Run("AffineTransform", Shape(2, n), flops, bytes, [&]()
+			{
+				AffineTransform(atp, p, q);
+			});
+		}
+		if (runner.Wanted("AffineTransformPoints"))
+		{
+			std::vector<double> x(n, 1.0);
+			std::vector<double> y(n, 2.0);
+			std::vector<double> tx(n);
+			std::vector<double> ty(n);
+			runner.Run("AffineTransformPoints", Shape(2, n), flops, bytes, [&]()
+			{
+				AffineTransformPoints(atp, n, &x[0], &y[0], &tx[0], &ty[0]);
+			});
+		}
+		if (runner.Wanted("AffinePipeline"))
+		{
+			//
+			// Four stages in one pass, against the 4 * flops and 4 * bytes of four passes.
+			//
+			AffinePipeline pipeline;
+			for (int stage = 0; stage < 4; stage++)
+			{
+				pipeline.Append(atp);
+			}
+			std::vector<double> x(n, 1.0);
+			std::vector<double> y(n, 2.0);
+			std::vector<double> tx(n);
+			std::vector<double> ty(n);
+			runner.Run("AffinePipeline", Shape(2, n), flops, bytes, [&]()
+			{
+				pipeline.Apply(n, &x[0], &y[0], &tx[0], &ty[0]);
+			});
+		}
+		if (runner.Wanted("CombineAffineTransformPrefixes"))
+		{
+			const std::vector<AffineTransformParams> chain(n, atp);
+			std::vector<AffineTransformParams> prefixes(n);
+			runner.Run("CombineAffineTransformPrefixes", Shape(6, n), 20.0 * n,
+			           2.0 * sizeof(AffineTransformParams) * n, [&]()
+			{
+				CombineAffineTransformPrefixes(n, &chain[0], &prefixes[0]);
+			});
+		}
+		if (runner.Wanted("CombineAffineTransforms"))
+		{
+			const std::vector<AffineTransformParams> chain(n, atp);
+			AffineTransformParams composite;
+			runner.Run("CombineAffineTransforms", Shape(6, n), 20.0 * n,
+			           1.0 * sizeof(AffineTransformParams) * n, [&]()
+			{
+				CombineAffineTransforms(n, &chain[0], composite);
+			});
+		}
+	}
+
+	/// \brief  Operations on single transforms.
+	void RunTransformCases(Runner& runner)
+	{
+		const AffineTransformParams atp0(1.1, 0.2, -0.3, 0.9, 5.0, -7.0);
+		const AffineTransformParams atp1(0.7, -0.1, 0.4, 1.3, -2.0, 3.0);
+		AffineTransformParams result;
+
+		if (runner.Wanted("InverseAffineTransform"))
+		{
+			runner.Run("InverseAffineTransform", "2x3", 14.0, 96.0, [&]()
+			{
+				g_sink = InverseAffineTransform(atp0, result) ? 1.0 : 0.0;
+			});
+		}
+		if (runner.Wanted("CombineAffineTransform"))
+		{
+			runner.Run("CombineAffineTransform", "2x3", 20.0, 144.0, [&]()
+			{
+				CombineAffineTransform(atp0, atp1, result);
+			});
+		}
+	}
+
+	std::string JsonString(const std::string& text)
+	{
+		std::string quoted = "\"";
+		for (size_t i = 0; i < text.size(); i++)
+		{
+			if (text[i] == '"' || text[i] == '\\')
+			{
+				quoted += '\\';
+			}
+			quoted += text[i];
+		}
+		return quoted + "\"";
+	}
+
+	void WriteJson(const std::string& path, const std::vector<Result>& results)
+	{
+		std::ofstream out(path.c_str());
+		out << "{\n";
+		out << "  \"library\": \"numeric\",\n";
+		out << "  \"isa\": " << JsonString(kernel::IsaName(kernel::ActiveIsa())) << ",\n";
+		out << "  \"results\": [\n";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& r = results[i];
+			out << "    {\"name\": " << JsonString(r.name)
+			    << ", \"shape\": " << JsonString(r.shape)
+			    << ", \"threads\": " << r.threads
+			    << ", \"ns_per_op\": " << r.nsPerOp
+			    << ", \"gflops\": " << r.gflops
+			    << ", \"gbps\": " << r.gbps
+			    << ", \"allocs_per_op\": " << r.allocsPerOp
+			    << ", \"heap_allocs_per_op\": " << r.heapAllocsPerOp
+			    << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n";
+		out << "}\n";
+		if (!out)
+		{
+			std::fprintf(stderr, "cannot write %s\n", path.c_str());
+		}
+	}
+
+	//
+	// The baseline reader only understands files written by WriteJson, one result per line.
+	//
+	bool FindField(const std::string& line, const std::string& key, std::string& value)
+	{
+		const std::string pattern = "\"" + key + "\": ";
+		const size_t at = line.find(pattern);
+		if (at == std::string::npos)
+		{
+			return false;
+		}
+		size_t begin = at + pattern.size();
+		size_t end;
+		if (line[begin] == '"')
+		{
+			begin++;
+			end = line.find('"', begin);
+		}
+		else
+		{
+			end = line.find_first_of(",}", begin);
+		}
+		if (end == std::string::npos)
+		{
+			return false;
+		}
+		value = line.substr(begin, end - begin);
+		return true;
+	}
+
+	std::string Key(const std::string& name, const std::string& shape, const unsigned int threads)
+	{
+		std::ostringstream os;
+		os << name << " " << shape << " " << threads;
+		return os.str();
+	}
+
+	/// \return Number of regressions.
+	size_t Compare(const std::string& path, const std::vector<Result>& results, const double threshold)
+	{
+		std::ifstream in(path.c_str());
+		if (!in)
+		{
+			std::fprintf(stderr, "cannot read %s\n", path.c_str());
+			return 1;
+		}
+
+		std::map<std::string, double> baseline;
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::string name;
+			std::string shape;
+			std::string threads;
+			std::string ns;
+			if (FindField(line, "name", name) && FindField(line, "shape", shape) &&
+				FindField(line, "threads", threads) && FindField(line, "ns_per_op", ns))
+			{
+				baseline[Key(name, shape, static_cast<unsigned int>(std::atoi(threads.c_str())))] =
+					std::atof(ns.c_str());
+			}
+		}
+
+		size_t regressions = 0;
+		size_t compared = 0;
+		std::printf("\ncomparison with %s (threshold %.0f%%)\n", path.c_str(), threshold * 100);
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Result& r = results[i];
+			const std::map<std::string, double>::const_iterator it = baseline.find(Key(r.name, r.shape, r.threads));
+			if (it == baseline.end() || it->second <= 0)
+			{
+				continue;
+			}
+			compared++;
+			const double change = r.nsPerOp / it->second - 1.0;
+			if (change > threshold)
+			{
+				regressions++;
+				std::printf("REGRESSION %-24s %-20s %3u %14.1f ns -> %14.1f ns (%+.1f%%)\n",
+				            r.name.c_str(), r.shape.c_str(), r.threads, it->second, r.nsPerOp, change * 100);
+			}
+			else if (change < -threshold)
+			{
+				std::printf("improved   %-24s %-20s %3u %14.1f ns -> %14.1f ns (%+.1f%%)\n",
+				            r.name.c_str(), r.shape.c_str(), r.threads, it->second, r.nsPerOp, change * 100);
+			}
+		}
+		std::printf("%u cases compared, %u regressions\n",
+		            static_cast<unsigned int>(compared), static_cast<unsigned int>(regressions));
+		return regressions;
+	}
+
+	/// \brief  Errors of Strassen-Winograd and of the classical product, relative to |A| |B|.
+	void ReportStrassenAccuracy(const unsigned int maxSize)
+	{
+		std::printf("%-6s %-10s %-6s %-10s %-14s %-14s %-8s %-14s\n", "type", "size", "cross", "levels",
+		            "strassen", "classical", "ratio", "max |diff|");
+		for (unsigned int size = 256; size <= maxSize; size *= 2)
+		{
+			for (unsigned int crossover = 64; crossover <= size; crossover *= 2)
+			{
+				const StrassenAccuracy f = MeasureStrassenAccuracy<float>(size, crossover, 1);
+				const StrassenAccuracy d = MeasureStrassenAccuracy<double>(size, crossover, 1);
+				const StrassenAccuracy* reports[] = {&f, &d};
+				const char* types[] = {"float", "double"};
+				for (int i = 0; i < 2; i++)
+				{
+					const StrassenAccuracy& r = *reports[i];
+					std::printf("%-6s %-10u %-6u %-10u %-14.3e %-14.3e %-8.1f %-14.3e\n", types[i],
+					            r.size, r.crossover, r.levels, r.strassenError, r.classicalError,
+					            r.classicalError > 0 ? r.strassenError / r.classicalError : 0.0,
+					            r.maxDifference);
+				}
+			}
+		}
+	}
+
+	/// \brief  Tune the kernels, write the cache and print the winners.
+	/// \return Whether the cache was written.
+	bool TuneAndSave()
+	{
+		const std::string path = kernel::TuningCachePath();
+		std::printf("cpu %s\nisa %s\nthreads %u\n", kernel::CpuModel().c_str(),
+		            kernel::IsaName(kernel::ActiveIsa()), ThreadPool::NumThreads());
+
+		const kernel::TuningParameters tuning = kernel::Tune();
+		std::printf("gemm float  mc %u kc %u nc %u\n",
+		            tuning.gemmFloat.mc, tuning.gemmFloat.kc, tuning.gemmFloat.nc);
+		std::printf("gemm double mc %u kc %u nc %u\n",
+		            tuning.gemmDouble.mc, tuning.gemmDouble.kc, tuning.gemmDouble.nc);
+		std::printf("gemm parallel from %.0f multiply-adds\n", tuning.gemmParallelFlops);
+		std::printf("transpose base edge %u, parallel from %lu elements\n", tuning.transposeBaseEdge,
+		            static_cast<unsigned long>(tuning.transposeParallelElements));
+		std::printf("strassen crossover %u\n", tuning.strassenCrossover);
+		std::printf("element-wise isa %s\n", kernel::IsaName(tuning.elementWiseIsa));
+
+		try
+		{
+			kernel::SaveTuning(path, tuning);
+		}
+		catch (const std::exception& e)
+		{
+			std::fprintf(stderr, "%s\n", e.what());
+			return false;
+		}
+		std::printf("written to %s\n", path.c_str());
+		return true;
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string arg = argv[i];
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--max-size" && hasValue)
+			{
+				options.maxSize = static_cast<unsigned int>(std::atoi(argv[++i]));
+			}
+			else if (arg == "--min-time" && hasValue)
+			{
+				options.minTime = std::atof(argv[++i]);
+			}
+			else if (arg == "--threshold" && hasValue)
+			{
+				options.threshold = std::atof(argv[++i]);
+			}
+			else if (arg == "--filter" && hasValue)
+			{
+				options.filter = argv[++i];
+			}
+			else if (arg == "--json" && hasValue)
+			{
+				options.json = argv[++i];
+			}
+			else if (arg == "--baseline" && hasValue)
+			{
+				options.baseline = argv[++i];
+			}
+			else if (arg == "--accuracy")
+			{
+				options.accuracy = true;
+			}
+			else if (arg == "--tune")
+			{
+				options.tune = true;
+			}
+			else if (arg == "--threads" && hasValue)
+			{
+				std::istringstream list(argv[++i]);
+				std::string item;
+				while (std::getline(list, item, ','))
+				{
+					const int threads = std::atoi(item.c_str());
+					if (threads > 0)
+					{
+						options.threads.push_back(static_cast<unsigned int>(threads));
+					}
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		if (options.threads.empty())
+		{
+			options.threads.push_back(1);
+			const unsigned int hardware = std::thread::hardware_concurrency();
+			if (hardware > 1)
+			{
+				options.threads.push_back(hardware);
+			}
+		}
+		return options.maxSize >= 2;
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		std::fprintf(stderr,
+			"usage: %s [--max-size N] [--threads 1,2,4] [--min-time seconds] [--filter text]\n"
+			"          [--json file] [--baseline file] [--threshold ratio] [--accuracy] [--tune]\n",
+			argv[0]);
+		return 2;
+	}
+
+	if (options.accuracy)
+	{
+		ReportStrassenAccuracy(options.maxSize);
+		return 0;
+	}
+	if (options.tune)
+	{
+		return TuneAndSave() ? 0 : 1;
+	}
+
+	CountingAllocator allocator(Allocator::Default());
+	Allocator::SetDefault(&allocator);
+	Runner runner(options, allocator);
+	std::printf("isa %s\n", kernel::IsaName(kernel::ActiveIsa()));
+
+	for (size_t t = 0; t < options.threads.size(); t++)
+	{
+		runner.SetThreads(options.threads[t]);
+
+		for (unsigned int size = 2; size <= options.maxSize; size *= 2)
+		{
+			RunMatrixCases(runner, size, size);
+		}
+
+		const unsigned long long maxElems = static_cast<unsigned long long>(options.maxSize) * options.maxSize;
+		for (unsigned long long rows = 1024; rows * 16 <= maxElems; rows *= 16)
+		{
+			RunMatrixCases(runner, static_cast<unsigned int>(rows), 16);
+		}
+
+		for (unsigned int size = 2; size <= options.maxSize; size *= 2)
+		{
+			RunAffineCases(runner, size * size);
+		}
+		RunTransformCases(runner);
+	}
+
+	Allocator::SetDefault(NULL);
+
+	if (!options.json.empty())
+	{
+		WriteJson(options.json, runner.Results());
+	}
+	if (!options.baseline.empty() && Compare(options.baseline, runner.Results(), options.threshold) > 0)
+	{
+		return 1;
+	}
+	return 0;
+}
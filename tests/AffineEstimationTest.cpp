@@ -0,0 +1,185 @@
+
+//
+// Affine estimation: least squares on exact correspondences, and RANSAC on correspondences
+// with a known set of outliers.
+//
+// Inliers are moved by at most 0.1 from the true target and outliers by at least 5, with a
+// threshold of 1, so RANSAC must report exactly the planted inliers. The same seed must give
+// bitwise the same transform and inliers on 1 and 4 threads.
+//
+#include "NumericTest.hpp"
+#include "AffineEstimation.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace numeric;
+
+namespace
+{
+	const unsigned int Threads[] = {1, 4};
+
+	template <typename T>
+	struct Correspondences
+	{
+		std::vector<T>             x;
+		std::vector<T>             y;
+		std::vector<T>             tx;
+		std::vector<T>             ty;
+		std::vector<unsigned char> inliers;
+	};
+
+	//
+	// n points in [-100, 100]^2 mapped by atp, with every outlierEvery-th one an outlier.
+	//
+	template <typename T>
+	Correspondences<T> Generate(const size_t n, const size_t outlierEvery, const double noise,
+	                            const BasicAffineTransformParams<T>& atp, const unsigned int seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_real_distribution<double> coordinate(-100, 100);
+		std::uniform_real_distribution<double> jitter(-noise, noise);
+		std::uniform_real_distribution<double> angle(0, 2 * 3.14159265358979);
+		std::uniform_real_distribution<double> distance(5, 50);
+
+		const T* l = atp.LinearMap().Data();
+		const T* t = atp.Translation().Data();
+		Correspondences<T> c;
+		for (size_t i = 0; i < n; i++)
+		{
+			const double x = coordinate(engine);
+			const double y = coordinate(engine);
+			double tx = l[0] * x + l[1] * y + t[0];
+			double ty = l[2] * x + l[3] * y + t[1];
+			const bool inlier = outlierEvery == 0 || i % outlierEvery != 0;
+			if (inlier)
+			{
+				tx += jitter(engine);
+				ty += jitter(engine);
+			}
+			else
+			{
+				const double a = angle(engine);
+				const double d = distance(engine);
+				tx += d * std::cos(a);
+				ty += d * std::sin(a);
+			}
+			c.x.push_back(static_cast<T>(x));
+			c.y.push_back(static_cast<T>(y));
+			c.tx.push_back(static_cast<T>(tx));
+			c.ty.push_back(static_cast<T>(ty));
+			c.inliers.push_back(inlier ? 1 : 0);
+		}
+		return c;
+	}
+
+	template <typename T>
+	double MaxDifference(const BasicAffineTransformParams<T>& a, const BasicAffineTransformParams<T>& b)
+	{
+		double difference = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			difference = std::max(difference, std::fabs(static_cast<double>(a.LinearMap().Data()[i]) - b.LinearMap().Data()[i]));
+		}
+		for (int i = 0; i < 2; i++)
+		{
+			difference = std::max(difference, std::fabs(static_cast<double>(a.Translation().Data()[i]) - b.Translation().Data()[i]));
+		}
+		return difference;
+	}
+
+	template <typename T>
+	void CheckLeastSquares(const BasicAffineTransformParams<T>& truth)
+	{
+		const Correspondences<T> c = Generate<T>(100000, 0, 0, truth, 1);
+		BasicAffineTransformParams<T> atp;
+		EstimateAffineTransform<T>(c.x.size(), &c.x[0], &c.y[0], &c.tx[0], &c.ty[0], atp);
+		NUMERIC_CHECK(MaxDifference(atp, truth) < 1e-3);
+
+		bool threw = false;
+		try
+		{
+			EstimateAffineTransform<T>(2, &c.x[0], &c.y[0], &c.tx[0], &c.ty[0], atp);
+		}
+		catch (const std::invalid_argument&)
+		{
+			threw = true;
+		}
+		NUMERIC_CHECK(threw);
+
+		const std::vector<T> line(10, T(1));
+		std::vector<T> ramp(10);
+		for (size_t i = 0; i < ramp.size(); i++)
+		{
+			ramp[i] = static_cast<T>(i);
+		}
+		threw = false;
+		try
+		{
+			EstimateAffineTransform<T>(10, &line[0], &ramp[0], &ramp[0], &ramp[0], atp);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		NUMERIC_CHECK(threw);
+	}
+
+	template <typename T>
+	void CheckRansac(const BasicAffineTransformParams<T>& truth, const size_t n, const size_t outlierEvery)
+	{
+		const Correspondences<T> c = Generate<T>(n, outlierEvery, 0.1, truth, 2);
+		size_t expectedCount = 0;
+		for (size_t i = 0; i < n; i++)
+		{
+			expectedCount += c.inliers[i];
+		}
+
+		RansacOptions options;
+		options.seed = 12345;
+
+		BasicAffineTransformParams<T> first;
+		std::vector<unsigned char> firstInliers(n, 2);
+		for (size_t t = 0; t < sizeof(Threads) / sizeof(Threads[0]); t++)
+		{
+			ThreadPool::SetNumThreads(Threads[t]);
+			BasicAffineTransformParams<T> atp;
+			std::vector<unsigned char> inliers(n, 2);
+			const size_t count = EstimateAffineTransformRansac<T>(n, &c.x[0], &c.y[0], &c.tx[0], &c.ty[0],
+			                                                      options, atp, &inliers[0]);
+			NUMERIC_CHECK(count == expectedCount);
+			NUMERIC_CHECK(inliers == c.inliers);
+			NUMERIC_CHECK(MaxDifference(atp, truth) < 0.05);
+			if (t == 0)
+			{
+				first = atp;
+				firstInliers = inliers;
+			}
+			else
+			{
+				NUMERIC_CHECK(MaxDifference(atp, first) == 0);
+				NUMERIC_CHECK(inliers == firstInliers);
+			}
+		}
+	}
+
+	template <typename T>
+	void CheckAll()
+	{
+		const BasicAffineTransformParams<T> truth(T(0.8), T(-0.6), T(0.7), T(0.9), T(12.5), T(-3.25));
+		CheckLeastSquares(truth);
+		CheckRansac(truth, 200, 3);
+		CheckRansac(truth, 50000, 2);
+	}
+}
+
+
+int main()
+{
+	CheckAll<float>();
+	CheckAll<double>();
+	return test::Result();
+}
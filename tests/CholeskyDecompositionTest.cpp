@@ -0,0 +1,125 @@
+
+//
+// Cholesky factor, solve and determinant on sizes around the panel width, on one and four
+// threads, against naive products.
+//
+#include "NumericTest.hpp"
+#include "CholeskyDecomposition.hpp"
+#include "ThreadPool.hpp"
+#include <limits>
+#include <stdexcept>
+
+using namespace numeric;
+
+namespace
+{
+	const unsigned int Sizes[] = {1, 2, 5, 64, 127, 128, 129, 300};
+
+	//
+	// A = L0 * L0^T for a lower-triangular L0 whose diagonal cycles through 1, 2 and 0.5 and
+	// whose other entries are at most 1/4, so det(A) is the squared product of the diagonal.
+	//
+	template <typename T>
+	BasicMatrix<T> LowerFactor(const unsigned int n, const unsigned int seed, double& determinant)
+	{
+		const T diagonal[] = {T(1), T(2), T(0.5)};
+		BasicMatrix<T> l = test::RandomMatrix<T>(n, n, seed);
+		determinant = 1;
+		for (unsigned int i = 0; i < n; i++)
+		{
+			for (unsigned int j = 0; j < n; j++)
+			{
+				l.SetElemAt(i, j, j < i ? l.GetElemAt(i, j) / T(16) : T(0));
+			}
+			l.SetElemAt(i, i, diagonal[i % 3]);
+			determinant *= static_cast<double>(diagonal[i % 3]) * diagonal[i % 3];
+		}
+		return l;
+	}
+
+	template <typename T>
+	void CheckFactor(const unsigned int n, const unsigned int seed)
+	{
+		double determinant = 0;
+		const BasicMatrix<T> l0 = LowerFactor<T>(n, seed, determinant);
+		BasicMatrix<T> a = test::NaiveMul(l0, false, l0, true);
+
+		//
+		// Only the lower triangle may be read.
+		//
+		for (unsigned int i = 0; i < n; i++)
+		{
+			for (unsigned int j = i + 1; j < n; j++)
+			{
+				a.SetElemAt(i, j, T(1000));
+			}
+		}
+
+		const BasicCholeskyDecomposition<T> cholesky(a);
+		if (!NUMERIC_CHECK(cholesky.IsPositiveDefinite()))
+		{
+			return;
+		}
+
+		const double tolerance = 10 * n * std::numeric_limits<T>::epsilon();
+		NUMERIC_CHECK(test::MaxDifference(cholesky.Factor(), l0) <= tolerance * test::MaxAbs(l0));
+		NUMERIC_CHECK(std::fabs(cholesky.Determinant() - determinant) <= tolerance * determinant);
+
+		const BasicMatrix<T> full = test::NaiveMul(l0, false, l0, true);
+		const BasicMatrix<T> b = test::RandomMatrix<T>(n, 3, seed + 1);
+		BasicMatrix<T> x(n, 3);
+		cholesky.Solve(b, x);
+		NUMERIC_CHECK(test::Residual(full, x, b) < 10);
+
+		BasicMatrix<T> inPlace = b;
+		cholesky.Solve(inPlace, inPlace);
+		NUMERIC_CHECK(test::MaxDifference(inPlace, x) == 0);
+	}
+
+	template <typename T>
+	void CheckNotPositiveDefinite()
+	{
+		double determinant = 0;
+		const BasicMatrix<T> l0 = LowerFactor<T>(140, 3, determinant);
+		BasicMatrix<T> a = test::NaiveMul(l0, false, l0, true);
+		a.SetElemAt(135, 135, -a.GetElemAt(135, 135));
+
+		const BasicCholeskyDecomposition<T> cholesky(a);
+		NUMERIC_CHECK(!cholesky.IsPositiveDefinite());
+
+		bool threw = false;
+		try
+		{
+			BasicMatrix<T> x(140, 1);
+			cholesky.Solve(test::RandomMatrix<T>(140, 1, 4), x);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		NUMERIC_CHECK(threw);
+	}
+
+	template <typename T>
+	void CheckAll()
+	{
+		for (size_t s = 0; s < sizeof(Sizes) / sizeof(Sizes[0]); s++)
+		{
+			CheckFactor<T>(Sizes[s], static_cast<unsigned int>(10 * s));
+		}
+		CheckNotPositiveDefinite<T>();
+	}
+}
+
+
+int main()
+{
+	const unsigned int threads[] = {1, 4};
+	for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+	{
+		ThreadPool::SetNumThreads(threads[t]);
+		CheckAll<float>();
+		CheckAll<double>();
+	}
+	return test::Result();
+}
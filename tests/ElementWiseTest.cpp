@@ -0,0 +1,240 @@
+
+//
+// Element-wise kernels on every instruction set this CPU runs, forced through SetTuning,
+// against the scalar kernels.
+//
+// Lengths around every vector width and unaligned starts exercise the tails. Operands are
+// small integers, except for the std::int32_t products, whose magnitudes reach 2^30 so that
+// the high halves of the SSE2 multiply emulation matter; every result is exact, so each
+// instruction set must match the scalar one exactly.
+//
+#include "NumericTest.hpp"
+#include "CpuFeatures.hpp"
+#include "ElementWise.hpp"
+#include "Tuning.hpp"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace numeric;
+
+namespace
+{
+	const size_t Lengths[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 65, 127, 129, 1000, 4099};
+
+	//
+	// Inputs start this many elements into their buffers, so no start is vector aligned.
+	//
+	const size_t Offset = 1;
+
+	template <typename T>
+	std::vector<T> RandomBuffer(const size_t n, const int range, const unsigned int seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_int_distribution<int> uniform(-range, range);
+		std::vector<T> buffer(n + Offset);
+		for (size_t i = 0; i < buffer.size(); i++)
+		{
+			buffer[i] = static_cast<T>(uniform(engine));
+		}
+		return buffer;
+	}
+
+	template <typename T>
+	bool Same(const T a, const T b)
+	{
+		return a == b || (a != a && b != b);
+	}
+
+	template <typename T>
+	bool Same(const std::vector<T>& a, const std::vector<T>& b)
+	{
+		if (a.size() != b.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (!Same(a[i], b[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//
+	// Everything the kernels produce for one length, under the instruction set in use.
+	//
+	template <typename T>
+	struct Results
+	{
+		std::vector<std::vector<T> > buffers;
+		std::vector<T>               values;
+		std::vector<size_t>          counts;
+	};
+
+	template <typename T>
+	Results<T> Run(const size_t n, const std::vector<T>& x, const std::vector<T>& y,
+	               const std::vector<T>& wide)
+	{
+		const T* px = &x[Offset];
+		const T* py = &y[Offset];
+		const T* pw = &wide[Offset];
+		Results<T> results;
+		std::vector<T> z(n + Offset, T(-7));
+		T* pz = &z[Offset];
+
+		kernel::Add<T>(n, px, py, pz);
+		results.buffers.push_back(z);
+		kernel::Sub<T>(n, px, py, pz);
+		results.buffers.push_back(z);
+		kernel::Mul<T>(n, px, py, pz);
+		results.buffers.push_back(z);
+		kernel::Mul<T>(n, pw, px, pz);
+		results.buffers.push_back(z);
+		kernel::Scale<T>(n, T(3), px, pz);
+		results.buffers.push_back(z);
+		kernel::Fill<T>(n, T(5), pz);
+		results.buffers.push_back(z);
+
+		std::vector<T> acc(y);
+		kernel::Axpby<T>(n, T(2), px, T(-3), &acc[Offset]);
+		results.buffers.push_back(acc);
+		acc = y;
+		kernel::Axpby<T>(n, T(2), px, T(0), &acc[Offset]);
+		results.buffers.push_back(acc);
+
+		kernel::Add<T>(n, px, px, &acc[Offset]);
+		results.buffers.push_back(acc);
+
+		for (int op = 0; op < kernel::NumReduceKernels; op++)
+		{
+			const kernel::ReduceKernel k = static_cast<kernel::ReduceKernel>(op);
+			results.values.push_back(kernel::Reduce<T>(k, n, px, T(1)));
+			acc = y;
+			kernel::Accumulate<T>(k, n, px, &acc[Offset]);
+			results.buffers.push_back(acc);
+		}
+		results.values.push_back(kernel::Max<T>(n, px, std::numeric_limits<T>::lowest()));
+		results.values.push_back(kernel::Min<T>(n, px, std::numeric_limits<T>::max()));
+		results.values.push_back(kernel::Dot<T>(n, px, py));
+
+		//
+		// Affine maps on x and y, separate and interleaved, and the inliers of a target that
+		// is the mapped points for every third point and off by 1 elsewhere.
+		//
+		const T linearMap[4] = {T(2), T(-1), T(1), T(3)};
+		const T translation[2] = {T(4), T(-2)};
+		std::vector<T> tx(n + Offset, T(-7));
+		std::vector<T> ty(n + Offset, T(-7));
+		kernel::AffinePoints<T>(n, linearMap, translation, px, py, &tx[Offset], &ty[Offset]);
+		results.buffers.push_back(tx);
+		results.buffers.push_back(ty);
+
+		std::vector<T> xy(2 * n + Offset);
+		for (size_t i = 0; i < n; i++)
+		{
+			xy[Offset + 2 * i] = px[i];
+			xy[Offset + 2 * i + 1] = py[i];
+		}
+		std::vector<T> txy(2 * n + Offset, T(-7));
+		kernel::AffinePointsInterleaved<T>(n, linearMap, translation, &xy[Offset], &txy[Offset]);
+		results.buffers.push_back(txy);
+
+		for (size_t i = 0; i < n; i++)
+		{
+			tx[Offset + i] += static_cast<T>(i % 3 == 0 ? 0 : 1);
+		}
+		results.counts.push_back(kernel::CountAffineInliers<T>(n, linearMap, translation, px, py,
+		                                                       &tx[Offset], &ty[Offset], T(0)));
+		results.counts.push_back(kernel::CountAffineInliers<T>(n, linearMap, translation, px, py,
+		                                                       &tx[Offset], &ty[Offset], T(1)));
+		return results;
+	}
+
+	template <typename T>
+	bool Same(const Results<T>& a, const Results<T>& b)
+	{
+		if (a.buffers.size() != b.buffers.size() || !Same(a.values, b.values) || a.counts != b.counts)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.buffers.size(); i++)
+		{
+			if (!Same(a.buffers[i], b.buffers[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void UseIsa(const kernel::Isa isa)
+	{
+		kernel::TuningParameters tuning = kernel::DefaultTuning();
+		tuning.elementWiseIsa = isa;
+		kernel::SetTuning(tuning);
+	}
+
+	template <typename T>
+	void CheckAll(const int wideRange)
+	{
+		for (size_t l = 0; l < sizeof(Lengths) / sizeof(Lengths[0]); l++)
+		{
+			const size_t n = Lengths[l];
+			const unsigned int seed = static_cast<unsigned int>(3 * l);
+			const std::vector<T> x = RandomBuffer<T>(n, 9, seed);
+			const std::vector<T> y = RandomBuffer<T>(n, 9, seed + 1);
+			const std::vector<T> wide = RandomBuffer<T>(n, wideRange, seed + 2);
+
+			UseIsa(kernel::IsaScalar);
+			const Results<T> expected = Run(n, x, y, wide);
+			for (int isa = kernel::IsaSse2; isa <= kernel::ActiveIsa(); isa++)
+			{
+				UseIsa(static_cast<kernel::Isa>(isa));
+				NUMERIC_CHECK(Same(Run(n, x, y, wide), expected));
+			}
+		}
+	}
+
+	//
+	// NaNs in a floating-point buffer: the sums propagate them, Max, Min and MaxAbs skip them.
+	//
+	template <typename T>
+	void CheckNaN()
+	{
+		std::vector<T> x = RandomBuffer<T>(37, 9, 99);
+		x[Offset + 5] = std::numeric_limits<T>::quiet_NaN();
+		x[Offset + 30] = std::numeric_limits<T>::quiet_NaN();
+		for (int isa = kernel::IsaScalar; isa <= kernel::ActiveIsa(); isa++)
+		{
+			UseIsa(static_cast<kernel::Isa>(isa));
+			NUMERIC_CHECK(std::isnan(kernel::Reduce<T>(kernel::ReduceKernelSum, 37, &x[Offset], T(0))));
+			NUMERIC_CHECK(std::isnan(kernel::Reduce<T>(kernel::ReduceKernelSumSquares, 37, &x[Offset], T(0))));
+			NUMERIC_CHECK(!std::isnan(kernel::Reduce<T>(kernel::ReduceKernelMax, 37, &x[Offset], T(-100))));
+			NUMERIC_CHECK(!std::isnan(kernel::Reduce<T>(kernel::ReduceKernelMin, 37, &x[Offset], T(100))));
+			NUMERIC_CHECK(!std::isnan(kernel::Reduce<T>(kernel::ReduceKernelMaxAbs, 37, &x[Offset], T(0))));
+			NUMERIC_CHECK(kernel::Max<T>(2, &x[Offset + 5], T(-100)) == x[Offset + 6]);
+		}
+	}
+}
+
+
+int main()
+{
+	CheckAll<float>(9);
+	CheckAll<double>(9);
+
+	//
+	// |wide * x| stays below 2^31 with |x| <= 9.
+	//
+	CheckAll<std::int32_t>(std::numeric_limits<std::int32_t>::max() / 9);
+
+	CheckNaN<float>();
+	CheckNaN<double>();
+	kernel::SetTuning(kernel::DefaultTuning());
+	return test::Result();
+}
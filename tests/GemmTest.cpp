@@ -0,0 +1,183 @@
+
+//
+// GEMM packing and blocking against a one-dot-product-per-element reference.
+//
+// Shapes straddle the register tiles and the cache blocks, and each product runs with the
+// default blocks on one thread, with blocks a few tiles wide so that every edge case of the
+// packing is crossed many times, and with those blocks split across four threads.
+//
+#include "NumericTest.hpp"
+#include "Gemm.hpp"
+#include "MatrixView.hpp"
+#include "ThreadPool.hpp"
+#include "Tuning.hpp"
+#include <cstdint>
+#include <vector>
+
+using namespace numeric;
+
+namespace
+{
+	struct Shape
+	{
+		unsigned int m;
+		unsigned int n;
+		unsigned int k;
+	};
+
+	const Shape Shapes[] =
+	{
+		{1, 1, 1},
+		{1, 17, 3},
+		{19, 1, 5},
+		{3, 5, 7},
+		{4, 16, 1},
+		{17, 33, 65},
+		{130, 257, 131},
+		{260, 40, 700},
+		{8, 2100, 20}
+	};
+
+	template <typename T>
+	void CheckMul(const Shape& shape, const unsigned int seed)
+	{
+		const BasicMatrix<T> a = test::RandomMatrix<T>(shape.m, shape.k, seed);
+		const BasicMatrix<T> b = test::RandomMatrix<T>(shape.k, shape.n, seed + 1);
+		BasicMatrix<T> c(shape.m, shape.n);
+		BasicMatrix<T>::Mul(a, b, c);
+		NUMERIC_CHECK(test::MaxDifference(c, test::NaiveMul(a, false, b, false)) == 0);
+	}
+
+	//
+	// Transposed operands only change the strides the packing reads with.
+	//
+	template <typename T>
+	void CheckTransposed(const Shape& shape, const unsigned int seed)
+	{
+		const BasicMatrix<T> a = test::RandomMatrix<T>(shape.m, shape.k, seed);
+		const BasicMatrix<T> at = test::RandomMatrix<T>(shape.k, shape.m, seed + 1);
+		const BasicMatrix<T> b = test::RandomMatrix<T>(shape.k, shape.n, seed + 2);
+		const BasicMatrix<T> bt = test::RandomMatrix<T>(shape.n, shape.k, seed + 3);
+		BasicMatrix<T> c(shape.m, shape.n);
+
+		BasicMatrix<T>::Mul(at, BasicMatrix<T>::Trans, b, BasicMatrix<T>::NoTrans, c);
+		NUMERIC_CHECK(test::MaxDifference(c, test::NaiveMul(at, true, b, false)) == 0);
+		BasicMatrix<T>::Mul(a, BasicMatrix<T>::NoTrans, bt, BasicMatrix<T>::Trans, c);
+		NUMERIC_CHECK(test::MaxDifference(c, test::NaiveMul(a, false, bt, true)) == 0);
+		BasicMatrix<T>::Mul(at, BasicMatrix<T>::Trans, bt, BasicMatrix<T>::Trans, c);
+		NUMERIC_CHECK(test::MaxDifference(c, test::NaiveMul(at, true, bt, true)) == 0);
+	}
+
+	//
+	// c = 2 * a * b - c on blocks of larger matrices, so that every operand has a leading
+	// dimension wider than its rows, and on a column-major result through the raw kernel.
+	//
+	template <typename T>
+	void CheckStrided(const Shape& shape, const unsigned int seed)
+	{
+		const BasicMatrix<T> a = test::RandomMatrix<T>(shape.m + 3, shape.k + 5, seed);
+		const BasicMatrix<T> b = test::RandomMatrix<T>(shape.k + 2, shape.n + 7, seed + 1);
+		const BasicMatrix<T> c0 = test::RandomMatrix<T>(shape.m + 1, shape.n + 4, seed + 2);
+
+		BasicMatrix<T> ablock(shape.m, shape.k);
+		BasicMatrix<T> bblock(shape.k, shape.n);
+		BasicMatrix<T> expected(shape.m, shape.n);
+		for (unsigned int i = 0; i < shape.m; i++)
+		{
+			for (unsigned int p = 0; p < shape.k; p++)
+			{
+				ablock.SetElemAt(i, p, a.GetElemAt(i + 1, p + 2));
+			}
+		}
+		for (unsigned int p = 0; p < shape.k; p++)
+		{
+			for (unsigned int j = 0; j < shape.n; j++)
+			{
+				bblock.SetElemAt(p, j, b.GetElemAt(p + 2, j + 3));
+			}
+		}
+		const BasicMatrix<T> product = test::NaiveMul(ablock, false, bblock, false);
+		for (unsigned int i = 0; i < shape.m; i++)
+		{
+			for (unsigned int j = 0; j < shape.n; j++)
+			{
+				expected.SetElemAt(i, j, T(2) * product.GetElemAt(i, j) - c0.GetElemAt(i + 1, j + 1));
+			}
+		}
+
+		BasicMatrix<T> c = c0;
+		BasicMatrix<T>::Gemm(T(2), a.Block(1, 2, shape.m, shape.k), b.Block(2, 3, shape.k, shape.n),
+		                     T(-1), c.Block(1, 1, shape.m, shape.n));
+		BasicMatrix<T> result(shape.m, shape.n);
+		for (unsigned int i = 0; i < shape.m; i++)
+		{
+			for (unsigned int j = 0; j < shape.n; j++)
+			{
+				result.SetElemAt(i, j, c.GetElemAt(i + 1, j + 1));
+			}
+		}
+		NUMERIC_CHECK(test::MaxDifference(result, expected) == 0);
+
+		std::vector<T> columnMajor(static_cast<size_t>(shape.m) * shape.n);
+		for (unsigned int i = 0; i < shape.m; i++)
+		{
+			for (unsigned int j = 0; j < shape.n; j++)
+			{
+				columnMajor[i + static_cast<size_t>(j) * shape.m] = c0.GetElemAt(i + 1, j + 1);
+			}
+		}
+		kernel::Gemm<T>(shape.m, shape.n, shape.k, T(2),
+		                a.Data() + a.Cols() + 2, a.Cols(), 1,
+		                b.Data() + 2 * b.Cols() + 3, b.Cols(), 1,
+		                T(-1), &columnMajor[0], 1, shape.m);
+		for (unsigned int i = 0; i < shape.m; i++)
+		{
+			for (unsigned int j = 0; j < shape.n; j++)
+			{
+				result.SetElemAt(i, j, columnMajor[i + static_cast<size_t>(j) * shape.m]);
+			}
+		}
+		NUMERIC_CHECK(test::MaxDifference(result, expected) == 0);
+	}
+
+	template <typename T>
+	void CheckAllShapes()
+	{
+		for (size_t s = 0; s < sizeof(Shapes) / sizeof(Shapes[0]); s++)
+		{
+			const unsigned int seed = static_cast<unsigned int>(10 * s);
+			CheckMul<T>(Shapes[s], seed);
+			CheckTransposed<T>(Shapes[s], seed);
+			CheckStrided<T>(Shapes[s], seed);
+		}
+	}
+
+	void CheckAllTypes()
+	{
+		CheckAllShapes<float>();
+		CheckAllShapes<double>();
+		CheckAllShapes<std::int32_t>();
+	}
+}
+
+
+int main()
+{
+	const kernel::TuningParameters defaults = kernel::DefaultTuning();
+	kernel::SetTuning(defaults);
+	ThreadPool::SetNumThreads(1);
+	CheckAllTypes();
+
+	kernel::TuningParameters small = defaults;
+	const kernel::GemmBlocks blocks = {8, 24, 48};
+	small.gemmFloat = blocks;
+	small.gemmDouble = blocks;
+	small.gemmParallelFlops = 0;
+	kernel::SetTuning(small);
+	CheckAllTypes();
+
+	ThreadPool::SetNumThreads(4);
+	CheckAllTypes();
+
+	return test::Result();
+}
@@ -0,0 +1,147 @@
+
+//
+// LU solve, inverse and determinant on sizes around the panel width, on one and four threads.
+//
+// Solutions are judged by their residual against a naive product. Determinants are checked
+// on matrices built as a row-swapped L * U with a known diagonal, whose determinant is exact.
+//
+#include "NumericTest.hpp"
+#include "LUDecomposition.hpp"
+#include "ThreadPool.hpp"
+#include <limits>
+#include <stdexcept>
+
+using namespace numeric;
+
+namespace
+{
+	const unsigned int Sizes[] = {1, 2, 5, 64, 127, 128, 129, 300};
+
+	template <typename T>
+	void CheckSolve(const unsigned int n, const unsigned int seed)
+	{
+		BasicMatrix<T> a = test::RandomMatrix<T>(n, n, seed);
+		for (unsigned int i = 0; i < n; i++)
+		{
+			a.SetElemAt(i, i, a.GetElemAt(i, i) + T(1));
+		}
+		const BasicMatrix<T> b = test::RandomMatrix<T>(n, 3, seed + 1);
+
+		const BasicLUDecomposition<T> lu(a);
+		if (!NUMERIC_CHECK(!lu.IsSingular()))
+		{
+			return;
+		}
+
+		BasicMatrix<T> x(n, 3);
+		lu.Solve(b, x);
+		NUMERIC_CHECK(test::Residual(a, x, b) < 10);
+
+		BasicMatrix<T> inPlace = b;
+		lu.Solve(inPlace, inPlace);
+		NUMERIC_CHECK(test::MaxDifference(inPlace, x) == 0);
+
+		BasicMatrix<T> inv(n, n);
+		lu.Inverse(inv);
+		BasicMatrix<T> identity(n, n);
+		BasicMatrix<T>::Zero(identity);
+		for (unsigned int i = 0; i < n; i++)
+		{
+			identity.SetElemAt(i, i, T(1));
+		}
+		NUMERIC_CHECK(test::Residual(a, inv, identity) < 10);
+
+		BasicMatrix<T> y(n, 3);
+		Solve(a, b, y);
+		NUMERIC_CHECK(test::MaxDifference(y, x) == 0);
+	}
+
+	//
+	// A = P * L * U, with unit lower L, upper U whose diagonal cycles through 1, -1, 2 and 0.5,
+	// and P one row swap, so det(A) = -(product of the diagonal) is a power of two. The other
+	// entries of L and U are at most 1/4, which keeps A well conditioned at every size.
+	//
+	template <typename T>
+	void CheckDeterminant(const unsigned int n, const unsigned int seed)
+	{
+		const T diagonal[] = {T(1), T(-1), T(2), T(0.5)};
+		BasicMatrix<T> l = test::RandomMatrix<T>(n, n, seed);
+		BasicMatrix<T> u = test::RandomMatrix<T>(n, n, seed + 1);
+		double expected = 1;
+		for (unsigned int i = 0; i < n; i++)
+		{
+			for (unsigned int j = 0; j < n; j++)
+			{
+				l.SetElemAt(i, j, j < i ? l.GetElemAt(i, j) / T(16) : T(0));
+				u.SetElemAt(i, j, j > i ? u.GetElemAt(i, j) / T(16) : T(0));
+			}
+			l.SetElemAt(i, i, T(1));
+			u.SetElemAt(i, i, diagonal[i % 4]);
+			expected *= diagonal[i % 4];
+		}
+
+		BasicMatrix<T> a = test::NaiveMul(l, false, u, false);
+		if (n > 1)
+		{
+			for (unsigned int j = 0; j < n; j++)
+			{
+				const T first = a.GetElemAt(0, j);
+				a.SetElemAt(0, j, a.GetElemAt(n - 1, j));
+				a.SetElemAt(n - 1, j, first);
+			}
+			expected = -expected;
+		}
+
+		const double determinant = static_cast<double>(Determinant(a));
+		NUMERIC_CHECK(std::fabs(determinant - expected) <= std::fabs(expected) * 1e3 * n * std::numeric_limits<T>::epsilon());
+	}
+
+	template <typename T>
+	void CheckSingular()
+	{
+		BasicMatrix<T> a = test::RandomMatrix<T>(140, 140, 7);
+		for (unsigned int j = 0; j < a.Cols(); j++)
+		{
+			a.SetElemAt(70, j, T(0));
+		}
+		const BasicLUDecomposition<T> lu(a);
+		NUMERIC_CHECK(lu.IsSingular());
+		NUMERIC_CHECK(lu.Determinant() == T(0));
+
+		bool threw = false;
+		try
+		{
+			BasicMatrix<T> x(140, 1);
+			lu.Solve(test::RandomMatrix<T>(140, 1, 8), x);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		NUMERIC_CHECK(threw);
+	}
+
+	template <typename T>
+	void CheckAll()
+	{
+		for (size_t s = 0; s < sizeof(Sizes) / sizeof(Sizes[0]); s++)
+		{
+			CheckSolve<T>(Sizes[s], static_cast<unsigned int>(10 * s));
+			CheckDeterminant<T>(Sizes[s], static_cast<unsigned int>(10 * s + 5));
+		}
+		CheckSingular<T>();
+	}
+}
+
+
+int main()
+{
+	const unsigned int threads[] = {1, 4};
+	for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+	{
+		ThreadPool::SetNumThreads(threads[t]);
+		CheckAll<float>();
+		CheckAll<double>();
+	}
+	return test::Result();
+}
@@ -0,0 +1,317 @@
+
+//
+// Matrix files: round trips of every element type, files of the other byte order, data
+// after padding, and rejection of crafted headers by both LoadMatrix and MappedMatrixFile.
+//
+#include "NumericTest.hpp"
+#include "MatrixFile.hpp"
+#include "MatrixView.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace numeric;
+
+namespace
+{
+	const char* const FilePath = "numeric_test_matrix_file.bin";
+
+	typedef std::vector<unsigned char> Bytes;
+
+	Bytes ReadFile(const std::string& path)
+	{
+		std::ifstream in(path.c_str(), std::ios::binary);
+		return Bytes(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	void WriteFile(const std::string& path, const Bytes& bytes)
+	{
+		std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	template <typename U>
+	void Patch(Bytes& bytes, const size_t offset, const U value)
+	{
+		std::memcpy(&bytes[offset], &value, sizeof(U));
+	}
+
+	template <typename T>
+	bool SameMatrix(const BasicMatrix<T>& a, const MatrixView<const T>& b)
+	{
+		if (a.Rows() != b.Rows() || a.Cols() != b.Cols())
+		{
+			return false;
+		}
+		for (unsigned int i = 0; i < a.Rows(); i++)
+		{
+			for (unsigned int j = 0; j < a.Cols(); j++)
+			{
+				if (a.GetElemAt(i, j) != b(i, j))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	template <typename T>
+	void CheckRoundTrip()
+	{
+		const BasicMatrix<T> mat = test::RandomMatrix<T>(37, 11, 1);
+		SaveMatrix(FilePath, mat);
+
+		BasicMatrix<T> loaded;
+		LoadMatrix(FilePath, loaded);
+		NUMERIC_CHECK(test::MaxDifference(loaded, mat) == 0);
+
+		{
+			const MappedMatrixFile file(FilePath);
+			NUMERIC_CHECK(file.Rows() == 37 && file.Cols() == 11);
+			NUMERIC_CHECK(SameMatrix(mat, file.View<T>()));
+			NUMERIC_CHECK(reinterpret_cast<std::uintptr_t>(file.View<T>().Data()) % MatrixFileHeaderBytes == 0);
+		}
+
+		//
+		// A block is written as a matrix of its own.
+		//
+		SaveMatrix(FilePath, mat.Block(3, 2, 20, 5));
+		LoadMatrix(FilePath, loaded);
+		NUMERIC_CHECK(SameMatrix(loaded, mat.Block(3, 2, 20, 5)));
+
+		CreateMatrixFile<T>(FilePath, 5, 300);
+		LoadMatrix(FilePath, loaded);
+		BasicMatrix<T> zeros(5, 300);
+		BasicMatrix<T>::Zero(zeros);
+		NUMERIC_CHECK(test::MaxDifference(loaded, zeros) == 0);
+	}
+
+	//
+	// Every header field and element reversed, as a machine of the other byte order writes
+	// them. LoadMatrix converts such a file; mapping it is refused.
+	//
+	template <typename T>
+	void CheckOtherByteOrder()
+	{
+		const BasicMatrix<T> mat = test::RandomMatrix<T>(9, 13, 2);
+		SaveMatrix(FilePath, mat);
+		Bytes bytes = ReadFile(FilePath);
+
+		const size_t fields[][2] =
+		{
+			{8, 4}, {12, 4}, {16, 4}, {20, 4}, {24, 4}, {28, 4}, {32, 4}, {36, 4}, {40, 8}, {48, 8}, {56, 8}
+		};
+		for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++)
+		{
+			std::reverse(&bytes[fields[f][0]], &bytes[fields[f][0]] + fields[f][1]);
+		}
+		for (size_t offset = MatrixFileHeaderBytes; offset < bytes.size(); offset += sizeof(T))
+		{
+			std::reverse(&bytes[offset], &bytes[offset] + sizeof(T));
+		}
+		WriteFile(FilePath, bytes);
+
+		BasicMatrix<T> loaded;
+		LoadMatrix(FilePath, loaded);
+		NUMERIC_CHECK(test::MaxDifference(loaded, mat) == 0);
+
+		bool threw = false;
+		try
+		{
+			const MappedMatrixFile file(FilePath);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		NUMERIC_CHECK(threw);
+	}
+
+	//
+	// Data placed after padding, at an offset the header gives, reads back from both readers.
+	//
+	void CheckPaddedData()
+	{
+		const BasicMatrix<double> mat = test::RandomMatrix<double>(9, 13, 5);
+		SaveMatrix(FilePath, mat);
+		Bytes bytes = ReadFile(FilePath);
+		const size_t offset = 4096;
+		bytes.insert(bytes.begin() + MatrixFileHeaderBytes, offset - MatrixFileHeaderBytes, 0xcd);
+		Patch<std::uint32_t>(bytes, 32, static_cast<std::uint32_t>(offset));
+		Patch<std::uint64_t>(bytes, 40, offset);
+		WriteFile(FilePath, bytes);
+
+		Matrix loaded;
+		LoadMatrix(FilePath, loaded);
+		NUMERIC_CHECK(test::MaxDifference(loaded, mat) == 0);
+
+		const MappedMatrixFile file(FilePath);
+		NUMERIC_CHECK(SameMatrix(mat, file.View<double>()));
+	}
+
+	//
+	// True when both readers throw std::runtime_error for the file.
+	//
+	bool Rejected(const Bytes& bytes)
+	{
+		WriteFile(FilePath, bytes);
+		int rejections = 0;
+		try
+		{
+			Matrix mat;
+			LoadMatrix(FilePath, mat);
+		}
+		catch (const std::runtime_error&)
+		{
+			rejections++;
+		}
+		try
+		{
+			const MappedMatrixFile file(FilePath);
+		}
+		catch (const std::runtime_error&)
+		{
+			rejections++;
+		}
+		return rejections == 2;
+	}
+
+	void CheckRejectedHeaders()
+	{
+		SaveMatrix(FilePath, test::RandomMatrix<double>(6, 10, 3));
+		const Bytes valid = ReadFile(FilePath);
+		NUMERIC_CHECK(!Rejected(valid));
+
+		Bytes bytes = valid;
+		bytes[0] = 'X';
+		NUMERIC_CHECK(Rejected(bytes));
+
+		NUMERIC_CHECK(Rejected(Bytes(valid.begin(), valid.begin() + MatrixFileHeaderBytes - 1)));
+
+		bytes = valid;
+		Patch<std::uint32_t>(bytes, 8, MatrixFileVersion + 1);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		bytes = valid;
+		Patch<std::uint32_t>(bytes, 12, 0x01020305);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		bytes = valid;
+		Patch<std::uint32_t>(bytes, 16, 4);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		bytes = valid;
+		Patch<std::uint32_t>(bytes, 20, 4);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		bytes = valid;
+		Patch<std::uint32_t>(bytes, 24, 0);
+		Patch<std::uint64_t>(bytes, 48, 0);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		//
+		// 2^31 * 2^31 * 8 bytes wraps to zero in 64 bits.
+		//
+		bytes = valid;
+		Patch<std::uint32_t>(bytes, 24, 1u << 31);
+		Patch<std::uint32_t>(bytes, 28, 1u << 31);
+		Patch<std::uint64_t>(bytes, 48, 0);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		//
+		// An offset so large that offset + size wraps back into the file.
+		//
+		bytes = valid;
+		Patch<std::uint64_t>(bytes, 40, ~std::uint64_t(0) - 63);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		bytes = valid;
+		Patch<std::uint32_t>(bytes, 32, 0);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		bytes = valid;
+		Patch<std::uint64_t>(bytes, 40, 96);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		//
+		// Aligned as the header says, but not to the element size.
+		//
+		bytes = valid;
+		bytes.insert(bytes.begin() + MatrixFileHeaderBytes, 4, 0);
+		Patch<std::uint32_t>(bytes, 32, 4);
+		Patch<std::uint64_t>(bytes, 40, MatrixFileHeaderBytes + 4);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		bytes = valid;
+		Patch<std::uint64_t>(bytes, 40, 32);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		bytes = valid;
+		Patch<std::uint64_t>(bytes, 48, 6 * 10 * 8 - 8);
+		NUMERIC_CHECK(Rejected(bytes));
+
+		NUMERIC_CHECK(Rejected(Bytes(valid.begin(), valid.end() - 1)));
+	}
+
+	void CheckInvalidArguments()
+	{
+		SaveMatrix(FilePath, test::RandomMatrix<double>(4, 4, 4));
+
+		bool threw = false;
+		try
+		{
+			MatrixF mat;
+			LoadMatrix(FilePath, mat);
+		}
+		catch (const std::invalid_argument&)
+		{
+			threw = true;
+		}
+		NUMERIC_CHECK(threw);
+
+		threw = false;
+		try
+		{
+			const MappedMatrixFile file(FilePath);
+			file.View<std::int32_t>();
+		}
+		catch (const std::invalid_argument&)
+		{
+			threw = true;
+		}
+		NUMERIC_CHECK(threw);
+
+		threw = false;
+		try
+		{
+			SaveMatrix(FilePath, Matrix());
+		}
+		catch (const std::invalid_argument&)
+		{
+			threw = true;
+		}
+		NUMERIC_CHECK(threw);
+	}
+}
+
+
+int main()
+{
+	CheckRoundTrip<float>();
+	CheckRoundTrip<double>();
+	CheckRoundTrip<std::int32_t>();
+	CheckOtherByteOrder<float>();
+	CheckOtherByteOrder<double>();
+	CheckOtherByteOrder<std::int32_t>();
+	CheckPaddedData();
+	CheckRejectedHeaders();
+	CheckInvalidArguments();
+	std::remove(FilePath);
+	return test::Result();
+}
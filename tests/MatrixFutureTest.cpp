@@ -0,0 +1,146 @@
+
+//
+// MatrixFuture graphs against the same operations run synchronously.
+//
+// The shapes span several bands of rows, and the chain mixes element-wise operations, which
+// depend on matching bands, with products, which depend on every band of their right
+// operand and on bands of a different height. Each graph is issued in one go, before any
+// result is waited for, and runs at several scheduler thread counts.
+//
+#include "NumericTest.hpp"
+#include "MatrixFuture.hpp"
+#include "TaskScheduler.hpp"
+#include <cstdint>
+#include <stdexcept>
+
+using namespace numeric;
+
+namespace
+{
+	template <typename T>
+	BasicMatrix<T> Product(const BasicMatrix<T>& a, const BasicMatrix<T>& b)
+	{
+		BasicMatrix<T> c(a.Rows(), b.Cols());
+		BasicMatrix<T>::Mul(a, b, c);
+		return c;
+	}
+
+	template <typename T>
+	BasicMatrix<T> Sum(const BasicMatrix<T>& a, const BasicMatrix<T>& b)
+	{
+		BasicMatrix<T> c(a.Rows(), a.Cols());
+		BasicMatrix<T>::Add(a, b, c);
+		return c;
+	}
+
+	template <typename T>
+	BasicMatrix<T> Difference(const BasicMatrix<T>& a, const BasicMatrix<T>& b)
+	{
+		BasicMatrix<T> c(a.Rows(), a.Cols());
+		BasicMatrix<T>::Sub(a, b, c);
+		return c;
+	}
+
+	template <typename T>
+	BasicMatrix<T> ElementProduct(const BasicMatrix<T>& a, const BasicMatrix<T>& b)
+	{
+		BasicMatrix<T> c(a.Rows(), a.Cols());
+		BasicMatrix<T>::DotMul(a, b, c);
+		return c;
+	}
+
+	//
+	// Every intermediate value stays below 2^24, so float results are exact too.
+	//
+	template <typename T>
+	void CheckGraph(const unsigned int seed)
+	{
+		const BasicMatrix<T> a = test::RandomMatrix<T>(700, 300, seed);
+		const BasicMatrix<T> b = test::RandomMatrix<T>(300, 300, seed + 1);
+		const BasicMatrix<T> c = test::RandomMatrix<T>(700, 300, seed + 2);
+		const BasicMatrix<T> g = test::RandomMatrix<T>(300, 50, seed + 3);
+		const BasicMatrix<T> p = test::RandomMatrix<T>(20, 700, seed + 4);
+
+		const BasicMatrixFuture<T> fa(a);
+		const BasicMatrixFuture<T> fb(b);
+		const BasicMatrixFuture<T> fc(c);
+		const BasicMatrixFuture<T> fg(g);
+		const BasicMatrixFuture<T> fp(p);
+
+		const BasicMatrixFuture<T> fd = MulAsync(fa, fb);
+		const BasicMatrixFuture<T> fe = AddAsync(fd, fc);
+		const BasicMatrixFuture<T> ff = MulAsync(fe, fg);
+		const BasicMatrixFuture<T> fk = MulAsync(fp, fe);
+		const BasicMatrixFuture<T> fh = SubAsync(DotMulAsync(fc, fc), fa);
+		BasicMatrixFuture<T> fx = fa;
+		for (int i = 0; i < 20; i++)
+		{
+			fx = AddAsync(fx, i % 2 == 0 ? fh : fc);
+		}
+		const BasicMatrixFuture<T> fy = SubAsync(fx, fe);
+
+		const BasicMatrix<T> d = Product(a, b);
+		const BasicMatrix<T> e = Sum(d, c);
+		const BasicMatrix<T> h = Difference(ElementProduct(c, c), a);
+		BasicMatrix<T> x = a;
+		for (int i = 0; i < 20; i++)
+		{
+			x = Sum(x, i % 2 == 0 ? h : c);
+		}
+
+		NUMERIC_CHECK(fy.Rows() == 700 && fy.Cols() == 300);
+		NUMERIC_CHECK(test::MaxDifference(fy.Get(), Difference(x, e)) == 0);
+		NUMERIC_CHECK(test::MaxDifference(fk.Get(), Product(p, e)) == 0);
+		NUMERIC_CHECK(test::MaxDifference(ff.Get(), Product(e, g)) == 0);
+		NUMERIC_CHECK(test::MaxDifference(fd.Get(), d) == 0);
+		NUMERIC_CHECK(fd.IsReady() && fe.IsReady() && ff.IsReady() && fk.IsReady());
+	}
+
+	template <typename T>
+	void CheckShapes()
+	{
+		const BasicMatrixFuture<T> a(test::RandomMatrix<T>(5, 4, 1));
+		const BasicMatrixFuture<T> b(test::RandomMatrix<T>(5, 3, 2));
+
+		int rejections = 0;
+		try
+		{
+			MulAsync(a, b);
+		}
+		catch (const std::invalid_argument&)
+		{
+			rejections++;
+		}
+		try
+		{
+			AddAsync(a, b);
+		}
+		catch (const std::invalid_argument&)
+		{
+			rejections++;
+		}
+		NUMERIC_CHECK(rejections == 2);
+
+		const BasicMatrixFuture<T> empty((BasicMatrix<T>()));
+		NUMERIC_CHECK(empty.IsReady());
+		NUMERIC_CHECK(AddAsync(empty, empty).Get().NumElements() == 0);
+	}
+}
+
+
+int main()
+{
+	const unsigned int threads[] = {1, 2, 4};
+	for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+	{
+		TaskScheduler::SetNumThreads(threads[t]);
+		for (unsigned int round = 0; round < 3; round++)
+		{
+			CheckGraph<float>(10 * round);
+			CheckGraph<double>(10 * round + 5);
+			CheckGraph<std::int32_t>(10 * round + 7);
+		}
+		CheckShapes<double>();
+	}
+	return test::Result();
+}
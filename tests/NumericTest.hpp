@@ -0,0 +1,148 @@
+#ifndef Numeric_NumericTest_HPP
+#define Numeric_NumericTest_HPP
+
+//
+// Checks shared by the tests. Each test is an executable that ctest runs; it counts the
+// failed checks, prints each one, and returns nonzero when any failed.
+//
+#include "Matrix.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+
+#define NUMERIC_CHECK(condition) \
+	numeric::test::Check((condition), #condition, __FILE__, __LINE__)
+
+namespace numeric
+{
+	namespace test
+	{
+		inline int& Failures()
+		{
+			static int failures = 0;
+			return failures;
+		}
+
+		inline bool Check(const bool passed, const char* condition, const char* file, const int line)
+		{
+			if (!passed)
+			{
+				std::printf("%s:%d: check failed: %s\n", file, line, condition);
+				Failures()++;
+			}
+			return passed;
+		}
+
+		//
+		// Function : The exit code of a test: 0 when every check passed.
+		//
+		inline int Result()
+		{
+			if (Failures() != 0)
+			{
+				std::printf("%d checks failed\n", Failures());
+				return 1;
+			}
+			return 0;
+		}
+
+		//
+		// Function : A rows*cols matrix of small integers in [-4, 4]. Products of such matrices
+		//      are exact in every element type up to an inner dimension of 2^20, so kernels
+		//      that sum in a different order still match a reference exactly.
+		//
+		template <typename T>
+		BasicMatrix<T> RandomMatrix(const unsigned int rows, const unsigned int cols, const unsigned int seed)
+		{
+			std::mt19937 engine(seed);
+			std::uniform_int_distribution<int> uniform(-4, 4);
+			BasicMatrix<T> mat(rows, cols);
+			T* data = mat.Data();
+			for (size_t i = 0; i < mat.NumElements(); i++)
+			{
+				data[i] = static_cast<T>(uniform(engine));
+			}
+			return mat;
+		}
+
+		//
+		// Function : op(a) * op(b), one dot product per element, in double.
+		//
+		template <typename T>
+		BasicMatrix<T> NaiveMul(const BasicMatrix<T>& a, const bool aTrans,
+		                        const BasicMatrix<T>& b, const bool bTrans)
+		{
+			const unsigned int m = aTrans ? a.Cols() : a.Rows();
+			const unsigned int k = aTrans ? a.Rows() : a.Cols();
+			const unsigned int n = bTrans ? b.Rows() : b.Cols();
+			BasicMatrix<T> c(m, n);
+			for (unsigned int i = 0; i < m; i++)
+			{
+				for (unsigned int j = 0; j < n; j++)
+				{
+					double sum = 0;
+					for (unsigned int p = 0; p < k; p++)
+					{
+						const T x = aTrans ? a.GetElemAt(p, i) : a.GetElemAt(i, p);
+						const T y = bTrans ? b.GetElemAt(j, p) : b.GetElemAt(p, j);
+						sum += static_cast<double>(x) * y;
+					}
+					c.SetElemAt(i, j, static_cast<T>(sum));
+				}
+			}
+			return c;
+		}
+
+		//
+		// Function : The largest absolute element.
+		//
+		template <typename T>
+		double MaxAbs(const BasicMatrix<T>& mat)
+		{
+			double value = 0;
+			for (size_t i = 0; i < mat.NumElements(); i++)
+			{
+				value = std::max(value, std::fabs(static_cast<double>(mat.Data()[i])));
+			}
+			return value;
+		}
+
+		//
+		// Function : The largest absolute difference between two matrices of the same shape,
+		//      NaN when either holds one, or infinity when the shapes differ.
+		//
+		template <typename T>
+		double MaxDifference(const BasicMatrix<T>& a, const BasicMatrix<T>& b)
+		{
+			if (a.Rows() != b.Rows() || a.Cols() != b.Cols())
+			{
+				return HUGE_VAL;
+			}
+			double difference = 0;
+			for (size_t i = 0; i < a.NumElements(); i++)
+			{
+				const double d = std::fabs(static_cast<double>(a.Data()[i]) - static_cast<double>(b.Data()[i]));
+				if (!(d <= difference))
+				{
+					difference = d;
+				}
+			}
+			return difference;
+		}
+
+		//
+		// Function : |A X - B| relative to |A| |X| n, in units of the rounding error of T. A
+		//      backward-stable solve keeps it below a small constant.
+		//
+		template <typename T>
+		double Residual(const BasicMatrix<T>& a, const BasicMatrix<T>& x, const BasicMatrix<T>& b)
+		{
+			const double scale = MaxAbs(a) * MaxAbs(x) * a.Cols() * std::numeric_limits<T>::epsilon();
+			return MaxDifference(NaiveMul(a, false, x, false), b) / scale;
+		}
+	}
+}
+
+#endif
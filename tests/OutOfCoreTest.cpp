@@ -0,0 +1,124 @@
+
+//
+// Out-of-core products against in-memory ones.
+//
+// The budgets give 64 and 128 element tiles, and no edge of the operands is a multiple of
+// the tile, so every product has partial tiles in each dimension, including an inner
+// dimension smaller than one tile. Small integer operands keep the products exact.
+//
+#include "NumericTest.hpp"
+#include "MatrixFile.hpp"
+#include "OutOfCore.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace numeric;
+
+namespace
+{
+	const char* const LhPath = "numeric_test_out_of_core_a.bin";
+	const char* const RhPath = "numeric_test_out_of_core_b.bin";
+	const char* const ResultPath = "numeric_test_out_of_core_c.bin";
+
+	struct Shape
+	{
+		unsigned int m;
+		unsigned int k;
+		unsigned int n;
+	};
+
+	const Shape Shapes[] =
+	{
+		{1, 1, 1},
+		{130, 97, 200},
+		{65, 1, 129},
+		{63, 300, 70},
+		{257, 191, 129}
+	};
+
+	//
+	// Tile edges the budgets are sized for.
+	//
+	const unsigned int TileEdges[] = {64, 128};
+
+	template <typename T>
+	void CheckProduct(const Shape& shape, const unsigned int tileEdge, const unsigned int seed)
+	{
+		const BasicMatrix<T> a = test::RandomMatrix<T>(shape.m, shape.k, seed);
+		const BasicMatrix<T> b = test::RandomMatrix<T>(shape.k, shape.n, seed + 1);
+		SaveMatrix(LhPath, a);
+		SaveMatrix(RhPath, b);
+
+		OutOfCoreOptions options;
+		options.memoryBudget = 6 * static_cast<size_t>(tileEdge) * tileEdge * sizeof(T);
+		MultiplyMatrixFiles<T>(LhPath, RhPath, ResultPath, options);
+
+		BasicMatrix<T> c;
+		LoadMatrix(ResultPath, c);
+		NUMERIC_CHECK(test::MaxDifference(c, test::NaiveMul(a, false, b, false)) == 0);
+	}
+
+	template <typename T>
+	void CheckAll()
+	{
+		for (size_t s = 0; s < sizeof(Shapes) / sizeof(Shapes[0]); s++)
+		{
+			for (size_t t = 0; t < sizeof(TileEdges) / sizeof(TileEdges[0]); t++)
+			{
+				CheckProduct<T>(Shapes[s], TileEdges[t], static_cast<unsigned int>(10 * s));
+			}
+		}
+	}
+
+	//
+	// True when MultiplyMatrixFiles throws std::invalid_argument.
+	//
+	template <typename T>
+	bool Rejected(const size_t memoryBudget)
+	{
+		OutOfCoreOptions options;
+		options.memoryBudget = memoryBudget;
+		try
+		{
+			MultiplyMatrixFiles<T>(LhPath, RhPath, ResultPath, options);
+		}
+		catch (const std::invalid_argument&)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	void CheckInvalidArguments()
+	{
+		const size_t budget = 6 * 64 * 64 * sizeof(double);
+		SaveMatrix(LhPath, test::RandomMatrix<double>(10, 20, 1));
+		SaveMatrix(RhPath, test::RandomMatrix<double>(21, 10, 2));
+		NUMERIC_CHECK(Rejected<double>(budget));
+
+		SaveMatrix(RhPath, test::RandomMatrix<double>(20, 10, 2));
+		NUMERIC_CHECK(!Rejected<double>(budget));
+		NUMERIC_CHECK(Rejected<double>(budget - 1));
+		NUMERIC_CHECK(Rejected<float>(budget));
+	}
+}
+
+
+int main()
+{
+	const unsigned int threads[] = {1, 4};
+	for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+	{
+		ThreadPool::SetNumThreads(threads[t]);
+		CheckAll<float>();
+		CheckAll<double>();
+		CheckAll<std::int32_t>();
+	}
+	CheckInvalidArguments();
+	std::remove(LhPath);
+	std::remove(RhPath);
+	std::remove(ResultPath);
+	return test::Result();
+}
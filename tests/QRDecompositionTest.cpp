@@ -0,0 +1,163 @@
+
+//
+// Householder QR and TSQR least squares against naive products.
+//
+// Each shape is solved on one thread, which uses the blocked Householder path, and on four,
+// where the tall-skinny shapes take the TSQR path; both must satisfy the normal equations
+// and agree with each other.
+//
+#include "NumericTest.hpp"
+#include "QRDecomposition.hpp"
+#include "ThreadPool.hpp"
+#include <limits>
+#include <stdexcept>
+
+using namespace numeric;
+
+namespace
+{
+	struct Shape
+	{
+		unsigned int m;
+		unsigned int n;
+	};
+
+	const Shape Shapes[] =
+	{
+		{1, 1},
+		{5, 3},
+		{64, 64},
+		{200, 129},
+		{300, 300},
+		{5000, 8},
+		{9000, 40}
+	};
+
+	//
+	// Random small integers in [-4, 4], with 4n added to the diagonal of the top square block,
+	// which makes that block diagonally dominant: every shape has full rank and a small
+	// condition number, so the forward error of a consistent solve stays near rounding.
+	//
+	template <typename T>
+	BasicMatrix<T> FullRankMatrix(const Shape& shape, const unsigned int seed)
+	{
+		BasicMatrix<T> a = test::RandomMatrix<T>(shape.m, shape.n, seed);
+		for (unsigned int i = 0; i < shape.n; i++)
+		{
+			a.SetElemAt(i, i, a.GetElemAt(i, i) + T(4 * shape.n));
+		}
+		return a;
+	}
+
+	//
+	// A^T (A x - b) relative to |A|^2 |x| m, in units of the rounding error of T.
+	//
+	template <typename T>
+	double NormalResidual(const BasicMatrix<T>& a, const BasicMatrix<T>& x, const BasicMatrix<T>& b)
+	{
+		BasicMatrix<T> r = test::NaiveMul(a, false, x, false);
+		for (size_t i = 0; i < r.NumElements(); i++)
+		{
+			r.Data()[i] -= b.Data()[i];
+		}
+		const BasicMatrix<T> normal = test::NaiveMul(a, true, r, false);
+		const double scale = test::MaxAbs(a) * (test::MaxAbs(a) * test::MaxAbs(x) + test::MaxAbs(b)) *
+		                     a.Rows() * std::numeric_limits<T>::epsilon();
+		return test::MaxAbs(normal) / scale;
+	}
+
+	template <typename T>
+	BasicMatrix<T> CheckLeastSquares(const Shape& shape, const unsigned int seed)
+	{
+		const BasicMatrix<T> a = FullRankMatrix<T>(shape, seed);
+		const BasicMatrix<T> b = test::RandomMatrix<T>(shape.m, 2, seed + 1);
+		BasicMatrix<T> x(shape.n, 2);
+
+		const BasicQRDecomposition<T> qr(a);
+		if (!NUMERIC_CHECK(!qr.IsRankDeficient()))
+		{
+			return x;
+		}
+		qr.LeastSquares(b, x);
+		NUMERIC_CHECK(NormalResidual(a, x, b) < 10);
+
+		//
+		// R^T R = A^T A, since Q is orthogonal.
+		//
+		BasicMatrix<T> r(shape.n, shape.n);
+		qr.R(r);
+		const BasicMatrix<T> ata = test::NaiveMul(a, true, a, false);
+		NUMERIC_CHECK(test::MaxDifference(test::NaiveMul(r, true, r, false), ata) <=
+		              10 * shape.m * std::numeric_limits<T>::epsilon() * test::MaxAbs(ata));
+
+		BasicMatrix<T> y(shape.n, 2);
+		LeastSquares(a, b, y);
+		NUMERIC_CHECK(test::MaxDifference(y, x) == 0);
+		return x;
+	}
+
+	//
+	// A consistent system with integer solution x0 is solved exactly up to rounding.
+	//
+	template <typename T>
+	void CheckConsistent(const Shape& shape, const unsigned int seed)
+	{
+		const BasicMatrix<T> a = FullRankMatrix<T>(shape, seed);
+		const BasicMatrix<T> x0 = test::RandomMatrix<T>(shape.n, 1, seed + 2);
+		const BasicMatrix<T> b = test::NaiveMul(a, false, x0, false);
+		BasicMatrix<T> x(shape.n, 1);
+		LeastSquares(a, b, x);
+		NUMERIC_CHECK(test::MaxDifference(x, x0) <= 1e3 * std::numeric_limits<T>::epsilon() * test::MaxAbs(x0));
+	}
+
+	template <typename T>
+	void CheckRankDeficient()
+	{
+		BasicMatrix<T> a = test::RandomMatrix<T>(300, 20, 5);
+		for (unsigned int i = 0; i < a.Rows(); i++)
+		{
+			a.SetElemAt(i, 7, a.GetElemAt(i, 3));
+		}
+		const BasicQRDecomposition<T> qr(a);
+		NUMERIC_CHECK(qr.IsRankDeficient());
+
+		bool threw = false;
+		try
+		{
+			BasicMatrix<T> x(20, 1);
+			qr.LeastSquares(test::RandomMatrix<T>(300, 1, 6), x);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		NUMERIC_CHECK(threw);
+	}
+
+	template <typename T>
+	void CheckAll()
+	{
+		for (size_t s = 0; s < sizeof(Shapes) / sizeof(Shapes[0]); s++)
+		{
+			const unsigned int seed = static_cast<unsigned int>(10 * s);
+			ThreadPool::SetNumThreads(1);
+			const BasicMatrix<T> serial = CheckLeastSquares<T>(Shapes[s], seed);
+			CheckConsistent<T>(Shapes[s], seed);
+
+			ThreadPool::SetNumThreads(4);
+			const BasicMatrix<T> parallel = CheckLeastSquares<T>(Shapes[s], seed);
+			CheckConsistent<T>(Shapes[s], seed);
+			NUMERIC_CHECK(test::MaxDifference(parallel, serial) <=
+			              1e3 * std::numeric_limits<T>::epsilon() * test::MaxAbs(serial));
+		}
+		CheckRankDeficient<T>();
+	}
+}
+
+
+int main()
+{
+	CheckAll<float>();
+	CheckAll<double>();
+	return test::Result();
+}
@@ -0,0 +1,206 @@
+
+//
+// Reductions of whole matrices, rows and columns on 1, 2 and 4 threads.
+//
+// The operands are not integers, so a different order of summation would change the last
+// bits; every thread count must give bitwise the result of one thread. Results are also
+// compared against sums in long double, and the largest and smallest elements are planted
+// twice so that the first position must be reported.
+//
+#include "NumericTest.hpp"
+#include "Reduction.hpp"
+#include "ThreadPool.hpp"
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace numeric;
+
+namespace
+{
+	struct Shape
+	{
+		unsigned int rows;
+		unsigned int cols;
+	};
+
+	//
+	// Up to a dozen chunks of 8192 elements, and column reductions over several blocks of
+	// rows and strips of columns.
+	//
+	const Shape Shapes[] =
+	{
+		{1, 1},
+		{3, 5},
+		{97, 1031},
+		{2, 40001},
+		{1500, 7},
+		{130, 4500}
+	};
+
+	const unsigned int Threads[] = {1, 2, 4};
+
+	const ReduceOp Ops[] =
+	{
+		ReduceSum, ReduceMean, ReduceMax, ReduceMin, ReduceNormL1, ReduceNormL2, ReduceNormInf
+	};
+
+	template <typename T>
+	BasicMatrix<T> RandomReal(const unsigned int rows, const unsigned int cols, const unsigned int seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_real_distribution<double> uniform(-1, 1);
+		BasicMatrix<T> mat(rows, cols);
+		for (size_t i = 0; i < mat.NumElements(); i++)
+		{
+			mat.Data()[i] = static_cast<T>(uniform(engine));
+		}
+		return mat;
+	}
+
+	//
+	// Everything reduced from one pair of matrices.
+	//
+	template <typename T>
+	struct Results
+	{
+		std::vector<T>            values;
+		std::vector<unsigned int> positions;
+		std::vector<BasicMatrix<T> > rowsAndCols;
+	};
+
+	template <typename T>
+	Results<T> Run(const BasicMatrix<T>& a, const BasicMatrix<T>& b)
+	{
+		Results<T> results;
+		results.values.push_back(BasicMatrix<T>::Sum(a));
+		results.values.push_back(BasicMatrix<T>::Mean(a));
+		results.values.push_back(BasicMatrix<T>::Norm(a, NormL1));
+		results.values.push_back(BasicMatrix<T>::Norm(a, NormL2));
+		results.values.push_back(BasicMatrix<T>::Norm(a, NormInf));
+		results.values.push_back(BasicMatrix<T>::Dot(a, b));
+		results.values.push_back(BasicMatrix<T>::Max(a));
+		results.values.push_back(BasicMatrix<T>::Min(a));
+
+		unsigned int row = 0;
+		unsigned int col = 0;
+		results.values.push_back(BasicMatrix<T>::Max(a, row, col));
+		results.positions.push_back(row);
+		results.positions.push_back(col);
+		results.values.push_back(BasicMatrix<T>::Min(a, row, col));
+		results.positions.push_back(row);
+		results.positions.push_back(col);
+
+		for (size_t o = 0; o < sizeof(Ops) / sizeof(Ops[0]); o++)
+		{
+			BasicMatrix<T> rows(a.Rows(), 1);
+			BasicMatrix<T>::RowReduce(a, Ops[o], rows);
+			results.rowsAndCols.push_back(rows);
+			BasicMatrix<T> cols(1, a.Cols());
+			BasicMatrix<T>::ColReduce(a, Ops[o], cols);
+			results.rowsAndCols.push_back(cols);
+		}
+		return results;
+	}
+
+	template <typename T>
+	bool Same(const Results<T>& x, const Results<T>& y)
+	{
+		if (x.values != y.values || x.positions != y.positions || x.rowsAndCols.size() != y.rowsAndCols.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < x.rowsAndCols.size(); i++)
+		{
+			if (test::MaxDifference(x.rowsAndCols[i], y.rowsAndCols[i]) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//
+	// The sums of one thread against long double, within the rounding error of summing n
+	// terms of T, and the planted extremes at their first positions.
+	//
+	template <typename T>
+	void CheckReference(const BasicMatrix<T>& a, const BasicMatrix<T>& b, const Results<T>& results,
+	                    const unsigned int maxAt, const unsigned int minAt)
+	{
+		const size_t n = a.NumElements();
+		long double sum = 0;
+		long double sumAbs = 0;
+		long double sumSquares = 0;
+		long double dot = 0;
+		long double dotAbs = 0;
+		for (size_t i = 0; i < n; i++)
+		{
+			const long double x = a.Data()[i];
+			sum += x;
+			sumAbs += std::fabs(x);
+			sumSquares += x * x;
+			dot += x * b.Data()[i];
+			dotAbs += std::fabs(x * b.Data()[i]);
+		}
+
+		const double eps = std::numeric_limits<T>::epsilon();
+		const double bound = 2 * n * eps;
+		NUMERIC_CHECK(std::fabs(results.values[0] - sum) <= bound * sumAbs);
+		NUMERIC_CHECK(std::fabs(results.values[2] - sumAbs) <= bound * sumAbs);
+		NUMERIC_CHECK(std::fabs(results.values[3] - std::sqrt(sumSquares)) <= bound * std::sqrt(sumSquares) + eps);
+		NUMERIC_CHECK(std::fabs(results.values[5] - dot) <= bound * dotAbs);
+
+		NUMERIC_CHECK(results.values[6] == a.Data()[maxAt] && results.values[8] == a.Data()[maxAt]);
+		NUMERIC_CHECK(results.values[7] == a.Data()[minAt] && results.values[9] == a.Data()[minAt]);
+		NUMERIC_CHECK(results.positions[0] == maxAt / a.Cols() && results.positions[1] == maxAt % a.Cols());
+		NUMERIC_CHECK(results.positions[2] == minAt / a.Cols() && results.positions[3] == minAt % a.Cols());
+	}
+
+	template <typename T>
+	void CheckAll()
+	{
+		for (size_t s = 0; s < sizeof(Shapes) / sizeof(Shapes[0]); s++)
+		{
+			const Shape& shape = Shapes[s];
+			const unsigned int seed = static_cast<unsigned int>(10 * s);
+			BasicMatrix<T> a = RandomReal<T>(shape.rows, shape.cols, seed);
+			const BasicMatrix<T> b = RandomReal<T>(shape.rows, shape.cols, seed + 1);
+
+			//
+			// Extremes planted at a third and a half of the buffer, and again at the end.
+			//
+			const size_t n = a.NumElements();
+			const unsigned int maxAt = static_cast<unsigned int>(n / 3);
+			const unsigned int minAt = static_cast<unsigned int>(n / 2);
+			if (maxAt != minAt)
+			{
+				a.Data()[maxAt] = T(2);
+				a.Data()[minAt] = T(-2);
+				a.Data()[n - 1] = T(2);
+				a.Data()[n - 2] = T(-2);
+			}
+
+			ThreadPool::SetNumThreads(Threads[0]);
+			const Results<T> expected = Run(a, b);
+			if (maxAt != minAt)
+			{
+				CheckReference(a, b, expected, maxAt, minAt);
+			}
+			for (size_t t = 1; t < sizeof(Threads) / sizeof(Threads[0]); t++)
+			{
+				ThreadPool::SetNumThreads(Threads[t]);
+				NUMERIC_CHECK(Same(Run(a, b), expected));
+			}
+		}
+	}
+}
+
+
+int main()
+{
+	CheckAll<float>();
+	CheckAll<double>();
+	return test::Result();
+}
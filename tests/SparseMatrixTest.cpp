@@ -0,0 +1,163 @@
+
+//
+// Sparse products and sums in CSR and CSC against the same operations on dense copies.
+//
+// The operands hold small integers, so every order of summation is exact and the results
+// must match the dense reference exactly. The large shapes carry enough nonzeros to be
+// split into several blocks with four threads; some rows and columns are left empty.
+//
+#include "NumericTest.hpp"
+#include "SparseMatrix.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace numeric;
+
+namespace
+{
+	struct Shape
+	{
+		unsigned int rows;
+		unsigned int cols;
+		unsigned int k;
+		unsigned int percent;
+	};
+
+	const Shape Shapes[] =
+	{
+		{1, 1, 1, 100},
+		{7, 5, 3, 50},
+		{40, 60, 17, 10},
+		{1200, 900, 5, 12},
+		{900, 1200, 9, 8}
+	};
+
+	//
+	// Function : A dense matrix with about percent% nonzeros, rows and columns ending in 7
+	//      left empty.
+	//
+	template <typename T>
+	BasicMatrix<T> RandomSparse(const unsigned int rows, const unsigned int cols,
+	                            const unsigned int percent, const unsigned int seed)
+	{
+		std::mt19937 engine(seed);
+		std::uniform_int_distribution<int> uniform(0, 99);
+		BasicMatrix<T> mat = test::RandomMatrix<T>(rows, cols, seed + 1);
+		for (unsigned int i = 0; i < rows; i++)
+		{
+			for (unsigned int j = 0; j < cols; j++)
+			{
+				if (i % 10 == 7 || j % 10 == 7 || uniform(engine) >= static_cast<int>(percent))
+				{
+					mat.SetElemAt(i, j, T(0));
+				}
+			}
+		}
+		return mat;
+	}
+
+	template <typename T>
+	BasicMatrix<T> Dense(const BasicSparseMatrix<T>& mat)
+	{
+		BasicMatrix<T> dense(mat.Rows(), mat.Cols());
+		mat.ToMatrix(dense);
+		return dense;
+	}
+
+	template <typename T>
+	void CheckShape(const Shape& shape, const typename BasicSparseMatrix<T>::StorageOrder order,
+	                const unsigned int seed)
+	{
+		const BasicMatrix<T> a = RandomSparse<T>(shape.rows, shape.cols, shape.percent, seed);
+		const BasicMatrix<T> b = RandomSparse<T>(shape.rows, shape.cols, shape.percent, seed + 2);
+		const BasicSparseMatrix<T> sa(a, order);
+		const BasicSparseMatrix<T> sb(b, order);
+		NUMERIC_CHECK(sa.Order() == order);
+		NUMERIC_CHECK(test::MaxDifference(Dense(sa), a) == 0);
+
+		//
+		// SpMV through both entry points.
+		//
+		const BasicMatrix<T> x = test::RandomMatrix<T>(shape.cols, 1, seed + 3);
+		const BasicMatrix<T> expectedY = test::NaiveMul(a, false, x, false);
+		std::vector<T> y(shape.rows, T(-99));
+		BasicSparseMatrix<T>::Mul(sa, x.Data(), y.empty() ? 0 : &y[0]);
+		BasicMatrix<T> yMat(shape.rows, 1);
+		for (unsigned int i = 0; i < shape.rows; i++)
+		{
+			yMat.SetElemAt(i, 0, y[i]);
+		}
+		NUMERIC_CHECK(test::MaxDifference(yMat, expectedY) == 0);
+		BasicSparseMatrix<T>::Mul(sa, x, yMat);
+		NUMERIC_CHECK(test::MaxDifference(yMat, expectedY) == 0);
+
+		//
+		// SpMM with a dense right-hand side.
+		//
+		const BasicMatrix<T> c = test::RandomMatrix<T>(shape.cols, shape.k, seed + 4);
+		BasicMatrix<T> product(shape.rows, shape.k);
+		BasicSparseMatrix<T>::Mul(sa, c, product);
+		NUMERIC_CHECK(test::MaxDifference(product, test::NaiveMul(a, false, c, false)) == 0);
+
+		//
+		// Sums into either order, into a fresh result and in place.
+		//
+		BasicMatrix<T> expectedSum(shape.rows, shape.cols);
+		for (size_t i = 0; i < a.NumElements(); i++)
+		{
+			expectedSum.Data()[i] = a.Data()[i] + b.Data()[i];
+		}
+		const typename BasicSparseMatrix<T>::StorageOrder orders[] =
+		{
+			BasicSparseMatrix<T>::RowMajor, BasicSparseMatrix<T>::ColMajor
+		};
+		for (size_t o = 0; o < 2; o++)
+		{
+			BasicSparseMatrix<T> sum(shape.rows, shape.cols, orders[o]);
+			BasicSparseMatrix<T>::Add(sa, sb, sum);
+			NUMERIC_CHECK(test::MaxDifference(Dense(sum), expectedSum) == 0);
+		}
+		BasicSparseMatrix<T> inPlace(sa);
+		BasicSparseMatrix<T>::Add(inPlace, sb, inPlace);
+		NUMERIC_CHECK(test::MaxDifference(Dense(inPlace), expectedSum) == 0);
+
+		//
+		// a + (-a) cancels to an empty matrix.
+		//
+		BasicMatrix<T> negated(a);
+		for (size_t i = 0; i < negated.NumElements(); i++)
+		{
+			negated.Data()[i] = -negated.Data()[i];
+		}
+		BasicSparseMatrix<T> zero(shape.rows, shape.cols, order);
+		BasicSparseMatrix<T>::Add(sa, BasicSparseMatrix<T>(negated, order), zero);
+		NUMERIC_CHECK(zero.NonZeros() == 0);
+	}
+
+	template <typename T>
+	void CheckAll()
+	{
+		for (size_t s = 0; s < sizeof(Shapes) / sizeof(Shapes[0]); s++)
+		{
+			const unsigned int seed = static_cast<unsigned int>(10 * s);
+			CheckShape<T>(Shapes[s], BasicSparseMatrix<T>::RowMajor, seed);
+			CheckShape<T>(Shapes[s], BasicSparseMatrix<T>::ColMajor, seed);
+		}
+	}
+}
+
+
+int main()
+{
+	const unsigned int threads[] = {1, 4};
+	for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+	{
+		ThreadPool::SetNumThreads(threads[t]);
+		CheckAll<float>();
+		CheckAll<double>();
+		CheckAll<std::int32_t>();
+	}
+	return test::Result();
+}
@@ -0,0 +1,133 @@
+
+//
+// Strassen-Winograd with peeling of odd dimensions against a naive product.
+//
+// Small crossovers force several levels on small shapes, so every combination of odd
+// rows, columns and inner dimension is peeled at some level. Small integer operands keep
+// every intermediate sum exact, so float and double must match the reference exactly, as
+// std::int32_t always does. Guard elements around C and after the workspace must survive.
+//
+#include "NumericTest.hpp"
+#include "Strassen.hpp"
+#include "ThreadPool.hpp"
+#include "Tuning.hpp"
+#include <cstdint>
+#include <vector>
+
+using namespace numeric;
+
+namespace
+{
+	struct Shape
+	{
+		unsigned int m;
+		unsigned int n;
+		unsigned int k;
+	};
+
+	const Shape Shapes[] =
+	{
+		{1, 1, 1},
+		{16, 16, 16},
+		{17, 16, 16},
+		{16, 17, 16},
+		{16, 16, 17},
+		{33, 47, 29},
+		{64, 64, 64},
+		{65, 17, 130},
+		{101, 99, 97},
+		{15, 200, 200},
+		{130, 260, 70}
+	};
+
+	const unsigned int Crossovers[] = {2, 8, 16};
+
+	const int GuardElements = 7;
+
+	template <typename T>
+	void CheckKernel(const Shape& shape, const unsigned int crossover, const unsigned int seed)
+	{
+		const BasicMatrix<T> a = test::RandomMatrix<T>(shape.m, shape.k, seed);
+		const BasicMatrix<T> b = test::RandomMatrix<T>(shape.k, shape.n, seed + 1);
+		const BasicMatrix<T> expected = test::NaiveMul(a, false, b, false);
+
+		const T guard = T(-99);
+		const size_t ldc = shape.n + 3;
+		std::vector<T> c(shape.m * ldc + GuardElements, guard);
+		const size_t workspaceSize = kernel::StrassenWorkspaceSize(shape.m, shape.n, shape.k, crossover);
+		std::vector<T> workspace(workspaceSize + GuardElements, guard);
+
+		kernel::StrassenGemm<T>(shape.m, shape.n, shape.k, a.Data(), shape.k, b.Data(), shape.n,
+		                        &c[0], static_cast<std::ptrdiff_t>(ldc), crossover, &workspace[0]);
+
+		BasicMatrix<T> result(shape.m, shape.n);
+		bool guardsKept = true;
+		for (unsigned int i = 0; i < shape.m; i++)
+		{
+			for (size_t j = 0; j < ldc; j++)
+			{
+				if (j < shape.n)
+				{
+					result.SetElemAt(i, static_cast<unsigned int>(j), c[i * ldc + j]);
+				}
+				else
+				{
+					guardsKept = guardsKept && c[i * ldc + j] == guard;
+				}
+			}
+		}
+		for (int i = 0; i < GuardElements; i++)
+		{
+			guardsKept = guardsKept && c[shape.m * ldc + i] == guard && workspace[workspaceSize + i] == guard;
+		}
+
+		NUMERIC_CHECK(test::MaxDifference(result, expected) == 0);
+		NUMERIC_CHECK(guardsKept);
+	}
+
+	template <typename T>
+	void CheckMatrix(const Shape& shape, const unsigned int seed)
+	{
+		const BasicMatrix<T> a = test::RandomMatrix<T>(shape.m, shape.k, seed);
+		const BasicMatrix<T> b = test::RandomMatrix<T>(shape.k, shape.n, seed + 1);
+		BasicMatrix<T> c(shape.m, shape.n);
+		BasicMatrix<T>::StrassenMul(a, b, c);
+		NUMERIC_CHECK(test::MaxDifference(c, test::NaiveMul(a, false, b, false)) == 0);
+	}
+
+	template <typename T>
+	void CheckAll()
+	{
+		for (size_t s = 0; s < sizeof(Shapes) / sizeof(Shapes[0]); s++)
+		{
+			const unsigned int seed = static_cast<unsigned int>(10 * s);
+			for (size_t x = 0; x < sizeof(Crossovers) / sizeof(Crossovers[0]); x++)
+			{
+				CheckKernel<T>(Shapes[s], Crossovers[x], seed);
+			}
+			CheckMatrix<T>(Shapes[s], seed);
+		}
+	}
+}
+
+
+int main()
+{
+	NUMERIC_CHECK(kernel::StrassenLevels(64, 64, 64, 16) == 3);
+	NUMERIC_CHECK(kernel::StrassenLevels(64, 15, 64, 16) == 0);
+	NUMERIC_CHECK(kernel::StrassenLevels(101, 99, 97, 8) == 4);
+
+	kernel::SetTuning(kernel::DefaultTuning());
+	kernel::SetStrassenCrossover(16);
+	NUMERIC_CHECK(kernel::StrassenCrossover() == 16);
+
+	const unsigned int threads[] = {1, 4};
+	for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+	{
+		ThreadPool::SetNumThreads(threads[t]);
+		CheckAll<float>();
+		CheckAll<double>();
+		CheckAll<std::int32_t>();
+	}
+	return test::Result();
+}
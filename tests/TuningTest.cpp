@@ -0,0 +1,235 @@
+
+//
+// Kernel tuning: SetTuning rejecting fields the kernels cannot run with, and tuning caches
+// surviving a save and load, with caches of another CPU, malformed ones and ones holding
+// invalid fields rejected.
+//
+#include "NumericTest.hpp"
+#include "CpuFeatures.hpp"
+#include "Tuning.hpp"
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using namespace numeric;
+
+namespace
+{
+	const char* const FilePath = "numeric_test_tuning.txt";
+
+	bool SameBlocks(const kernel::GemmBlocks& a, const kernel::GemmBlocks& b)
+	{
+		return a.mc == b.mc && a.kc == b.kc && a.nc == b.nc;
+	}
+
+	bool SameTuning(const kernel::TuningParameters& a, const kernel::TuningParameters& b)
+	{
+		return SameBlocks(a.gemmFloat, b.gemmFloat) &&
+			SameBlocks(a.gemmDouble, b.gemmDouble) &&
+			a.gemmParallelFlops == b.gemmParallelFlops &&
+			a.transposeBaseEdge == b.transposeBaseEdge &&
+			a.transposeParallelElements == b.transposeParallelElements &&
+			a.strassenCrossover == b.strassenCrossover &&
+			a.elementWiseIsa == b.elementWiseIsa;
+	}
+
+	//
+	// Parameters that differ from the defaults in every field.
+	//
+	kernel::TuningParameters Custom()
+	{
+		kernel::TuningParameters tuning = kernel::DefaultTuning();
+		tuning.gemmFloat.mc = 96;
+		tuning.gemmFloat.kc = 200;
+		tuning.gemmFloat.nc = 1024;
+		tuning.gemmDouble.mc = 64;
+		tuning.gemmDouble.kc = 320;
+		tuning.gemmDouble.nc = 512;
+		tuning.gemmParallelFlops = 12345;
+		tuning.transposeBaseEdge = 16;
+		tuning.transposeParallelElements = 4096;
+		tuning.strassenCrossover = 256;
+		tuning.elementWiseIsa = kernel::IsaScalar;
+		return tuning;
+	}
+
+	//
+	// True when SetTuning throws std::invalid_argument and keeps the parameters in use.
+	//
+	bool SetRejected(const kernel::TuningParameters& tuning)
+	{
+		const kernel::TuningParameters before = kernel::Tuning();
+		bool threw = false;
+		try
+		{
+			kernel::SetTuning(tuning);
+		}
+		catch (const std::invalid_argument&)
+		{
+			threw = true;
+		}
+		return threw && SameTuning(kernel::Tuning(), before);
+	}
+
+	void CheckValidate()
+	{
+		kernel::SetTuning(Custom());
+		NUMERIC_CHECK(SameTuning(kernel::Tuning(), Custom()));
+		NUMERIC_CHECK(kernel::ElementWiseIsa() == kernel::IsaScalar);
+
+		kernel::TuningParameters bad = Custom();
+		bad.gemmFloat.mc = 0;
+		NUMERIC_CHECK(SetRejected(bad));
+		bad = Custom();
+		bad.gemmDouble.mc = 66;
+		NUMERIC_CHECK(SetRejected(bad));
+		bad = Custom();
+		bad.gemmFloat.kc = 0;
+		NUMERIC_CHECK(SetRejected(bad));
+		bad = Custom();
+		bad.gemmDouble.nc = 520;
+		NUMERIC_CHECK(SetRejected(bad));
+
+		//
+		// Blocks beyond 32 MiB, including products that overflow 32 bits.
+		//
+		bad = Custom();
+		bad.gemmDouble.mc = 4096;
+		bad.gemmDouble.kc = 2048;
+		NUMERIC_CHECK(SetRejected(bad));
+		bad = Custom();
+		bad.gemmFloat.kc = 65536;
+		bad.gemmFloat.nc = 65536;
+		NUMERIC_CHECK(SetRejected(bad));
+		bad = Custom();
+		bad.gemmFloat.mc = 1u << 20;
+		bad.gemmFloat.kc = 1u << 20;
+		NUMERIC_CHECK(SetRejected(bad));
+
+		bad = Custom();
+		bad.gemmParallelFlops = -1;
+		NUMERIC_CHECK(SetRejected(bad));
+		bad = Custom();
+		bad.gemmParallelFlops = std::numeric_limits<double>::quiet_NaN();
+		NUMERIC_CHECK(SetRejected(bad));
+		bad = Custom();
+		bad.transposeBaseEdge = 0;
+		NUMERIC_CHECK(SetRejected(bad));
+		bad = Custom();
+		bad.transposeParallelElements = 0;
+		NUMERIC_CHECK(SetRejected(bad));
+		bad = Custom();
+		bad.strassenCrossover = 0;
+		NUMERIC_CHECK(SetRejected(bad));
+		bad = Custom();
+		bad.elementWiseIsa = static_cast<kernel::Isa>(kernel::IsaScalar - 1);
+		NUMERIC_CHECK(SetRejected(bad));
+		if (kernel::ActiveIsa() < kernel::IsaAvx512)
+		{
+			bad = Custom();
+			bad.elementWiseIsa = static_cast<kernel::Isa>(kernel::ActiveIsa() + 1);
+			NUMERIC_CHECK(SetRejected(bad));
+		}
+
+		kernel::SetTuning(kernel::DefaultTuning());
+		NUMERIC_CHECK(SameTuning(kernel::Tuning(), kernel::DefaultTuning()));
+		NUMERIC_CHECK(kernel::ElementWiseIsa() == kernel::ActiveIsa());
+	}
+
+	void CheckRoundTrip()
+	{
+		kernel::SaveTuning(FilePath, Custom());
+		NUMERIC_CHECK(SameTuning(kernel::LoadTuning(FilePath), Custom()));
+
+		kernel::SaveTuning(FilePath, kernel::DefaultTuning());
+		NUMERIC_CHECK(SameTuning(kernel::LoadTuning(FilePath), kernel::DefaultTuning()));
+
+		//
+		// Missing keys keep their defaults, unknown keys and comments are skipped.
+		//
+		{
+			std::ofstream out(FilePath, std::ios::trunc);
+			out << "# partial\n"
+				<< "cpu = " << kernel::CpuModel() << "\n"
+				<< "isa = " << kernel::IsaName(kernel::ActiveIsa()) << "\n"
+				<< "strassen.crossover = 128\n"
+				<< "some.future.key = 3\n";
+		}
+		kernel::TuningParameters expected = kernel::DefaultTuning();
+		expected.strassenCrossover = 128;
+		NUMERIC_CHECK(SameTuning(kernel::LoadTuning(FilePath), expected));
+	}
+
+	//
+	// True when LoadTuning throws E for a file holding the header of this CPU, with cpu and
+	// isa as given, followed by body.
+	//
+	template <typename E>
+	bool LoadRejected(const std::string& cpu, const std::string& isa, const std::string& body)
+	{
+		{
+			std::ofstream out(FilePath, std::ios::trunc);
+			out << "cpu = " << cpu << "\n" << "isa = " << isa << "\n" << body;
+		}
+		try
+		{
+			kernel::LoadTuning(FilePath);
+		}
+		catch (const E&)
+		{
+			return true;
+		}
+		catch (const std::exception&)
+		{
+		}
+		return false;
+	}
+
+	void CheckRejectedCaches()
+	{
+		const std::string cpu = kernel::CpuModel();
+		const std::string isa = kernel::IsaName(kernel::ActiveIsa());
+		NUMERIC_CHECK(!LoadRejected<std::runtime_error>(cpu, isa, ""));
+		NUMERIC_CHECK(!LoadRejected<std::invalid_argument>(cpu, isa, ""));
+
+		NUMERIC_CHECK(LoadRejected<std::runtime_error>(cpu + " (another)", isa, ""));
+		NUMERIC_CHECK(LoadRejected<std::runtime_error>("", isa, ""));
+		const std::string otherIsa = kernel::IsaName(
+			kernel::ActiveIsa() == kernel::IsaScalar ? kernel::IsaSse2 : kernel::IsaScalar);
+		NUMERIC_CHECK(LoadRejected<std::runtime_error>(cpu, otherIsa, ""));
+
+		NUMERIC_CHECK(LoadRejected<std::runtime_error>(cpu, isa, "gemm.float.mc\n"));
+		NUMERIC_CHECK(LoadRejected<std::runtime_error>(cpu, isa, "gemm.float.mc = -4\n"));
+		NUMERIC_CHECK(LoadRejected<std::runtime_error>(cpu, isa, "gemm.float.mc = 12x\n"));
+		NUMERIC_CHECK(LoadRejected<std::runtime_error>(cpu, isa, "elementwise.isa = mmx\n"));
+
+		NUMERIC_CHECK(LoadRejected<std::invalid_argument>(cpu, isa, "gemm.double.nc = 100\n"));
+		NUMERIC_CHECK(LoadRejected<std::invalid_argument>(cpu, isa, "strassen.crossover = 0\n"));
+		NUMERIC_CHECK(LoadRejected<std::invalid_argument>(cpu, isa,
+			"gemm.double.kc = 65536\ngemm.double.nc = 65536\n"));
+
+		std::remove(FilePath);
+		bool threw = false;
+		try
+		{
+			kernel::LoadTuning(FilePath);
+		}
+		catch (const std::runtime_error&)
+		{
+			threw = true;
+		}
+		NUMERIC_CHECK(threw);
+	}
+}
+
+
+int main()
+{
+	CheckValidate();
+	CheckRoundTrip();
+	CheckRejectedCaches();
+	std::remove(FilePath);
+	return test::Result();
+}